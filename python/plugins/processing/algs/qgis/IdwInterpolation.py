@@ -87,6 +87,8 @@ class IdwInterpolation(QgisAlgorithm):
 
     INTERPOLATION_DATA = 'INTERPOLATION_DATA'
     DISTANCE_COEFFICIENT = 'DISTANCE_COEFFICIENT'
+    MAX_NEIGHBORS = 'MAX_NEIGHBORS'
+    SEARCH_RADIUS = 'SEARCH_RADIUS'
     COLUMNS = 'COLUMNS'
     ROWS = 'ROWS'
     CELLSIZE_X = 'CELLSIZE_X'
@@ -110,6 +112,16 @@ class IdwInterpolation(QgisAlgorithm):
         self.addParameter(QgsProcessingParameterNumber(self.DISTANCE_COEFFICIENT,
                                                        self.tr('Distance coefficient P'), type=QgsProcessingParameterNumber.Double,
                                                        minValue=0.0, maxValue=99.99, defaultValue=2.0))
+        max_neighbors_param = QgsProcessingParameterNumber(self.MAX_NEIGHBORS,
+                                                           self.tr('Maximum number of neighbors (0 for all points)'),
+                                                           minValue=0, defaultValue=0, optional=True)
+        max_neighbors_param.setFlags(max_neighbors_param.flags() | QgsProcessingParameterDefinition.FlagAdvanced)
+        self.addParameter(max_neighbors_param)
+        search_radius_param = QgsProcessingParameterNumber(self.SEARCH_RADIUS,
+                                                           self.tr('Search radius (0 for no limit)'), type=QgsProcessingParameterNumber.Double,
+                                                           minValue=0.0, defaultValue=0.0, optional=True)
+        search_radius_param.setFlags(search_radius_param.flags() | QgsProcessingParameterDefinition.FlagAdvanced)
+        self.addParameter(search_radius_param)
         self.addParameter(QgsProcessingParameterNumber(self.COLUMNS,
                                                        self.tr('Number of columns'),
                                                        minValue=0, maxValue=10000000, defaultValue=300))
@@ -137,6 +149,8 @@ class IdwInterpolation(QgisAlgorithm):
     def processAlgorithm(self, parameters, context, feedback):
         interpolationData = ParameterInterpolationData.parseValue(parameters[self.INTERPOLATION_DATA])
         coefficient = self.parameterAsDouble(parameters, self.DISTANCE_COEFFICIENT, context)
+        maxNeighbors = self.parameterAsInt(parameters, self.MAX_NEIGHBORS, context)
+        searchRadius = self.parameterAsDouble(parameters, self.SEARCH_RADIUS, context)
         columns = self.parameterAsInt(parameters, self.COLUMNS, context)
         rows = self.parameterAsInt(parameters, self.ROWS, context)
         cellsizeX = self.parameterAsDouble(parameters, self.CELLSIZE_X, context)
@@ -171,6 +185,8 @@ class IdwInterpolation(QgisAlgorithm):
 
         interpolator = QgsIDWInterpolator(layerData)
         interpolator.setDistanceCoefficient(coefficient)
+        interpolator.setMaxNeighbors(maxNeighbors)
+        interpolator.setSearchRadius(searchRadius)
 
         writer = QgsGridFileWriter(interpolator,
                                    output,
@@ -21,6 +21,32 @@
 #include "qgsfeedback.h"
 #include <QFile>
 #include <QFileInfo>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+
+///@cond PRIVATE
+
+//! Number of rows interpolated by a task
+static const int ROW_BLOCK_SIZE = 16;
+
+struct QgsGridFileWriter::RowBlock
+{
+  int firstRow = 0;
+  int rowCount = 0;
+  //! y coordinate of the center of the cells of the first row
+  double firstYValue = 0;
+  //! interpolated values of the cells, by rows, and whether the interpolation succeeded
+  QVector< double > values;
+  QVector< bool > valid;
+  QFuture< void > future;
+};
+
+///@endcond
 
 QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputPath, const QgsRectangle &extent, int nCols, int nRows, double cellSizeX, double cellSizeY )
   : mInterpolator( i )
@@ -30,6 +56,7 @@ QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputP
   , mNumRows( nRows )
   , mCellSizeX( cellSizeX )
   , mCellSizeY( cellSizeY )
+  , mThreadCount( QThread::idealThreadCount() )
 {
 
 }
@@ -63,37 +90,89 @@ int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
   outStream.setRealNumberPrecision( 8 );
   writeHeader( outStream );
 
-  double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
-  double currentXValue;
-  double interpolatedValue;
+  // rows are computed in blocks, concurrently if the interpolator allows it, and written in order
+  const int threadCount = mInterpolator->prepareConcurrentInterpolation() ? std::max( 1, mThreadCount ) : 1;
+  const int maxBlocks = 2 * threadCount;
+  std::deque< std::unique_ptr< RowBlock > > blocks;
+  auto processBlock = [this, feedback]( RowBlock * block )
+  {
+    interpolateBlock( block, feedback );
+  };
 
-  for ( int i = 0; i < mNumRows; ++i )
+  double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
+  int nextRow = 0;
+  bool canceled = false;
+  while ( nextRow < mNumRows || !blocks.empty() )
   {
-    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
-    for ( int j = 0; j < mNumColumns; ++j )
+    if ( nextRow < mNumRows && static_cast< int >( blocks.size() ) < maxBlocks )
     {
-      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue ) == 0 )
+      std::unique_ptr< RowBlock > block( new RowBlock() );
+      block->firstRow = nextRow;
+      block->rowCount = std::min( ROW_BLOCK_SIZE, mNumRows - nextRow );
+      block->firstYValue = currentYValue;
+      for ( int i = 0; i < block->rowCount; ++i )
       {
-        outStream << interpolatedValue << ' ';
+        currentYValue -= mCellSizeY;
+      }
+      nextRow += block->rowCount;
+      if ( threadCount > 1 )
+      {
+        block->future = QtConcurrent::run( processBlock, block.get() );
       }
       else
       {
-        outStream << "-9999 ";
+        processBlock( block.get() );
       }
-      currentXValue += mCellSizeX;
+      blocks.push_back( std::move( block ) );
+      continue;
     }
-    outStream << endl;
-    currentYValue -= mCellSizeY;
 
-    if ( feedback )
+    RowBlock *block = blocks.front().get();
+    block->future.waitForFinished();
+    for ( int i = 0; i < block->rowCount; ++i )
     {
-      if ( feedback->isCanceled() )
+      if ( feedback && feedback->isCanceled() )
+      {
+        canceled = true;
+        break;
+      }
+
+      for ( int j = 0; j < mNumColumns; ++j )
       {
-        outputFile.remove();
-        return 3;
+        const int index = i * mNumColumns + j;
+        if ( block->valid.at( index ) )
+        {
+          outStream << block->values.at( index ) << ' ';
+        }
+        else
+        {
+          outStream << "-9999 ";
+        }
+      }
+      outStream << endl;
+
+      if ( feedback )
+      {
+        feedback->setProgress( 100.0 * ( block->firstRow + i ) / static_cast< double >( mNumRows ) );
       }
-      feedback->setProgress( 100.0 * i / static_cast< double >( mNumRows ) );
     }
+    if ( canceled )
+    {
+      break;
+    }
+    blocks.pop_front();
+  }
+
+  // wait for the running blocks before leaving
+  for ( const std::unique_ptr< RowBlock > &block : blocks )
+  {
+    block->future.waitForFinished();
+  }
+
+  if ( canceled )
+  {
+    outputFile.remove();
+    return 3;
   }
 
   // create prj file
@@ -116,6 +195,35 @@ int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
   return 0;
 }
 
+void QgsGridFileWriter::interpolateBlock( RowBlock *block, QgsFeedback *feedback ) const
+{
+  block->values.resize( block->rowCount * mNumColumns );
+  block->valid.fill( false, block->rowCount * mNumColumns );
+
+  double currentYValue = block->firstYValue;
+  double currentXValue;
+  double interpolatedValue;
+  for ( int i = 0; i < block->rowCount; ++i )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      return;
+    }
+
+    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
+    for ( int j = 0; j < mNumColumns; ++j )
+    {
+      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue ) == 0 )
+      {
+        block->values[ i * mNumColumns + j ] = interpolatedValue;
+        block->valid[ i * mNumColumns + j ] = true;
+      }
+      currentXValue += mCellSizeX;
+    }
+    currentYValue -= mCellSizeY;
+  }
+}
+
 int QgsGridFileWriter::writeHeader( QTextStream &outStream )
 {
   outStream << "NCOLS " << mNumColumns << endl;
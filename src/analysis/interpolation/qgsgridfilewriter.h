@@ -22,12 +22,16 @@
 #include <QString>
 #include <QTextStream>
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 
 class QgsInterpolator;
 class QgsFeedback;
 
 /** \ingroup analysis
- * A class that does interpolation to a grid and writes the results to an ascii grid*/
+ * A class that does interpolation to a grid and writes the results to an ascii grid.
+ *
+ * If the interpolator supports it (see QgsInterpolator::prepareConcurrentInterpolation()),
+ * blocks of rows are interpolated concurrently by several threads, and written in order.*/
 //todo: extend such that writing to other file types is possible
 class ANALYSIS_EXPORT QgsGridFileWriter
 {
@@ -38,13 +42,34 @@ class ANALYSIS_EXPORT QgsGridFileWriter
      \param feedback optional feedback object for progress reports and cancelation support
     \returns 0 in case of success*/
 
-    int writeFile( QgsFeedback *feedback = nullptr );
+    int writeFile( QgsFeedback *feedback = nullptr ) SIP_RELEASEGIL;
+
+    /**
+     * Sets the number of threads interpolating rows concurrently. By default, the ideal
+     * thread count of the system is used. Set \a count to 1 to interpolate from the
+     * calling thread only.
+     * \see threadCount()
+     * \since QGIS 3.0
+     */
+    void setThreadCount( int count ) { mThreadCount = count; }
+
+    /**
+     * Returns the number of threads interpolating rows concurrently.
+     * \see setThreadCount()
+     * \since QGIS 3.0
+     */
+    int threadCount() const { return mThreadCount; }
 
   private:
 
+    struct RowBlock;
+
     QgsGridFileWriter(); //forbidden
     int writeHeader( QTextStream &outStream );
 
+    //! Interpolates the values of the cells of a block of rows
+    void interpolateBlock( RowBlock *block, QgsFeedback *feedback ) const;
+
     QgsInterpolator *mInterpolator = nullptr;
     QString mOutputFilePath;
     QgsRectangle mInterpolationExtent;
@@ -53,6 +78,8 @@ class ANALYSIS_EXPORT QgsGridFileWriter
 
     double mCellSizeX;
     double mCellSizeY;
+
+    int mThreadCount = 1;
 };
 
 #endif
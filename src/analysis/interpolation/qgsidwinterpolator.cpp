@@ -16,8 +16,11 @@
  ***************************************************************************/
 
 #include "qgsidwinterpolator.h"
+#include "qgis.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <vector>
 
 QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData> &layerData ): QgsInterpolator( layerData ), mDistanceCoefficient( 2.0 )
 {
@@ -42,17 +45,42 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result )
   double sumCounter = 0;
   double sumDenominator = 0;
 
-  Q_FOREACH ( const vertexData &vertex_it, mCachedBaseData )
+  // returns true if the vertex is at x, y, and its value is the result
+  auto addVertex = [&]( const vertexData & vertex_it )
   {
     distance = std::sqrt( ( vertex_it.x - x ) * ( vertex_it.x - x ) + ( vertex_it.y - y ) * ( vertex_it.y - y ) );
     if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
     {
       result = vertex_it.z;
-      return 0;
+      return true;
     }
     currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
     sumCounter += ( currentWeight * vertex_it.z );
     sumDenominator += currentWeight;
+    return false;
+  };
+
+  if ( mMaxNeighbors <= 0 && mSearchRadius <= 0 )
+  {
+    Q_FOREACH ( const vertexData &vertex_it, mCachedBaseData )
+    {
+      if ( addVertex( vertex_it ) )
+        return 0;
+    }
+  }
+  else
+  {
+    if ( !mIndexBuilt || mIndexPoints.size() != mCachedBaseData.size() )
+    {
+      buildIndex();
+    }
+
+    const QVector<int> indices = neighbors( x, y );
+    for ( int index : indices )
+    {
+      if ( addVertex( mCachedBaseData.at( index ) ) )
+        return 0;
+    }
   }
 
   if ( sumDenominator == 0.0 )
@@ -63,3 +91,176 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result )
   result = sumCounter / sumDenominator;
   return 0;
 }
+
+bool QgsIDWInterpolator::prepareConcurrentInterpolation()
+{
+  if ( !mDataIsCached )
+  {
+    cacheBaseData();
+  }
+  if ( !mDataIsCached )
+  {
+    return false;
+  }
+
+  // the index is built even if it is not used yet, the neighbor settings may still change
+  if ( !mIndexBuilt || mIndexPoints.size() != mCachedBaseData.size() )
+  {
+    buildIndex();
+  }
+  return true;
+}
+
+void QgsIDWInterpolator::buildIndex()
+{
+  mIndexBuilt = true;
+  mIndexCellStarts.clear();
+  mIndexPoints.clear();
+
+  const int count = mCachedBaseData.size();
+  double xMax = -std::numeric_limits<double>::max();
+  double yMax = -std::numeric_limits<double>::max();
+  mIndexXMin = std::numeric_limits<double>::max();
+  mIndexYMin = std::numeric_limits<double>::max();
+  for ( const vertexData &vertex : qgsAsConst( mCachedBaseData ) )
+  {
+    mIndexXMin = std::min( mIndexXMin, vertex.x );
+    mIndexYMin = std::min( mIndexYMin, vertex.y );
+    xMax = std::max( xMax, vertex.x );
+    yMax = std::max( yMax, vertex.y );
+  }
+
+  mIndexColumns = 1;
+  mIndexRows = 1;
+  mIndexCellSize = 1;
+  const double width = xMax - mIndexXMin;
+  const double height = yMax - mIndexYMin;
+  if ( count > 0 && std::isfinite( width ) && std::isfinite( height ) )
+  {
+    // about two points by cell, without too many empty cells for elongated extents
+    double cellSize = std::sqrt( width * height * 2.0 / count );
+    if ( !( cellSize > 0 ) )
+      cellSize = std::max( width, height ) * 2.0 / count;
+    if ( !( cellSize > 0 ) )
+      cellSize = 1;
+    while ( ( std::floor( width / cellSize ) + 1 ) * ( std::floor( height / cellSize ) + 1 ) > 4.0 * count + 16 )
+      cellSize *= 2;
+
+    mIndexCellSize = cellSize;
+    mIndexColumns = static_cast< int >( std::floor( width / cellSize ) ) + 1;
+    mIndexRows = static_cast< int >( std::floor( height / cellSize ) ) + 1;
+  }
+
+  // points are stored by cell, in increasing order in each cell
+  mIndexCellStarts.fill( 0, mIndexColumns * mIndexRows + 1 );
+  QVector<int> pointCells( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    const vertexData &vertex = mCachedBaseData.at( i );
+    pointCells[ i ] = indexRow( vertex.y ) * mIndexColumns + indexColumn( vertex.x );
+    ++mIndexCellStarts[ pointCells.at( i ) + 1 ];
+  }
+  for ( int cell = 0; cell < mIndexColumns * mIndexRows; ++cell )
+  {
+    mIndexCellStarts[ cell + 1 ] += mIndexCellStarts.at( cell );
+  }
+  QVector<int> cellEnds = mIndexCellStarts;
+  mIndexPoints.resize( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    mIndexPoints[ cellEnds[ pointCells.at( i )]++ ] = i;
+  }
+}
+
+int QgsIDWInterpolator::indexColumn( double x ) const
+{
+  const double column = std::floor( ( x - mIndexXMin ) / mIndexCellSize );
+  if ( !( column > 0 ) )
+    return 0;
+  return column < mIndexColumns ? static_cast< int >( column ) : mIndexColumns - 1;
+}
+
+int QgsIDWInterpolator::indexRow( double y ) const
+{
+  const double row = std::floor( ( y - mIndexYMin ) / mIndexCellSize );
+  if ( !( row > 0 ) )
+    return 0;
+  return row < mIndexRows ? static_cast< int >( row ) : mIndexRows - 1;
+}
+
+QVector<int> QgsIDWInterpolator::neighbors( double x, double y ) const
+{
+  const double maxSqrDistance = mSearchRadius > 0 ? mSearchRadius * mSearchRadius : std::numeric_limits<double>::infinity();
+
+  // squared distances and indices of the points. With a maximum number of neighbors, this is
+  // a max heap of the nearest points, ties between equally distant points go to the first ones
+  typedef QPair< double, int > Candidate;
+  std::vector< Candidate > candidates;
+
+  auto addCell = [&]( int row, int column )
+  {
+    const int cell = row * mIndexColumns + column;
+    for ( int position = mIndexCellStarts.at( cell ); position < mIndexCellStarts.at( cell + 1 ); ++position )
+    {
+      const int index = mIndexPoints.at( position );
+      const vertexData &vertex = mCachedBaseData.at( index );
+      const double sqrDistance = ( vertex.x - x ) * ( vertex.x - x ) + ( vertex.y - y ) * ( vertex.y - y );
+      if ( !( sqrDistance <= maxSqrDistance ) )
+        continue;
+
+      const Candidate candidate( sqrDistance, index );
+      if ( mMaxNeighbors <= 0 || static_cast< int >( candidates.size() ) < mMaxNeighbors )
+      {
+        candidates.push_back( candidate );
+        if ( mMaxNeighbors > 0 )
+          std::push_heap( candidates.begin(), candidates.end() );
+      }
+      else if ( candidate < candidates.front() )
+      {
+        std::pop_heap( candidates.begin(), candidates.end() );
+        candidates.back() = candidate;
+        std::push_heap( candidates.begin(), candidates.end() );
+      }
+    }
+  };
+
+  // cells are visited by rings around the cell of x, y. Points in the ring at distance d
+  // (in cells) are at least ( d - 1 ) cells away, even if x, y is outside of the grid
+  const int centerColumn = indexColumn( x );
+  const int centerRow = indexRow( y );
+  const int maxRing = std::max( std::max( centerColumn, mIndexColumns - 1 - centerColumn ),
+                                std::max( centerRow, mIndexRows - 1 - centerRow ) );
+  for ( int ring = 0; ring <= maxRing; ++ring )
+  {
+    const double minDistance = std::max( ring - 1, 0 ) * mIndexCellSize;
+    if ( minDistance * minDistance > maxSqrDistance )
+      break;
+    if ( mMaxNeighbors > 0 && static_cast< int >( candidates.size() ) == mMaxNeighbors && minDistance * minDistance > candidates.front().first )
+      break;
+
+    const int firstColumn = std::max( centerColumn - ring, 0 );
+    const int lastColumn = std::min( centerColumn + ring, mIndexColumns - 1 );
+    for ( int row = std::max( centerRow - ring, 0 ); row <= std::min( centerRow + ring, mIndexRows - 1 ); ++row )
+    {
+      if ( row == centerRow - ring || row == centerRow + ring )
+      {
+        for ( int column = firstColumn; column <= lastColumn; ++column )
+          addCell( row, column );
+      }
+      else
+      {
+        if ( centerColumn - ring >= 0 )
+          addCell( row, centerColumn - ring );
+        if ( centerColumn + ring < mIndexColumns )
+          addCell( row, centerColumn + ring );
+      }
+    }
+  }
+
+  QVector<int> indices;
+  indices.reserve( static_cast< int >( candidates.size() ) );
+  for ( const Candidate &candidate : candidates )
+    indices << candidate.second;
+  std::sort( indices.begin(), indices.end() );
+  return indices;
+}
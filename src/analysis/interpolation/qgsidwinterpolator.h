@@ -23,6 +23,11 @@
 
 /** \ingroup analysis
  * \class QgsIDWInterpolator
+ * Inverse distance weighting interpolation.
+ *
+ * By default every data point contributes to every interpolated value. With a
+ * maximum number of neighbors or a search radius, only the nearest data points
+ * are used, which are found through a grid index of the data points.
  */
 class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
 {
@@ -36,16 +41,80 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
        \returns 0 in case of success*/
     int interpolatePoint( double x, double y, double &result ) override;
 
+    bool prepareConcurrentInterpolation() override;
+
     void setDistanceCoefficient( double p ) {mDistanceCoefficient = p;}
 
+    /**
+     * Sets the maximum number of data points, the nearest ones, used for each
+     * interpolated value. A value of 0 uses all the data points.
+     * \see maxNeighbors()
+     * \since QGIS 3.0
+     */
+    void setMaxNeighbors( int count ) { mMaxNeighbors = count; }
+
+    /**
+     * Returns the maximum number of data points used for each interpolated value,
+     * 0 if all the data points are used.
+     * \see setMaxNeighbors()
+     * \since QGIS 3.0
+     */
+    int maxNeighbors() const { return mMaxNeighbors; }
+
+    /**
+     * Sets the search \a radius (in map units): only the data points within this
+     * distance are used for an interpolated value, which fails when there are none.
+     * A value of 0 does not limit the distance.
+     * \see searchRadius()
+     * \since QGIS 3.0
+     */
+    void setSearchRadius( double radius ) { mSearchRadius = radius; }
+
+    /**
+     * Returns the search radius (in map units), 0 if the distance is not limited.
+     * \see setSearchRadius()
+     * \since QGIS 3.0
+     */
+    double searchRadius() const { return mSearchRadius; }
+
   private:
 
     QgsIDWInterpolator(); //forbidden
 
+    //! Builds the grid index of the cached data points
+    void buildIndex();
+
+    /**
+     * Returns the indices of the data points used for the value at x, y, in
+     * increasing order, according to the maximum number of neighbors and the search radius
+     */
+    QVector<int> neighbors( double x, double y ) const;
+
+    //! Returns the column of the grid index holding x, the nearest one if x is outside of the grid
+    int indexColumn( double x ) const;
+
+    //! Returns the row of the grid index holding y, the nearest one if y is outside of the grid
+    int indexRow( double y ) const;
+
     /** The parameter that sets how the values are weighted with distance.
        Smaller values mean sharper peaks at the data points. The default is a
        value of 2*/
     double mDistanceCoefficient;
+
+    int mMaxNeighbors = 0;
+    double mSearchRadius = 0;
+
+    //! Grid index of the cached data points
+    bool mIndexBuilt = false;
+    double mIndexXMin = 0;
+    double mIndexYMin = 0;
+    double mIndexCellSize = 1;
+    int mIndexColumns = 0;
+    int mIndexRows = 0;
+    //! start of the points of each cell in mIndexPoints, by rows, plus the end of the last cell
+    QVector<int> mIndexCellStarts;
+    //! indices of the data points, by cell
+    QVector<int> mIndexPoints;
 };
 
 #endif
@@ -67,6 +67,15 @@ class ANALYSIS_EXPORT QgsInterpolator
        \returns 0 in case of success*/
     virtual int interpolatePoint( double x, double y, double &result ) = 0;
 
+    /**
+     * Prepares the interpolator for calls to interpolatePoint() from several threads
+     * at once, e.g. by caching the base data. Returns false if the interpolator does not
+     * support concurrent calls, in which case interpolatePoint() must only be called
+     * from one thread at a time.
+     * \since QGIS 3.0
+     */
+    virtual bool prepareConcurrentInterpolation() { return false; }
+
     //! \note not available in Python bindings
     QList<LayerData> layerData() const { return mLayerData; } SIP_SKIP
 
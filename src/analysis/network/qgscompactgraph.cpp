@@ -0,0 +1,72 @@
+/***************************************************************************
+  qgscompactgraph.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgscompactgraph.h"
+#include "qgsgraph.h"
+
+#include <algorithm>
+#include <limits>
+
+QgsCompactGraph::QgsCompactGraph( const QgsGraph &graph )
+{
+  const int vertexCount = graph.vertexCount();
+  const int edgeCount = graph.edgeCount();
+
+  for ( int i = 0; i < edgeCount; ++i )
+    mStrategyCount = std::max( mStrategyCount, graph.edge( i ).strategies().size() );
+
+  mPoints.reserve( vertexCount );
+  mOutOffsets.reserve( vertexCount + 1 );
+  mEdgeSources.reserve( edgeCount );
+  mEdgeTargets.reserve( edgeCount );
+  mSourceEdgeIds.reserve( edgeCount );
+  mCosts.resize( static_cast< std::size_t >( mStrategyCount ) * edgeCount, std::numeric_limits<double>::infinity() );
+
+  // source edge id to compact edge index, for the incoming edge index
+  std::vector< int > compactEdges( edgeCount, -1 );
+
+  for ( int v = 0; v < vertexCount; ++v )
+  {
+    const QgsGraphVertex &vertex = graph.vertex( v );
+    mPoints.push_back( vertex.point() );
+    mOutOffsets.push_back( static_cast< int >( mEdgeTargets.size() ) );
+
+    const QgsGraphEdgeIds outEdges = vertex.outEdges();
+    for ( int edgeId : outEdges )
+    {
+      const QgsGraphEdge &edge = graph.edge( edgeId );
+      const int compactEdge = static_cast< int >( mEdgeTargets.size() );
+      compactEdges[ edgeId ] = compactEdge;
+      mEdgeSources.push_back( v );
+      mEdgeTargets.push_back( edge.inVertex() );
+      mSourceEdgeIds.push_back( edgeId );
+
+      const QVector< QVariant > strategies = edge.strategies();
+      for ( int s = 0; s < strategies.size(); ++s )
+        mCosts[ static_cast< std::size_t >( s ) * edgeCount + compactEdge ] = strategies.at( s ).toDouble();
+    }
+  }
+  mOutOffsets.push_back( static_cast< int >( mEdgeTargets.size() ) );
+
+  mInOffsets.reserve( vertexCount + 1 );
+  mInEdges.reserve( edgeCount );
+  for ( int v = 0; v < vertexCount; ++v )
+  {
+    mInOffsets.push_back( static_cast< int >( mInEdges.size() ) );
+    const QgsGraphEdgeIds inEdges = graph.vertex( v ).inEdges();
+    for ( int edgeId : inEdges )
+      mInEdges.push_back( compactEdges[ edgeId ] );
+  }
+  mInOffsets.push_back( static_cast< int >( mInEdges.size() ) );
+}
@@ -0,0 +1,122 @@
+/***************************************************************************
+  qgscompactgraph.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSCOMPACTGRAPH_H
+#define QGSCOMPACTGRAPH_H
+
+#include <vector>
+
+#include "qgis.h"
+#include "qgspointxy.h"
+#include "qgis_analysis.h"
+
+class QgsGraph;
+
+/**
+ * \ingroup analysis
+ * \class QgsCompactGraph
+ * \brief A read-only copy of a QgsGraph, stored in compressed sparse row form.
+ *
+ * The edges leaving each vertex are stored next to each other in contiguous arrays,
+ * and the costs of every strategy are converted to doubles once, into one array
+ * per strategy. The edges entering each vertex are indexed as well, so that searches
+ * can also walk the graph backwards. This avoids the per edge list copies and QVariant
+ * conversions of searching a QgsGraph, and is the input of QgsShortestPathEngine.
+ *
+ * Vertices keep the indices they have in the source graph. Edges are renumbered so
+ * that the edges leaving a vertex are consecutive, in the order of QgsGraphVertex::outEdges(),
+ * sourceEdgeId() returns the index of an edge in the source graph.
+ *
+ * \since QGIS 3.0
+ */
+class ANALYSIS_EXPORT QgsCompactGraph
+{
+  public:
+
+    //! Constructor for an empty graph
+    QgsCompactGraph() = default;
+
+    /**
+     * Constructor for a compact copy of \a graph. Edges which have less costs than
+     * the edge with the most strategies get an infinite cost for the missing strategies,
+     * i.e. they are never used by searches optimizing these strategies.
+     */
+    explicit QgsCompactGraph( const QgsGraph &graph );
+
+    //! Returns the number of vertices in the graph
+    int vertexCount() const { return static_cast< int >( mPoints.size() ); }
+
+    //! Returns the number of edges in the graph
+    int edgeCount() const { return static_cast< int >( mEdgeTargets.size() ); }
+
+    //! Returns the number of cost strategies of the graph
+    int strategyCount() const { return mStrategyCount; }
+
+    //! Returns the point associated with a \a vertex
+    QgsPointXY vertexPoint( int vertex ) const { return mPoints[ vertex ]; }
+
+    //! Returns the index of the first edge leaving a \a vertex
+    int outEdgesBegin( int vertex ) const { return mOutOffsets[ vertex ]; }
+
+    //! Returns the index following the last edge leaving a \a vertex
+    int outEdgesEnd( int vertex ) const { return mOutOffsets[ vertex + 1 ]; }
+
+    //! Returns the position of the first edge entering a \a vertex in the incoming edge index
+    int inEdgesBegin( int vertex ) const { return mInOffsets[ vertex ]; }
+
+    //! Returns the position following the last edge entering a \a vertex in the incoming edge index
+    int inEdgesEnd( int vertex ) const { return mInOffsets[ vertex + 1 ]; }
+
+    //! Returns the edge at a \a position in the incoming edge index
+    int inEdge( int position ) const { return mInEdges[ position ]; }
+
+    //! Returns the vertex an \a edge leaves from
+    int edgeSource( int edge ) const { return mEdgeSources[ edge ]; }
+
+    //! Returns the vertex an \a edge enters
+    int edgeTarget( int edge ) const { return mEdgeTargets[ edge ]; }
+
+    //! Returns the index an \a edge has in the source QgsGraph
+    int sourceEdgeId( int edge ) const { return mSourceEdgeIds[ edge ]; }
+
+    //! Returns the cost of an \a edge using a \a strategy
+    double edgeCost( int edge, int strategy ) const { return mCosts[ static_cast< std::size_t >( strategy ) * mEdgeTargets.size() + edge ]; }
+
+    /**
+     * Returns the costs of all edges using a \a strategy, indexed by edge.
+     * \note not available in Python bindings
+     */
+    const double *costs( int strategy ) const SIP_SKIP { return mCosts.data() + static_cast< std::size_t >( strategy ) * mEdgeTargets.size(); }
+
+  private:
+
+    std::vector< QgsPointXY > mPoints;
+    int mStrategyCount = 0;
+
+    //! first edge leaving each vertex, plus the edge count
+    std::vector< int > mOutOffsets;
+    std::vector< int > mEdgeSources;
+    std::vector< int > mEdgeTargets;
+    std::vector< int > mSourceEdgeIds;
+
+    //! first position of each vertex in mInEdges, plus the edge count
+    std::vector< int > mInOffsets;
+    //! edges entering each vertex, in the order of QgsGraphVertex::inEdges()
+    std::vector< int > mInEdges;
+
+    //! one column of edge costs per strategy
+    std::vector< double > mCosts;
+};
+
+#endif // QGSCOMPACTGRAPH_H
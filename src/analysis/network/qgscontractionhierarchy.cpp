@@ -0,0 +1,660 @@
+/***************************************************************************
+  qgscontractionhierarchy.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgscontractionhierarchy.h"
+#include "qgscompactgraph.h"
+#include "qgsfeedback.h"
+#include "qgslogger.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+///@cond PRIVATE
+
+//! Identifies hierarchy files
+static const quint32 HIERARCHY_FILE_MAGIC = 0x51474348;
+static const quint32 HIERARCHY_FILE_VERSION = 1;
+
+//! Number of vertices a witness search settles before giving up and adding the shortcut
+static const int WITNESS_SETTLED_LIMIT = 500;
+
+typedef std::pair< double, int > QueueEntry;
+typedef std::priority_queue< QueueEntry, std::vector< QueueEntry >, std::greater< QueueEntry > > MinimumQueue;
+
+/**
+ * The graph during the contraction: the hierarchy edges leaving and entering
+ * each vertex, including the edges to contracted vertices, which are skipped.
+ */
+struct QgsContractionGraph
+{
+  explicit QgsContractionGraph( int vertexCount )
+    : outEdges( vertexCount )
+    , inEdges( vertexCount )
+    , contracted( vertexCount, false )
+  {
+  }
+
+  int addEdge( int source, int target, double cost, int first, int second )
+  {
+    const int edge = static_cast< int >( sources.size() );
+    sources.push_back( source );
+    targets.push_back( target );
+    costs.push_back( cost );
+    firsts.push_back( first );
+    seconds.push_back( second );
+    outEdges[ source ].push_back( edge );
+    inEdges[ target ].push_back( edge );
+    return edge;
+  }
+
+  std::vector< std::vector< int > > outEdges;
+  std::vector< std::vector< int > > inEdges;
+  std::vector< bool > contracted;
+
+  std::vector< int > sources;
+  std::vector< int > targets;
+  std::vector< double > costs;
+  std::vector< int > firsts;
+  std::vector< int > seconds;
+};
+
+/**
+ * Dijkstra search among the vertices which are not contracted yet, looking for
+ * paths which make a shortcut unnecessary.
+ */
+class QgsWitnessSearch
+{
+  public:
+
+    explicit QgsWitnessSearch( const QgsContractionGraph &graph )
+      : mGraph( graph )
+      , mCosts( graph.outEdges.size() )
+      , mStamps( graph.outEdges.size(), 0 )
+    {
+    }
+
+    //! Searches from source without going through excluded, up to maxCost
+    void run( int source, int excluded, double maxCost )
+    {
+      if ( ++mStamp == 0 )
+      {
+        std::fill( mStamps.begin(), mStamps.end(), 0 );
+        mStamp = 1;
+      }
+      mQueue = MinimumQueue();
+      setCost( source, 0.0 );
+
+      int settled = 0;
+      while ( !mQueue.empty() )
+      {
+        const QueueEntry entry = mQueue.top();
+        mQueue.pop();
+        if ( entry.first > cost( entry.second ) )
+          continue;
+        if ( entry.first > maxCost || ++settled > WITNESS_SETTLED_LIMIT )
+          break;
+
+        for ( int edge : mGraph.outEdges[ entry.second ] )
+        {
+          const int target = mGraph.targets[ edge ];
+          if ( target == excluded || mGraph.contracted[ target ] )
+            continue;
+          const double targetCost = entry.first + mGraph.costs[ edge ];
+          if ( targetCost < cost( target ) )
+            setCost( target, targetCost );
+        }
+      }
+    }
+
+    double cost( int vertex ) const { return mStamps[ vertex ] == mStamp ? mCosts[ vertex ] : std::numeric_limits<double>::infinity(); }
+
+  private:
+
+    void setCost( int vertex, double cost )
+    {
+      mStamps[ vertex ] = mStamp;
+      mCosts[ vertex ] = cost;
+      mQueue.push( QueueEntry( cost, vertex ) );
+    }
+
+    const QgsContractionGraph &mGraph;
+    std::vector< double > mCosts;
+    std::vector< unsigned int > mStamps;
+    unsigned int mStamp = 0;
+    MinimumQueue mQueue;
+};
+
+/**
+ * Contracts a vertex, or only counts the shortcuts its contraction needs if simulate is true.
+ * Returns the number of shortcuts.
+ */
+static int contractVertex( QgsContractionGraph &graph, QgsWitnessSearch &witness, int vertex, bool simulate )
+{
+  int shortcuts = 0;
+  // the edge lists of the vertex are not changed by its own contraction
+  const std::vector< int > &inEdges = graph.inEdges[ vertex ];
+  const std::vector< int > &outEdges = graph.outEdges[ vertex ];
+  for ( int inEdge : inEdges )
+  {
+    const int source = graph.sources[ inEdge ];
+    if ( source == vertex || graph.contracted[ source ] )
+      continue;
+
+    double maxOutCost = -1;
+    for ( int outEdge : outEdges )
+    {
+      const int target = graph.targets[ outEdge ];
+      if ( target != vertex && target != source && !graph.contracted[ target ] )
+        maxOutCost = std::max( maxOutCost, graph.costs[ outEdge ] );
+    }
+    if ( maxOutCost < 0 )
+      continue;
+
+    const double inCost = graph.costs[ inEdge ];
+    witness.run( source, vertex, inCost + maxOutCost );
+    for ( int outEdge : outEdges )
+    {
+      const int target = graph.targets[ outEdge ];
+      if ( target == vertex || target == source || graph.contracted[ target ] )
+        continue;
+
+      const double cost = inCost + graph.costs[ outEdge ];
+      if ( witness.cost( target ) <= cost )
+        continue;
+
+      ++shortcuts;
+      if ( !simulate )
+        graph.addEdge( source, target, cost, inEdge, outEdge );
+    }
+  }
+  return shortcuts;
+}
+
+//! Returns the contraction priority of a vertex, the lowest are contracted first
+static int vertexPriority( QgsContractionGraph &graph, QgsWitnessSearch &witness, int vertex, const std::vector< int > &contractedNeighbors )
+{
+  int edges = 0;
+  for ( int edge : graph.inEdges[ vertex ] )
+  {
+    if ( !graph.contracted[ graph.sources[ edge ] ] )
+      ++edges;
+  }
+  for ( int edge : graph.outEdges[ vertex ] )
+  {
+    if ( !graph.contracted[ graph.targets[ edge ] ] )
+      ++edges;
+  }
+  // the edge difference keeps the hierarchy small, the contracted neighbors spread
+  // the contraction uniformly over the graph
+  return contractVertex( graph, witness, vertex, true ) - edges + contractedNeighbors[ vertex ];
+}
+
+static void writeArray( QDataStream &stream, const std::vector< int > &values )
+{
+  stream << static_cast< quint32 >( values.size() );
+  for ( int value : values )
+    stream << static_cast< qint32 >( value );
+}
+
+static void writeArray( QDataStream &stream, const std::vector< double > &values )
+{
+  stream << static_cast< quint32 >( values.size() );
+  for ( double value : values )
+    stream << value;
+}
+
+//! Reads an array written by writeArray, checking that the file is large enough for its size
+template <typename T, typename S>
+static bool readArray( QDataStream &stream, std::vector< T > &values )
+{
+  quint32 size = 0;
+  stream >> size;
+  if ( stream.status() != QDataStream::Ok || size > stream.device()->bytesAvailable() / static_cast< qint64 >( sizeof( S ) ) )
+    return false;
+
+  values.resize( size );
+  for ( quint32 i = 0; i < size; ++i )
+  {
+    S value;
+    stream >> value;
+    values[ i ] = static_cast< T >( value );
+  }
+  return stream.status() == QDataStream::Ok;
+}
+
+//! Checks that an edge index is consistent with its array sizes
+static bool isValidIndex( const std::vector< int > &offsets, const std::vector< int > &vertices, const std::vector< int > &edges, int vertexCount, int edgeCount )
+{
+  if ( offsets.size() != static_cast< std::size_t >( vertexCount ) + 1 || offsets.front() != 0 || offsets.back() != static_cast< int >( vertices.size() ) || vertices.size() != edges.size() )
+    return false;
+  for ( int i = 0; i < vertexCount; ++i )
+  {
+    if ( offsets[ i ] > offsets[ i + 1 ] )
+      return false;
+  }
+  return std::all_of( vertices.begin(), vertices.end(), [vertexCount]( int vertex ) { return vertex >= 0 && vertex < vertexCount; } )
+         && std::all_of( edges.begin(), edges.end(), [edgeCount]( int edge ) { return edge >= 0 && edge < edgeCount; } );
+}
+
+/**
+ * Dijkstra search going upwards in the hierarchy. Its state is kept in hashes,
+ * as such a search only visits a small part of the graph.
+ */
+struct QgsContractionHierarchy::UpwardSearch
+{
+  struct Label
+  {
+    double cost;
+    //! hierarchy edge through which the vertex is reached, -1 for the origin
+    int edge;
+    int previous;
+  };
+
+  explicit UpwardSearch( int vertex )
+  {
+    labels.insert( vertex, Label{ 0.0, -1, -1 } );
+    queue.push( QueueEntry( 0.0, vertex ) );
+  }
+
+  double cost( int vertex ) const
+  {
+    auto it = labels.constFind( vertex );
+    return it == labels.constEnd() ? std::numeric_limits<double>::infinity() : it->cost;
+  }
+
+  //! Returns the lowest cost in the queue, infinity once the search is over
+  double minimumCost()
+  {
+    while ( !queue.empty() && queue.top().first > cost( queue.top().second ) )
+      queue.pop();
+    return queue.empty() ? std::numeric_limits<double>::infinity() : queue.top().first;
+  }
+
+  //! Removes the vertex with the lowest cost from the queue, minimumCost() must be finite
+  int pop()
+  {
+    const int vertex = queue.top().second;
+    queue.pop();
+    return vertex;
+  }
+
+  void update( int vertex, double cost, int edge, int previous )
+  {
+    auto it = labels.find( vertex );
+    if ( it == labels.end() )
+      labels.insert( vertex, Label{ cost, edge, previous } );
+    else if ( cost < it->cost )
+      *it = Label{ cost, edge, previous };
+    else
+      return;
+    queue.push( QueueEntry( cost, vertex ) );
+  }
+
+  QHash< int, Label > labels;
+  MinimumQueue queue;
+};
+
+///@endcond
+
+QgsContractionHierarchy::QgsContractionHierarchy( const QgsCompactGraph &graph, int strategy, QgsFeedback *feedback )
+  : mStrategy( strategy )
+{
+  if ( strategy < 0 || strategy >= graph.strategyCount() )
+    return;
+
+  const int vertexCount = graph.vertexCount();
+  QgsContractionGraph contraction( vertexCount );
+  for ( int edge = 0; edge < graph.edgeCount(); ++edge )
+  {
+    // the queries rely on non negative costs
+    const double cost = graph.edgeCost( edge, strategy );
+    if ( cost < 0 )
+    {
+      QgsDebugMsg( QString( "Edge %1 has a negative cost, the hierarchy can not be built" ).arg( edge ) );
+      return;
+    }
+    if ( graph.edgeSource( edge ) != graph.edgeTarget( edge ) && std::isfinite( cost ) )
+      contraction.addEdge( graph.edgeSource( edge ), graph.edgeTarget( edge ), cost, graph.sourceEdgeId( edge ), -1 );
+  }
+  const int originalEdgeCount = static_cast< int >( contraction.sources.size() );
+
+  QgsWitnessSearch witness( contraction );
+  std::vector< int > contractedNeighbors( vertexCount, 0 );
+  std::priority_queue< std::pair< int, int >, std::vector< std::pair< int, int > >, std::greater< std::pair< int, int > > > queue;
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return;
+    queue.push( std::make_pair( vertexPriority( contraction, witness, vertex, contractedNeighbors ), vertex ) );
+  }
+
+  // the priorities of the vertices are updated lazily: a vertex is only contracted
+  // if its current priority is still the lowest
+  std::vector< int > ranks( vertexCount, 0 );
+  int rank = 0;
+  while ( !queue.empty() )
+  {
+    const int vertex = queue.top().second;
+    queue.pop();
+    const int priority = vertexPriority( contraction, witness, vertex, contractedNeighbors );
+    if ( !queue.empty() && priority > queue.top().first )
+    {
+      queue.push( std::make_pair( priority, vertex ) );
+      continue;
+    }
+
+    contractVertex( contraction, witness, vertex, false );
+    contraction.contracted[ vertex ] = true;
+    ranks[ vertex ] = rank++;
+    for ( int edge : contraction.inEdges[ vertex ] )
+      contractedNeighbors[ contraction.sources[ edge ] ]++;
+    for ( int edge : contraction.outEdges[ vertex ] )
+      contractedNeighbors[ contraction.targets[ edge ] ]++;
+
+    if ( feedback && rank % 1000 == 0 )
+    {
+      if ( feedback->isCanceled() )
+        return;
+      feedback->setProgress( 100.0 * rank / vertexCount );
+    }
+  }
+
+  mPoints.reserve( vertexCount );
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+    mPoints.push_back( graph.vertexPoint( vertex ) );
+  mEdgeFirst = std::move( contraction.firsts );
+  mEdgeSecond = std::move( contraction.seconds );
+  mEdgeCosts = std::move( contraction.costs );
+  mShortcutCount = static_cast< int >( mEdgeFirst.size() ) - originalEdgeCount;
+  buildSearchGraph( contraction.sources, contraction.targets, ranks );
+  mValid = true;
+}
+
+void QgsContractionHierarchy::buildSearchGraph( const std::vector< int > &edgeSources, const std::vector< int > &edgeTargets, const std::vector< int > &ranks )
+{
+  const int vertexCount = static_cast< int >( ranks.size() );
+  mUpOffsets.assign( vertexCount + 1, 0 );
+  mDownOffsets.assign( vertexCount + 1, 0 );
+  for ( std::size_t edge = 0; edge < edgeSources.size(); ++edge )
+  {
+    if ( ranks[ edgeSources[ edge ] ] < ranks[ edgeTargets[ edge ] ] )
+      mUpOffsets[ edgeSources[ edge ] + 1 ]++;
+    else
+      mDownOffsets[ edgeTargets[ edge ] + 1 ]++;
+  }
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+  {
+    mUpOffsets[ vertex + 1 ] += mUpOffsets[ vertex ];
+    mDownOffsets[ vertex + 1 ] += mDownOffsets[ vertex ];
+  }
+
+  mUpTargets.resize( mUpOffsets.back() );
+  mUpEdges.resize( mUpOffsets.back() );
+  mDownSources.resize( mDownOffsets.back() );
+  mDownEdges.resize( mDownOffsets.back() );
+  std::vector< int > upPositions( mUpOffsets.begin(), mUpOffsets.end() - 1 );
+  std::vector< int > downPositions( mDownOffsets.begin(), mDownOffsets.end() - 1 );
+  for ( std::size_t edge = 0; edge < edgeSources.size(); ++edge )
+  {
+    const int source = edgeSources[ edge ];
+    const int target = edgeTargets[ edge ];
+    if ( ranks[ source ] < ranks[ target ] )
+    {
+      const int position = upPositions[ source ]++;
+      mUpTargets[ position ] = target;
+      mUpEdges[ position ] = static_cast< int >( edge );
+    }
+    else
+    {
+      const int position = downPositions[ target ]++;
+      mDownSources[ position ] = source;
+      mDownEdges[ position ] = static_cast< int >( edge );
+    }
+  }
+}
+
+bool QgsContractionHierarchy::writeToFile( const QString &fileName ) const
+{
+  if ( !mValid )
+    return false;
+
+  QFile file( fileName );
+  if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  stream << HIERARCHY_FILE_MAGIC << HIERARCHY_FILE_VERSION;
+  stream << static_cast< qint32 >( mStrategy ) << static_cast< qint32 >( mShortcutCount );
+
+  stream << static_cast< quint32 >( mPoints.size() );
+  for ( const QgsPointXY &point : mPoints )
+    stream << point.x() << point.y();
+
+  writeArray( stream, mEdgeFirst );
+  writeArray( stream, mEdgeSecond );
+  writeArray( stream, mEdgeCosts );
+  writeArray( stream, mUpOffsets );
+  writeArray( stream, mUpTargets );
+  writeArray( stream, mUpEdges );
+  writeArray( stream, mDownOffsets );
+  writeArray( stream, mDownSources );
+  writeArray( stream, mDownEdges );
+
+  file.close();
+  return stream.status() == QDataStream::Ok && file.error() == QFileDevice::NoError;
+}
+
+bool QgsContractionHierarchy::readFromFile( const QString &fileName )
+{
+  *this = QgsContractionHierarchy();
+
+  QFile file( fileName );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  quint32 magic = 0;
+  quint32 version = 0;
+  stream >> magic >> version;
+  if ( magic != HIERARCHY_FILE_MAGIC || version != HIERARCHY_FILE_VERSION )
+    return false;
+
+  QgsContractionHierarchy hierarchy;
+  qint32 strategy = 0;
+  qint32 shortcutCount = 0;
+  quint32 vertexCount = 0;
+  stream >> strategy >> shortcutCount >> vertexCount;
+  if ( stream.status() != QDataStream::Ok || vertexCount > file.bytesAvailable() / static_cast< qint64 >( 2 * sizeof( double ) ) )
+    return false;
+
+  hierarchy.mStrategy = strategy;
+  hierarchy.mShortcutCount = shortcutCount;
+  hierarchy.mPoints.reserve( vertexCount );
+  for ( quint32 i = 0; i < vertexCount; ++i )
+  {
+    double x = 0;
+    double y = 0;
+    stream >> x >> y;
+    hierarchy.mPoints.push_back( QgsPointXY( x, y ) );
+  }
+
+  if ( !readArray< int, qint32 >( stream, hierarchy.mEdgeFirst )
+       || !readArray< int, qint32 >( stream, hierarchy.mEdgeSecond )
+       || !readArray< double, double >( stream, hierarchy.mEdgeCosts )
+       || !readArray< int, qint32 >( stream, hierarchy.mUpOffsets )
+       || !readArray< int, qint32 >( stream, hierarchy.mUpTargets )
+       || !readArray< int, qint32 >( stream, hierarchy.mUpEdges )
+       || !readArray< int, qint32 >( stream, hierarchy.mDownOffsets )
+       || !readArray< int, qint32 >( stream, hierarchy.mDownSources )
+       || !readArray< int, qint32 >( stream, hierarchy.mDownEdges ) )
+    return false;
+
+  // reject inconsistent files rather than crash on them. Shortcuts are made of
+  // edges created before them, so unpacking them always terminates
+  const int edgeCount = static_cast< int >( hierarchy.mEdgeFirst.size() );
+  if ( hierarchy.mEdgeSecond.size() != hierarchy.mEdgeFirst.size() || hierarchy.mEdgeCosts.size() != hierarchy.mEdgeFirst.size() )
+    return false;
+  for ( int edge = 0; edge < edgeCount; ++edge )
+  {
+    const int second = hierarchy.mEdgeSecond[ edge ];
+    if ( second >= edge || ( second >= 0 && ( hierarchy.mEdgeFirst[ edge ] < 0 || hierarchy.mEdgeFirst[ edge ] >= edge ) ) )
+      return false;
+
+    // the queries rely on non negative costs
+    const double cost = hierarchy.mEdgeCosts[ edge ];
+    if ( !std::isfinite( cost ) || cost < 0 )
+      return false;
+  }
+  if ( !isValidIndex( hierarchy.mUpOffsets, hierarchy.mUpTargets, hierarchy.mUpEdges, static_cast< int >( vertexCount ), edgeCount )
+       || !isValidIndex( hierarchy.mDownOffsets, hierarchy.mDownSources, hierarchy.mDownEdges, static_cast< int >( vertexCount ), edgeCount ) )
+    return false;
+
+  hierarchy.mValid = true;
+  *this = std::move( hierarchy );
+  return true;
+}
+
+void QgsContractionHierarchy::unpackEdge( int edge, QVector<int> *path ) const
+{
+  // shortcuts can be nested deeply, so they are expanded with an explicit stack
+  std::vector< int > stack( 1, edge );
+  while ( !stack.empty() )
+  {
+    const int current = stack.back();
+    stack.pop_back();
+    if ( mEdgeSecond[ current ] < 0 )
+    {
+      path->append( mEdgeFirst[ current ] );
+    }
+    else
+    {
+      stack.push_back( mEdgeSecond[ current ] );
+      stack.push_back( mEdgeFirst[ current ] );
+    }
+  }
+}
+
+double QgsContractionHierarchy::shortestPath( int startVertex, int endVertex, QVector<int> *path ) const
+{
+  if ( path )
+    path->clear();
+  const int vertexCount = this->vertexCount();
+  if ( !mValid || startVertex < 0 || startVertex >= vertexCount || endVertex < 0 || endVertex >= vertexCount )
+    return std::numeric_limits<double>::infinity();
+  if ( startVertex == endVertex )
+    return 0.0;
+
+  UpwardSearch forward( startVertex );
+  UpwardSearch backward( endVertex );
+  double bestCost = std::numeric_limits<double>::infinity();
+  int meetingVertex = -1;
+  for ( ;; )
+  {
+    // each search stops once it cannot reach a vertex cheaper than the best path
+    const double forwardCost = forward.minimumCost();
+    const double backwardCost = backward.minimumCost();
+    const bool forwardDone = forwardCost >= bestCost;
+    const bool backwardDone = backwardCost >= bestCost;
+    if ( forwardDone && backwardDone )
+      break;
+
+    const bool isForward = !forwardDone && ( backwardDone || forwardCost <= backwardCost );
+    UpwardSearch &search = isForward ? forward : backward;
+    const UpwardSearch &other = isForward ? backward : forward;
+    const int vertex = search.pop();
+    const double cost = isForward ? forwardCost : backwardCost;
+    if ( cost + other.cost( vertex ) < bestCost )
+    {
+      bestCost = cost + other.cost( vertex );
+      meetingVertex = vertex;
+    }
+
+    if ( isForward )
+    {
+      for ( int i = mUpOffsets[ vertex ]; i < mUpOffsets[ vertex + 1 ]; ++i )
+        search.update( mUpTargets[ i ], cost + mEdgeCosts[ mUpEdges[ i ] ], mUpEdges[ i ], vertex );
+    }
+    else
+    {
+      for ( int i = mDownOffsets[ vertex ]; i < mDownOffsets[ vertex + 1 ]; ++i )
+        search.update( mDownSources[ i ], cost + mEdgeCosts[ mDownEdges[ i ] ], mDownEdges[ i ], vertex );
+    }
+  }
+
+  if ( path && meetingVertex >= 0 )
+  {
+    std::vector< int > edges;
+    for ( int vertex = meetingVertex; forward.labels.value( vertex ).edge >= 0; vertex = forward.labels.value( vertex ).previous )
+      edges.push_back( forward.labels.value( vertex ).edge );
+    for ( auto it = edges.rbegin(); it != edges.rend(); ++it )
+      unpackEdge( *it, path );
+    for ( int vertex = meetingVertex; backward.labels.value( vertex ).edge >= 0; vertex = backward.labels.value( vertex ).previous )
+      unpackEdge( backward.labels.value( vertex ).edge, path );
+  }
+  return bestCost;
+}
+
+QVector<double> QgsContractionHierarchy::costsToVertices( int startVertex, const QVector<int> &targets ) const
+{
+  QVector<double> result( targets.size(), std::numeric_limits<double>::infinity() );
+  const int vertexCount = this->vertexCount();
+  if ( !mValid || startVertex < 0 || startVertex >= vertexCount )
+    return result;
+
+  // the upward searches backwards from the targets leave the cost of reaching each
+  // target in buckets on their vertices, the search from the start then only has
+  // to combine its costs with the buckets of the vertices it reaches
+  QHash< int, QVector< QPair< int, double > > > buckets;
+  for ( int i = 0; i < targets.size(); ++i )
+  {
+    const int target = targets.at( i );
+    if ( target < 0 || target >= vertexCount )
+      continue;
+
+    UpwardSearch backward( target );
+    while ( std::isfinite( backward.minimumCost() ) )
+    {
+      const double cost = backward.minimumCost();
+      const int vertex = backward.pop();
+      buckets[ vertex ].append( qMakePair( i, cost ) );
+      for ( int j = mDownOffsets[ vertex ]; j < mDownOffsets[ vertex + 1 ]; ++j )
+        backward.update( mDownSources[ j ], cost + mEdgeCosts[ mDownEdges[ j ] ], mDownEdges[ j ], vertex );
+    }
+  }
+
+  UpwardSearch forward( startVertex );
+  while ( std::isfinite( forward.minimumCost() ) )
+  {
+    const double cost = forward.minimumCost();
+    const int vertex = forward.pop();
+    auto bucket = buckets.constFind( vertex );
+    if ( bucket != buckets.constEnd() )
+    {
+      for ( const QPair< int, double > &entry : *bucket )
+        result[ entry.first ] = std::min( result[ entry.first ], cost + entry.second );
+    }
+    for ( int j = mUpOffsets[ vertex ]; j < mUpOffsets[ vertex + 1 ]; ++j )
+      forward.update( mUpTargets[ j ], cost + mEdgeCosts[ mUpEdges[ j ] ], mUpEdges[ j ], vertex );
+  }
+  return result;
+}
@@ -0,0 +1,149 @@
+/***************************************************************************
+  qgscontractionhierarchy.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSCONTRACTIONHIERARCHY_H
+#define QGSCONTRACTIONHIERARCHY_H
+
+#include <QString>
+#include <QVector>
+#include <vector>
+
+#include "qgis.h"
+#include "qgspointxy.h"
+#include "qgis_analysis.h"
+
+class QgsCompactGraph;
+class QgsFeedback;
+
+/**
+ * \ingroup analysis
+ * \class QgsContractionHierarchy
+ * \brief A contraction hierarchy of a graph, answering shortest path queries much faster than a Dijkstra search.
+ *
+ * Building the hierarchy contracts the vertices of the graph one after the other, from
+ * the least to the most important, and adds shortcut edges between the neighbors of a
+ * vertex wherever it lies on the only shortest path between them. A query then only
+ * searches upwards in the hierarchy, from both ends, which visits a small part of the graph.
+ *
+ * Building the hierarchy is expensive, but it only depends on the graph: it can be
+ * saved to a file with writeToFile() and loaded again with readFromFile(), e.g. to answer
+ * queries until the network changes without building the graph again. The file also
+ * stores the vertex points, the vertices are those of the source graph.
+ *
+ * Queries do not modify the hierarchy, so the same hierarchy can be queried from
+ * several threads at once. Edge costs must not be negative.
+ *
+ * \since QGIS 3.0
+ */
+class ANALYSIS_EXPORT QgsContractionHierarchy
+{
+  public:
+
+    //! Constructor for an invalid hierarchy
+    QgsContractionHierarchy() = default;
+
+    /**
+     * Builds the hierarchy of \a graph, for the costs of the strategy with index \a strategy.
+     * Edges with an infinite cost are left out. If an edge has a negative cost,
+     * the hierarchy is invalid.
+     *
+     * The optional \a feedback argument reports the progress and allows the build to be
+     * canceled, which results in an invalid hierarchy.
+     */
+    QgsContractionHierarchy( const QgsCompactGraph &graph, int strategy = 0, QgsFeedback *feedback = nullptr );
+
+    //! Returns true if the hierarchy was built or read successfully
+    bool isValid() const { return mValid; }
+
+    //! Returns the number of vertices in the hierarchy
+    int vertexCount() const { return static_cast< int >( mPoints.size() ); }
+
+    //! Returns the number of edges in the hierarchy, including the shortcuts
+    int edgeCount() const { return static_cast< int >( mEdgeFirst.size() ); }
+
+    //! Returns the number of shortcut edges added by the contraction
+    int shortcutCount() const { return mShortcutCount; }
+
+    //! Returns the index of the strategy whose costs are used by the hierarchy
+    int strategy() const { return mStrategy; }
+
+    //! Returns the point associated with a \a vertex
+    QgsPointXY vertexPoint( int vertex ) const { return mPoints[ vertex ]; }
+
+    /**
+     * Writes the hierarchy to the file \a fileName.
+     * Returns false if the file could not be written.
+     * \see readFromFile()
+     */
+    bool writeToFile( const QString &fileName ) const;
+
+    /**
+     * Replaces the hierarchy with the one stored in the file \a fileName.
+     * Returns false if the file could not be read, is not a hierarchy file or is inconsistent (e.g. negative costs),
+     * in which case the hierarchy is invalid.
+     * \see writeToFile()
+     */
+    bool readFromFile( const QString &fileName );
+
+    /**
+     * Returns the cost of the shortest path from \a startVertex to \a endVertex,
+     * or infinity if \a endVertex cannot be reached.
+     *
+     * If \a path is set, it receives the indices in the source QgsGraph of the edges
+     * of the path, in order from the start vertex.
+     */
+    double shortestPath( int startVertex, int endVertex, QVector<int> *path SIP_OUT = nullptr ) const;
+
+    /**
+     * Returns the costs of the shortest paths from \a startVertex to each of the
+     * \a targets, infinity for unreachable targets.
+     */
+    QVector<double> costsToVertices( int startVertex, const QVector<int> &targets ) const;
+
+  private:
+
+    struct UpwardSearch;
+
+    //! Appends the source graph edges represented by a hierarchy edge to path
+    void unpackEdge( int edge, QVector<int> *path ) const;
+
+    //! Builds the upward and downward edge indices from the edges and the vertex ranks
+    void buildSearchGraph( const std::vector< int > &edgeSources, const std::vector< int > &edgeTargets, const std::vector< int > &ranks );
+
+    bool mValid = false;
+    int mStrategy = 0;
+    int mShortcutCount = 0;
+    std::vector< QgsPointXY > mPoints;
+
+    /**
+     * Edges of the hierarchy. For edges of the source graph mEdgeFirst is the index
+     * of the edge in the source graph and mEdgeSecond is -1, shortcuts are made of
+     * the hierarchy edges mEdgeFirst then mEdgeSecond.
+     */
+    std::vector< int > mEdgeFirst;
+    std::vector< int > mEdgeSecond;
+    std::vector< double > mEdgeCosts;
+
+    //! edges leaving each vertex towards a higher ranked vertex, by vertex
+    std::vector< int > mUpOffsets;
+    std::vector< int > mUpTargets;
+    std::vector< int > mUpEdges;
+
+    //! edges entering each vertex from a higher ranked vertex, by vertex
+    std::vector< int > mDownOffsets;
+    std::vector< int > mDownSources;
+    std::vector< int > mDownEdges;
+};
+
+#endif // QGSCONTRACTIONHIERARCHY_H
@@ -14,10 +14,9 @@
 ***************************************************************************/
 
 #include <limits>
+#include <queue>
 
-#include <QMap>
 #include <QVector>
-#include <QPair>
 
 #include "qgsgraph.h"
 #include "qgsgraphanalyzer.h"
@@ -44,26 +43,38 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
     resultTree->insert( resultTree->begin(), source->vertexCount(), -1 );
   }
 
-  // QMultiMap< cost, vertexIdx > not_begin
-  // I use it and don't create any struct or class
-  QMultiMap< double, int > not_begin;
-  QMultiMap< double, int >::iterator it;
+  // candidate vertices, with the cost at which they were queued. Vertices whose cost
+  // decreased since are queued again, their outdated entries are skipped. Among
+  // entries of equal cost the last queued one comes first.
+  struct QueueEntry
+  {
+    double cost;
+    quint64 order;
+    int vertex;
+    bool operator<( const QueueEntry &other ) const
+    {
+      // std::priority_queue takes the greatest entry first
+      return cost > other.cost || ( cost == other.cost && order < other.order );
+    }
+  };
+  std::priority_queue< QueueEntry > not_begin;
+  quint64 order = 0;
 
-  not_begin.insert( 0.0, startPointIdx );
+  not_begin.push( QueueEntry{ 0.0, order++, startPointIdx } );
 
   while ( !not_begin.empty() )
   {
-    it = not_begin.begin();
-    double curCost = it.key();
-    int curVertex = it.value();
-    not_begin.erase( it );
+    const double curCost = not_begin.top().cost;
+    const int curVertex = not_begin.top().vertex;
+    not_begin.pop();
+    if ( curCost > ( *result )[ curVertex ] )
+      continue;
 
     // edge index list
-    QgsGraphEdgeIds l = source->vertex( curVertex ).outEdges();
-    QgsGraphEdgeIds::iterator arcIt;
-    for ( arcIt = l.begin(); arcIt != l.end(); ++arcIt )
+    const QgsGraphEdgeIds l = source->vertex( curVertex ).outEdges();
+    for ( int edgeId : l )
     {
-      const QgsGraphEdge arc = source->edge( *arcIt );
+      const QgsGraphEdge &arc = source->edge( edgeId );
       double cost = arc.cost( criterionNum ).toDouble() + curCost;
 
       if ( cost < ( *result )[ arc.inVertex()] )
@@ -71,9 +82,9 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
         ( *result )[ arc.inVertex()] = cost;
         if ( resultTree )
         {
-          ( *resultTree )[ arc.inVertex()] = *arcIt;
+          ( *resultTree )[ arc.inVertex()] = edgeId;
         }
-        not_begin.insert( cost, arc.inVertex() );
+        not_begin.push( QueueEntry{ cost, order++, arc.inVertex() } );
       }
     }
   }
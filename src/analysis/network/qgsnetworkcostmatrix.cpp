@@ -0,0 +1,225 @@
+/***************************************************************************
+  qgsnetworkcostmatrix.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsnetworkcostmatrix.h"
+#include "qgscompactgraph.h"
+#include "qgsshortestpathengine.h"
+#include "qgsfeature.h"
+#include "qgsfeaturesink.h"
+#include "qgsfeedback.h"
+#include "qgsmessagelog.h"
+
+#include <QMutex>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <vector>
+
+///@cond PRIVATE
+
+//! Number of origins searched by a task
+static const int ROW_BLOCK_SIZE = 16;
+
+struct QgsNetworkCostMatrix::RowBlock
+{
+  int firstRow = 0;
+  int rowCount = 0;
+  //! costs of the rows of the block, by rows
+  QVector<double> costs;
+  QFuture< void > future;
+};
+
+///@endcond
+
+QgsNetworkCostMatrix::QgsNetworkCostMatrix( const QgsCompactGraph *graph, int strategy )
+  : mGraph( graph )
+  , mStrategy( strategy )
+  , mThreadCount( QThread::idealThreadCount() )
+{
+}
+
+QgsFields QgsNetworkCostMatrix::fields()
+{
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "origin" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "destination" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "cost" ), QVariant::Double ) );
+  return fields;
+}
+
+bool QgsNetworkCostMatrix::computeRows( const QVector<int> &origins, const QVector<int> &destinations, QgsFeedback *feedback,
+                                        const std::function< bool( const RowBlock & ) > &writeBlock ) const
+{
+  // invalid destinations are left out of the searches, and keep an infinite cost
+  const int vertexCount = mGraph->vertexCount();
+  QVector<int> targets;
+  QVector<int> targetColumns;
+  for ( int column = 0; column < destinations.size(); ++column )
+  {
+    if ( destinations.at( column ) >= 0 && destinations.at( column ) < vertexCount )
+    {
+      targets << destinations.at( column );
+      targetColumns << column;
+    }
+  }
+
+  // a search engine holds state for the whole graph, so the engines are reused
+  // by the following blocks rather than created for each block
+  QMutex enginesMutex;
+  std::vector< std::unique_ptr< QgsShortestPathEngine > > engines;
+
+  const int columnCount = destinations.size();
+  auto processBlock = [&]( RowBlock * block )
+  {
+    std::unique_ptr< QgsShortestPathEngine > engine;
+    {
+      QMutexLocker locker( &enginesMutex );
+      if ( !engines.empty() )
+      {
+        engine = std::move( engines.back() );
+        engines.pop_back();
+      }
+    }
+    if ( !engine )
+      engine.reset( new QgsShortestPathEngine( mGraph, mStrategy ) );
+
+    block->costs.fill( std::numeric_limits<double>::infinity(), block->rowCount * columnCount );
+    for ( int row = 0; row < block->rowCount; ++row )
+    {
+      if ( feedback && feedback->isCanceled() )
+        break;
+
+      const int origin = origins.at( block->firstRow + row );
+      if ( origin < 0 || origin >= vertexCount )
+        continue;
+
+      const QVector<double> costs = engine->costsToVertices( origin, targets );
+      double *rowCosts = block->costs.data() + static_cast< qgssize >( row ) * columnCount;
+      for ( int i = 0; i < costs.size(); ++i )
+        rowCosts[ targetColumns.at( i ) ] = costs.at( i );
+    }
+
+    QMutexLocker locker( &enginesMutex );
+    engines.push_back( std::move( engine ) );
+  };
+
+  const int threadCount = std::max( 1, mThreadCount );
+  const int maxBlocks = 2 * threadCount;
+  std::deque< std::unique_ptr< RowBlock > > blocks;
+  int nextRow = 0;
+  bool ok = true;
+  while ( nextRow < origins.size() || !blocks.empty() )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      ok = false;
+      break;
+    }
+
+    if ( nextRow < origins.size() && static_cast< int >( blocks.size() ) < maxBlocks )
+    {
+      std::unique_ptr< RowBlock > block( new RowBlock() );
+      block->firstRow = nextRow;
+      block->rowCount = std::min( ROW_BLOCK_SIZE, origins.size() - nextRow );
+      nextRow += block->rowCount;
+      if ( threadCount > 1 )
+      {
+        block->future = QtConcurrent::run( processBlock, block.get() );
+      }
+      else
+      {
+        processBlock( block.get() );
+      }
+      blocks.push_back( std::move( block ) );
+      continue;
+    }
+
+    // blocks are written in order, once they are computed
+    RowBlock *block = blocks.front().get();
+    block->future.waitForFinished();
+    if ( feedback && feedback->isCanceled() )
+    {
+      ok = false;
+      break;
+    }
+    if ( !writeBlock( *block ) )
+    {
+      ok = false;
+      break;
+    }
+    if ( feedback )
+      feedback->setProgress( 100.0 * ( block->firstRow + block->rowCount ) / origins.size() );
+    blocks.pop_front();
+  }
+
+  // wait for the running blocks, they refer to the local state
+  for ( const std::unique_ptr< RowBlock > &block : blocks )
+  {
+    block->future.waitForFinished();
+  }
+  return ok;
+}
+
+QVector<double> QgsNetworkCostMatrix::costMatrix( const QVector<int> &origins, const QVector<int> &destinations, QgsFeedback *feedback ) const
+{
+  // a QVector allocates at most INT_MAX bytes, including its header
+  const qint64 size = static_cast< qint64 >( origins.size() ) * destinations.size();
+  const qint64 maxSize = ( std::numeric_limits< int >::max() - static_cast< qint64 >( sizeof( QArrayData ) ) ) / static_cast< qint64 >( sizeof( double ) );
+  if ( size > maxSize )
+  {
+    QgsMessageLog::logMessage( QObject::tr( "The cost matrix of %1 origins and %2 destinations is too large, it must be written to a sink instead." ).arg( origins.size() ).arg( destinations.size() ), QObject::tr( "Network analysis" ), QgsMessageLog::CRITICAL );
+    return QVector<double>();
+  }
+
+  QVector<double> matrix( static_cast< int >( size ) );
+  auto writeBlock = [&matrix, &destinations]( const RowBlock & block )
+  {
+    std::copy( block.costs.constBegin(), block.costs.constEnd(), matrix.begin() + static_cast< qgssize >( block.firstRow ) * destinations.size() );
+    return true;
+  };
+
+  if ( !computeRows( origins, destinations, feedback, writeBlock ) )
+    return QVector<double>();
+  return matrix;
+}
+
+bool QgsNetworkCostMatrix::writeToSink( const QVector<int> &origins, const QVector<int> &destinations, QgsFeatureSink *sink, QgsFeedback *feedback, bool includeUnreachable ) const
+{
+  const QgsFields fields = QgsNetworkCostMatrix::fields();
+  auto writeBlock = [&]( const RowBlock & block )
+  {
+    QgsFeatureList features;
+    for ( int row = 0; row < block.rowCount; ++row )
+    {
+      for ( int column = 0; column < destinations.size(); ++column )
+      {
+        const double cost = block.costs.at( row * destinations.size() + column );
+        if ( !includeUnreachable && std::isinf( cost ) )
+          continue;
+
+        QgsFeature feature( fields );
+        feature.setAttributes( QgsAttributes() << block.firstRow + row << column << cost );
+        features << feature;
+      }
+    }
+    return sink->addFeatures( features, QgsFeatureSink::FastInsert );
+  };
+
+  return computeRows( origins, destinations, feedback, writeBlock );
+}
@@ -0,0 +1,115 @@
+/***************************************************************************
+  qgsnetworkcostmatrix.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSNETWORKCOSTMATRIX_H
+#define QGSNETWORKCOSTMATRIX_H
+
+#include <QVector>
+#include <functional>
+
+#include "qgis.h"
+#include "qgsfields.h"
+#include "qgis_analysis.h"
+
+class QgsCompactGraph;
+class QgsFeatureSink;
+class QgsFeedback;
+
+/**
+ * \ingroup analysis
+ * \class QgsNetworkCostMatrix
+ * \brief Computes the costs of the shortest paths between origins and destinations of a network.
+ *
+ * Each origin is searched with QgsShortestPathEngine::costsToVertices(), which stops
+ * as soon as all destinations are reached. The origins are searched concurrently,
+ * in blocks of rows, by several threads sharing the read-only graph (see setThreadCount()).
+ *
+ * The costs are either returned as a dense matrix by costMatrix(), or written as
+ * one feature per origin and destination pair to a sink by writeToSink(), which only
+ * keeps a few blocks of rows in memory.
+ *
+ * \since QGIS 3.0
+ */
+class ANALYSIS_EXPORT QgsNetworkCostMatrix
+{
+  public:
+
+    /**
+     * Constructor for a cost matrix of \a graph, for the costs of the strategy with
+     * index \a strategy. The graph must outlive the matrix.
+     */
+    QgsNetworkCostMatrix( const QgsCompactGraph *graph SIP_KEEPREFERENCE, int strategy = 0 );
+
+    /**
+     * Sets the number of threads searching origins concurrently. By default, the ideal
+     * thread count of the system is used. Set \a count to 1 to search from the calling
+     * thread only.
+     * \see threadCount()
+     */
+    void setThreadCount( int count ) { mThreadCount = count; }
+
+    /**
+     * Returns the number of threads searching origins concurrently.
+     * \see setThreadCount()
+     */
+    int threadCount() const { return mThreadCount; }
+
+    /**
+     * Returns the costs of the shortest paths from each of the \a origins to each
+     * of the \a destinations, which are vertex indices of the graph. The matrix is
+     * stored by rows: the cost from origins[i] to destinations[j] is at index
+     * i * destinations.size() + j. Unreachable destinations, as well as invalid
+     * vertex indices, have an infinite cost. Very large matrices, whose size exceeds
+     * the capacity of a QVector, must be written with writeToSink() instead: an empty
+     * matrix is returned for them and an error is logged.
+     *
+     * An empty matrix is returned if the computation is canceled through \a feedback.
+     */
+    QVector<double> costMatrix( const QVector<int> &origins, const QVector<int> &destinations, QgsFeedback *feedback = nullptr ) const;
+
+    /**
+     * Writes the costs of the shortest paths from each of the \a origins to each of
+     * the \a destinations to a \a sink, as features without geometry with the fields().
+     * Features are written in the order of the origins, then of the destinations.
+     * If \a includeUnreachable is false, no feature is written for destinations which
+     * cannot be reached, otherwise their cost is infinite.
+     *
+     * Returns false if the computation is canceled through \a feedback or the features
+     * could not be added to the sink.
+     */
+    bool writeToSink( const QVector<int> &origins, const QVector<int> &destinations, QgsFeatureSink *sink, QgsFeedback *feedback = nullptr, bool includeUnreachable = false ) const;
+
+    /**
+     * Returns the fields of the features written by writeToSink(): the positions of the
+     * origin and destination in the lists of origins and destinations, and the cost.
+     */
+    static QgsFields fields();
+
+  private:
+
+    struct RowBlock;
+
+    /**
+     * Computes the rows of the matrix in blocks, which are passed to \a writeBlock
+     * in order, from the calling thread. Returns false if canceled or if writeBlock fails.
+     */
+    bool computeRows( const QVector<int> &origins, const QVector<int> &destinations, QgsFeedback *feedback,
+                      const std::function< bool( const RowBlock & ) > &writeBlock ) const;
+
+    const QgsCompactGraph *mGraph = nullptr;
+    int mStrategy = 0;
+    int mThreadCount = 1;
+};
+
+#endif // QGSNETWORKCOSTMATRIX_H
@@ -0,0 +1,351 @@
+/***************************************************************************
+  qgsshortestpathengine.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsshortestpathengine.h"
+#include "qgscompactgraph.h"
+
+#include <algorithm>
+#include <limits>
+
+///@cond PRIVATE
+
+//! Number of children of the heap nodes
+static const int HEAP_ARITY = 4;
+
+/**
+ * The state of a search in one direction. The state is only reset for the vertices
+ * a search reaches: a vertex has a cost in the current search if its stamp is the
+ * stamp of the search.
+ */
+struct QgsShortestPathEngine::SearchSpace
+{
+  struct HeapEntry
+  {
+    double cost;
+    //! insertion order, vertices of equal cost are taken last inserted first
+    quint64 order;
+    int vertex;
+  };
+
+  explicit SearchSpace( int vertexCount )
+    : costs( vertexCount )
+    , parentEdges( vertexCount )
+    , stamps( vertexCount, 0 )
+    , heapPositions( vertexCount, -1 )
+  {
+  }
+
+  void reset()
+  {
+    heap.clear();
+    order = 0;
+    if ( ++stamp == 0 )
+    {
+      std::fill( stamps.begin(), stamps.end(), 0 );
+      stamp = 1;
+    }
+  }
+
+  bool isReached( int vertex ) const { return stamps[ vertex ] == stamp; }
+
+  double cost( int vertex ) const { return isReached( vertex ) ? costs[ vertex ] : std::numeric_limits<double>::infinity(); }
+
+  bool isEmpty() const { return heap.empty(); }
+
+  double minimumCost() const { return heap.front().cost; }
+
+  static bool before( const HeapEntry &a, const HeapEntry &b )
+  {
+    return a.cost < b.cost || ( a.cost == b.cost && a.order > b.order );
+  }
+
+  /**
+   * Sets the cost of a vertex, reached through edge, if it is lower than its
+   * current cost. Returns true if the cost was changed.
+   */
+  bool update( int vertex, double cost, int edge )
+  {
+    if ( !( cost < this->cost( vertex ) ) )
+      return false;
+
+    if ( !isReached( vertex ) )
+    {
+      stamps[ vertex ] = stamp;
+      heapPositions[ vertex ] = -1;
+    }
+    costs[ vertex ] = cost;
+    parentEdges[ vertex ] = edge;
+
+    int position = heapPositions[ vertex ];
+    if ( position < 0 )
+    {
+      position = static_cast< int >( heap.size() );
+      heap.push_back( HeapEntry() );
+    }
+    siftUp( position, HeapEntry{ cost, order++, vertex } );
+    return true;
+  }
+
+  //! Removes the vertex with the lowest cost from the heap and returns it
+  int pop()
+  {
+    const int vertex = heap.front().vertex;
+    heapPositions[ vertex ] = -1;
+    const HeapEntry last = heap.back();
+    heap.pop_back();
+    if ( !heap.empty() )
+      siftDown( 0, last );
+    return vertex;
+  }
+
+  void place( int position, const HeapEntry &entry )
+  {
+    heap[ position ] = entry;
+    heapPositions[ entry.vertex ] = position;
+  }
+
+  void siftUp( int position, const HeapEntry &entry )
+  {
+    while ( position > 0 )
+    {
+      const int parent = ( position - 1 ) / HEAP_ARITY;
+      if ( !before( entry, heap[ parent ] ) )
+        break;
+      place( position, heap[ parent ] );
+      position = parent;
+    }
+    place( position, entry );
+  }
+
+  void siftDown( int position, const HeapEntry &entry )
+  {
+    const int size = static_cast< int >( heap.size() );
+    for ( ;; )
+    {
+      const int firstChild = position * HEAP_ARITY + 1;
+      if ( firstChild >= size )
+        break;
+      const int lastChild = std::min( firstChild + HEAP_ARITY, size );
+      int best = firstChild;
+      for ( int child = firstChild + 1; child < lastChild; ++child )
+      {
+        if ( before( heap[ child ], heap[ best ] ) )
+          best = child;
+      }
+      if ( !before( heap[ best ], entry ) )
+        break;
+      place( position, heap[ best ] );
+      position = best;
+    }
+    place( position, entry );
+  }
+
+  std::vector< double > costs;
+  //! compact graph edge through which each vertex is reached, -1 for the origin of the search
+  std::vector< int > parentEdges;
+  std::vector< unsigned int > stamps;
+  //! position of each vertex in the heap, -1 if it is not queued
+  std::vector< int > heapPositions;
+  std::vector< HeapEntry > heap;
+  unsigned int stamp = 0;
+  quint64 order = 0;
+};
+
+///@endcond
+
+QgsShortestPathEngine::QgsShortestPathEngine( const QgsCompactGraph *graph, int strategy )
+  : mGraph( graph )
+  , mStrategy( strategy )
+  , mForward( new SearchSpace( graph->vertexCount() ) )
+{
+}
+
+QgsShortestPathEngine::~QgsShortestPathEngine() = default;
+
+void QgsShortestPathEngine::shortestPathTree( int startVertex, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  SearchSpace &search = *mForward;
+  search.reset();
+  search.update( startVertex, 0.0, -1 );
+
+  if ( mStrategy >= 0 && mStrategy < mGraph->strategyCount() )
+  {
+    const double *costs = mGraph->costs( mStrategy );
+    while ( !search.isEmpty() )
+    {
+      const int vertex = search.pop();
+      const double vertexCost = search.costs[ vertex ];
+      const int end = mGraph->outEdgesEnd( vertex );
+      for ( int edge = mGraph->outEdgesBegin( vertex ); edge < end; ++edge )
+      {
+        search.update( mGraph->edgeTarget( edge ), costs[ edge ] + vertexCost, edge );
+      }
+    }
+  }
+
+  const int vertexCount = mGraph->vertexCount();
+  if ( resultTree )
+  {
+    resultTree->fill( -1, vertexCount );
+    for ( int vertex = 0; vertex < vertexCount; ++vertex )
+    {
+      if ( search.isReached( vertex ) && search.parentEdges[ vertex ] >= 0 )
+        ( *resultTree )[ vertex ] = mGraph->sourceEdgeId( search.parentEdges[ vertex ] );
+    }
+  }
+  if ( resultCost )
+  {
+    resultCost->resize( vertexCount );
+    for ( int vertex = 0; vertex < vertexCount; ++vertex )
+      ( *resultCost )[ vertex ] = search.cost( vertex );
+  }
+}
+
+double QgsShortestPathEngine::shortestPath( int startVertex, int endVertex, QVector<int> *path )
+{
+  if ( path )
+    path->clear();
+  if ( startVertex == endVertex )
+    return 0.0;
+  if ( mStrategy < 0 || mStrategy >= mGraph->strategyCount() )
+    return std::numeric_limits<double>::infinity();
+
+  // only point to point queries search backwards
+  if ( !mBackward )
+    mBackward.reset( new SearchSpace( mGraph->vertexCount() ) );
+
+  const double *costs = mGraph->costs( mStrategy );
+  SearchSpace &forward = *mForward;
+  SearchSpace &backward = *mBackward;
+  forward.reset();
+  backward.reset();
+  forward.update( startVertex, 0.0, -1 );
+  backward.update( endVertex, 0.0, -1 );
+
+  // the searches alternate from both ends, each time extending the one with the
+  // closest frontier, until no path through the frontiers can beat the best one found
+  double bestCost = std::numeric_limits<double>::infinity();
+  int meetingVertex = -1;
+  while ( !forward.isEmpty() && !backward.isEmpty() )
+  {
+    if ( forward.minimumCost() + backward.minimumCost() >= bestCost )
+      break;
+
+    if ( forward.minimumCost() <= backward.minimumCost() )
+    {
+      const int vertex = forward.pop();
+      const double vertexCost = forward.costs[ vertex ];
+      const int end = mGraph->outEdgesEnd( vertex );
+      for ( int edge = mGraph->outEdgesBegin( vertex ); edge < end; ++edge )
+      {
+        const int target = mGraph->edgeTarget( edge );
+        const double cost = costs[ edge ] + vertexCost;
+        if ( forward.update( target, cost, edge ) && cost + backward.cost( target ) < bestCost )
+        {
+          bestCost = cost + backward.cost( target );
+          meetingVertex = target;
+        }
+      }
+    }
+    else
+    {
+      const int vertex = backward.pop();
+      const double vertexCost = backward.costs[ vertex ];
+      const int end = mGraph->inEdgesEnd( vertex );
+      for ( int position = mGraph->inEdgesBegin( vertex ); position < end; ++position )
+      {
+        const int edge = mGraph->inEdge( position );
+        const int source = mGraph->edgeSource( edge );
+        const double cost = costs[ edge ] + vertexCost;
+        if ( backward.update( source, cost, edge ) && cost + forward.cost( source ) < bestCost )
+        {
+          bestCost = cost + forward.cost( source );
+          meetingVertex = source;
+        }
+      }
+    }
+  }
+
+  if ( path && meetingVertex >= 0 )
+  {
+    for ( int vertex = meetingVertex; forward.parentEdges[ vertex ] >= 0; )
+    {
+      const int edge = forward.parentEdges[ vertex ];
+      path->append( mGraph->sourceEdgeId( edge ) );
+      vertex = mGraph->edgeSource( edge );
+    }
+    std::reverse( path->begin(), path->end() );
+    for ( int vertex = meetingVertex; backward.parentEdges[ vertex ] >= 0; )
+    {
+      const int edge = backward.parentEdges[ vertex ];
+      path->append( mGraph->sourceEdgeId( edge ) );
+      vertex = mGraph->edgeTarget( edge );
+    }
+  }
+  return bestCost;
+}
+
+QVector<double> QgsShortestPathEngine::costsToVertices( int startVertex, const QVector<int> &targets )
+{
+  QVector<double> result( targets.size(), std::numeric_limits<double>::infinity() );
+  if ( targets.isEmpty() )
+    return result;
+
+  if ( mTargetMarks.size() != static_cast< std::size_t >( mGraph->vertexCount() ) )
+  {
+    mTargetMarks.assign( mGraph->vertexCount(), 0 );
+    mTargetMark = 0;
+  }
+  if ( ++mTargetMark == 0 )
+  {
+    std::fill( mTargetMarks.begin(), mTargetMarks.end(), 0 );
+    mTargetMark = 1;
+  }
+  int remainingTargets = 0;
+  for ( int target : targets )
+  {
+    if ( mTargetMarks[ target ] != mTargetMark )
+    {
+      mTargetMarks[ target ] = mTargetMark;
+      ++remainingTargets;
+    }
+  }
+
+  SearchSpace &search = *mForward;
+  search.reset();
+  search.update( startVertex, 0.0, -1 );
+
+  if ( mStrategy >= 0 && mStrategy < mGraph->strategyCount() )
+  {
+    const double *costs = mGraph->costs( mStrategy );
+    while ( !search.isEmpty() )
+    {
+      const int vertex = search.pop();
+      if ( mTargetMarks[ vertex ] == mTargetMark && --remainingTargets == 0 )
+        break;
+
+      const double vertexCost = search.costs[ vertex ];
+      const int end = mGraph->outEdgesEnd( vertex );
+      for ( int edge = mGraph->outEdgesBegin( vertex ); edge < end; ++edge )
+      {
+        search.update( mGraph->edgeTarget( edge ), costs[ edge ] + vertexCost, edge );
+      }
+    }
+  }
+
+  // once the search stopped, the costs of all reached targets are final
+  for ( int i = 0; i < targets.size(); ++i )
+    result[ i ] = search.cost( targets.at( i ) );
+  return result;
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+  qgsshortestpathengine.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSHORTESTPATHENGINE_H
+#define QGSSHORTESTPATHENGINE_H
+
+#include <QVector>
+#include <memory>
+#include <vector>
+
+#include "qgis.h"
+#include "qgis_analysis.h"
+
+class QgsCompactGraph;
+
+/**
+ * \ingroup analysis
+ * \class QgsShortestPathEngine
+ * \brief Answers shortest path queries on a QgsCompactGraph with Dijkstra's algorithm.
+ *
+ * The candidate vertices are kept in an indexed 4-ary heap, and the search state
+ * is allocated once and reused by the following queries, so that a query only touches
+ * the vertices it reaches. Point to point queries search from both ends at once and
+ * stop as soon as the shortest path is known, one to many queries stop once all
+ * targets are reached.
+ *
+ * An engine must only be used by one thread at a time, but any number of engines
+ * can share the same graph. The graph must outlive the engine. Edge costs must not
+ * be negative.
+ *
+ * \since QGIS 3.0
+ */
+class ANALYSIS_EXPORT QgsShortestPathEngine
+{
+  public:
+
+    /**
+     * Constructor for an engine searching \a graph, optimizing the costs
+     * of the strategy with index \a strategy.
+     */
+    QgsShortestPathEngine( const QgsCompactGraph *graph SIP_KEEPREFERENCE, int strategy = 0 );
+
+    ~QgsShortestPathEngine();
+
+    //! QgsShortestPathEngine cannot be copied
+    QgsShortestPathEngine( const QgsShortestPathEngine &rh ) = delete;
+    //! QgsShortestPathEngine cannot be copied
+    QgsShortestPathEngine &operator=( const QgsShortestPathEngine &rh ) = delete;
+
+    //! Returns the graph searched by the engine
+    const QgsCompactGraph *graph() const { return mGraph; }
+
+    //! Returns the index of the strategy whose costs are optimized
+    int strategy() const { return mStrategy; }
+
+    /**
+     * Computes the shortest paths from \a startVertex to all vertices of the graph.
+     *
+     * The results are the same as QgsGraphAnalyzer::dijkstra() with the source graph:
+     * \a resultTree receives the index in the source QgsGraph of the edge entering each
+     * vertex on its shortest path, or -1 for the start vertex and unreachable vertices,
+     * and \a resultCost receives the cost of the paths, infinity for unreachable vertices.
+     */
+    void shortestPathTree( int startVertex, QVector<int> *resultTree SIP_OUT = nullptr, QVector<double> *resultCost SIP_OUT = nullptr );
+
+    /**
+     * Returns the cost of the shortest path from \a startVertex to \a endVertex,
+     * or infinity if \a endVertex cannot be reached.
+     *
+     * If \a path is set, it receives the indices in the source QgsGraph of the edges
+     * of the path, in order from the start vertex.
+     */
+    double shortestPath( int startVertex, int endVertex, QVector<int> *path SIP_OUT = nullptr );
+
+    /**
+     * Returns the costs of the shortest paths from \a startVertex to each of the
+     * \a targets, infinity for unreachable targets.
+     *
+     * The search stops as soon as the costs of all targets are known.
+     */
+    QVector<double> costsToVertices( int startVertex, const QVector<int> &targets );
+
+  private:
+#ifdef SIP_RUN
+    QgsShortestPathEngine( const QgsShortestPathEngine &rh );
+#endif
+
+    struct SearchSpace;
+
+    const QgsCompactGraph *mGraph = nullptr;
+    int mStrategy = 0;
+    std::unique_ptr< SearchSpace > mForward;
+    std::unique_ptr< SearchSpace > mBackward;
+    //! marks the targets of the current one to many query
+    std::vector< unsigned int > mTargetMarks;
+    unsigned int mTargetMark = 0;
+};
+
+#endif // QGSSHORTESTPATHENGINE_H
@@ -29,6 +29,9 @@
 #include "qgsdistancearea.h"
 #include "qgswkbtypes.h"
 
+#include "qgsspatialindex.h"
+
+#include <QHash>
 #include <QString>
 #include <QtAlgorithms>
 
@@ -54,37 +57,21 @@ class QgsPointCompare
       return tx1 < tx2;
     }
 
-  private:
-    double mTolerance;
-};
-
-template <typename RandIter, typename Type, typename CompareOp > RandIter my_binary_search( RandIter begin, RandIter end, Type val, CompareOp comp )
-{
-  // result if not found
-  RandIter not_found = end;
-
-  while ( true )
-  {
-    RandIter avg = begin + ( end - begin ) / 2;
-    if ( begin == avg || end == avg )
+    /**
+     * Returns the tolerance cell of a point. Points are equivalent for the comparison
+     * if and only if they are in the same cell.
+     */
+    QPair< double, double > cell( const QgsPointXY &p ) const
     {
-      if ( !comp( *begin, val ) && !comp( val, *begin ) )
-        return begin;
-      if ( !comp( *end, val ) && !comp( val, *end ) )
-        return end;
+      if ( mTolerance <= 0 )
+        return qMakePair( p.x(), p.y() );
 
-      return not_found;
+      return qMakePair( std::ceil( p.x() / mTolerance ), std::ceil( p.y() / mTolerance ) );
     }
-    if ( comp( val, *avg ) )
-      end = avg;
-    else if ( comp( *avg, val ) )
-      begin = avg;
-    else
-      return avg;
-  }
 
-  return not_found;
-}
+  private:
+    double mTolerance;
+};
 
 struct TiePointInfo
 {
@@ -102,6 +89,87 @@ bool TiePointInfoCompare( const TiePointInfo &a, const TiePointInfo &b )
   return a.mFirstPoint.x() == b.mFirstPoint.x() ? a.mFirstPoint.y() < b.mFirstPoint.y() : a.mFirstPoint.x() < b.mFirstPoint.x();
 }
 
+/** \ingroup analysis
+ * \class QgsTiePointIndex
+ * Spatial index of the additional points, used to find the points a segment may be tied to.
+ *
+ * Each point is indexed by a square around it, which holds every segment closer to the
+ * point than the segment it is currently tied to. Until every point is tied to a segment,
+ * all the points are candidates.
+ */
+class QgsTiePointIndex
+{
+  public:
+    explicit QgsTiePointIndex( const QVector< QgsPointXY > &points )
+      : mPoints( points )
+      , mLengths( points.size(), std::numeric_limits<double>::infinity() )
+      , mRects( points.size() )
+    {  }
+
+    //! Returns the indices of the points which may be closer to the segment pt1 - pt2 than to their tied segment
+    QList< QgsFeatureId > candidates( const QgsPointXY &pt1, const QgsPointXY &pt2 ) const
+    {
+      if ( !mIndexed )
+      {
+        QList< QgsFeatureId > all;
+        all.reserve( mPoints.size() );
+        for ( int i = 0; i < mPoints.size(); ++i )
+          all << i;
+        return all;
+      }
+      return mIndex.intersects( QgsRectangle( pt1, pt2 ) );
+    }
+
+    //! Sets the squared distance from the point with index i to the segment it is tied to
+    void setTieLength( int i, double sqrLength )
+    {
+      if ( std::isinf( mLengths[ i ] ) )
+      {
+        ++mTiedCount;
+      }
+      else if ( mIndexed && mLengths[ i ] > 0 )
+      {
+        QgsFeature f( i );
+        f.setGeometry( QgsGeometry::fromRect( mRects[ i ] ) );
+        mIndex.deleteFeature( f );
+      }
+
+      mLengths[ i ] = sqrLength;
+      // sqrDistToSegment() rounds squared distances below DEFAULT_SEGMENT_EPSILON to 0,
+      // and the square is slightly enlarged against rounding errors
+      const QgsPointXY &p = mPoints.at( i );
+      const double radius = std::sqrt( std::max( sqrLength, DEFAULT_SEGMENT_EPSILON ) ) * ( 1 + 1e-9 )
+                            + 1e-9 * ( std::fabs( p.x() ) + std::fabs( p.y() ) );
+      mRects[ i ] = QgsRectangle( p.x() - radius, p.y() - radius, p.x() + radius, p.y() + radius );
+
+      if ( !mIndexed )
+      {
+        if ( mTiedCount == mPoints.size() )
+        {
+          for ( int j = 0; j < mPoints.size(); ++j )
+          {
+            if ( mLengths[ j ] > 0 )
+              mIndex.insertFeature( j, mRects[ j ] );
+          }
+          mIndexed = true;
+        }
+      }
+      // a point lying on its tied segment cannot be tied any closer
+      else if ( sqrLength > 0 )
+      {
+        mIndex.insertFeature( i, mRects[ i ] );
+      }
+    }
+
+  private:
+    const QVector< QgsPointXY > &mPoints;
+    QVector< double > mLengths;
+    QVector< QgsRectangle > mRects;
+    QgsSpatialIndex mIndex;
+    int mTiedCount = 0;
+    bool mIndexed = false;
+};
+
 QgsVectorLayerDirector::QgsVectorLayerDirector( QgsFeatureSource *source,
     int directionFieldId,
     const QString &directDirectionValue,
@@ -146,10 +214,25 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
   tmpInfo.mLength = std::numeric_limits<double>::infinity();
 
   QVector< TiePointInfo > pointLengthMap( additionalPoints.size(), tmpInfo );
-  QVector< TiePointInfo >::iterator pointLengthIt;
+  QgsTiePointIndex tiePointIndex( additionalPoints );
 
-  //Graph's points;
+  QgsPointCompare pointCompare( builder->topologyTolerance() );
+
+  //Graph's points, one for each tolerance cell, and the index of the point of each cell.
+  //With a topology tolerance, every point of a cell is merged into the first point added
+  //to it: lines ending in the same cell are connected, and tie points are snapped to the
+  //vertex of their cell. Close points in neighboring cells stay apart.
   QVector< QgsPointXY > points;
+  QHash< QPair< double, double >, int > pointIndices;
+  auto addPoint = [&points, &pointIndices, &pointCompare]( const QgsPointXY & point )
+  {
+    const QPair< double, double > cell = pointCompare.cell( point );
+    if ( !pointIndices.contains( cell ) )
+    {
+      pointIndices.insert( cell, points.size() );
+      points.push_back( point );
+    }
+  };
 
   QgsFeatureIterator fit = mSource->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) );
 
@@ -178,13 +261,14 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
       for ( pointIt = mplIt->begin(); pointIt != mplIt->end(); ++pointIt )
       {
         pt2 = ct.transform( *pointIt );
-        points.push_back( pt2 );
+        addPoint( pt2 );
 
-        if ( !isFirstPoint )
+        if ( !isFirstPoint && !additionalPoints.isEmpty() )
         {
-          int i = 0;
-          for ( i = 0; i != additionalPoints.size(); ++i )
+          const QList< QgsFeatureId > candidates = tiePointIndex.candidates( pt1, pt2 );
+          for ( QgsFeatureId candidate : candidates )
           {
+            const int i = static_cast< int >( candidate );
             TiePointInfo info;
             if ( pt1 == pt2 )
             {
@@ -199,12 +283,12 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
 
             if ( pointLengthMap[ i ].mLength > info.mLength )
             {
-              Q_UNUSED( info.mTiedPoint );
               info.mFirstPoint = pt1;
               info.mLastPoint = pt2;
 
               pointLengthMap[ i ] = info;
               snappedPoints[ i ] = info.mTiedPoint;
+              tiePointIndex.setTieLength( i, info.mLength );
             }
           }
         }
@@ -226,21 +310,24 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
   {
     if ( snappedPoints[ i ] != QgsPointXY( 0.0, 0.0 ) )
     {
-      points.push_back( snappedPoints [ i ] );
+      addPoint( snappedPoints [ i ] );
     }
   }
 
-  QgsPointCompare pointCompare( builder->topologyTolerance() );
-
+  // vertices are numbered in the order of their cells
   std::sort( points.begin(), points.end(), pointCompare );
-  QVector< QgsPointXY >::iterator tmp = std::unique( points.begin(), points.end() );
-  points.resize( tmp - points.begin() );
-
   for ( i = 0; i < points.size(); ++i )
+  {
+    pointIndices[ pointCompare.cell( points[ i ] )] = i;
     builder->addVertex( i, points[ i ] );
+  }
 
   for ( i = 0; i < snappedPoints.size() ; ++i )
-    snappedPoints[ i ] = *( my_binary_search( points.begin(), points.end(), snappedPoints[ i ], pointCompare ) );
+  {
+    QHash< QPair< double, double >, int >::const_iterator indexIt = pointIndices.constFind( pointCompare.cell( snappedPoints[ i ] ) );
+    if ( indexIt != pointIndices.constEnd() )
+      snappedPoints[ i ] = points[ indexIt.value()];
+  }
 
   std::sort( pointLengthMap.begin(), pointLengthMap.end(), TiePointInfoCompare );
 
@@ -329,23 +416,15 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
           pointsOnArc[ 0.0 ] = pt1;
           pointsOnArc[ pt1.sqrDist( pt2 )] = pt2;
 
-          TiePointInfo t;
-          t.mFirstPoint = pt1;
-          t.mLastPoint  = pt2;
-          t.mLength = 0.0;
-          pointLengthIt = my_binary_search( pointLengthMap.begin(), pointLengthMap.end(), t, TiePointInfoCompare );
-
-          if ( pointLengthIt != pointLengthMap.end() )
+          if ( !pointLengthMap.isEmpty() )
           {
-            QVector< TiePointInfo >::iterator it;
-            for ( it = pointLengthIt; it - pointLengthMap.begin() >= 0; --it )
-            {
-              if ( it->mFirstPoint == pt1 && it->mLastPoint == pt2 )
-              {
-                pointsOnArc[ pt1.sqrDist( it->mTiedPoint )] = it->mTiedPoint;
-              }
-            }
-            for ( it = pointLengthIt + 1; it != pointLengthMap.end(); ++it )
+            TiePointInfo t;
+            t.mFirstPoint = pt1;
+            t.mLastPoint  = pt2;
+            t.mLength = 0.0;
+            const std::pair< QVector< TiePointInfo >::const_iterator, QVector< TiePointInfo >::const_iterator > tiedRange =
+              std::equal_range( pointLengthMap.constBegin(), pointLengthMap.constEnd(), t, TiePointInfoCompare );
+            for ( QVector< TiePointInfo >::const_iterator it = tiedRange.first; it != tiedRange.second; ++it )
             {
               if ( it->mFirstPoint == pt1 && it->mLastPoint == pt2 )
               {
@@ -361,10 +440,8 @@ void QgsVectorLayerDirector::makeGraph( QgsGraphBuilderInterface *builder, const
           bool isFirstPoint = true;
           for ( pointsIt = pointsOnArc.begin(); pointsIt != pointsOnArc.end(); ++pointsIt )
           {
-            pt2 = *pointsIt;
-            tmp = my_binary_search( points.begin(), points.end(), pt2, pointCompare );
-            pt2 = *tmp;
-            pt2idx = tmp - points.begin();
+            pt2idx = pointIndices.value( pointCompare.cell( *pointsIt ) );
+            pt2 = points[ pt2idx ];
 
             if ( !isFirstPoint && pt1 != pt2 )
             {
@@ -18,8 +18,37 @@
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
 
+#include <QAtomicInt>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
 #define NO_DATA -9999
 
+///@cond PRIVATE
+
+// Number of rows and columns of the tiles the surface is accumulated in
+static const int TILE_SIZE = 256;
+
+// Maximum number of tiles held in memory, i.e. 512 MB of cells
+static const int MAX_TILES_IN_MEMORY = 2048;
+
+// Number of points whose kernels are added to the tiles at once
+static const size_t POINT_BATCH_SIZE = 65536;
+
+// A tile of cells of the surface
+struct QgsKernelDensityEstimation::Tile
+{
+  int firstRow = 0;
+  int firstColumn = 0;
+  int rows = 0;
+  int columns = 0;
+  std::vector< float > values;
+};
+
+///@endcond
+
 QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEstimation::Parameters &parameters, const QString &outputFile, const QString &outputFormat )
   : mSource( parameters.source )
   , mOutputFile( outputFile )
@@ -34,6 +63,7 @@ QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEs
   , mBufferSize( -1 )
   , mDatasetH( nullptr )
   , mRasterBandH( nullptr )
+  , mThreadCount( QThread::idealThreadCount() )
 {
   if ( !parameters.radiusField.isEmpty() )
     mRadiusField = mSource->fields().lookupField( parameters.radiusField );
@@ -41,6 +71,8 @@ QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEs
     mWeightField = mSource->fields().lookupField( parameters.weightField );
 }
 
+QgsKernelDensityEstimation::~QgsKernelDensityEstimation() = default;
+
 QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::run()
 {
   Result result = prepare();
@@ -89,6 +121,16 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::prepare()
   if ( !createEmptyLayer( driver, mBounds, rows, cols ) )
     return FileCreationError;
 
+  mRows = rows;
+  mColumns = cols;
+  mTileRows = ( rows + TILE_SIZE - 1 ) / TILE_SIZE;
+  mTileColumns = ( cols + TILE_SIZE - 1 ) / TILE_SIZE;
+  mTiles.clear();
+  mTiles.resize( static_cast< size_t >( mTileRows ) * mTileColumns );
+  mTilesWritten.assign( mTiles.size(), false );
+  mTilesInMemory = 0;
+  mPendingPoints.clear();
+
   // open the raster in GA_Update mode
   mDatasetH = GDALOpen( mOutputFile.toUtf8().constData(), GA_Update );
   if ( !mDatasetH )
@@ -156,61 +198,196 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
       continue;
     }
 
-    // calculate the pixel position
-    unsigned int xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
-
+    KernelPoint point;
+    point.x = ( *pointIt ).x();
+    point.y = ( *pointIt ).y();
+    point.radius = radius;
+    point.weight = weight;
+    point.blockSize = blockSize;
 
-    // get the data
-    float *dataBuffer = ( float * ) CPLMalloc( sizeof( float ) * blockSize * blockSize );
-    if ( GDALRasterIO( mRasterBandH, GF_Read, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
+    // calculate the pixel position
+    point.xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
+    point.yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
+    point.yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
+
+    // the block of cells must be inside the raster
+    if ( blockSize <= 0
+         || static_cast< qint64 >( point.xPosition ) + blockSize > mColumns
+         || static_cast< qint64 >( point.yPositionIO ) + blockSize > mRows )
     {
       result = RasterIoError;
+      continue;
     }
 
-    for ( int xp = 0; xp < blockSize; xp++ )
+    // kernels are added to the tiles in batches of points
+    mPendingPoints.push_back( point );
+  }
+
+  if ( mPendingPoints.size() >= POINT_BATCH_SIZE )
+  {
+    Result batchResult = addPendingPoints();
+    if ( batchResult != Success )
+      result = batchResult;
+  }
+
+  return result;
+}
+
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
+{
+  Result result = addPendingPoints();
+  Result writeResult = writeTiles();
+  if ( result == Success )
+    result = writeResult;
+
+  GDALClose( ( GDALDatasetH ) mDatasetH );
+  mDatasetH = nullptr;
+  mRasterBandH = nullptr;
+  return result;
+}
+
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addPendingPoints()
+{
+  if ( mPendingPoints.empty() )
+    return Success;
+
+  // list the points by the tiles their blocks overlap, in the order they were added
+  std::vector< std::vector< int > > tilePoints( mTiles.size() );
+  std::vector< int > touchedTiles;
+  for ( int k = 0; k < static_cast< int >( mPendingPoints.size() ); ++k )
+  {
+    const KernelPoint &point = mPendingPoints[k];
+    const int firstTileRow = point.yPositionIO / TILE_SIZE;
+    const int lastTileRow = ( point.yPositionIO + point.blockSize - 1 ) / TILE_SIZE;
+    const int firstTileColumn = point.xPosition / TILE_SIZE;
+    const int lastTileColumn = ( point.xPosition + point.blockSize - 1 ) / TILE_SIZE;
+    for ( int tileRow = firstTileRow; tileRow <= lastTileRow; ++tileRow )
     {
-      for ( int yp = 0; yp < blockSize; yp++ )
+      for ( int tileColumn = firstTileColumn; tileColumn <= lastTileColumn; ++tileColumn )
       {
-        double pixelCentroidX = ( xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
-        double pixelCentroidY = ( yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
-
-        double distance = std::sqrt( std::pow( pixelCentroidX - ( *pointIt ).x(), 2.0 ) + std::pow( pixelCentroidY - ( *pointIt ).y(), 2.0 ) );
-
-        // is pixel outside search bandwidth of feature?
-        if ( distance > radius )
-        {
-          continue;
-        }
-
-        double pixelValue = weight * calculateKernelValue( distance, radius, mShape, mOutputValues );
-        int pos = xp + blockSize * yp;
-        if ( dataBuffer[ pos ] == NO_DATA )
-        {
-          dataBuffer[ pos ] = 0;
-        }
-        dataBuffer[ pos ] += pixelValue;
+        const int index = tileRow * mTileColumns + tileColumn;
+        if ( tilePoints[index].empty() )
+          touchedTiles.push_back( index );
+        tilePoints[index].push_back( k );
       }
     }
-    if ( GDALRasterIO( mRasterBandH, GF_Write, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
+  }
+
+  // tiles are only read from the output raster by this thread
+  Result result = Success;
+  for ( int index : touchedTiles )
+  {
+    if ( mTiles[index] )
+      continue;
+
+    std::unique_ptr< Tile > tile( new Tile() );
+    tile->firstRow = index / mTileColumns * TILE_SIZE;
+    tile->firstColumn = index % mTileColumns * TILE_SIZE;
+    tile->rows = std::min( TILE_SIZE, mRows - tile->firstRow );
+    tile->columns = std::min( TILE_SIZE, mColumns - tile->firstColumn );
+    tile->values.assign( static_cast< size_t >( tile->rows ) * tile->columns, NO_DATA );
+    if ( mTilesWritten[index]
+         && GDALRasterIO( mRasterBandH, GF_Read, tile->firstColumn, tile->firstRow, tile->columns, tile->rows,
+                          tile->values.data(), tile->columns, tile->rows, GDT_Float32, 0, 0 ) != CE_None )
     {
       result = RasterIoError;
     }
-    CPLFree( dataBuffer );
+    mTiles[index] = std::move( tile );
+    ++mTilesInMemory;
   }
 
+  // each tile is computed by a single thread, which adds the kernels to its cells in the order of the points
+  QAtomicInt nextTile( 0 );
+  auto processTiles = [this, &nextTile, &touchedTiles, &tilePoints]()
+  {
+    int i;
+    while ( ( i = nextTile.fetchAndAddRelaxed( 1 ) ) < static_cast< int >( touchedTiles.size() ) )
+    {
+      const int index = touchedTiles[i];
+      Tile &tile = *mTiles[index];
+      for ( int k : tilePoints[index] )
+      {
+        addKernelToTile( mPendingPoints[k], tile );
+      }
+    }
+  };
+
+  const int threadCount = std::min( std::max( 1, mThreadCount ), static_cast< int >( touchedTiles.size() ) );
+  QList< QFuture< void > > futures;
+  for ( int thread = 1; thread < threadCount; ++thread )
+  {
+    futures << QtConcurrent::run( processTiles );
+  }
+  processTiles();
+  for ( QFuture< void > &future : futures )
+  {
+    future.waitForFinished();
+  }
+
+  mPendingPoints.clear();
+
+  if ( mTilesInMemory > MAX_TILES_IN_MEMORY )
+  {
+    Result writeResult = writeTiles();
+    if ( writeResult != Success )
+      result = writeResult;
+  }
   return result;
 }
 
-QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
+void QgsKernelDensityEstimation::addKernelToTile( const KernelPoint &point, Tile &tile ) const
 {
-  GDALClose( ( GDALDatasetH ) mDatasetH );
-  mDatasetH = nullptr;
-  mRasterBandH = nullptr;
-  return Success;
+  // part of the block of the point inside the tile
+  const int firstXp = std::max( 0, tile.firstColumn - static_cast< int >( point.xPosition ) );
+  const int endXp = std::min( point.blockSize, tile.firstColumn + tile.columns - static_cast< int >( point.xPosition ) );
+  const int firstYp = std::max( 0, tile.firstRow - static_cast< int >( point.yPositionIO ) );
+  const int endYp = std::min( point.blockSize, tile.firstRow + tile.rows - static_cast< int >( point.yPositionIO ) );
+
+  for ( int xp = firstXp; xp < endXp; xp++ )
+  {
+    for ( int yp = firstYp; yp < endYp; yp++ )
+    {
+      double pixelCentroidX = ( point.xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
+      double pixelCentroidY = ( point.yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
+
+      double distance = std::sqrt( std::pow( pixelCentroidX - point.x, 2.0 ) + std::pow( pixelCentroidY - point.y, 2.0 ) );
+
+      // is pixel outside search bandwidth of feature?
+      if ( distance > point.radius )
+      {
+        continue;
+      }
+
+      double pixelValue = point.weight * calculateKernelValue( distance, point.radius, mShape, mOutputValues );
+      float &cell = tile.values[ static_cast< size_t >( point.yPositionIO + yp - tile.firstRow ) * tile.columns + ( point.xPosition + xp - tile.firstColumn )];
+      if ( cell == NO_DATA )
+      {
+        cell = 0;
+      }
+      cell += pixelValue;
+    }
+  }
+}
+
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::writeTiles()
+{
+  Result result = Success;
+  for ( size_t index = 0; index < mTiles.size(); ++index )
+  {
+    std::unique_ptr< Tile > &tile = mTiles[index];
+    if ( !tile )
+      continue;
+
+    if ( GDALRasterIO( mRasterBandH, GF_Write, tile->firstColumn, tile->firstRow, tile->columns, tile->rows,
+                       tile->values.data(), tile->columns, tile->rows, GDT_Float32, 0, 0 ) != CE_None )
+    {
+      result = RasterIoError;
+    }
+    mTilesWritten[index] = true;
+    tile.reset();
+  }
+  mTilesInMemory = 0;
+  return result;
 }
 
 int QgsKernelDensityEstimation::radiusSizeInPixels( double radius ) const
@@ -19,6 +19,9 @@
 #include "qgsrectangle.h"
 #include <QString>
 
+#include <memory>
+#include <vector>
+
 // GDAL includes
 #include <gdal.h>
 #include <cpl_string.h>
@@ -33,6 +36,12 @@ class QgsFeature;
  * \class QgsKernelDensityEstimation
  * \ingroup analysis
  * Performs Kernel Density Estimation ("heatmap") calculations on a vector layer.
+ *
+ * The surface is accumulated in memory, in tiles which are only written to the output file
+ * by finalise() (or when they exceed the memory budget). Points are added in batches, whose
+ * kernels are computed concurrently for different tiles (see setThreadCount()). The kernels
+ * of the points are still added to each cell in the order of the points, so that the output
+ * does not depend on the number of threads.
  * \since QGIS 3.0
  */
 class ANALYSIS_EXPORT QgsKernelDensityEstimation
@@ -99,6 +108,26 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
      * to generate the surface. The output path and file format are also required.
      */
     QgsKernelDensityEstimation( const Parameters &parameters, const QString &outputFile, const QString &outputFormat );
+    ~QgsKernelDensityEstimation();
+
+    //! QgsKernelDensityEstimation cannot be copied
+    QgsKernelDensityEstimation( const QgsKernelDensityEstimation &rh ) = delete;
+    //! QgsKernelDensityEstimation cannot be copied
+    QgsKernelDensityEstimation &operator=( const QgsKernelDensityEstimation &rh ) = delete;
+
+    /**
+     * Sets the number of threads adding the kernels of points to the surface tiles concurrently.
+     * By default, the ideal thread count of the system is used. Set \a count to 1 to add the
+     * kernels from the calling thread only.
+     * \see threadCount()
+     */
+    void setThreadCount( int count ) { mThreadCount = count; }
+
+    /**
+     * Returns the number of threads adding the kernels of points to the surface tiles concurrently.
+     * \see setThreadCount()
+     */
+    int threadCount() const { return mThreadCount; }
 
     /**
      * Runs the KDE calculation across the whole layer at once. Either call this method, or manually
@@ -130,6 +159,34 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
   private:
 
+    //! A point whose kernel is added to the surface, with the block of cells it covers
+    struct KernelPoint
+    {
+      double x;
+      double y;
+      double radius;
+      double weight;
+      //! Number of rows and columns of the block of cells
+      int blockSize;
+      //! Column of the first cell of the block
+      unsigned int xPosition;
+      //! Row of the first cell of the block, counted from the bottom of the raster
+      unsigned int yPosition;
+      //! Row of the first cell of the block, counted from the top of the raster
+      unsigned int yPositionIO;
+    };
+
+    struct Tile;
+
+    //! Adds the kernels of the pending points to the tiles of the surface
+    Result addPendingPoints();
+
+    //! Adds the kernel of \a point to the cells of \a tile
+    void addKernelToTile( const KernelPoint &point, Tile &tile ) const;
+
+    //! Writes the tiles held in memory to the output raster and releases them
+    Result writeTiles();
+
     //! Calculate the value given to a point width a given distance for a specified kernel shape
     double calculateKernelValue( const double distance, const double bandwidth, const KernelShape shape, const OutputValues outputType ) const;
     //! Uniform kernel function
@@ -165,6 +222,20 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
     GDALDatasetH mDatasetH;
     GDALRasterBandH mRasterBandH;
 
+    int mRows = 0;
+    int mColumns = 0;
+    int mTileRows = 0;
+    int mTileColumns = 0;
+    //! Tiles of the surface held in memory, by tile index
+    std::vector< std::unique_ptr< Tile > > mTiles;
+    //! Whether the tiles were written to the output raster, and must be read again if they are needed
+    std::vector< bool > mTilesWritten;
+    int mTilesInMemory = 0;
+    //! Points whose kernels still have to be added to the tiles
+    std::vector< KernelPoint > mPendingPoints;
+    //! Number of threads adding kernels to tiles concurrently
+    int mThreadCount = 1;
+
     //! Creates a new raster layer and initializes it to the no data value
     bool createEmptyLayer( GDALDriverH driver, const QgsRectangle &bounds, int rows, int columns ) const;
     int radiusSizeInPixels( double radius ) const;
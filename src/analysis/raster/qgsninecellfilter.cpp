@@ -20,6 +20,31 @@
 #include "cpl_string.h"
 #include "qgsfeedback.h"
 #include <QFile>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+
+///@cond PRIVATE
+
+// Maximum memory used by the input rows of a band, in bytes
+static const qint64 BAND_MEMORY = 4 * 1024 * 1024;
+
+// A band of output rows, with the input rows needed to compute it
+struct QgsNineCellFilterBand
+{
+  int firstRow = 0;
+  int rows = 0;
+  //! input rows, from the row above the band to the row below it
+  std::vector< float > input;
+  std::vector< float > output;
+  QFuture< void > future;
+};
+
+///@endcond
 
 QgsNineCellFilter::QgsNineCellFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : mInputFile( inputFile )
@@ -30,6 +55,7 @@ QgsNineCellFilter::QgsNineCellFilter( const QString &inputFile, const QString &o
   , mInputNodataValue( -1.0 )
   , mOutputNodataValue( -1.0 )
   , mZFactor( 1.0 )
+  , mThreadCount( QThread::idealThreadCount() )
 {
 
 }
@@ -40,6 +66,7 @@ QgsNineCellFilter::QgsNineCellFilter()
   , mInputNodataValue( -1.0 )
   , mOutputNodataValue( -1.0 )
   , mZFactor( 1.0 )
+  , mThreadCount( QThread::idealThreadCount() )
 {
 }
 
@@ -96,91 +123,97 @@ int QgsNineCellFilter::processRaster( QgsFeedback *feedback )
     return 6;
   }
 
-  //keep only three scanlines in memory at a time
-  float *scanLine1 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float *scanLine2 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float *scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-
-  float *resultLine = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-
-  //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
-  for ( int i = 0; i < ySize; ++i )
+  // Rows are read and written in bands of whole GDAL blocks, which are computed concurrently
+  int blockXSize = 0;
+  int blockYSize = 0;
+  GDALGetBlockSize( rasterBand, &blockXSize, &blockYSize );
+  blockYSize = std::max( 1, blockYSize );
+  const int threadCount = std::max( 1, mThreadCount );
+  // small rasters are still split into several bands for each thread
+  const int memoryRows = std::max( 1, static_cast< int >( BAND_MEMORY / ( static_cast< qint64 >( xSize ) * sizeof( float ) ) ) );
+  const int targetRows = std::min( memoryRows, ( ySize + 4 * threadCount - 1 ) / ( 4 * threadCount ) );
+  const int bandRows = targetRows >= blockYSize ? targetRows / blockYSize * blockYSize : targetRows;
+  // bands are read ahead of the band being written, so that every thread has one to compute
+  const int maxBands = threadCount > 1 ? 2 * threadCount : 1;
+
+  auto processBand = [this, xSize, feedback]( QgsNineCellFilterBand * band )
   {
-    if ( feedback && feedback->isCanceled() )
-    {
-      break;
-    }
-
-    if ( feedback )
+    for ( int row = 0; row < band->rows; ++row )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( i ) / ySize );
-    }
-
-    if ( i == 0 )
-    {
-      //fill scanline 1 with (input) nodata for the values above the first row and feed scanline2 with the first row
-      for ( int a = 0; a < xSize; ++a )
+      if ( feedback && feedback->isCanceled() )
       {
-        scanLine1[a] = mInputNodataValue;
+        return;
       }
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, 0, xSize, 1, scanLine2, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( "Raster IO Error" );
-      }
-    }
-    else
-    {
-      //normally fetch only scanLine3 and release scanline 1 if we move forward one row
-      CPLFree( scanLine1 );
-      scanLine1 = scanLine2;
-      scanLine2 = scanLine3;
-      scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+      float *scanLine = band->input.data() + static_cast< size_t >( row ) * xSize;
+      processRow( scanLine, scanLine + xSize, scanLine + 2 * xSize, band->output.data() + static_cast< size_t >( row ) * xSize, xSize );
     }
+  };
 
-    if ( i == ySize - 1 ) //fill the row below the bottom with nodata values
+  std::deque< std::unique_ptr< QgsNineCellFilterBand > > bands;
+  int nextRow = 0;
+  int writtenRows = 0;
+  while ( writtenRows < ySize )
+  {
+    if ( feedback && feedback->isCanceled() )
     {
-      for ( int a = 0; a < xSize; ++a )
-      {
-        scanLine3[a] = mInputNodataValue;
-      }
+      break;
     }
-    else
+
+    if ( nextRow < ySize && static_cast< int >( bands.size() ) < maxBands )
     {
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, i + 1, xSize, 1, scanLine3, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
+      std::unique_ptr< QgsNineCellFilterBand > band( new QgsNineCellFilterBand() );
+      band->firstRow = nextRow;
+      band->rows = std::min( bandRows, ySize - nextRow );
+      nextRow += band->rows;
+
+      //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
+      band->input.assign( static_cast< size_t >( band->rows + 2 ) * xSize, mInputNodataValue );
+      const int firstInputRow = std::max( 0, band->firstRow - 1 );
+      const int inputRows = std::min( ySize, band->firstRow + band->rows + 1 ) - firstInputRow;
+      float *inputData = band->input.data() + static_cast< size_t >( firstInputRow - band->firstRow + 1 ) * xSize;
+      if ( GDALRasterIO( rasterBand, GF_Read, 0, firstInputRow, xSize, inputRows, inputData, xSize, inputRows, GDT_Float32, 0, 0 ) != CE_None )
       {
         QgsDebugMsg( "Raster IO Error" );
       }
-    }
+      band->output.resize( static_cast< size_t >( band->rows ) * xSize );
 
-    for ( int j = 0; j < xSize; ++j )
-    {
-      if ( j == 0 )
+      if ( threadCount > 1 )
       {
-        resultLine[j] = processNineCellWindow( &mInputNodataValue, &scanLine1[j], &scanLine1[j + 1], &mInputNodataValue, &scanLine2[j],
-                                               &scanLine2[j + 1], &mInputNodataValue, &scanLine3[j], &scanLine3[j + 1] );
-      }
-      else if ( j == xSize - 1 )
-      {
-        resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &mInputNodataValue, &scanLine2[j - 1], &scanLine2[j],
-                                               &mInputNodataValue, &scanLine3[j - 1], &scanLine3[j], &mInputNodataValue );
+        band->future = QtConcurrent::run( processBand, band.get() );
       }
       else
       {
-        resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &scanLine1[j + 1], &scanLine2[j - 1], &scanLine2[j],
-                                               &scanLine2[j + 1], &scanLine3[j - 1], &scanLine3[j], &scanLine3[j + 1] );
+        processBand( band.get() );
       }
+      bands.push_back( std::move( band ) );
+      continue;
     }
 
-    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, i, xSize, 1, resultLine, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
+    //bands are written in order, once they are computed
+    QgsNineCellFilterBand *band = bands.front().get();
+    band->future.waitForFinished();
+    if ( feedback && feedback->isCanceled() )
+    {
+      break;
+    }
+    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, band->firstRow, xSize, band->rows, band->output.data(), xSize, band->rows, GDT_Float32, 0, 0 ) != CE_None )
     {
       QgsDebugMsg( "Raster IO Error" );
     }
+    writtenRows += band->rows;
+    bands.pop_front();
+
+    if ( feedback )
+    {
+      feedback->setProgress( 100.0 * static_cast< double >( writtenRows ) / ySize );
+    }
   }
 
-  CPLFree( resultLine );
-  CPLFree( scanLine1 );
-  CPLFree( scanLine2 );
-  CPLFree( scanLine3 );
+  //bands may still be computed after a cancelation
+  for ( const std::unique_ptr< QgsNineCellFilterBand > &band : bands )
+  {
+    band->future.waitForFinished();
+  }
 
   GDALClose( inputDataset );
 
@@ -279,3 +312,24 @@ GDALDatasetH QgsNineCellFilter::openOutputFile( GDALDatasetH inputDataset, GDALD
   return outputDataset;
 }
 
+void QgsNineCellFilter::processRow( float *scanLine1, float *scanLine2, float *scanLine3, float *resultLine, int xSize )
+{
+  for ( int j = 0; j < xSize; ++j )
+  {
+    if ( j == 0 )
+    {
+      resultLine[j] = processNineCellWindow( &mInputNodataValue, &scanLine1[j], &scanLine1[j + 1], &mInputNodataValue, &scanLine2[j],
+                                             &scanLine2[j + 1], &mInputNodataValue, &scanLine3[j], &scanLine3[j + 1] );
+    }
+    else if ( j == xSize - 1 )
+    {
+      resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &mInputNodataValue, &scanLine2[j - 1], &scanLine2[j],
+                                             &mInputNodataValue, &scanLine3[j - 1], &scanLine3[j], &mInputNodataValue );
+    }
+    else
+    {
+      resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &scanLine1[j + 1], &scanLine2[j - 1], &scanLine2[j],
+                                             &scanLine2[j + 1], &scanLine3[j - 1], &scanLine3[j], &scanLine3[j + 1] );
+    }
+  }
+}
@@ -21,13 +21,17 @@
 #include <QString>
 #include "gdal.h"
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 
 class QgsFeedback;
 
 /** \ingroup analysis
  * Base class for raster analysis methods that work with a 3x3 cell filter and calculate the value of each cell based on
 the cell value and the eight neighbour cells. Common examples are slope and aspect calculation in DEMs. Subclasses only implement
-the method that calculates the new value from the nine values. Everything else (reading file, writing file) is done by this subclass*/
+the method that calculates the new value from the nine values. Everything else (reading file, writing file) is done by this subclass.
+
+The raster is processed in bands of rows, which are computed concurrently by several threads (see setThreadCount()),
+so processNineCellWindow() must not modify the filter.*/
 
 class ANALYSIS_EXPORT QgsNineCellFilter
 {
@@ -39,7 +43,20 @@ class ANALYSIS_EXPORT QgsNineCellFilter
     /** Starts the calculation, reads from mInputFile and stores the result in mOutputFile
       \param feedback feedback object that receives update and that is checked for cancelation.
       \returns 0 in case of success*/
-    int processRaster( QgsFeedback *feedback = nullptr );
+    int processRaster( QgsFeedback *feedback = nullptr ) SIP_RELEASEGIL;
+
+    /** Sets the number of threads computing bands of rows concurrently. By default, the
+     * ideal thread count of the system is used. Set \a count to 1 to process rows one after the other.
+     * \see threadCount()
+     * \since QGIS 3.0
+     */
+    void setThreadCount( int count ) { mThreadCount = count; }
+
+    /** Returns the number of threads computing bands of rows concurrently.
+     * \see setThreadCount()
+     * \since QGIS 3.0
+     */
+    int threadCount() const { return mThreadCount; }
 
     double cellSizeX() const { return mCellSizeX; }
     void setCellSizeX( double size ) { mCellSizeX = size; }
@@ -75,6 +92,10 @@ class ANALYSIS_EXPORT QgsNineCellFilter
       \returns the output dataset or nullptr in case of error*/
     GDALDatasetH openOutputFile( GDALDatasetH inputDataset, GDALDriverH outputDriver );
 
+    /** Calculates the \a xSize output values of a row into \a resultLine, from the rows above (\a scanLine1),
+      at (\a scanLine2) and below (\a scanLine3) it*/
+    void processRow( float *scanLine1, float *scanLine2, float *scanLine3, float *resultLine, int xSize );
+
   protected:
 
     QString mInputFile;
@@ -89,6 +110,8 @@ class ANALYSIS_EXPORT QgsNineCellFilter
     float mOutputNodataValue;
     //! Scale factor for z-value if x-/y- units are different to z-units (111120 for degree->meters and 370400 for degree->feet)
     double mZFactor;
+    //! Number of threads computing bands of rows concurrently
+    int mThreadCount;
 };
 
 #endif // QGSNINECELLFILTER_H
@@ -25,10 +25,275 @@
 #include "qgsfeedback.h"
 
 #include <QFile>
+#include <QThread>
+#include <QtConcurrentRun>
 
 #include <cpl_string.h>
 #include <gdalwarper.h>
 
+#include <algorithm>
+#include <cfloat>
+#include <deque>
+#include <memory>
+#include <vector>
+
+///@cond PRIVATE
+
+// Maximum memory used by the input and output values of a tile, in bytes
+static const qint64 TILE_MEMORY = 32 * 1024 * 1024;
+
+/**
+ * A raster calculator expression compiled into a list of operations on single cells.
+ *
+ * The operations are evaluated one after the other for chunks of cells small enough to stay
+ * in the CPU cache, each writing into its own scratch buffer, so that no matrix is allocated
+ * while evaluating and the values only go through memory once. The results are the same as
+ * those of QgsRasterCalcNode::calculate().
+ */
+class QgsRasterCalcProgram
+{
+  public:
+
+    //! Number of cells evaluated by each operation at once
+    static const int CHUNK_SIZE = 1024;
+
+    /**
+     * Compiles the expression of \a node. The indexes of the rasters it refers to are
+     * looked up in \a rasterRefs. Returns false if the expression cannot be evaluated cell by cell.
+     */
+    bool compile( const QgsRasterCalcNode *node, const QStringList &rasterRefs, double nodataValue )
+    {
+      mInstructions.clear();
+      mNodataValue = nodataValue;
+      mOperators.setNodataValue( nodataValue );
+      return append( node, rasterRefs ) >= 0;
+    }
+
+    /**
+     * Evaluates the expression for \a count cells into \a result. The values of the cells in each
+     * raster are in \a inputs, with the no data value for no data cells.
+     */
+    void evaluate( const std::vector< std::vector< double > > &inputs, qgssize count, float *result ) const
+    {
+      const int instructionCount = static_cast< int >( mInstructions.size() );
+      std::vector< double > scratch( static_cast< size_t >( instructionCount ) * CHUNK_SIZE );
+      std::vector< const double * > values( instructionCount );
+      for ( int k = 0; k < instructionCount; ++k )
+      {
+        if ( mInstructions[k].type == QgsRasterCalcNode::tNumber )
+        {
+          std::fill( scratch.begin() + k * CHUNK_SIZE, scratch.begin() + ( k + 1 ) * CHUNK_SIZE, mInstructions[k].number );
+          values[k] = scratch.data() + k * CHUNK_SIZE;
+        }
+      }
+
+      const double nodata = mNodataValue;
+      for ( qgssize offset = 0; offset < count; offset += CHUNK_SIZE )
+      {
+        const int n = static_cast< int >( std::min( static_cast< qgssize >( CHUNK_SIZE ), count - offset ) );
+        for ( int k = 0; k < instructionCount; ++k )
+        {
+          const Instruction &instruction = mInstructions[k];
+          double *out = scratch.data() + k * CHUNK_SIZE;
+          switch ( instruction.type )
+          {
+            case QgsRasterCalcNode::tRasterRef:
+              values[k] = inputs[instruction.input].data() + offset;
+              break;
+
+            case QgsRasterCalcNode::tOperator:
+            {
+              //operations with nodata values always generate nodata
+              const double *left = values[instruction.left];
+              if ( instruction.right < 0 )
+              {
+                for ( int i = 0; i < n; ++i )
+                  out[i] = left[i] == nodata ? nodata : mOperators.calculateOneArgumentOp( instruction.oneArgOperator, left[i] );
+              }
+              else
+              {
+                const double *right = values[instruction.right];
+                for ( int i = 0; i < n; ++i )
+                  out[i] = left[i] == nodata || right[i] == nodata ? nodata : mOperators.calculateTwoArgumentOp( instruction.twoArgOperator, left[i], right[i] );
+              }
+              values[k] = out;
+              break;
+            }
+
+            default:
+              break;
+          }
+        }
+
+        const double *resultValues = values[instructionCount - 1];
+        for ( int i = 0; i < n; ++i )
+          result[offset + i] = static_cast< float >( resultValues[i] );
+      }
+    }
+
+  private:
+
+    struct Instruction
+    {
+      QgsRasterCalcNode::Type type = QgsRasterCalcNode::tNumber;
+      //! Index of the raster of a raster reference
+      int input = -1;
+      double number = 0;
+      QgsRasterMatrix::OneArgOperator oneArgOperator = QgsRasterMatrix::opSQRT;
+      QgsRasterMatrix::TwoArgOperator twoArgOperator = QgsRasterMatrix::opPLUS;
+      //! Instructions computing the arguments of an operator, right is -1 for one argument operators
+      int left = -1;
+      int right = -1;
+    };
+
+    //! Appends the instructions computing \a node, returns the index of the last one or -1 on error
+    int append( const QgsRasterCalcNode *node, const QStringList &rasterRefs )
+    {
+      if ( !node )
+        return -1;
+
+      Instruction instruction;
+      instruction.type = node->mType;
+      switch ( node->mType )
+      {
+        case QgsRasterCalcNode::tNumber:
+          instruction.number = node->mNumber;
+          break;
+
+        case QgsRasterCalcNode::tRasterRef:
+          // the last entry with a reference wins, as in the map of raster blocks
+          instruction.input = rasterRefs.lastIndexOf( node->mRasterName );
+          if ( instruction.input < 0 )
+            return -1;
+          break;
+
+        case QgsRasterCalcNode::tOperator:
+        {
+          bool twoArguments = true;
+          switch ( node->mOperator )
+          {
+            case QgsRasterCalcNode::opPLUS:
+              instruction.twoArgOperator = QgsRasterMatrix::opPLUS;
+              break;
+            case QgsRasterCalcNode::opMINUS:
+              instruction.twoArgOperator = QgsRasterMatrix::opMINUS;
+              break;
+            case QgsRasterCalcNode::opMUL:
+              instruction.twoArgOperator = QgsRasterMatrix::opMUL;
+              break;
+            case QgsRasterCalcNode::opDIV:
+              instruction.twoArgOperator = QgsRasterMatrix::opDIV;
+              break;
+            case QgsRasterCalcNode::opPOW:
+              instruction.twoArgOperator = QgsRasterMatrix::opPOW;
+              break;
+            case QgsRasterCalcNode::opEQ:
+              instruction.twoArgOperator = QgsRasterMatrix::opEQ;
+              break;
+            case QgsRasterCalcNode::opNE:
+              instruction.twoArgOperator = QgsRasterMatrix::opNE;
+              break;
+            case QgsRasterCalcNode::opGT:
+              instruction.twoArgOperator = QgsRasterMatrix::opGT;
+              break;
+            case QgsRasterCalcNode::opLT:
+              instruction.twoArgOperator = QgsRasterMatrix::opLT;
+              break;
+            case QgsRasterCalcNode::opGE:
+              instruction.twoArgOperator = QgsRasterMatrix::opGE;
+              break;
+            case QgsRasterCalcNode::opLE:
+              instruction.twoArgOperator = QgsRasterMatrix::opLE;
+              break;
+            case QgsRasterCalcNode::opAND:
+              instruction.twoArgOperator = QgsRasterMatrix::opAND;
+              break;
+            case QgsRasterCalcNode::opOR:
+              instruction.twoArgOperator = QgsRasterMatrix::opOR;
+              break;
+            case QgsRasterCalcNode::opSQRT:
+              instruction.oneArgOperator = QgsRasterMatrix::opSQRT;
+              twoArguments = false;
+              break;
+            case QgsRasterCalcNode::opSIN:
+              instruction.oneArgOperator = QgsRasterMatrix::opSIN;
+              twoArguments = false;
+              break;
+            case QgsRasterCalcNode::opCOS:
+              instruction.oneArgOperator = QgsRasterMatrix::opCOS;
+              twoArguments = false;
+              break;
+            case QgsRasterCalcNode::opTAN:
+              instruction.oneArgOperator = QgsRasterMatrix::opTAN;
+              twoArguments = false;
+              break;
+            case QgsRasterCalcNode::opASIN:
+              instruction.oneArgOperator = QgsRasterMatrix::opASIN;
+              twoArguments = false;
+              break;
+            case QgsRasterCalcNode::opACOS:
+              instruction.oneArgOperator = QgsRasterMatrix::opACOS;
+              twoArguments = false;
+              break;
+            case QgsRasterCalcNode::opATAN:
+              instruction.oneArgOperator = QgsRasterMatrix::opATAN;
+              twoArguments = false;
+              break;
+            case QgsRasterCalcNode::opSIGN:
+              instruction.oneArgOperator = QgsRasterMatrix::opSIGN;
+              twoArguments = false;
+              break;
+            case QgsRasterCalcNode::opLOG:
+              instruction.oneArgOperator = QgsRasterMatrix::opLOG;
+              twoArguments = false;
+              break;
+            case QgsRasterCalcNode::opLOG10:
+              instruction.oneArgOperator = QgsRasterMatrix::opLOG10;
+              twoArguments = false;
+              break;
+            default:
+              return -1;
+          }
+
+          instruction.left = append( node->mLeft, rasterRefs );
+          if ( instruction.left < 0 )
+            return -1;
+          if ( twoArguments )
+          {
+            instruction.right = append( node->mRight, rasterRefs );
+            if ( instruction.right < 0 )
+              return -1;
+          }
+          break;
+        }
+
+        default:
+          // matrices are not evaluated cell by cell
+          return -1;
+      }
+
+      mInstructions.push_back( instruction );
+      return static_cast< int >( mInstructions.size() ) - 1;
+    }
+
+    std::vector< Instruction > mInstructions;
+    double mNodataValue = 0;
+    //! Holds the no data value used by the operators
+    QgsRasterMatrix mOperators;
+};
+
+// A tile of output rows, with the blocks of the input rasters
+struct QgsRasterCalculatorTile
+{
+  int firstRow = 0;
+  int rows = 0;
+  std::vector< std::unique_ptr< QgsRasterBlock > > blocks;
+  std::vector< float > result;
+  QFuture< void > future;
+};
+
+///@endcond
+
 QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QString &outputFile, const QString &outputFormat,
     const QgsRectangle &outputExtent, int nOutputColumns, int nOutputRows, const QVector<QgsRasterCalculatorEntry> &rasterEntries )
   : mFormulaString( formulaString )
@@ -38,6 +303,7 @@ QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QS
   , mNumOutputColumns( nOutputColumns )
   , mNumOutputRows( nOutputRows )
   , mRasterEntries( rasterEntries )
+  , mThreadCount( QThread::idealThreadCount() )
 {
   //default to first layer's crs
   mOutputCrs = mRasterEntries.at( 0 ).raster->crs();
@@ -53,6 +319,7 @@ QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QS
   , mNumOutputColumns( nOutputColumns )
   , mNumOutputRows( nOutputRows )
   , mRasterEntries( rasterEntries )
+  , mThreadCount( QThread::idealThreadCount() )
 {
 }
 
@@ -67,6 +334,21 @@ int QgsRasterCalculator::processCalculation( QgsFeedback *feedback )
     return static_cast<int>( ParserError );
   }
 
+  //expressions combining the values of single cells are evaluated in tiles
+  QStringList rasterRefs;
+  bool hasRasters = true;
+  Q_FOREACH ( const QgsRasterCalculatorEntry &entry, mRasterEntries )
+  {
+    rasterRefs << entry.ref;
+    hasRasters = hasRasters && entry.raster;
+  }
+  QgsRasterCalcProgram program;
+  if ( hasRasters && program.compile( calcNode, rasterRefs, -FLT_MAX ) )
+  {
+    delete calcNode;
+    return processTiles( program, feedback );
+  }
+
   QMap< QString, QgsRasterBlock * > inputBlocks;
   QVector<QgsRasterCalculatorEntry>::const_iterator it = mRasterEntries.constBegin();
   for ( ; it != mRasterEntries.constEnd(); ++it )
@@ -178,6 +460,7 @@ int QgsRasterCalculator::processCalculation( QgsFeedback *feedback )
 QgsRasterCalculator::QgsRasterCalculator()
   : mNumOutputColumns( 0 )
   , mNumOutputRows( 0 )
+  , mThreadCount( QThread::idealThreadCount() )
 {
 }
 
@@ -229,3 +512,156 @@ void QgsRasterCalculator::outputGeoTransform( double *transform ) const
   transform[4] = 0;
   transform[5] = -mOutputRectangle.height() / mNumOutputRows;
 }
+
+int QgsRasterCalculator::processTiles( const QgsRasterCalcProgram &program, QgsFeedback *feedback )
+{
+  //open output dataset for writing
+  GDALDriverH outputDriver = openOutputDriver();
+  if ( !outputDriver )
+  {
+    return static_cast< int >( CreateOutputError );
+  }
+
+  GDALDatasetH outputDataset = openOutputFile( outputDriver );
+  if ( !outputDataset )
+  {
+    return static_cast< int >( CreateOutputError );
+  }
+  GDALSetProjection( outputDataset, mOutputCrs.toWkt().toLocal8Bit().data() );
+  GDALRasterBandH outputRasterBand = GDALGetRasterBand( outputDataset, 1 );
+
+  float outputNodataValue = -FLT_MAX;
+  GDALSetRasterNoDataValue( outputRasterBand, outputNodataValue );
+
+  //rasters are read on this thread, reprojected if needed
+  std::vector< std::unique_ptr< QgsRasterProjector > > projectors;
+  Q_FOREACH ( const QgsRasterCalculatorEntry &entry, mRasterEntries )
+  {
+    std::unique_ptr< QgsRasterProjector > projector;
+    if ( entry.raster->crs() != mOutputCrs )
+    {
+      projector.reset( new QgsRasterProjector() );
+      projector->setCrs( entry.raster->crs(), mOutputCrs );
+      projector->setInput( entry.raster->dataProvider() );
+      projector->setPrecision( QgsRasterProjector::Exact );
+    }
+    projectors.push_back( std::move( projector ) );
+  }
+
+  const int threadCount = std::max( 1, mThreadCount );
+  const qint64 rowMemory = static_cast< qint64 >( mNumOutputColumns ) * ( mRasterEntries.size() * sizeof( double ) + sizeof( float ) );
+  const int memoryRows = std::max( 1, static_cast< int >( TILE_MEMORY / std::max( rowMemory, static_cast< qint64 >( 1 ) ) ) );
+  // small rasters are still split into several tiles for each thread, but not into tiny ones
+  const int tileRows = std::max( std::min( 64, memoryRows ), std::min( memoryRows, ( mNumOutputRows + 4 * threadCount - 1 ) / ( 4 * threadCount ) ) );
+  // tiles are read ahead of the tile being written, so that every thread has one to compute
+  const int maxTiles = threadCount > 1 ? 2 * threadCount : 1;
+  const double rowHeight = mOutputRectangle.height() / mNumOutputRows;
+  const int entryCount = mRasterEntries.size();
+
+  auto processTile = [&program, entryCount, outputNodataValue]( QgsRasterCalculatorTile * tile )
+  {
+    //convert input raster values to double, also convert input no data to result no data
+    std::vector< std::vector< double > > inputs( entryCount );
+    for ( int k = 0; k < entryCount; ++k )
+    {
+      QgsRasterBlock *block = tile->blocks[k].get();
+      const qgssize count = static_cast< qgssize >( block->width() ) * block->height();
+      inputs[k].resize( count );
+      for ( qgssize i = 0; i < count; ++i )
+      {
+        inputs[k][i] = block->isNoData( i ) ? outputNodataValue : block->value( i );
+      }
+      tile->blocks[k].reset();
+    }
+    program.evaluate( inputs, tile->result.size(), tile->result.data() );
+  };
+
+  int result = static_cast< int >( Success );
+  std::deque< std::unique_ptr< QgsRasterCalculatorTile > > tiles;
+  int nextRow = 0;
+  int writtenRows = 0;
+  while ( writtenRows < mNumOutputRows )
+  {
+    if ( feedback && feedback->isCanceled() )
+    {
+      break;
+    }
+
+    if ( nextRow < mNumOutputRows && static_cast< int >( tiles.size() ) < maxTiles )
+    {
+      std::unique_ptr< QgsRasterCalculatorTile > tile( new QgsRasterCalculatorTile() );
+      tile->firstRow = nextRow;
+      tile->rows = std::min( tileRows, mNumOutputRows - nextRow );
+      nextRow += tile->rows;
+
+      const double yMaximum = mOutputRectangle.yMaximum() - tile->firstRow * rowHeight;
+      const QgsRectangle tileExtent( mOutputRectangle.xMinimum(), yMaximum - tile->rows * rowHeight, mOutputRectangle.xMaximum(), yMaximum );
+      for ( int k = 0; k < entryCount; ++k )
+      {
+        const QgsRasterCalculatorEntry &entry = mRasterEntries.at( k );
+        std::unique_ptr< QgsRasterBlock > block;
+        if ( projectors[k] )
+          block.reset( projectors[k]->block( entry.bandNumber, tileExtent, mNumOutputColumns, tile->rows ) );
+        else
+          block.reset( entry.raster->dataProvider()->block( entry.bandNumber, tileExtent, mNumOutputColumns, tile->rows ) );
+        if ( !block || block->isEmpty() )
+        {
+          result = static_cast< int >( MemoryError );
+          break;
+        }
+        tile->blocks.push_back( std::move( block ) );
+      }
+      if ( result != static_cast< int >( Success ) )
+      {
+        break;
+      }
+      tile->result.resize( static_cast< size_t >( tile->rows ) * mNumOutputColumns );
+
+      if ( threadCount > 1 )
+      {
+        tile->future = QtConcurrent::run( processTile, tile.get() );
+      }
+      else
+      {
+        processTile( tile.get() );
+      }
+      tiles.push_back( std::move( tile ) );
+      continue;
+    }
+
+    //tiles are written in order, once they are computed
+    QgsRasterCalculatorTile *tile = tiles.front().get();
+    tile->future.waitForFinished();
+    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, tile->firstRow, mNumOutputColumns, tile->rows, tile->result.data(), mNumOutputColumns, tile->rows, GDT_Float32, 0, 0 ) != CE_None )
+    {
+      QgsDebugMsg( "RasterIO error!" );
+    }
+    writtenRows += tile->rows;
+    tiles.pop_front();
+
+    if ( feedback )
+    {
+      feedback->setProgress( 100.0 * static_cast< double >( writtenRows ) / mNumOutputRows );
+    }
+  }
+
+  //tiles may still be computed after a cancelation or an error
+  for ( const std::unique_ptr< QgsRasterCalculatorTile > &tile : tiles )
+  {
+    tile->future.waitForFinished();
+  }
+
+  if ( result == static_cast< int >( Success ) && feedback && feedback->isCanceled() )
+  {
+    result = static_cast< int >( Canceled );
+  }
+  if ( result != static_cast< int >( Success ) )
+  {
+    //delete the dataset without closing (because it is faster)
+    GDALDeleteDataset( outputDriver, mOutputFile.toUtf8().constData() );
+    return result;
+  }
+  GDALClose( outputDataset );
+
+  return result;
+}
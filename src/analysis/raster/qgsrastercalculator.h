@@ -27,6 +27,7 @@
 
 class QgsRasterLayer;
 class QgsFeedback;
+class QgsRasterCalcProgram;
 
 
 struct ANALYSIS_EXPORT QgsRasterCalculatorEntry
@@ -43,7 +44,11 @@ struct ANALYSIS_EXPORT QgsRasterCalculatorEntry
 };
 
 /** \ingroup analysis
- * Raster calculator class*/
+ * Raster calculator class.
+ *
+ * Expressions which only combine the values of the same cell of each raster are evaluated
+ * in tiles of rows, which are read one after the other and computed concurrently
+ * (see setThreadCount()).*/
 class ANALYSIS_EXPORT QgsRasterCalculator
 {
   public:
@@ -93,6 +98,19 @@ class ANALYSIS_EXPORT QgsRasterCalculator
     //TODO QGIS 3.0 - return QgsRasterCalculator::Result
     int processCalculation( QgsFeedback *feedback = nullptr );
 
+    /** Sets the number of threads computing tiles of the output raster concurrently. By default, the
+     * ideal thread count of the system is used. Set \a count to 1 to compute tiles one after the other.
+     * \see threadCount()
+     * \since QGIS 3.0
+     */
+    void setThreadCount( int count ) { mThreadCount = count; }
+
+    /** Returns the number of threads computing tiles of the output raster concurrently.
+     * \see setThreadCount()
+     * \since QGIS 3.0
+     */
+    int threadCount() const { return mThreadCount; }
+
   private:
     //default constructor forbidden. We need formula, output file, output format and output raster resolution obligatory
     QgsRasterCalculator();
@@ -109,6 +127,10 @@ class ANALYSIS_EXPORT QgsRasterCalculator
       \param transform double[6] array that receives the GDAL parameters*/
     void outputGeoTransform( double *transform ) const;
 
+    /** Reads the input rasters, evaluates the compiled expression and writes the output raster in tiles of rows
+      \returns a QgsRasterCalculator::Result*/
+    int processTiles( const QgsRasterCalcProgram &program, QgsFeedback *feedback );
+
     QString mFormulaString;
     QString mOutputFile;
     QString mOutputFormat;
@@ -124,6 +146,9 @@ class ANALYSIS_EXPORT QgsRasterCalculator
 
     /***/
     QVector<QgsRasterCalculatorEntry> mRasterEntries;
+
+    //! Number of threads computing tiles concurrently
+    int mThreadCount;
 };
 
 #endif // QGSRASTERCALCULATOR_H
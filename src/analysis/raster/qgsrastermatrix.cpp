@@ -207,65 +207,61 @@ bool QgsRasterMatrix::oneArgumentOperation( OneArgOperator op )
     value = mData[i];
     if ( value != mNodataValue )
     {
-      switch ( op )
-      {
-        case opSQRT:
-          if ( value < 0 ) //no complex numbers
-          {
-            mData[i] = mNodataValue;
-          }
-          else
-          {
-            mData[i] = std::sqrt( value );
-          }
-          break;
-        case opSIN:
-          mData[i] = std::sin( value );
-          break;
-        case opCOS:
-          mData[i] = std::cos( value );
-          break;
-        case opTAN:
-          mData[i] = std::tan( value );
-          break;
-        case opASIN:
-          mData[i] = std::asin( value );
-          break;
-        case opACOS:
-          mData[i] = std::acos( value );
-          break;
-        case opATAN:
-          mData[i] = std::atan( value );
-          break;
-        case opSIGN:
-          mData[i] = -value;
-          break;
-        case opLOG:
-          if ( value <= 0 )
-          {
-            mData[i] = mNodataValue;
-          }
-          else
-          {
-            mData[i] = ::log( value );
-          }
-          break;
-        case opLOG10:
-          if ( value <= 0 )
-          {
-            mData[i] = mNodataValue;
-          }
-          else
-          {
-            mData[i] = ::log10( value );
-          }
-          break;
-      }
+      mData[i] = calculateOneArgumentOp( op, value );
     }
   }
   return true;
 }
 
+double QgsRasterMatrix::calculateOneArgumentOp( OneArgOperator op, double value ) const
+{
+  switch ( op )
+  {
+    case opSQRT:
+      if ( value < 0 ) //no complex numbers
+      {
+        return mNodataValue;
+      }
+      else
+      {
+        return std::sqrt( value );
+      }
+    case opSIN:
+      return std::sin( value );
+    case opCOS:
+      return std::cos( value );
+    case opTAN:
+      return std::tan( value );
+    case opASIN:
+      return std::asin( value );
+    case opACOS:
+      return std::acos( value );
+    case opATAN:
+      return std::atan( value );
+    case opSIGN:
+      return -value;
+    case opLOG:
+      if ( value <= 0 )
+      {
+        return mNodataValue;
+      }
+      else
+      {
+        return ::log( value );
+      }
+    case opLOG10:
+      if ( value <= 0 )
+      {
+        return mNodataValue;
+      }
+      else
+      {
+        return ::log10( value );
+      }
+  }
+  return value;
+}
+
 double QgsRasterMatrix::calculateTwoArgumentOp( TwoArgOperator op, double arg1, double arg2 ) const
 {
   switch ( op )
@@ -126,7 +126,10 @@ class ANALYSIS_EXPORT QgsRasterMatrix
 
     /*sqrt, std::sin, std::cos, tan, asin, acos, atan*/
     bool oneArgumentOperation( OneArgOperator op );
+    double calculateOneArgumentOp( OneArgOperator op, double value ) const;
     bool testPowerValidity( double base, double power ) const;
+
+    friend class QgsRasterCalcProgram;
 };
 
 #endif // QGSRASTERMATRIX_H
@@ -19,6 +19,9 @@
 #include "qgsfeatureiterator.h"
 #include "qgsfeedback.h"
 #include "qgsgeometry.h"
+#include "qgsgeometrycollection.h"
+#include "qgscurvepolygon.h"
+#include "qgslinestring.h"
 #include "qgsvectordataprovider.h"
 #include "qgsvectorlayer.h"
 #include "qgsrasterdataprovider.h"
@@ -26,7 +29,219 @@
 #include "qgsrasterblock.h"
 #include "qgslogger.h"
 
+#include <QCache>
 #include <QFile>
+#include <QHash>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <vector>
+
+///@cond PRIVATE
+
+// Number of rows and columns of the tiles the raster is read in
+static const int TILE_SIZE = 256;
+
+// Memory budget of the raster tiles kept for the following polygons, in KB
+static const int TILE_CACHE_MEMORY = 256 * 1024;
+
+// Number of polygons computed by a single task
+static const int ZONE_BATCH_SIZE = 32;
+
+// A tile of raster cells, aligned to the raster grid
+struct QgsZonalStatistics::RasterTile
+{
+  float value( int row, int column ) const
+  {
+    return values[ static_cast< size_t >( row - firstRow ) * columns + ( column - firstColumn )];
+  }
+
+  int firstRow = 0;
+  int firstColumn = 0;
+  int rows = 0;
+  int columns = 0;
+  std::vector< float > values;
+};
+
+/*
+ * Reads the raster in tiles and keeps the recently used ones, as neighbouring polygons mostly
+ * cover the same tiles. Tiles are only read by the thread iterating the polygons, as the data
+ * provider is not thread safe, and are never modified once read.
+ */
+class QgsZonalStatistics::RasterTileCache
+{
+  public:
+    RasterTileCache( QgsRasterDataProvider *provider, int band, const QgsRectangle &rasterBBox, double cellSizeX, double cellSizeY, int nCellsX, int nCellsY )
+      : mProvider( provider )
+      , mBand( band )
+      , mRasterBBox( rasterBBox )
+      , mCellSizeX( cellSizeX )
+      , mCellSizeY( cellSizeY )
+      , mNCellsX( nCellsX )
+      , mNCellsY( nCellsY )
+      , mTileColumns( ( nCellsX + TILE_SIZE - 1 ) / TILE_SIZE )
+    {
+      mTiles.setMaxCost( TILE_CACHE_MEMORY );
+    }
+
+    //! Returns the number of tiles in a row of tiles
+    int tileColumns() const { return mTileColumns; }
+
+    //! Returns the tile at \a tileRow and \a tileColumn, which is read unless it was used recently
+    std::shared_ptr< const RasterTile > tile( int tileRow, int tileColumn )
+    {
+      const qint64 key = static_cast< qint64 >( tileRow ) * mTileColumns + tileColumn;
+      if ( std::shared_ptr< const RasterTile > *cached = mTiles.object( key ) )
+        return *cached;
+
+      std::shared_ptr< RasterTile > tile = std::make_shared< RasterTile >();
+      tile->firstRow = tileRow * TILE_SIZE;
+      tile->firstColumn = tileColumn * TILE_SIZE;
+      tile->rows = std::min( TILE_SIZE, mNCellsY - tile->firstRow );
+      tile->columns = std::min( TILE_SIZE, mNCellsX - tile->firstColumn );
+      tile->values.assign( static_cast< size_t >( tile->rows ) * tile->columns, std::numeric_limits< float >::quiet_NaN() );
+
+      //tiles on the border end at the raster extent, so that they are read without resampling
+      const int lastRow = tile->firstRow + tile->rows;
+      const int lastColumn = tile->firstColumn + tile->columns;
+      QgsRectangle extent( mRasterBBox.xMinimum() + tile->firstColumn * mCellSizeX,
+                           lastRow == mNCellsY ? mRasterBBox.yMinimum() : mRasterBBox.yMaximum() - lastRow * mCellSizeY,
+                           lastColumn == mNCellsX ? mRasterBBox.xMaximum() : mRasterBBox.xMinimum() + lastColumn * mCellSizeX,
+                           mRasterBBox.yMaximum() - tile->firstRow * mCellSizeY );
+      std::unique_ptr< QgsRasterBlock > block( mProvider->block( mBand, extent, tile->columns, tile->rows ) );
+      if ( block && block->isValid() )
+      {
+        float *value = tile->values.data();
+        for ( int i = 0; i < tile->rows; ++i )
+        {
+          for ( int j = 0; j < tile->columns; ++j )
+          {
+            *value++ = block->value( i, j );
+          }
+        }
+      }
+      else
+      {
+        QgsDebugMsg( "Could not read raster tile" );
+      }
+
+      const int cost = std::max( 1, static_cast< int >( tile->values.size() * sizeof( float ) / 1024 ) );
+      mTiles.insert( key, new std::shared_ptr< const RasterTile >( tile ), cost );
+      return tile;
+    }
+
+  private:
+    QgsRasterDataProvider *mProvider = nullptr;
+    int mBand;
+    QgsRectangle mRasterBBox;
+    double mCellSizeX;
+    double mCellSizeY;
+    int mNCellsX;
+    int mNCellsY;
+    int mTileColumns;
+    QCache< qint64, std::shared_ptr< const RasterTile > > mTiles;
+};
+
+// A polygon and the pixels covering its bounding box, with its statistics once they are computed
+struct QgsZonalStatistics::Zone
+{
+  QgsFeatureId id = 0;
+  QgsGeometry geometry;
+  int offsetX = 0;
+  int offsetY = 0;
+  int nCellsX = 0;
+  int nCellsY = 0;
+  FeatureStats stats;
+  //! The statistics must be computed with the precise intersection, which uses GEOS and is not thread safe
+  bool needsPreciseIntersection = false;
+};
+
+// Polygons computed by a single task, with the raster tiles they cover
+struct QgsZonalStatistics::ZoneBatch
+{
+  //! Returns the tile containing the pixel at \a row and \a column, or nullptr if it was not read
+  const RasterTile *tile( int row, int column ) const
+  {
+    const qint64 key = static_cast< qint64 >( row / TILE_SIZE ) * tileColumns + column / TILE_SIZE;
+    auto it = tiles.constFind( key );
+    return it != tiles.constEnd() ? it.value().get() : nullptr;
+  }
+
+  //! Returns the value of the pixel at \a row and \a column
+  float value( int row, int column ) const
+  {
+    const RasterTile *t = tile( row, column );
+    return t ? t->value( row, column ) : std::numeric_limits< float >::quiet_NaN();
+  }
+
+  std::vector< Zone > zones;
+  int tileColumns = 0;
+  QHash< qint64, std::shared_ptr< const RasterTile > > tiles;
+  QFuture< void > future;
+};
+
+// A polygon ring edge crossing rows of pixel centers, from its lower (x0, y0) to its upper end (x1, y1)
+struct QgsZonalStatisticsEdge
+{
+  double x0;
+  double y0;
+  double x1;
+  double y1;
+};
+
+static void addRingEdges( const QgsCurve *ring, std::vector< QgsZonalStatisticsEdge > &edges )
+{
+  if ( !ring )
+    return;
+
+  //curves are segmentized like for the GEOS point in polygon test
+  std::unique_ptr< QgsLineString > segmentized;
+  const QgsLineString *line = dynamic_cast< const QgsLineString * >( ring );
+  if ( !line )
+  {
+    segmentized.reset( ring->curveToLine() );
+    line = segmentized.get();
+  }
+
+  const int nPoints = line->numPoints();
+  for ( int i = 1; i < nPoints; ++i )
+  {
+    double x0 = line->xAt( i - 1 );
+    double y0 = line->yAt( i - 1 );
+    double x1 = line->xAt( i );
+    double y1 = line->yAt( i );
+    //horizontal edges never cross a row
+    if ( y0 == y1 )
+      continue;
+    if ( y0 > y1 )
+    {
+      std::swap( x0, x1 );
+      std::swap( y0, y1 );
+    }
+    edges.push_back( { x0, y0, x1, y1 } );
+  }
+}
+
+static void addPolygonEdges( const QgsAbstractGeometry *geometry, std::vector< QgsZonalStatisticsEdge > &edges )
+{
+  if ( const QgsGeometryCollection *collection = dynamic_cast< const QgsGeometryCollection * >( geometry ) )
+  {
+    for ( int i = 0; i < collection->numGeometries(); ++i )
+      addPolygonEdges( collection->geometryN( i ), edges );
+  }
+  else if ( const QgsCurvePolygon *polygon = dynamic_cast< const QgsCurvePolygon * >( geometry ) )
+  {
+    addRingEdges( polygon->exteriorRing(), edges );
+    for ( int i = 0; i < polygon->numInteriorRings(); ++i )
+      addRingEdges( polygon->interiorRing( i ), edges );
+  }
+}
+
+///@endcond
 
 QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QString &attributePrefix, int rasterBand, QgsZonalStatistics::Statistics stats )
   : mRasterLayer( rasterLayer )
@@ -34,6 +249,7 @@ QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterL
   , mPolygonLayer( polygonLayer )
   , mAttributePrefix( attributePrefix )
   , mStatistics( stats )
+  , mThreadCount( QThread::idealThreadCount() )
 {}
 
 int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
@@ -212,134 +428,212 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
   bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Minority ) ||
                               ( mStatistics & QgsZonalStatistics::Majority );
 
-  FeatureStats featureStats( statsStoreValues, statsStoreValueCount );
   int featureCounter = 0;
 
-  QgsChangedAttributesMap changeMap;
-  while ( fi.nextFeature( f ) )
-  {
-    if ( feedback && feedback->isCanceled() )
-    {
-      break;
-    }
+  //polygons are computed concurrently in batches, the raster tiles they need are read beforehand
+  RasterTileCache tileCache( mRasterProvider, mRasterBand, rasterBBox, cellsizeX, cellsizeY, nCellsXProvider, nCellsYProvider );
+  const int threadCount = std::max( 1, mThreadCount );
+  //batches are prepared ahead of the batch being written, so that every thread has one to compute
+  const int maxBatches = threadCount > 1 ? 2 * threadCount : 1;
 
-    if ( feedback )
+  auto processBatch = [this, cellsizeX, cellsizeY, rasterBBox, feedback]( ZoneBatch * batch )
+  {
+    for ( Zone &zone : batch->zones )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
+      if ( feedback && feedback->isCanceled() )
+      {
+        return;
+      }
+      processZone( zone, *batch, cellsizeX, cellsizeY, rasterBBox );
     }
+  };
 
-    if ( !f.hasGeometry() )
+  QgsChangedAttributesMap changeMap;
+  std::deque< std::unique_ptr< ZoneBatch > > batches;
+  bool featuresLeft = true;
+  while ( featuresLeft || !batches.empty() )
+  {
+    if ( feedback && feedback->isCanceled() )
     {
-      ++featureCounter;
-      continue;
+      break;
     }
-    QgsGeometry featureGeometry = f.geometry();
 
-    QgsRectangle featureRect = featureGeometry.boundingBox().intersect( &rasterBBox );
-    if ( featureRect.isEmpty() )
+    if ( featuresLeft && static_cast< int >( batches.size() ) < maxBatches )
     {
-      ++featureCounter;
-      continue;
-    }
+      std::unique_ptr< ZoneBatch > batch( new ZoneBatch() );
+      batch->tileColumns = tileCache.tileColumns();
+      while ( static_cast< int >( batch->zones.size() ) < ZONE_BATCH_SIZE )
+      {
+        if ( !fi.nextFeature( f ) )
+        {
+          featuresLeft = false;
+          break;
+        }
 
-    int offsetX, offsetY, nCellsX, nCellsY;
-    if ( cellInfoForBBox( rasterBBox, featureRect, cellsizeX, cellsizeY, offsetX, offsetY, nCellsX, nCellsY ) != 0 )
-    {
-      ++featureCounter;
-      continue;
-    }
+        if ( feedback )
+        {
+          feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
+        }
+        ++featureCounter;
 
-    //avoid access to cells outside of the raster (may occur because of rounding)
-    if ( ( offsetX + nCellsX ) > nCellsXProvider )
-    {
-      nCellsX = nCellsXProvider - offsetX;
-    }
-    if ( ( offsetY + nCellsY ) > nCellsYProvider )
-    {
-      nCellsY = nCellsYProvider - offsetY;
-    }
+        if ( !f.hasGeometry() )
+        {
+          continue;
+        }
 
-    statisticsFromMiddlePointTest( featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                   rasterBBox, featureStats );
+        Zone zone;
+        zone.id = f.id();
+        zone.geometry = f.geometry();
 
-    if ( featureStats.count <= 1 )
-    {
-      //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
-      statisticsFromPreciseIntersection( featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                         rasterBBox, featureStats );
-    }
+        QgsRectangle featureRect = zone.geometry.boundingBox().intersect( &rasterBBox );
+        if ( featureRect.isEmpty() )
+        {
+          continue;
+        }
 
-    //write the statistics value to the vector data provider
-    QgsAttributeMap changeAttributeMap;
-    if ( mStatistics & QgsZonalStatistics::Count )
-      changeAttributeMap.insert( countIndex, QVariant( featureStats.count ) );
-    if ( mStatistics & QgsZonalStatistics::Sum )
-      changeAttributeMap.insert( sumIndex, QVariant( featureStats.sum ) );
-    if ( featureStats.count > 0 )
-    {
-      double mean = featureStats.sum / featureStats.count;
-      if ( mStatistics & QgsZonalStatistics::Mean )
-        changeAttributeMap.insert( meanIndex, QVariant( mean ) );
-      if ( mStatistics & QgsZonalStatistics::Median )
-      {
-        std::sort( featureStats.values.begin(), featureStats.values.end() );
-        int size =  featureStats.values.count();
-        bool even = ( size % 2 ) < 1;
-        double medianValue;
-        if ( even )
+        if ( cellInfoForBBox( rasterBBox, featureRect, cellsizeX, cellsizeY, zone.offsetX, zone.offsetY, zone.nCellsX, zone.nCellsY ) != 0 )
         {
-          medianValue = ( featureStats.values.at( size / 2 - 1 ) + featureStats.values.at( size / 2 ) ) / 2;
+          continue;
         }
-        else //odd
+
+        //avoid access to cells outside of the raster (may occur because of rounding)
+        if ( ( zone.offsetX + zone.nCellsX ) > nCellsXProvider )
         {
-          medianValue = featureStats.values.at( ( size + 1 ) / 2 - 1 );
+          zone.nCellsX = nCellsXProvider - zone.offsetX;
         }
-        changeAttributeMap.insert( medianIndex, QVariant( medianValue ) );
-      }
-      if ( mStatistics & QgsZonalStatistics::StDev || mStatistics & QgsZonalStatistics::Variance )
-      {
-        double sumSquared = 0;
-        for ( int i = 0; i < featureStats.values.count(); ++i )
+        if ( ( zone.offsetY + zone.nCellsY ) > nCellsYProvider )
         {
-          double diff = featureStats.values.at( i ) - mean;
-          sumSquared += diff * diff;
+          zone.nCellsY = nCellsYProvider - zone.offsetY;
         }
-        double variance = sumSquared / featureStats.values.count();
-        if ( mStatistics & QgsZonalStatistics::StDev )
+
+        if ( zone.nCellsX > 0 && zone.nCellsY > 0 )
         {
-          double stdev = std::pow( variance, 0.5 );
-          changeAttributeMap.insert( stdevIndex, QVariant( stdev ) );
+          for ( int tileRow = zone.offsetY / TILE_SIZE; tileRow <= ( zone.offsetY + zone.nCellsY - 1 ) / TILE_SIZE; ++tileRow )
+          {
+            for ( int tileColumn = zone.offsetX / TILE_SIZE; tileColumn <= ( zone.offsetX + zone.nCellsX - 1 ) / TILE_SIZE; ++tileColumn )
+            {
+              const qint64 key = static_cast< qint64 >( tileRow ) * batch->tileColumns + tileColumn;
+              if ( !batch->tiles.contains( key ) )
+              {
+                batch->tiles.insert( key, tileCache.tile( tileRow, tileColumn ) );
+              }
+            }
+          }
         }
-        if ( mStatistics & QgsZonalStatistics::Variance )
-          changeAttributeMap.insert( varianceIndex, QVariant( variance ) );
+
+        zone.stats = FeatureStats( statsStoreValues, statsStoreValueCount );
+        batch->zones.push_back( zone );
       }
-      if ( mStatistics & QgsZonalStatistics::Min )
-        changeAttributeMap.insert( minIndex, QVariant( featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Max )
-        changeAttributeMap.insert( maxIndex, QVariant( featureStats.max ) );
-      if ( mStatistics & QgsZonalStatistics::Range )
-        changeAttributeMap.insert( rangeIndex, QVariant( featureStats.max - featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority )
+
+      if ( threadCount > 1 )
       {
-        QList<int> vals = featureStats.valueCount.values();
-        std::sort( vals.begin(), vals.end() );
-        if ( mStatistics & QgsZonalStatistics::Minority )
+        batch->future = QtConcurrent::run( processBatch, batch.get() );
+      }
+      else
+      {
+        processBatch( batch.get() );
+      }
+      batches.push_back( std::move( batch ) );
+      continue;
+    }
+
+    //batches are written in order, once they are computed
+    ZoneBatch *batch = batches.front().get();
+    batch->future.waitForFinished();
+    if ( feedback && feedback->isCanceled() )
+    {
+      break;
+    }
+
+    for ( Zone &zone : batch->zones )
+    {
+      if ( zone.needsPreciseIntersection )
+      {
+        //the GEOS context is shared by the whole process, so the precise intersection is computed on this thread
+        statisticsFromPreciseIntersection( zone.geometry, zone.offsetX, zone.offsetY, zone.nCellsX, zone.nCellsY, cellsizeX, cellsizeY,
+                                           rasterBBox, *batch, zone.stats );
+        std::sort( zone.stats.values.begin(), zone.stats.values.end() );
+      }
+      const FeatureStats &featureStats = zone.stats;
+
+      //write the statistics value to the vector data provider
+      QgsAttributeMap changeAttributeMap;
+      if ( mStatistics & QgsZonalStatistics::Count )
+        changeAttributeMap.insert( countIndex, QVariant( featureStats.count ) );
+      if ( mStatistics & QgsZonalStatistics::Sum )
+        changeAttributeMap.insert( sumIndex, QVariant( featureStats.sum ) );
+      if ( featureStats.count > 0 )
+      {
+        double mean = featureStats.sum / featureStats.count;
+        if ( mStatistics & QgsZonalStatistics::Mean )
+          changeAttributeMap.insert( meanIndex, QVariant( mean ) );
+        if ( mStatistics & QgsZonalStatistics::Median )
         {
-          float minorityKey = featureStats.valueCount.key( vals.first() );
-          changeAttributeMap.insert( minorityIndex, QVariant( minorityKey ) );
+          //values are sorted by processZone()
+          int size =  featureStats.values.count();
+          bool even = ( size % 2 ) < 1;
+          double medianValue;
+          if ( even )
+          {
+            medianValue = ( featureStats.values.at( size / 2 - 1 ) + featureStats.values.at( size / 2 ) ) / 2;
+          }
+          else //odd
+          {
+            medianValue = featureStats.values.at( ( size + 1 ) / 2 - 1 );
+          }
+          changeAttributeMap.insert( medianIndex, QVariant( medianValue ) );
         }
-        if ( mStatistics & QgsZonalStatistics::Majority )
+        if ( mStatistics & QgsZonalStatistics::StDev || mStatistics & QgsZonalStatistics::Variance )
         {
-          float majKey = featureStats.valueCount.key( vals.last() );
-          changeAttributeMap.insert( majorityIndex, QVariant( majKey ) );
+          double sumSquared = 0;
+          for ( int i = 0; i < featureStats.values.count(); ++i )
+          {
+            double diff = featureStats.values.at( i ) - mean;
+            sumSquared += diff * diff;
+          }
+          double variance = sumSquared / featureStats.values.count();
+          if ( mStatistics & QgsZonalStatistics::StDev )
+          {
+            double stdev = std::pow( variance, 0.5 );
+            changeAttributeMap.insert( stdevIndex, QVariant( stdev ) );
+          }
+          if ( mStatistics & QgsZonalStatistics::Variance )
+            changeAttributeMap.insert( varianceIndex, QVariant( variance ) );
+        }
+        if ( mStatistics & QgsZonalStatistics::Min )
+          changeAttributeMap.insert( minIndex, QVariant( featureStats.min ) );
+        if ( mStatistics & QgsZonalStatistics::Max )
+          changeAttributeMap.insert( maxIndex, QVariant( featureStats.max ) );
+        if ( mStatistics & QgsZonalStatistics::Range )
+          changeAttributeMap.insert( rangeIndex, QVariant( featureStats.max - featureStats.min ) );
+        if ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority )
+        {
+          QList<int> vals = featureStats.valueCount.values();
+          std::sort( vals.begin(), vals.end() );
+          if ( mStatistics & QgsZonalStatistics::Minority )
+          {
+            float minorityKey = featureStats.valueCount.key( vals.first() );
+            changeAttributeMap.insert( minorityIndex, QVariant( minorityKey ) );
+          }
+          if ( mStatistics & QgsZonalStatistics::Majority )
+          {
+            float majKey = featureStats.valueCount.key( vals.last() );
+            changeAttributeMap.insert( majorityIndex, QVariant( majKey ) );
+          }
         }
+        if ( mStatistics & QgsZonalStatistics::Variety )
+          changeAttributeMap.insert( varietyIndex, QVariant( featureStats.valueCount.count() ) );
       }
-      if ( mStatistics & QgsZonalStatistics::Variety )
-        changeAttributeMap.insert( varietyIndex, QVariant( featureStats.valueCount.count() ) );
+
+      changeMap.insert( zone.id, changeAttributeMap );
     }
+    batches.pop_front();
+  }
 
-    changeMap.insert( f.id(), changeAttributeMap );
-    ++featureCounter;
+  //batches may still be computed after a cancelation
+  for ( const std::unique_ptr< ZoneBatch > &batch : batches )
+  {
+    batch->future.waitForFinished();
   }
 
   vectorProvider->changeAttributeValues( changeMap );
@@ -386,65 +680,110 @@ int QgsZonalStatistics::cellInfoForBBox( const QgsRectangle &rasterBBox, const Q
   return 0;
 }
 
-void QgsZonalStatistics::statisticsFromMiddlePointTest( const QgsGeometry &poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats )
+void QgsZonalStatistics::processZone( Zone &zone, const ZoneBatch &batch, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox ) const
 {
-  double cellCenterX, cellCenterY;
+  statisticsFromScanlines( zone.geometry, zone.offsetX, zone.offsetY, zone.nCellsX, zone.nCellsY, cellSizeX, cellSizeY,
+                           rasterBBox, batch, zone.stats );
 
-  cellCenterY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
-  stats.reset();
-
-  GEOSGeometry *polyGeos = poly.exportToGeos();
-  if ( !polyGeos )
+  if ( zone.stats.count <= 1 )
   {
+    //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case,
+    //computed when the batch is written
+    zone.needsPreciseIntersection = true;
     return;
   }
 
-  GEOSContextHandle_t geosctxt = QgsGeometry::getGEOSHandler();
-  const GEOSPreparedGeometry *polyGeosPrepared = GEOSPrepare_r( geosctxt, polyGeos );
-  if ( !polyGeosPrepared )
+  //sorted for the median, while the statistics are computed concurrently
+  std::sort( zone.stats.values.begin(), zone.stats.values.end() );
+}
+
+void QgsZonalStatistics::statisticsFromScanlines( const QgsGeometry &poly, int pixelOffsetX,
+    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const ZoneBatch &batch, FeatureStats &stats ) const
+{
+  stats.reset();
+
+  if ( nCellsX <= 0 || nCellsY <= 0 || !poly.geometry() )
   {
-    GEOSGeom_destroy_r( geosctxt, polyGeos );
     return;
   }
 
-  GEOSCoordSequence *cellCenterCoords = nullptr;
-  GEOSGeometry *currentCellCenter = nullptr;
+  std::vector< QgsZonalStatisticsEdge > edges;
+  addPolygonEdges( poly.geometry(), edges );
+
+  std::vector< double > cellCentersX( nCellsX );
+  double cellCenterX = rasterBBox.xMinimum() + pixelOffsetX * cellSizeX + cellSizeX / 2;
+  for ( int j = 0; j < nCellsX; ++j )
+  {
+    cellCentersX[j] = cellCenterX;
+    cellCenterX += cellSizeX;
+  }
 
-  QgsRectangle featureBBox = poly.boundingBox().intersect( &rasterBBox );
-  QgsRectangle intersectBBox = rasterBBox.intersect( &featureBBox );
+  //edges are sorted by the row they could first cross (rounding is covered by starting one row earlier)
+  const double firstCellCenterY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
+  std::vector< std::vector< int > > edgesByRow( nCellsY );
+  for ( int k = 0; k < static_cast< int >( edges.size() ); ++k )
+  {
+    const double firstRow = std::floor( ( firstCellCenterY - edges[k].y1 ) / cellSizeY ) - 1;
+    if ( firstRow >= nCellsY )
+      continue;
+    edgesByRow[ static_cast< int >( std::max( 0.0, firstRow ) )].push_back( k );
+  }
 
-  QgsRasterBlock *block = mRasterProvider->block( mRasterBand, intersectBBox, nCellsX, nCellsY );
-  for ( int i = 0; i < nCellsY; ++i )
+  std::vector< int > activeEdges;
+  std::vector< double > crossings;
+  double cellCenterY = firstCellCenterY;
+  for ( int i = 0; i < nCellsY; ++i, cellCenterY -= cellSizeY )
   {
-    cellCenterX = rasterBBox.xMinimum() + pixelOffsetX * cellSizeX + cellSizeX / 2;
-    for ( int j = 0; j < nCellsX; ++j )
+    activeEdges.insert( activeEdges.end(), edgesByRow[i].begin(), edgesByRow[i].end() );
+
+    //x coordinates where the row of cell centers crosses the rings, with an edge covering [y0, y1[
+    crossings.clear();
+    for ( size_t k = 0; k < activeEdges.size(); )
+    {
+      const QgsZonalStatisticsEdge &edge = edges[ activeEdges[k] ];
+      if ( cellCenterY < edge.y0 )
+      {
+        //rows go downwards, so the edge is not crossed anymore
+        activeEdges[k] = activeEdges.back();
+        activeEdges.pop_back();
+        continue;
+      }
+      if ( cellCenterY < edge.y1 )
+      {
+        crossings.push_back( edge.x0 + ( cellCenterY - edge.y0 ) * ( edge.x1 - edge.x0 ) / ( edge.y1 - edge.y0 ) );
+      }
+      ++k;
+    }
+    std::sort( crossings.begin(), crossings.end() );
+
+    //cell centers between pairs of crossings are inside the polygon, those on the boundary are not
+    const int row = pixelOffsetY + i;
+    const RasterTile *tile = nullptr;
+    for ( size_t k = 0; k + 1 < crossings.size(); k += 2 )
     {
-      if ( validPixel( block->value( i, j ) ) )
+      int j = std::upper_bound( cellCentersX.begin(), cellCentersX.end(), crossings[k] ) - cellCentersX.begin();
+      for ( ; j < nCellsX && cellCentersX[j] < crossings[k + 1]; ++j )
       {
-        GEOSGeom_destroy_r( geosctxt, currentCellCenter );
-        cellCenterCoords = GEOSCoordSeq_create_r( geosctxt, 1, 2 );
-        GEOSCoordSeq_setX_r( geosctxt, cellCenterCoords, 0, cellCenterX );
-        GEOSCoordSeq_setY_r( geosctxt, cellCenterCoords, 0, cellCenterY );
-        currentCellCenter = GEOSGeom_createPoint_r( geosctxt, cellCenterCoords );
-        if ( GEOSPreparedContains_r( geosctxt, polyGeosPrepared, currentCellCenter ) )
+        const int column = pixelOffsetX + j;
+        if ( !tile || column >= tile->firstColumn + tile->columns )
         {
-          stats.addValue( block->value( i, j ) );
+          tile = batch.tile( row, column );
+          if ( !tile )
+            continue;
+        }
+
+        const float value = tile->value( row, column );
+        if ( validPixel( value ) )
+        {
+          stats.addValue( value );
         }
       }
-      cellCenterX += cellSizeX;
     }
-    cellCenterY -= cellSizeY;
   }
-
-  GEOSGeom_destroy_r( geosctxt, currentCellCenter );
-  GEOSPreparedGeom_destroy_r( geosctxt, polyGeosPrepared );
-  GEOSGeom_destroy_r( geosctxt, polyGeos );
-  delete block;
 }
 
 void QgsZonalStatistics::statisticsFromPreciseIntersection( const QgsGeometry &poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats )
+    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const ZoneBatch &batch, FeatureStats &stats ) const
 {
   stats.reset();
 
@@ -456,16 +795,13 @@ void QgsZonalStatistics::statisticsFromPreciseIntersection( const QgsGeometry &p
   double pixelArea = cellSizeX * cellSizeY;
   double weight = 0;
 
-  QgsRectangle featureBBox = poly.boundingBox().intersect( &rasterBBox );
-  QgsRectangle intersectBBox = rasterBBox.intersect( &featureBBox );
-
-  QgsRasterBlock *block = mRasterProvider->block( mRasterBand, intersectBBox, nCellsX, nCellsY );
   for ( int i = 0; i < nCellsY; ++i )
   {
     double currentX = rasterBBox.xMinimum() + cellSizeX / 2.0 + pixelOffsetX * cellSizeX;
-    for ( int j = 0; j < nCellsX; ++j )
+    for ( int j = 0; j < nCellsX; ++j, currentX += cellSizeX )
     {
-      if ( !validPixel( block->value( i, j ) ) )
+      float value = batch.value( pixelOffsetY + i, pixelOffsetX + j );
+      if ( !validPixel( value ) )
       {
         continue;
       }
@@ -481,16 +817,14 @@ void QgsZonalStatistics::statisticsFromPreciseIntersection( const QgsGeometry &p
           if ( intersectionArea >= 0.0 )
           {
             weight = intersectionArea / pixelArea;
-            stats.addValue( block->value( i, j ), weight );
+            stats.addValue( value, weight );
           }
         }
         pixelRectGeometry = QgsGeometry();
       }
-      currentX += cellSizeX;
     }
     currentY -= cellSizeY;
   }
-  delete block;
 }
 
 bool QgsZonalStatistics::validPixel( float value ) const
@@ -35,7 +35,11 @@ class QgsRectangle;
 class QgsField;
 
 /** \ingroup analysis
- *  A class that calculates raster statistics (count, sum, mean) for a polygon or multipolygon layer and appends the results as attributes*/
+ *  A class that calculates raster statistics (count, sum, mean) for a polygon or multipolygon layer and appends the results as attributes.
+ *
+ *  The cells of a polygon are found by scanning its rings row by row. The raster is read in tiles which are
+ *  shared by neighbouring polygons, and the statistics of several polygons are computed concurrently
+ *  (see setThreadCount()).*/
 class ANALYSIS_EXPORT QgsZonalStatistics
 {
   public:
@@ -72,6 +76,19 @@ class ANALYSIS_EXPORT QgsZonalStatistics
       \returns 0 in case of success*/
     int calculateStatistics( QgsFeedback *feedback );
 
+    /** Sets the number of threads computing the statistics of polygons concurrently. By default, the
+     * ideal thread count of the system is used. Set \a count to 1 to process polygons one after the other.
+     * \see threadCount()
+     * \since QGIS 3.0
+     */
+    void setThreadCount( int count ) { mThreadCount = count; }
+
+    /** Returns the number of threads computing the statistics of polygons concurrently.
+     * \see setThreadCount()
+     * \since QGIS 3.0
+     */
+    int threadCount() const { return mThreadCount; }
+
   private:
     QgsZonalStatistics() = default;
 
@@ -116,18 +133,30 @@ class ANALYSIS_EXPORT QgsZonalStatistics
         bool mStoreValueCounts;
     };
 
+    struct RasterTile;
+    class RasterTileCache;
+    struct Zone;
+    struct ZoneBatch;
+
     /** Analysis what cells need to be considered to cover the bounding box of a feature
       \returns 0 in case of success*/
     int cellInfoForBBox( const QgsRectangle &rasterBBox, const QgsRectangle &featureBBox, double cellSizeX, double cellSizeY,
                          int &offsetX, int &offsetY, int &nCellsX, int &nCellsY ) const;
 
-    //! Returns statistics by considering the pixels where the center point is within the polygon (fast)
-    void statisticsFromMiddlePointTest( const QgsGeometry &poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                        double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats );
+    /**
+     * Computes the statistics of a \a zone from the raster tiles of its \a batch. Zones covering at most one
+     * pixel center are only flagged, their statistics are computed with statisticsFromPreciseIntersection().
+     */
+    void processZone( Zone &zone, const ZoneBatch &batch, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox ) const;
+
+    /** Returns statistics by considering the pixels where the center point is within the polygon (fast).
+      The pixels are found by intersecting each row of pixel centers with the polygon rings.*/
+    void statisticsFromScanlines( const QgsGeometry &poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
+                                  double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const ZoneBatch &batch, FeatureStats &stats ) const;
 
     //! Returns statistics with precise pixel - polygon intersection test (slow)
     void statisticsFromPreciseIntersection( const QgsGeometry &poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                            double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats );
+                                            double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const ZoneBatch &batch, FeatureStats &stats ) const;
 
     //! Tests whether a pixel's value should be included in the result
     bool validPixel( float value ) const;
@@ -143,6 +172,8 @@ class ANALYSIS_EXPORT QgsZonalStatistics
     //! The nodata value of the input layer
     float mInputNodataValue = -1;
     Statistics mStatistics = QgsZonalStatistics::All;
+    //! Number of threads computing the statistics of polygons concurrently
+    int mThreadCount = 1;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsZonalStatistics::Statistics )
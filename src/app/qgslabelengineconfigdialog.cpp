@@ -46,6 +46,8 @@ QgsLabelEngineConfigDialog::QgsLabelEngineConfigDialog( QWidget *parent )
 
   chkShowPartialsLabels->setChecked( engineSettings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
   mDrawOutlinesChkBox->setChecked( engineSettings.testFlag( QgsLabelingEngineSettings::RenderOutlineLabels ) );
+  chkReusePlacements->setChecked( engineSettings.testFlag( QgsLabelingEngineSettings::ReusePlacements ) );
+  chkSolveInParallel->setChecked( engineSettings.testFlag( QgsLabelingEngineSettings::SolveInParallel ) );
 }
 
 
@@ -62,6 +64,8 @@ void QgsLabelEngineConfigDialog::onOK()
   engineSettings.setFlag( QgsLabelingEngineSettings::UseAllLabels, chkShowAllLabels->isChecked() );
   engineSettings.setFlag( QgsLabelingEngineSettings::UsePartialCandidates, chkShowPartialsLabels->isChecked() );
   engineSettings.setFlag( QgsLabelingEngineSettings::RenderOutlineLabels, mDrawOutlinesChkBox->isChecked() );
+  engineSettings.setFlag( QgsLabelingEngineSettings::ReusePlacements, chkReusePlacements->isChecked() );
+  engineSettings.setFlag( QgsLabelingEngineSettings::SolveInParallel, chkSolveInParallel->isChecked() );
 
   QgsProject::instance()->setLabelingEngineSettings( engineSettings );
 
@@ -79,4 +83,6 @@ void QgsLabelEngineConfigDialog::setDefaults()
   chkShowAllLabels->setChecked( false );
   chkShowPartialsLabels->setChecked( p.getShowPartial() );
   mDrawOutlinesChkBox->setChecked( true );
+  chkReusePlacements->setChecked( false );
+  chkSolveInParallel->setChecked( false );
 }
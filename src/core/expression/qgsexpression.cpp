@@ -17,6 +17,8 @@
 #include "qgsexpressionfunction.h"
 #include "qgsexpressionprivate.h"
 #include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionbatch.h"
+#include "qgsfeaturebatch.h"
 #include "qgsfeaturerequest.h"
 #include "qgscolorramp.h"
 #include "qgslogger.h"
@@ -99,6 +101,7 @@ bool QgsExpression::checkExpression( const QString &text, const QgsExpressionCon
 void QgsExpression::setExpression( const QString &expression )
 {
   detach();
+  d->mProgram.reset();
   d->mRootNode = ::parseExpression( expression, d->mParserErrorString );
   d->mEvalErrorString = QString();
   d->mExp = expression;
@@ -336,7 +339,24 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
     return false;
   }
 
-  return d->mRootNode->prepare( this, context );
+  bool result = d->mRootNode->prepare( this, context );
+
+  // prepared nodes are lowered to a program, which evaluates faster than the tree
+  d->mProgram.reset( d->mCompilationEnabled ? QgsExpressionProgram::compile( d->mRootNode ) : nullptr );
+  return result;
+}
+
+void QgsExpression::setCompilationEnabled( bool enabled )
+{
+  detach();
+  d->mCompilationEnabled = enabled;
+  if ( !enabled )
+    d->mProgram.reset();
+}
+
+bool QgsExpression::compilationEnabled() const
+{
+  return d->mCompilationEnabled;
 }
 
 QVariant QgsExpression::evaluate()
@@ -360,9 +380,41 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
     return QVariant();
   }
 
+  if ( d->mProgram )
+    return d->mProgram->run( this, context );
+
   return d->mRootNode->eval( this, context );
 }
 
+QVariantList QgsExpression::evaluateBatch( const QgsFeatureBatch &batch, QgsExpressionContext *context )
+{
+  QgsExpressionBatchValues values;
+  evaluateBatch( batch, context, values );
+
+  QVariantList results;
+  results.reserve( batch.count() );
+  for ( int row = 0; row < batch.count(); ++row )
+    results << values.value( row );
+  return results;
+}
+
+void QgsExpression::evaluateBatch( const QgsFeatureBatch &batch, QgsExpressionContext *context, QgsExpressionBatchValues &values, const QList<QgsFeature> *features )
+{
+  d->mEvalErrorString = QString();
+  if ( !d->mRootNode )
+  {
+    d->mEvalErrorString = tr( "No root node! Parsing failed?" );
+    values.reset( QgsExpressionBatchValues::Null, batch.count() );
+    return;
+  }
+
+  // nodes evaluated feature by feature need a context to set the features on
+  QgsExpressionContext featureContext;
+  QgsExpressionBatchContext batchContext( batch, context ? context : &featureContext, features );
+  d->mRootNode->evalBatch( this, batchContext, values );
+  d->mEvalErrorString = batchContext.error();
+}
+
 bool QgsExpression::hasEvalError() const
 {
   return !d->mEvalErrorString.isNull();
@@ -40,7 +40,9 @@ class QgsFields;
 class QgsDistanceArea;
 class QDomElement;
 class QgsExpressionContext;
+class QgsExpressionBatchValues;
 class QgsExpressionPrivate;
+class QgsFeatureBatch;
 class QgsExpressionNode;
 class QgsExpressionFunction;
 
@@ -175,6 +177,23 @@ class CORE_EXPORT QgsExpression
      */
     bool prepare( const QgsExpressionContext *context );
 
+    /**
+     * Sets whether prepare() compiles the expression to a program, which evaluate() runs
+     * instead of evaluating the nodes of the expression. Compilation is enabled by default.
+     * Disabling it drops the program of a prepared expression, enabling it only takes effect
+     * at the next call to prepare().
+     * \see compilationEnabled()
+     * \since QGIS 3.0
+     */
+    void setCompilationEnabled( bool enabled );
+
+    /**
+     * Returns whether prepare() compiles the expression to a program.
+     * \see setCompilationEnabled()
+     * \since QGIS 3.0
+     */
+    bool compilationEnabled() const;
+
     /**
      * Get list of columns referenced by the expression.
      *
@@ -220,6 +239,35 @@ class CORE_EXPORT QgsExpression
      */
     QVariant evaluate( const QgsExpressionContext *context );
 
+    /**
+     * Evaluates the expression for all the features of a \a batch and returns the results, one per feature.
+     *
+     * Operators and common functions on number and string attributes are evaluated for the whole batch
+     * at once. The other parts of the expression are evaluated feature by feature, with each feature
+     * set in turn on the \a context. If the evaluation fails for some features, their results are NULL
+     * and evalErrorString() returns the first error.
+     *
+     * \param batch features to evaluate the expression for
+     * \param context context for evaluating expression. If nullptr, a context with only the features is used.
+     * \note prepare() should be called before calling this method.
+     * \see evaluate()
+     * \since QGIS 3.0
+     */
+    QVariantList evaluateBatch( const QgsFeatureBatch &batch, QgsExpressionContext *context );
+
+    /**
+     * Evaluates the expression for all the features of a \a batch and stores the results
+     * in \a values, without converting them to variants.
+     *
+     * If \a features is set, it must hold the features the rows of the batch were read from.
+     * They are then used for the parts of the expression evaluated feature by feature, and the
+     * batch only needs the columns of the attributes referenced by the expression.
+     * \note not available in Python bindings
+     * \see evaluate()
+     * \since QGIS 3.0
+     */
+    void evaluateBatch( const QgsFeatureBatch &batch, QgsExpressionContext *context, QgsExpressionBatchValues &values, const QList<QgsFeature> *features = nullptr ) SIP_SKIP;
+
     //! Returns true if an error occurred when evaluating last input
     bool hasEvalError() const;
     //! Returns evaluation error
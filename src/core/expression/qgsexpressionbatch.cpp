@@ -0,0 +1,205 @@
+/***************************************************************************
+  qgsexpressionbatch.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionbatch.h"
+#include "qgsfeaturebatch.h"
+
+void QgsExpressionBatchValues::reset( Type type, int count, QVariant::Type variantType, QVariant::Type nullType )
+{
+  mType = type;
+  mConstant = false;
+  mVariantType = variantType;
+  mNullType = nullType;
+  mConstantValue = QVariant();
+
+  // resizing keeps the capacity of the vectors when the values are reused
+  mIntegers.resize( type == Integer ? count : 0 );
+  mDoubles.resize( type == Double ? count : 0 );
+  mStrings.resize( type == String ? count : 0 );
+  mVariants.resize( type == Variant ? count : 0 );
+  mNulls.fill( 1, count );
+}
+
+void QgsExpressionBatchValues::setConstant( const QVariant &value )
+{
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      reset( Integer, 1, value.type(), value.type() );
+      if ( !value.isNull() )
+        setInteger( 0, value.toLongLong() );
+      break;
+
+    case QVariant::Double:
+      reset( Double, 1, QVariant::Double, QVariant::Double );
+      if ( !value.isNull() )
+        setDouble( 0, value.toDouble() );
+      break;
+
+    case QVariant::String:
+      reset( String, 1, QVariant::String, QVariant::String );
+      if ( !value.isNull() )
+        setString( 0, value.toString() );
+      break;
+
+    default:
+      reset( value.isNull() ? Null : Variant, 1 );
+      if ( mType == Variant )
+        setVariant( 0, value );
+      break;
+  }
+  mConstant = true;
+  mConstantValue = value;
+}
+
+QVariant QgsExpressionBatchValues::value( int row ) const
+{
+  if ( mConstant )
+    return mConstantValue;
+
+  if ( mType == Variant )
+    return mVariants.at( row );
+
+  if ( mType == Null || mNulls.at( row ) )
+    return QVariant( mNullType );
+
+  switch ( mType )
+  {
+    case Integer:
+    {
+      QVariant v( mIntegers.at( row ) );
+      if ( mVariantType != QVariant::LongLong )
+        v.convert( mVariantType );
+      return v;
+    }
+
+    case Double:
+      return mDoubles.at( row );
+
+    case String:
+      return mStrings.at( row );
+
+    case Null:
+    case Variant:
+      break;
+  }
+  return QVariant();
+}
+
+void QgsExpressionBatchValues::narrow()
+{
+  if ( mType != Variant || mConstant )
+    return;
+
+  // all values and all NULLs must share a single type, so that value() returns them unchanged
+  QVariant::Type valueType = QVariant::Invalid;
+  QVariant::Type nullType = QVariant::Invalid;
+  bool hasValue = false;
+  bool hasNull = false;
+  for ( const QVariant &v : qgsAsConst( mVariants ) )
+  {
+    QVariant::Type &type = v.isNull() ? nullType : valueType;
+    bool &seen = v.isNull() ? hasNull : hasValue;
+    if ( !seen )
+    {
+      type = v.type();
+      seen = true;
+    }
+    else if ( v.type() != type )
+    {
+      return;
+    }
+  }
+
+  Type narrowedType;
+  switch ( valueType )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+      narrowedType = Integer;
+      break;
+    case QVariant::Double:
+      narrowedType = Double;
+      break;
+    case QVariant::String:
+      narrowedType = String;
+      break;
+    default:
+      if ( hasValue )
+        return;
+      narrowedType = Null;
+      break;
+  }
+
+  QVector<QVariant> variants;
+  variants.swap( mVariants );
+  reset( narrowedType, variants.count(), valueType == QVariant::Invalid ? QVariant::LongLong : valueType, nullType );
+  if ( narrowedType == Null )
+    return;
+
+  for ( int row = 0; row < variants.count(); ++row )
+  {
+    const QVariant &v = variants.at( row );
+    if ( v.isNull() )
+      continue;
+
+    switch ( narrowedType )
+    {
+      case Integer:
+        setInteger( row, v.toLongLong() );
+        break;
+      case Double:
+        setDouble( row, v.toDouble() );
+        break;
+      case String:
+        setString( row, v.toString() );
+        break;
+      case Null:
+      case Variant:
+        break;
+    }
+  }
+}
+
+QgsExpressionBatchContext::QgsExpressionBatchContext( const QgsFeatureBatch &batch, QgsExpressionContext *context, const QgsFeatureList *features )
+  : mBatch( batch )
+  , mContext( context )
+  , mCount( batch.count() )
+  , mSourceFeatures( features )
+{
+  Q_ASSERT( !features || features->count() == mCount );
+}
+
+const QgsFeature &QgsExpressionBatchContext::feature( int row )
+{
+  if ( mSourceFeatures )
+    return mSourceFeatures->at( row );
+
+  if ( mFeatures.isEmpty() )
+  {
+    mFeatures.reserve( mCount );
+    for ( int i = 0; i < mCount; ++i )
+      mFeatures.append( mBatch.feature( i ) );
+  }
+  return mFeatures.at( row );
+}
+
+void QgsExpressionBatchContext::addError( const QString &error )
+{
+  if ( mError.isNull() )
+    mError = error;
+}
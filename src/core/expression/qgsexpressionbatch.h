@@ -0,0 +1,179 @@
+/***************************************************************************
+  qgsexpressionbatch.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONBATCH_H
+#define QGSEXPRESSIONBATCH_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeature.h"
+
+#include <QVariant>
+#include <QVector>
+
+class QgsExpressionContext;
+class QgsFeatureBatch;
+
+/**
+ * \ingroup core
+ * \class QgsExpressionBatchValues
+ * The values of an expression node for all the features of a QgsFeatureBatch.
+ *
+ * Numbers and strings are stored unboxed in typed arrays, so that expression nodes
+ * can process a whole batch in a tight loop. Values which can not be stored in a
+ * typed array (dates, geometries, mixed types...) are stored as variants. A node
+ * with a static value is stored once as a constant and applies to all rows.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsExpressionBatchValues
+{
+  public:
+
+    //! Storage type of the values
+    enum Type
+    {
+      Null, //!< All values are NULL
+      Integer, //!< Values are 64 bit integers
+      Double, //!< Values are doubles
+      String, //!< Values are strings
+      Variant, //!< Values are variants
+    };
+
+    //! Returns the storage type of the values
+    Type type() const { return mType; }
+
+    //! Returns true if the values are numbers (integers or doubles)
+    bool isNumeric() const { return mType == Integer || mType == Double; }
+
+    //! Returns the variant type of NULL values returned by value()
+    QVariant::Type nullType() const { return mNullType; }
+
+    //! Returns true if the same value applies to all rows
+    bool isConstant() const { return mConstant; }
+
+    /**
+     * Removes all values and prepares storage for \a count rows of the given \a type.
+     * All rows are initially NULL. Integer values are returned by value() as variants of
+     * \a variantType, and NULL values as variants of \a nullType.
+     */
+    void reset( Type type, int count, QVariant::Type variantType = QVariant::LongLong, QVariant::Type nullType = QVariant::Invalid );
+
+    //! Sets a constant \a value for all rows
+    void setConstant( const QVariant &value );
+
+    //! Returns true if the value at \a row is NULL
+    bool isNull( int row ) const { return mType == Null || mNulls.at( mConstant ? 0 : row ); }
+
+    //! Returns the integer value at \a row, for Integer values
+    qint64 integer( int row ) const { return mIntegers.at( mConstant ? 0 : row ); }
+
+    //! Returns the value at \a row as a double, for Integer and Double values
+    double number( int row ) const { return mType == Integer ? mIntegers.at( mConstant ? 0 : row ) : mDoubles.at( mConstant ? 0 : row ); }
+
+    //! Returns the string value at \a row, for String values
+    const QString &string( int row ) const { return mStrings.at( mConstant ? 0 : row ); }
+
+    //! Returns the value at \a row as a variant
+    QVariant value( int row ) const;
+
+    //! Sets an integer \a value at \a row
+    void setInteger( int row, qint64 value ) { mIntegers[row] = value; mNulls[row] = 0; }
+
+    //! Sets a double \a value at \a row
+    void setDouble( int row, double value ) { mDoubles[row] = value; mNulls[row] = 0; }
+
+    //! Sets a string \a value at \a row
+    void setString( int row, const QString &value ) { mStrings[row] = value; mNulls[row] = 0; }
+
+    //! Sets a variant \a value at \a row
+    void setVariant( int row, const QVariant &value ) { mVariants[row] = value; mNulls[row] = value.isNull() ? 1 : 0; }
+
+    /**
+     * Converts Variant values to typed values when all the values have the same
+     * integer, double or string type, so that parent nodes can process them in batch.
+     */
+    void narrow();
+
+  private:
+
+    Type mType = Null;
+    bool mConstant = false;
+    QVariant::Type mVariantType = QVariant::LongLong;
+    QVariant::Type mNullType = QVariant::Invalid;
+    QVariant mConstantValue;
+
+    QVector<qint64> mIntegers;
+    QVector<double> mDoubles;
+    QVector<QString> mStrings;
+    QVector<QVariant> mVariants;
+    QVector<char> mNulls;
+};
+
+/**
+ * \ingroup core
+ * \class QgsExpressionBatchContext
+ * The state shared by the nodes of an expression while it is evaluated over a QgsFeatureBatch.
+ *
+ * Nodes which can not process the batch at once are evaluated feature by feature. The features
+ * they need are either the ones the batch was read from, when they are given, or created from
+ * the batch on first use, and then shared by all nodes.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsExpressionBatchContext
+{
+  public:
+
+    /**
+     * Constructor for QgsExpressionBatchContext, for evaluating over \a batch with the given expression \a context.
+     * If \a features is set, it must hold the features of all the rows of the batch, and they are
+     * used for the feature by feature evaluation instead of features created from the batch.
+     */
+    QgsExpressionBatchContext( const QgsFeatureBatch &batch, QgsExpressionContext *context, const QgsFeatureList *features = nullptr );
+
+    //! Returns the batch of features
+    const QgsFeatureBatch &batch() const { return mBatch; }
+
+    //! Returns the expression context, may be nullptr
+    QgsExpressionContext *expressionContext() const { return mContext; }
+
+    //! Returns the number of features in the batch
+    int count() const { return mCount; }
+
+    //! Returns the feature at \a row
+    const QgsFeature &feature( int row );
+
+    /**
+     * Records an evaluation error from a feature evaluated on its own. Only the first error is kept.
+     */
+    void addError( const QString &error );
+
+    //! Returns the first evaluation error, or a null string if the evaluation succeeded
+    QString error() const { return mError; }
+
+  private:
+
+    const QgsFeatureBatch &mBatch;
+    QgsExpressionContext *mContext = nullptr;
+    int mCount = 0;
+    const QgsFeatureList *mSourceFeatures = nullptr;
+    QVector<QgsFeature> mFeatures;
+    QString mError;
+};
+
+#endif // QGSEXPRESSIONBATCH_H
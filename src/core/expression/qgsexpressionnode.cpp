@@ -14,6 +14,10 @@
  ***************************************************************************/
 
 #include "qgsexpressionnode.h"
+#include "qgsexpression.h"
+#include "qgsexpressionbatch.h"
+#include "qgsexpressioncontext.h"
+#include "qgsexpressionprogram.h"
 
 
 QVariant QgsExpressionNode::eval( QgsExpression *parent, const QgsExpressionContext *context )
@@ -29,6 +33,58 @@ QVariant QgsExpressionNode::eval( QgsExpression *parent, const QgsExpressionCont
   }
 }
 
+void QgsExpressionNode::evalBatch( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values )
+{
+  if ( mHasCachedValue )
+  {
+    values.setConstant( mCachedStaticValue );
+    return;
+  }
+
+  if ( evalBatchNode( parent, context, values ) )
+    return;
+
+  // evaluate feature by feature
+  QgsExpressionContext *expressionContext = context.expressionContext();
+  values.reset( QgsExpressionBatchValues::Variant, context.count() );
+  for ( int row = 0; row < context.count(); ++row )
+  {
+    if ( expressionContext )
+      expressionContext->setFeature( context.feature( row ) );
+
+    QVariant value = eval( parent, expressionContext );
+    if ( parent->hasEvalError() )
+    {
+      context.addError( parent->evalErrorString() );
+      parent->setEvalErrorString( QString() );
+      value = QVariant();
+    }
+    values.setVariant( row, value );
+  }
+  values.narrow();
+}
+
+bool QgsExpressionNode::evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values )
+{
+  Q_UNUSED( parent );
+  Q_UNUSED( context );
+  Q_UNUSED( values );
+  return false;
+}
+
+int QgsExpressionNode::compile( QgsExpressionProgram &program )
+{
+  if ( mHasCachedValue )
+    return program.addConstant( mCachedStaticValue );
+
+  return compileNode( program );
+}
+
+int QgsExpressionNode::compileNode( QgsExpressionProgram &program )
+{
+  return program.addEvaluate( this );
+}
+
 bool QgsExpressionNode::prepare( QgsExpression *parent, const QgsExpressionContext *context )
 {
   if ( isStatic( parent, context ) )
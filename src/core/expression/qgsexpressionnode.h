@@ -25,6 +25,9 @@
 
 class QgsExpression;
 class QgsExpressionContext;
+class QgsExpressionBatchContext;
+class QgsExpressionBatchValues;
+class QgsExpressionProgram;
 
 /**
  * \ingroup core
@@ -181,6 +184,25 @@ class CORE_EXPORT QgsExpressionNode SIP_ABSTRACT
      */
     QVariant eval( QgsExpression *parent, const QgsExpressionContext *context );
 
+    /**
+     * Evaluates this node for all the features of a batch and stores the results in \a values.
+     * Nodes which can not process the whole batch at once are evaluated feature by feature,
+     * errors from these evaluations are recorded in the batch \a context.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void evalBatch( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values ) SIP_SKIP;
+
+    /**
+     * Adds the instructions evaluating this prepared node to a \a program and returns the
+     * operand holding its result. Nodes with a static value are added as constants.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    int compile( QgsExpressionProgram &program ) SIP_SKIP;
+
     /**
      * Generate a clone of this node.
      * Ownership is transferred to the caller.
@@ -266,6 +288,20 @@ class CORE_EXPORT QgsExpressionNode SIP_ABSTRACT
      */
     virtual QVariant evalNode( QgsExpression *parent, const QgsExpressionContext *context ) = 0;
 
+    /**
+     * Virtual batch eval method. Returns false if the node can not process the batch at once,
+     * in which case it is evaluated feature by feature with evalNode().
+     * \since QGIS 3.0
+     */
+    virtual bool evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values ) SIP_SKIP;
+
+    /**
+     * Virtual compile method. The default implementation adds an instruction evaluating
+     * the node with eval().
+     * \since QGIS 3.0
+     */
+    virtual int compileNode( QgsExpressionProgram &program ) SIP_SKIP;
+
     bool mHasCachedValue = false;
     QVariant mCachedStaticValue;
 };
@@ -16,10 +16,55 @@
 #include "qgsexpressionnodeimpl.h"
 #include "qgsexpressionutils.h"
 #include "qgsexpression.h"
+#include "qgsexpressionbatch.h"
+#include "qgsexpressioncontext.h"
+#include "qgsexpressionprogram.h"
 
 #include "qgsgeometry.h"
+#include "qgsfeaturebatch.h"
 #include "qgsfeaturerequest.h"
 
+// helpers for batch evaluation
+
+//! Returns true if the batch values are numbers, or only NULLs
+static bool isNumericBatch( const QgsExpressionBatchValues &values )
+{
+  return values.isNumeric() || values.type() == QgsExpressionBatchValues::Null;
+}
+
+//! Returns true if the batch values are strings, or only NULLs
+static bool isStringBatch( const QgsExpressionBatchValues &values )
+{
+  return values.type() == QgsExpressionBatchValues::String || values.type() == QgsExpressionBatchValues::Null;
+}
+
+//! Returns true if the value at \a row would be evaluated as a variant of string type (NULL strings included)
+static bool isStringVariant( const QgsExpressionBatchValues &values, int row )
+{
+  if ( values.isNull( row ) )
+    return values.nullType() == QVariant::String;
+  return values.type() == QgsExpressionBatchValues::String;
+}
+
+//! Returns the three-valued logic value at \a row of numeric or NULL batch values
+static QgsExpressionUtils::TVL batchTVLValue( const QgsExpressionBatchValues &values, int row )
+{
+  if ( values.isNull( row ) )
+    return QgsExpressionUtils::Unknown;
+  if ( values.type() == QgsExpressionBatchValues::Integer )
+    return values.integer( row ) != 0 ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+  return !qgsDoubleNear( values.number( row ), 0.0 ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+}
+
+//! Stores a three-valued logic value at \a row of Integer batch values
+static void setBatchTVLValue( QgsExpressionBatchValues &values, int row, QgsExpressionUtils::TVL value )
+{
+  if ( value != QgsExpressionUtils::Unknown )
+    values.setInteger( row, value == QgsExpressionUtils::True ? 1 : 0 );
+}
+
+//
+
 const char *QgsExpressionNodeBinaryOperator::BINARY_OPERATOR_TEXT[] =
 {
   // this must correspond (number and order of element) to the declaration of the enum BinaryOperator
@@ -90,6 +135,11 @@ QVariant QgsExpressionNodeUnaryOperator::evalNode( QgsExpression *parent, const
   QVariant val = mOperand->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
 
+  return evalOperand( parent, val );
+}
+
+QVariant QgsExpressionNodeUnaryOperator::evalOperand( QgsExpression *parent, const QVariant &val )
+{
   switch ( mOp )
   {
     case uoNot:
@@ -112,6 +162,56 @@ QVariant QgsExpressionNodeUnaryOperator::evalNode( QgsExpression *parent, const
   return QVariant();
 }
 
+bool QgsExpressionNodeUnaryOperator::evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values )
+{
+  QgsExpressionBatchValues operand;
+  mOperand->evalBatch( parent, context, operand );
+  const int count = context.count();
+
+  switch ( mOp )
+  {
+    case uoNot:
+      if ( !isNumericBatch( operand ) )
+        return false;
+
+      values.reset( QgsExpressionBatchValues::Integer, count, QVariant::Int );
+      for ( int row = 0; row < count; ++row )
+        setBatchTVLValue( values, row, QgsExpressionUtils::NOT[batchTVLValue( operand, row )] );
+      return true;
+
+    case uoMinus:
+      // NULL operands raise an error or are converted to 0, leave them to evalNode()
+      if ( !operand.isNumeric() )
+        return false;
+      for ( int row = 0; row < count; ++row )
+      {
+        if ( operand.isNull( row ) )
+          return false;
+      }
+
+      if ( operand.type() == QgsExpressionBatchValues::Integer )
+      {
+        values.reset( QgsExpressionBatchValues::Integer, count );
+        for ( int row = 0; row < count; ++row )
+          values.setInteger( row, -operand.integer( row ) );
+      }
+      else
+      {
+        values.reset( QgsExpressionBatchValues::Double, count, QVariant::Double );
+        for ( int row = 0; row < count; ++row )
+          values.setDouble( row, -operand.number( row ) );
+      }
+      return true;
+  }
+  return false;
+}
+
+int QgsExpressionNodeUnaryOperator::compileNode( QgsExpressionProgram &program )
+{
+  int operand = mOperand->compile( program );
+  return program.addUnaryOperator( mOp, operand, this );
+}
+
 QgsExpressionNode::NodeType QgsExpressionNodeUnaryOperator::nodeType() const
 {
   return ntUnaryOperator;
@@ -168,6 +268,11 @@ QVariant QgsExpressionNodeBinaryOperator::evalNode( QgsExpression *parent, const
   QVariant vR = mOpRight->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
 
+  return evalOperands( parent, context, vL, vR );
+}
+
+QVariant QgsExpressionNodeBinaryOperator::evalOperands( QgsExpression *parent, const QgsExpressionContext *context, const QVariant &vL, const QVariant &vR )
+{
   switch ( mOp )
   {
     case boPlus:
@@ -509,6 +614,186 @@ QVariant QgsExpressionNodeBinaryOperator::evalNode( QgsExpression *parent, const
   return QVariant();
 }
 
+bool QgsExpressionNodeBinaryOperator::evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values )
+{
+  switch ( mOp )
+  {
+    case boRegexp:
+    case boLike:
+    case boNotLike:
+    case boILike:
+    case boNotILike:
+    case boIntDiv:
+      return false;
+
+    default:
+      break;
+  }
+
+  QgsExpressionBatchValues vL;
+  QgsExpressionBatchValues vR;
+  mOpLeft->evalBatch( parent, context, vL );
+  mOpRight->evalBatch( parent, context, vR );
+  const int count = context.count();
+
+  switch ( mOp )
+  {
+    case boPlus:
+      if ( isStringBatch( vL ) && isStringBatch( vR ) )
+      {
+        // two string variants are concatenated, NULL strings included. Only two NULL strings give NULL
+        values.reset( QgsExpressionBatchValues::String, count, QVariant::String );
+        for ( int row = 0; row < count; ++row )
+        {
+          if ( !isStringVariant( vL, row ) || !isStringVariant( vR, row ) || ( vL.isNull( row ) && vR.isNull( row ) ) )
+            continue;
+          values.setString( row, ( vL.isNull( row ) ? QString() : vL.string( row ) ) + ( vR.isNull( row ) ? QString() : vR.string( row ) ) );
+        }
+        return true;
+      }
+      FALLTHROUGH;
+    case boMinus:
+    case boMul:
+    case boDiv:
+    case boMod:
+    case boPow:
+    {
+      if ( !isNumericBatch( vL ) || !isNumericBatch( vR ) )
+        return false;
+
+      if ( vL.type() == QgsExpressionBatchValues::Null || vR.type() == QgsExpressionBatchValues::Null )
+      {
+        values.reset( QgsExpressionBatchValues::Null, count );
+      }
+      else if ( mOp != boDiv && mOp != boPow && vL.type() == QgsExpressionBatchValues::Integer && vR.type() == QgsExpressionBatchValues::Integer )
+      {
+        // both are integers - let's use integer arithmetics
+        values.reset( QgsExpressionBatchValues::Integer, count );
+        for ( int row = 0; row < count; ++row )
+        {
+          if ( vL.isNull( row ) || vR.isNull( row ) || ( mOp == boMod && vR.integer( row ) == 0 ) )
+            continue;
+          values.setInteger( row, computeInt( vL.integer( row ), vR.integer( row ) ) );
+        }
+      }
+      else
+      {
+        // general floating point arithmetic
+        values.reset( QgsExpressionBatchValues::Double, count, QVariant::Double );
+        for ( int row = 0; row < count; ++row )
+        {
+          if ( vL.isNull( row ) || vR.isNull( row ) )
+            continue;
+          double fL = vL.number( row );
+          double fR = vR.number( row );
+          if ( mOp == boPow )
+            values.setDouble( row, std::pow( fL, fR ) );
+          else if ( ( mOp == boDiv || mOp == boMod ) && fR == 0. )
+            continue; // silently handle division by zero and return NULL
+          else
+            values.setDouble( row, computeDouble( fL, fR ) );
+        }
+      }
+      return true;
+    }
+
+    case boAnd:
+    case boOr:
+      if ( !isNumericBatch( vL ) || !isNumericBatch( vR ) )
+        return false;
+
+      values.reset( QgsExpressionBatchValues::Integer, count, QVariant::Int );
+      for ( int row = 0; row < count; ++row )
+      {
+        QgsExpressionUtils::TVL tvlL = batchTVLValue( vL, row ), tvlR = batchTVLValue( vR, row );
+        setBatchTVLValue( values, row, mOp == boAnd ? QgsExpressionUtils::AND[tvlL][tvlR] : QgsExpressionUtils::OR[tvlL][tvlR] );
+      }
+      return true;
+
+    case boEQ:
+    case boNE:
+    case boLT:
+    case boGT:
+    case boLE:
+    case boGE:
+    {
+      const bool numeric = isNumericBatch( vL ) && isNumericBatch( vR );
+      if ( !numeric && !( isStringBatch( vL ) && isStringBatch( vR ) ) )
+        return false;
+
+      values.reset( QgsExpressionBatchValues::Integer, count, QVariant::Int );
+      for ( int row = 0; row < count; ++row )
+      {
+        if ( vL.isNull( row ) || vR.isNull( row ) )
+          continue;
+        bool result = numeric ? compare( vL.number( row ) - vR.number( row ) ) : compare( QString::compare( vL.string( row ), vR.string( row ) ) );
+        values.setInteger( row, result ? 1 : 0 );
+      }
+      return true;
+    }
+
+    case boIs:
+    case boIsNot:
+    {
+      const bool numeric = isNumericBatch( vL ) && isNumericBatch( vR );
+      const bool nullOperand = vL.type() == QgsExpressionBatchValues::Null || vR.type() == QgsExpressionBatchValues::Null;
+      if ( !numeric && !nullOperand && !( isStringBatch( vL ) && isStringBatch( vR ) ) )
+        return false;
+
+      values.reset( QgsExpressionBatchValues::Integer, count, QVariant::Int );
+      for ( int row = 0; row < count; ++row )
+      {
+        bool equal;
+        if ( vL.isNull( row ) || vR.isNull( row ) )
+          equal = vL.isNull( row ) && vR.isNull( row );
+        else if ( numeric )
+          equal = qgsDoubleNear( vL.number( row ), vR.number( row ) );
+        else
+          equal = QString::compare( vL.string( row ), vR.string( row ) ) == 0;
+        values.setInteger( row, equal == ( mOp == boIs ) ? 1 : 0 );
+      }
+      return true;
+    }
+
+    case boConcat:
+      if ( !isStringBatch( vL ) || !isStringBatch( vR ) )
+        return false;
+
+      values.reset( QgsExpressionBatchValues::String, count, QVariant::String );
+      for ( int row = 0; row < count; ++row )
+      {
+        if ( vL.isNull( row ) || vR.isNull( row ) )
+          continue;
+        values.setString( row, vL.string( row ) + vR.string( row ) );
+      }
+      return true;
+
+    default:
+      break;
+  }
+  return false;
+}
+
+int QgsExpressionNodeBinaryOperator::compileNode( QgsExpressionProgram &program )
+{
+  switch ( mOp )
+  {
+    case boRegexp:
+    case boLike:
+    case boNotLike:
+    case boILike:
+    case boNotILike:
+      return program.addEvaluate( this );
+
+    default:
+      break;
+  }
+
+  int left = mOpLeft->compile( program );
+  int right = mOpRight->compile( program );
+  return program.addBinaryOperator( mOp, left, right, this );
+}
+
 bool QgsExpressionNodeBinaryOperator::compare( double diff )
 {
   switch ( mOp )
@@ -853,6 +1138,126 @@ QVariant QgsExpressionNodeFunction::evalNode( QgsExpression *parent, const QgsEx
   return res;
 }
 
+QVariant QgsExpressionNodeFunction::evalArguments( QgsExpression *parent, const QgsExpressionContext *context, const QVariantList &values )
+{
+  QString name = QgsExpression::Functions()[mFnIndex]->name();
+  QgsExpressionFunction *fd = context && context->hasFunction( name ) ? context->function( name ) : QgsExpression::Functions()[mFnIndex];
+
+  // functions with lazy evaluation need the argument nodes
+  if ( fd->lazyEval() )
+    return evalNode( parent, context );
+
+  // all "normal" functions return NULL when an argument is NULL, as in QgsExpressionFunction::run()
+  const QgsExpressionFunction::ParameterList &params = fd->parameters();
+  for ( int arg = 0; arg < values.count(); ++arg )
+  {
+    bool defaultParamIsNull = params.count() > arg && params.at( arg ).optional() && !params.at( arg ).defaultValue().isValid();
+    if ( QgsExpressionUtils::isNull( values.at( arg ) ) && !defaultParamIsNull && !fd->handlesNull() )
+      return QVariant();
+  }
+
+  QVariant res = fd->func( values, context, parent );
+  ENSURE_NO_EVAL_ERROR;
+  return res;
+}
+
+bool QgsExpressionNodeFunction::evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values )
+{
+  QString name = QgsExpression::Functions()[mFnIndex]->name();
+  if ( !mArgs || mArgs->count() != 1 || ( context.expressionContext() && context.expressionContext()->hasFunction( name ) ) )
+    return false;
+
+  int function = QgsExpressionProgram::functionFromName( name );
+  if ( function < 0 )
+    return false;
+
+  QgsExpressionBatchValues arg;
+  mArgs->at( 0 )->evalBatch( parent, context, arg );
+  const int count = context.count();
+
+  // functions return NULL when their argument is NULL
+  if ( arg.type() == QgsExpressionBatchValues::Null )
+  {
+    values.reset( QgsExpressionBatchValues::Null, count );
+    return true;
+  }
+
+  switch ( function )
+  {
+    case QgsExpressionProgram::Abs:
+    case QgsExpressionProgram::Sqrt:
+    case QgsExpressionProgram::Floor:
+    case QgsExpressionProgram::Ceil:
+      if ( !arg.isNumeric() )
+        return false;
+
+      values.reset( QgsExpressionBatchValues::Double, count, QVariant::Double );
+      for ( int row = 0; row < count; ++row )
+      {
+        if ( arg.isNull( row ) )
+          continue;
+        double x = arg.number( row );
+        switch ( function )
+        {
+          case QgsExpressionProgram::Abs:
+            values.setDouble( row, std::fabs( x ) );
+            break;
+          case QgsExpressionProgram::Sqrt:
+            values.setDouble( row, std::sqrt( x ) );
+            break;
+          case QgsExpressionProgram::Floor:
+            values.setDouble( row, std::floor( x ) );
+            break;
+          default:
+            values.setDouble( row, std::ceil( x ) );
+            break;
+        }
+      }
+      return true;
+
+    case QgsExpressionProgram::Upper:
+    case QgsExpressionProgram::Lower:
+    case QgsExpressionProgram::Trim:
+      if ( arg.type() != QgsExpressionBatchValues::String )
+        return false;
+
+      values.reset( QgsExpressionBatchValues::String, count, QVariant::String );
+      for ( int row = 0; row < count; ++row )
+      {
+        if ( arg.isNull( row ) )
+          continue;
+        const QString &str = arg.string( row );
+        values.setString( row, function == QgsExpressionProgram::Upper ? str.toUpper() : function == QgsExpressionProgram::Lower ? str.toLower() : str.trimmed() );
+      }
+      return true;
+
+    case QgsExpressionProgram::Length:
+      // geometries are handled by evalNode()
+      if ( arg.type() != QgsExpressionBatchValues::String )
+        return false;
+
+      values.reset( QgsExpressionBatchValues::Integer, count, QVariant::Int );
+      for ( int row = 0; row < count; ++row )
+      {
+        if ( !arg.isNull( row ) )
+          values.setInteger( row, arg.string( row ).length() );
+      }
+      return true;
+  }
+  return false;
+}
+
+int QgsExpressionNodeFunction::compileNode( QgsExpressionProgram &program )
+{
+  QString name = QgsExpression::Functions()[mFnIndex]->name();
+  int function = QgsExpressionProgram::functionFromName( name );
+  if ( function < 0 || !mArgs || mArgs->count() != 1 )
+    return program.addEvaluate( this );
+
+  int argument = mArgs->at( 0 )->compile( program );
+  return program.addFunction( static_cast< QgsExpressionProgram::Function >( function ), name, argument, this );
+}
+
 QgsExpressionNodeFunction::QgsExpressionNodeFunction( int fnIndex, QgsExpressionNode::NodeList *args )
   : mFnIndex( fnIndex )
 {
@@ -1085,6 +1490,19 @@ QVariant QgsExpressionNodeLiteral::evalNode( QgsExpression *parent, const QgsExp
   return mValue;
 }
 
+bool QgsExpressionNodeLiteral::evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values )
+{
+  Q_UNUSED( parent );
+  Q_UNUSED( context );
+  values.setConstant( mValue );
+  return true;
+}
+
+int QgsExpressionNodeLiteral::compileNode( QgsExpressionProgram &program )
+{
+  return program.addConstant( mValue );
+}
+
 QgsExpressionNode::NodeType QgsExpressionNodeLiteral::nodeType() const
 {
   return ntLiteral;
@@ -1175,6 +1593,77 @@ QVariant QgsExpressionNodeColumnRef::evalNode( QgsExpression *parent, const QgsE
   return QVariant( '[' + mName + ']' );
 }
 
+bool QgsExpressionNodeColumnRef::evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values )
+{
+  Q_UNUSED( parent );
+  const QgsFeatureBatch &batch = context.batch();
+  int column = batch.columnIndex( mIndex >= 0 ? mIndex : batch.fields().lookupField( mName ) );
+  if ( column < 0 )
+    return false;
+
+  const int count = context.count();
+  QVariant::Type fieldType = batch.fields().at( batch.attributes().at( column ) ).type();
+  switch ( batch.columnType( column ) )
+  {
+    case QgsFeatureBatch::DoubleColumn:
+    {
+      const double *doubles = batch.doubleColumn( column );
+      values.reset( QgsExpressionBatchValues::Double, count, fieldType, fieldType );
+      for ( int row = 0; row < count; ++row )
+      {
+        if ( !batch.isNull( row, column ) )
+          values.setDouble( row, doubles[row] );
+      }
+      return true;
+    }
+
+    case QgsFeatureBatch::IntegerColumn:
+    {
+      // booleans do not follow the integer rules of the operators
+      if ( fieldType == QVariant::Bool )
+        break;
+
+      const qint64 *integers = batch.integerColumn( column );
+      values.reset( QgsExpressionBatchValues::Integer, count, fieldType, fieldType );
+      for ( int row = 0; row < count; ++row )
+      {
+        if ( !batch.isNull( row, column ) )
+          values.setInteger( row, integers[row] );
+      }
+      return true;
+    }
+
+    case QgsFeatureBatch::StringColumn:
+    {
+      const QString *strings = batch.stringColumn( column );
+      values.reset( QgsExpressionBatchValues::String, count, fieldType, fieldType );
+      for ( int row = 0; row < count; ++row )
+      {
+        if ( !batch.isNull( row, column ) )
+          values.setString( row, strings[row] );
+      }
+      return true;
+    }
+
+    case QgsFeatureBatch::VariantColumn:
+      break;
+  }
+
+  values.reset( QgsExpressionBatchValues::Variant, count );
+  for ( int row = 0; row < count; ++row )
+    values.setVariant( row, batch.value( row, column ) );
+  return true;
+}
+
+int QgsExpressionNodeColumnRef::compileNode( QgsExpressionProgram &program )
+{
+  // columns which were not found when preparing are looked up by name for each feature
+  if ( mIndex < 0 )
+    return program.addEvaluate( this );
+
+  return program.addAttribute( mIndex, this );
+}
+
 QgsExpressionNode::NodeType QgsExpressionNodeColumnRef::nodeType() const
 {
   return ntColumnRef;
@@ -52,6 +52,8 @@ class CORE_EXPORT QgsExpressionNodeUnaryOperator : public QgsExpressionNode
     virtual QgsExpressionNode::NodeType nodeType() const override;
     virtual bool prepareNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
     virtual QVariant evalNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
+    virtual bool evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values ) override SIP_SKIP;
+    virtual int compileNode( QgsExpressionProgram &program ) override SIP_SKIP;
     virtual QString dump() const override;
 
     virtual QSet<QString> referencedColumns() const override;
@@ -61,6 +63,13 @@ class CORE_EXPORT QgsExpressionNodeUnaryOperator : public QgsExpressionNode
 
     virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
 
+    /**
+     * Applies the operator to the value \a val of its operand, evaluated beforehand.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QVariant evalOperand( QgsExpression *parent, const QVariant &val ) SIP_SKIP;
+
     /**
      * Returns a the name of this operator without the operands.
      * I.e. "NOT" or "-"
@@ -135,6 +144,8 @@ class CORE_EXPORT QgsExpressionNodeBinaryOperator : public QgsExpressionNode
     virtual QgsExpressionNode::NodeType nodeType() const override;
     virtual bool prepareNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
     virtual QVariant evalNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
+    virtual bool evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values ) override SIP_SKIP;
+    virtual int compileNode( QgsExpressionProgram &program ) override SIP_SKIP;
     virtual QString dump() const override;
 
     virtual QSet<QString> referencedColumns() const override;
@@ -143,6 +154,14 @@ class CORE_EXPORT QgsExpressionNodeBinaryOperator : public QgsExpressionNode
     virtual QgsExpressionNode *clone() const override SIP_FACTORY;
     virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
 
+    /**
+     * Applies the operator to the values \a vL and \a vR of its operands, evaluated beforehand
+     * for the same \a context.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QVariant evalOperands( QgsExpression *parent, const QgsExpressionContext *context, const QVariant &vL, const QVariant &vR ) SIP_SKIP;
+
     int precedence() const;
     bool leftAssociative() const;
 
@@ -227,6 +246,8 @@ class CORE_EXPORT QgsExpressionNodeFunction : public QgsExpressionNode
     virtual QgsExpressionNode::NodeType nodeType() const override;
     virtual bool prepareNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
     virtual QVariant evalNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
+    virtual bool evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values ) override SIP_SKIP;
+    virtual int compileNode( QgsExpressionProgram &program ) override SIP_SKIP;
     virtual QString dump() const override;
 
     virtual QSet<QString> referencedColumns() const override;
@@ -235,6 +256,14 @@ class CORE_EXPORT QgsExpressionNodeFunction : public QgsExpressionNode
     virtual QgsExpressionNode *clone() const override SIP_FACTORY;
     virtual bool isStatic( QgsExpression *parent, const QgsExpressionContext *context ) const override;
 
+    /**
+     * Calls the function with the \a values of its arguments, evaluated beforehand for the same \a context.
+     * Functions with lazy evaluation evaluate their argument nodes again.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QVariant evalArguments( QgsExpression *parent, const QgsExpressionContext *context, const QVariantList &values ) SIP_SKIP;
+
     //! Tests whether the provided argument list is valid for the matching function
     static bool validateParams( int fnIndex, QgsExpressionNode::NodeList *args, QString &error );
 
@@ -259,6 +288,8 @@ class CORE_EXPORT QgsExpressionNodeLiteral : public QgsExpressionNode
     virtual QgsExpressionNode::NodeType nodeType() const override;
     virtual bool prepareNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
     virtual QVariant evalNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
+    virtual bool evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values ) override SIP_SKIP;
+    virtual int compileNode( QgsExpressionProgram &program ) override SIP_SKIP;
     virtual QString dump() const override;
 
     virtual QSet<QString> referencedColumns() const override;
@@ -287,6 +318,8 @@ class CORE_EXPORT QgsExpressionNodeColumnRef : public QgsExpressionNode
     virtual QgsExpressionNode::NodeType nodeType() const override;
     virtual bool prepareNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
     virtual QVariant evalNode( QgsExpression *parent, const QgsExpressionContext *context ) override;
+    virtual bool evalBatchNode( QgsExpression *parent, QgsExpressionBatchContext &context, QgsExpressionBatchValues &values ) override SIP_SKIP;
+    virtual int compileNode( QgsExpressionProgram &program ) override SIP_SKIP;
     virtual QString dump() const override;
 
     virtual QSet<QString> referencedColumns() const override;
@@ -0,0 +1,556 @@
+/***************************************************************************
+  qgsexpressionprogram.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionprogram.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionutils.h"
+
+#include <QMap>
+#include <QVarLengthArray>
+#include <cmath>
+#include <memory>
+
+//
+// QgsExpressionProgram::Value
+//
+
+void QgsExpressionProgram::Value::setNull( QVariant::Type type )
+{
+  this->type = Null;
+  variantType = type;
+  string = QString();
+  variant = QVariant();
+}
+
+void QgsExpressionProgram::Value::setInteger( qint64 value, QVariant::Type type )
+{
+  this->type = Integer;
+  variantType = type;
+  integer = value;
+}
+
+void QgsExpressionProgram::Value::setDouble( double value )
+{
+  type = Double;
+  number = value;
+}
+
+void QgsExpressionProgram::Value::setString( const QString &value )
+{
+  type = String;
+  string = value;
+}
+
+void QgsExpressionProgram::Value::setValue( const QVariant &value )
+{
+  if ( value.isNull() )
+  {
+    setNull( value.type() );
+    return;
+  }
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+      setInteger( value.toLongLong(), value.type() );
+      break;
+
+    case QVariant::Double:
+      setDouble( value.toDouble() );
+      break;
+
+    case QVariant::String:
+      setString( value.toString() );
+      break;
+
+    default:
+      // unsigned 64 bit integers do not fit in the integer register
+      type = Variant;
+      variant = value;
+      break;
+  }
+}
+
+QVariant QgsExpressionProgram::Value::value() const
+{
+  switch ( type )
+  {
+    case Null:
+      return QVariant( variantType );
+
+    case Integer:
+      switch ( variantType )
+      {
+        case QVariant::Int:
+          return QVariant( static_cast< int >( integer ) );
+        case QVariant::UInt:
+          return QVariant( static_cast< uint >( integer ) );
+        default:
+          return QVariant( static_cast< qlonglong >( integer ) );
+      }
+
+    case Double:
+      return QVariant( number );
+
+    case String:
+      return QVariant( string );
+
+    case Variant:
+      break;
+  }
+  return variant;
+}
+
+//
+// QgsExpressionProgram
+//
+
+//! Returns the three-valued logic value of a register, or -1 if it can not be computed without conversion
+static int tvlValue( bool isNull, bool isInteger, bool isDouble, qint64 integer, double number )
+{
+  if ( isNull )
+    return QgsExpressionUtils::Unknown;
+  if ( isInteger )
+    return integer != 0 ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+  if ( isDouble )
+    return !qgsDoubleNear( number, 0.0 ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+  return -1;
+}
+
+//! Applies a comparison operator to the difference of two values
+static bool compareDiff( int op, double diff )
+{
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boEQ:
+      return qgsDoubleNear( diff, 0.0 );
+    case QgsExpressionNodeBinaryOperator::boNE:
+      return !qgsDoubleNear( diff, 0.0 );
+    case QgsExpressionNodeBinaryOperator::boLT:
+      return diff < 0;
+    case QgsExpressionNodeBinaryOperator::boGT:
+      return diff > 0;
+    case QgsExpressionNodeBinaryOperator::boLE:
+      return diff <= 0;
+    case QgsExpressionNodeBinaryOperator::boGE:
+      return diff >= 0;
+    default:
+      Q_ASSERT( false );
+      return false;
+  }
+}
+
+QgsExpressionProgram *QgsExpressionProgram::compile( QgsExpressionNode *root )
+{
+  if ( !root )
+    return nullptr;
+
+  std::unique_ptr< QgsExpressionProgram > program( new QgsExpressionProgram() );
+  program->mResult = root->compile( *program );
+
+  // nothing to gain if the whole tree is evaluated directly
+  if ( program->mInstructions.count() == 1 && program->mInstructions.at( 0 ).code == Evaluate )
+    return nullptr;
+
+  return program.release();
+}
+
+int QgsExpressionProgram::functionFromName( const QString &name )
+{
+  static const QMap< QString, Function > FUNCTIONS
+  {
+    { QStringLiteral( "abs" ), Abs },
+    { QStringLiteral( "sqrt" ), Sqrt },
+    { QStringLiteral( "floor" ), Floor },
+    { QStringLiteral( "ceil" ), Ceil },
+    { QStringLiteral( "upper" ), Upper },
+    { QStringLiteral( "lower" ), Lower },
+    { QStringLiteral( "trim" ), Trim },
+    { QStringLiteral( "length" ), Length },
+  };
+  auto it = FUNCTIONS.constFind( name );
+  return it != FUNCTIONS.constEnd() ? it.value() : -1;
+}
+
+int QgsExpressionProgram::addConstant( const QVariant &value )
+{
+  Value constant;
+  constant.setValue( value );
+  mConstants.append( constant );
+  // constants use negative operands, registers positive ones
+  return -mConstants.count();
+}
+
+int QgsExpressionProgram::addEvaluate( QgsExpressionNode *node )
+{
+  return addInstruction( Evaluate, 0, 0, 0, node );
+}
+
+int QgsExpressionProgram::addAttribute( int fieldIndex, QgsExpressionNode *node )
+{
+  return addInstruction( Attribute, fieldIndex, 0, 0, node );
+}
+
+int QgsExpressionProgram::addBinaryOperator( int op, int left, int right, QgsExpressionNode *node )
+{
+  return addInstruction( BinaryOperator, op, left, right, node );
+}
+
+int QgsExpressionProgram::addUnaryOperator( int op, int operand, QgsExpressionNode *node )
+{
+  return addInstruction( UnaryOperator, op, operand, 0, node );
+}
+
+int QgsExpressionProgram::addFunction( Function function, const QString &name, int argument, QgsExpressionNode *node )
+{
+  return addInstruction( FunctionCall, function, argument, 0, node, name );
+}
+
+int QgsExpressionProgram::addInstruction( OpCode code, int op, int left, int right, QgsExpressionNode *node, const QString &name )
+{
+  Instruction instruction;
+  instruction.code = code;
+  instruction.op = op;
+  instruction.left = left;
+  instruction.right = right;
+  instruction.node = node;
+  instruction.name = name;
+  mInstructions.append( instruction );
+  // each instruction writes to its own register
+  return mInstructions.count() - 1;
+}
+
+QVariant QgsExpressionProgram::run( QgsExpression *parent, const QgsExpressionContext *context ) const
+{
+  // registers live on the stack, so that a program can be shared between copies of an expression
+  QVarLengthArray< Value, 16 > registers( mInstructions.count() );
+  auto operand = [&]( int index ) -> const Value &
+  {
+    return index >= 0 ? registers[index] : mConstants.at( -1 - index );
+  };
+
+  for ( int i = 0; i < mInstructions.count(); ++i )
+  {
+    const Instruction &instruction = mInstructions.at( i );
+    Value &result = registers[i];
+    bool done = false;
+    switch ( instruction.code )
+    {
+      case Evaluate:
+        break;
+
+      case Attribute:
+        if ( context && context->hasFeature() )
+        {
+          result.setValue( context->feature().attribute( instruction.op ) );
+          done = true;
+        }
+        break;
+
+      case BinaryOperator:
+        done = evaluateBinaryOperator( instruction, operand( instruction.left ), operand( instruction.right ), result );
+        break;
+
+      case UnaryOperator:
+        done = evaluateUnaryOperator( instruction, operand( instruction.left ), result );
+        break;
+
+      case FunctionCall:
+        if ( !context || !context->hasFunction( instruction.name ) )
+          done = evaluateFunction( instruction, operand( instruction.left ), result );
+        break;
+    }
+
+    if ( !done )
+    {
+      // evaluate the node of the instruction. The values of its operands are passed on, so that
+      // the operand nodes are not evaluated twice
+      QVariant value;
+      switch ( instruction.code )
+      {
+        case Evaluate:
+        case Attribute:
+          value = instruction.node->eval( parent, context );
+          break;
+
+        case BinaryOperator:
+          value = static_cast< QgsExpressionNodeBinaryOperator * >( instruction.node )->evalOperands( parent, context, operand( instruction.left ).value(), operand( instruction.right ).value() );
+          break;
+
+        case UnaryOperator:
+          value = static_cast< QgsExpressionNodeUnaryOperator * >( instruction.node )->evalOperand( parent, operand( instruction.left ).value() );
+          break;
+
+        case FunctionCall:
+          value = static_cast< QgsExpressionNodeFunction * >( instruction.node )->evalArguments( parent, context, QVariantList() << operand( instruction.left ).value() );
+          break;
+      }
+      result.setValue( value );
+      if ( parent->hasEvalError() )
+        return QVariant();
+    }
+  }
+
+  return operand( mResult ).value();
+}
+
+bool QgsExpressionProgram::evaluateBinaryOperator( const Instruction &instruction, const Value &left, const Value &right, Value &result ) const
+{
+  const bool leftNull = left.type == Value::Null;
+  const bool rightNull = right.type == Value::Null;
+  const bool numeric = left.isNumeric() && right.isNumeric();
+  const bool strings = left.type == Value::String && right.type == Value::String;
+
+  switch ( instruction.op )
+  {
+    case QgsExpressionNodeBinaryOperator::boPlus:
+      if ( left.isStringVariant() && right.isStringVariant() )
+      {
+        // NULL strings are concatenated as empty strings, only two NULL strings give NULL
+        if ( leftNull && rightNull )
+          result.setNull( QVariant::String );
+        else
+          result.setString( left.string + right.string );
+        return true;
+      }
+      FALLTHROUGH;
+    case QgsExpressionNodeBinaryOperator::boMinus:
+    case QgsExpressionNodeBinaryOperator::boMul:
+    case QgsExpressionNodeBinaryOperator::boDiv:
+    case QgsExpressionNodeBinaryOperator::boMod:
+    {
+      if ( leftNull || rightNull )
+      {
+        result.setNull();
+        return true;
+      }
+      if ( !numeric )
+        return false;
+
+      if ( instruction.op != QgsExpressionNodeBinaryOperator::boDiv && left.type == Value::Integer && right.type == Value::Integer )
+      {
+        // both are integers - let's use integer arithmetics
+        qint64 iL = left.integer;
+        qint64 iR = right.integer;
+        switch ( instruction.op )
+        {
+          case QgsExpressionNodeBinaryOperator::boPlus:
+            result.setInteger( iL + iR );
+            break;
+          case QgsExpressionNodeBinaryOperator::boMinus:
+            result.setInteger( iL - iR );
+            break;
+          case QgsExpressionNodeBinaryOperator::boMul:
+            result.setInteger( iL * iR );
+            break;
+          default:
+            if ( iR == 0 )
+              result.setNull();
+            else
+              result.setInteger( iL % iR );
+            break;
+        }
+        return true;
+      }
+
+      // general floating point arithmetic
+      double fL = left.toDouble();
+      double fR = right.toDouble();
+      switch ( instruction.op )
+      {
+        case QgsExpressionNodeBinaryOperator::boPlus:
+          result.setDouble( fL + fR );
+          break;
+        case QgsExpressionNodeBinaryOperator::boMinus:
+          result.setDouble( fL - fR );
+          break;
+        case QgsExpressionNodeBinaryOperator::boMul:
+          result.setDouble( fL * fR );
+          break;
+        case QgsExpressionNodeBinaryOperator::boDiv:
+          if ( fR == 0. )
+            result.setNull(); // silently handle division by zero and return NULL
+          else
+            result.setDouble( fL / fR );
+          break;
+        default:
+          if ( fR == 0. )
+            result.setNull();
+          else
+            result.setDouble( std::fmod( fL, fR ) );
+          break;
+      }
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boIntDiv:
+      // NULL operands are converted by the node
+      if ( !numeric )
+        return false;
+      if ( right.toDouble() == 0. )
+        result.setNull();
+      else
+        result.setInteger( static_cast< qint64 >( std::floor( left.toDouble() / right.toDouble() ) ) );
+      return true;
+
+    case QgsExpressionNodeBinaryOperator::boPow:
+      if ( leftNull || rightNull )
+        result.setNull();
+      else if ( numeric )
+        result.setDouble( std::pow( left.toDouble(), right.toDouble() ) );
+      else
+        return false;
+      return true;
+
+    case QgsExpressionNodeBinaryOperator::boAnd:
+    case QgsExpressionNodeBinaryOperator::boOr:
+    {
+      int tvlL = tvlValue( leftNull, left.type == Value::Integer, left.type == Value::Double, left.integer, left.number );
+      int tvlR = tvlValue( rightNull, right.type == Value::Integer, right.type == Value::Double, right.integer, right.number );
+      if ( tvlL < 0 || tvlR < 0 )
+        return false;
+
+      QgsExpressionUtils::TVL tvl = instruction.op == QgsExpressionNodeBinaryOperator::boAnd ? QgsExpressionUtils::AND[tvlL][tvlR] : QgsExpressionUtils::OR[tvlL][tvlR];
+      if ( tvl == QgsExpressionUtils::Unknown )
+        result.setNull();
+      else
+        result.setInteger( tvl == QgsExpressionUtils::True ? 1 : 0, QVariant::Int );
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boEQ:
+    case QgsExpressionNodeBinaryOperator::boNE:
+    case QgsExpressionNodeBinaryOperator::boLT:
+    case QgsExpressionNodeBinaryOperator::boGT:
+    case QgsExpressionNodeBinaryOperator::boLE:
+    case QgsExpressionNodeBinaryOperator::boGE:
+      if ( leftNull || rightNull )
+        result.setNull();
+      else if ( numeric )
+        result.setInteger( compareDiff( instruction.op, left.toDouble() - right.toDouble() ) ? 1 : 0, QVariant::Int );
+      else if ( strings )
+        result.setInteger( compareDiff( instruction.op, QString::compare( left.string, right.string ) ) ? 1 : 0, QVariant::Int );
+      else
+        return false;
+      return true;
+
+    case QgsExpressionNodeBinaryOperator::boIs:
+    case QgsExpressionNodeBinaryOperator::boIsNot:
+    {
+      bool equal;
+      if ( leftNull || rightNull )
+        equal = leftNull && rightNull;
+      else if ( numeric )
+        equal = qgsDoubleNear( left.toDouble(), right.toDouble() );
+      else if ( strings )
+        equal = QString::compare( left.string, right.string ) == 0;
+      else
+        return false;
+      result.setInteger( equal == ( instruction.op == QgsExpressionNodeBinaryOperator::boIs ) ? 1 : 0, QVariant::Int );
+      return true;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boConcat:
+      if ( leftNull || rightNull )
+        result.setNull();
+      else if ( strings )
+        result.setString( left.string + right.string );
+      else
+        return false;
+      return true;
+
+    default:
+      break;
+  }
+  return false;
+}
+
+bool QgsExpressionProgram::evaluateUnaryOperator( const Instruction &instruction, const Value &operand, Value &result ) const
+{
+  switch ( instruction.op )
+  {
+    case QgsExpressionNodeUnaryOperator::uoNot:
+    {
+      int tvl = tvlValue( operand.type == Value::Null, operand.type == Value::Integer, operand.type == Value::Double, operand.integer, operand.number );
+      if ( tvl < 0 )
+        return false;
+
+      QgsExpressionUtils::TVL notTvl = QgsExpressionUtils::NOT[tvl];
+      if ( notTvl == QgsExpressionUtils::Unknown )
+        result.setNull();
+      else
+        result.setInteger( notTvl == QgsExpressionUtils::True ? 1 : 0, QVariant::Int );
+      return true;
+    }
+
+    case QgsExpressionNodeUnaryOperator::uoMinus:
+      // NULL operands are converted by the node
+      if ( operand.type == Value::Integer )
+        result.setInteger( -operand.integer );
+      else if ( operand.type == Value::Double )
+        result.setDouble( -operand.number );
+      else
+        return false;
+      return true;
+  }
+  return false;
+}
+
+bool QgsExpressionProgram::evaluateFunction( const Instruction &instruction, const Value &argument, Value &result ) const
+{
+  // functions return NULL when their argument is NULL
+  if ( argument.type == Value::Null )
+  {
+    result.setNull();
+    return true;
+  }
+
+  switch ( instruction.op )
+  {
+    case Abs:
+    case Sqrt:
+    case Floor:
+    case Ceil:
+    {
+      if ( !argument.isNumeric() )
+        return false;
+
+      double x = argument.toDouble();
+      result.setDouble( instruction.op == Abs ? std::fabs( x ) : instruction.op == Sqrt ? std::sqrt( x ) : instruction.op == Floor ? std::floor( x ) : std::ceil( x ) );
+      return true;
+    }
+
+    case Upper:
+    case Lower:
+    case Trim:
+      if ( argument.type != Value::String )
+        return false;
+
+      result.setString( instruction.op == Upper ? argument.string.toUpper() : instruction.op == Lower ? argument.string.toLower() : argument.string.trimmed() );
+      return true;
+
+    case Length:
+      // geometries are handled by the node
+      if ( argument.type != Value::String )
+        return false;
+
+      result.setInteger( argument.string.length(), QVariant::Int );
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,199 @@
+/***************************************************************************
+  qgsexpressionprogram.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONPROGRAM_H
+#define QGSEXPRESSIONPROGRAM_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+class QgsExpression;
+class QgsExpressionContext;
+class QgsExpressionNode;
+
+/**
+ * \ingroup core
+ * \class QgsExpressionProgram
+ * A prepared expression tree compiled to a flat list of instructions.
+ *
+ * Each instruction reads its operands from registers and writes its result to a new
+ * register. Registers hold numbers and strings unboxed, values are only converted to
+ * QVariant when they leave the program. Nodes with a static value are folded into
+ * constants when the program is compiled.
+ *
+ * Nodes which have no instruction of their own are evaluated with QgsExpressionNode::eval(),
+ * as a single instruction which also evaluates their children. When an instruction receives
+ * operands of types it does not handle (e.g. dates), its node is evaluated with the values of
+ * the operands instead, so a program always returns the same results as the tree and no node
+ * is evaluated twice.
+ *
+ * A program refers to the nodes of the tree it was compiled from, it must be compiled
+ * again whenever the tree is prepared again.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsExpressionProgram
+{
+  public:
+
+    //! Functions with a dedicated instruction
+    enum Function
+    {
+      Abs,
+      Sqrt,
+      Floor,
+      Ceil,
+      Upper,
+      Lower,
+      Trim,
+      Length,
+    };
+
+    /**
+     * Compiles the prepared tree starting at \a root. Returns nullptr if no part of the tree
+     * can be compiled, in which case the tree should be evaluated directly.
+     * Ownership is transferred to the caller.
+     */
+    static QgsExpressionProgram *compile( QgsExpressionNode *root );
+
+    /**
+     * Runs the program for the given \a context. Errors are reported to the \a parent expression.
+     */
+    QVariant run( QgsExpression *parent, const QgsExpressionContext *context ) const;
+
+    //! Returns the number of instructions of the program
+    int instructionCount() const { return mInstructions.count(); }
+
+    /**
+     * Adds a constant \a value and returns its operand.
+     */
+    int addConstant( const QVariant &value );
+
+    /**
+     * Adds an instruction evaluating a whole \a node with QgsExpressionNode::eval() and returns its result operand.
+     */
+    int addEvaluate( QgsExpressionNode *node );
+
+    /**
+     * Adds an instruction loading the attribute \a fieldIndex of the context feature and returns its result operand.
+     * The \a node is evaluated instead when the context has no feature.
+     */
+    int addAttribute( int fieldIndex, QgsExpressionNode *node );
+
+    /**
+     * Adds a binary operator instruction and returns its result operand.
+     * \param op a QgsExpressionNodeBinaryOperator::BinaryOperator
+     * \param left left operand
+     * \param right right operand
+     * \param node operator node, applied instead to operands of other types than numbers and strings
+     */
+    int addBinaryOperator( int op, int left, int right, QgsExpressionNode *node );
+
+    /**
+     * Adds a unary operator instruction and returns its result operand.
+     * \param op a QgsExpressionNodeUnaryOperator::UnaryOperator
+     * \param operand operand
+     * \param node operator node, applied instead to operands of other types than numbers
+     */
+    int addUnaryOperator( int op, int operand, QgsExpressionNode *node );
+
+    /**
+     * Adds a function call instruction and returns its result operand.
+     * \param function function to call
+     * \param name function name, the \a node is called instead when the context overrides the function
+     * \param argument function argument
+     * \param node function node, called instead for arguments of other types than expected
+     */
+    int addFunction( Function function, const QString &name, int argument, QgsExpressionNode *node );
+
+    /**
+     * Returns the function with a dedicated instruction named \a name, or -1 if there is none.
+     */
+    static int functionFromName( const QString &name );
+
+  private:
+
+    QgsExpressionProgram() = default;
+
+    //! Instruction codes
+    enum OpCode
+    {
+      Evaluate,
+      Attribute,
+      BinaryOperator,
+      UnaryOperator,
+      FunctionCall,
+    };
+
+    struct Instruction
+    {
+      OpCode code;
+      //! operator, function or field index
+      int op;
+      int left;
+      int right;
+      QgsExpressionNode *node;
+      QString name;
+    };
+
+    //! Unboxed value of a register
+    struct Value
+    {
+      enum Type
+      {
+        Null,
+        Integer,
+        Double,
+        String,
+        Variant,
+      };
+
+      Type type = Null;
+      //! variant type of integers and NULL values
+      QVariant::Type variantType = QVariant::Invalid;
+      qint64 integer = 0;
+      double number = 0;
+      QString string;
+      QVariant variant;
+
+      void setNull( QVariant::Type type = QVariant::Invalid );
+      void setInteger( qint64 value, QVariant::Type type = QVariant::LongLong );
+      void setDouble( double value );
+      void setString( const QString &value );
+      void setValue( const QVariant &value );
+      QVariant value() const;
+
+      bool isNumeric() const { return type == Integer || type == Double; }
+      double toDouble() const { return type == Integer ? integer : number; }
+      bool isStringVariant() const { return type == String || ( type == Null && variantType == QVariant::String ); }
+    };
+
+    int addInstruction( OpCode code, int op, int left, int right, QgsExpressionNode *node, const QString &name = QString() );
+    bool evaluateBinaryOperator( const Instruction &instruction, const Value &left, const Value &right, Value &result ) const;
+    bool evaluateUnaryOperator( const Instruction &instruction, const Value &operand, Value &result ) const;
+    bool evaluateFunction( const Instruction &instruction, const Value &argument, Value &result ) const;
+
+    QVector<Instruction> mInstructions;
+    QVector<Value> mConstants;
+    //! operand holding the result of the program
+    int mResult = 0;
+};
+
+#endif // QGSEXPRESSIONPROGRAM_H
@@ -0,0 +1,258 @@
+/***************************************************************************
+  qgscompactgeometry.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgscompactgeometry.h"
+#include "qgsgeometry.h"
+#include "qgsgeometrycollection.h"
+#include "qgsgeometryfactory.h"
+#include "qgslinestring.h"
+#include "qgspoint.h"
+#include "qgspolygon.h"
+
+#include <limits>
+
+bool QgsCompactGeometry::isSupported( QgsWkbTypes::Type type )
+{
+  QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( type );
+  switch ( flatType )
+  {
+    case QgsWkbTypes::Point:
+    case QgsWkbTypes::LineString:
+    case QgsWkbTypes::Polygon:
+    case QgsWkbTypes::MultiPoint:
+    case QgsWkbTypes::MultiLineString:
+    case QgsWkbTypes::MultiPolygon:
+      // 25D types would come back as Z types
+      return QgsWkbTypes::zmType( flatType, QgsWkbTypes::hasZ( type ), QgsWkbTypes::hasM( type ) ) == type;
+
+    default:
+      return false;
+  }
+}
+
+QgsCompactGeometry QgsCompactGeometry::fromGeometry( const QgsGeometry &geometry, Precision precision )
+{
+  QgsCompactGeometry compact;
+  const QgsAbstractGeometry *g = geometry.geometry();
+  if ( !g || !isSupported( g->wkbType() ) )
+    return compact;
+
+  compact.mWkbType = g->wkbType();
+  compact.mPrecision = precision;
+  compact.mBoundingBox = g->boundingBox();
+
+  const bool hasZ = g->is3D();
+  const bool hasM = g->isMeasure();
+  const double originX = compact.mBoundingBox.xMinimum();
+  const double originY = compact.mBoundingBox.yMinimum();
+  const int vertexCount = g->nCoordinates();
+  const int stride = compact.stride();
+  if ( precision == DoublePrecision )
+    compact.mDoubles.reserve( vertexCount * stride );
+  else
+    compact.mFloats.reserve( vertexCount * stride );
+
+  auto addVertex = [&]( double x, double y, double z, double m )
+  {
+    if ( precision == DoublePrecision )
+    {
+      compact.mDoubles << x << y;
+      if ( hasZ )
+        compact.mDoubles << z;
+      if ( hasM )
+        compact.mDoubles << m;
+    }
+    else
+    {
+      compact.mFloats << static_cast< float >( x - originX ) << static_cast< float >( y - originY );
+      if ( hasZ )
+        compact.mFloats << static_cast< float >( z );
+      if ( hasM )
+        compact.mFloats << static_cast< float >( m );
+    }
+  };
+
+  int vertices = 0;
+  auto addRing = [&]( const QgsLineString *line )
+  {
+    const int n = line->numPoints();
+    for ( int i = 0; i < n; ++i )
+    {
+      addVertex( line->xAt( i ), line->yAt( i ), hasZ ? line->zAt( i ) : 0.0, hasM ? line->mAt( i ) : 0.0 );
+    }
+    vertices += n;
+    compact.mRingOffsets << vertices;
+  };
+
+  const QgsGeometryCollection *collection = QgsWkbTypes::isMultiType( compact.mWkbType ) ? static_cast< const QgsGeometryCollection * >( g ) : nullptr;
+  const int partCount = collection ? collection->numGeometries() : 1;
+  compact.mPartOffsets.reserve( partCount + 1 );
+  compact.mRingOffsets << 0;
+  for ( int i = 0; i < partCount; ++i )
+  {
+    compact.mPartOffsets << compact.mRingOffsets.count() - 1;
+
+    const QgsAbstractGeometry *part = collection ? collection->geometryN( i ) : g;
+    switch ( QgsWkbTypes::flatType( part->wkbType() ) )
+    {
+      case QgsWkbTypes::Point:
+      {
+        const QgsPoint *point = static_cast< const QgsPoint * >( part );
+        addVertex( point->x(), point->y(), hasZ ? point->z() : 0.0, hasM ? point->m() : 0.0 );
+        compact.mRingOffsets << ++vertices;
+        break;
+      }
+
+      case QgsWkbTypes::LineString:
+        addRing( static_cast< const QgsLineString * >( part ) );
+        break;
+
+      case QgsWkbTypes::Polygon:
+      {
+        const QgsPolygonV2 *polygon = static_cast< const QgsPolygonV2 * >( part );
+        if ( !polygon->exteriorRing() )
+          break;
+
+        addRing( static_cast< const QgsLineString * >( polygon->exteriorRing() ) );
+        for ( int ring = 0; ring < polygon->numInteriorRings(); ++ring )
+          addRing( static_cast< const QgsLineString * >( polygon->interiorRing( ring ) ) );
+        break;
+      }
+
+      default:
+        // parts of multi geometries always have the single type
+        return QgsCompactGeometry();
+    }
+  }
+  compact.mPartOffsets << compact.mRingOffsets.count() - 1;
+  return compact;
+}
+
+int QgsCompactGeometry::vertexCount( int part, int ring ) const
+{
+  int index = mPartOffsets.at( part ) + ring;
+  return mRingOffsets.at( index + 1 ) - mRingOffsets.at( index );
+}
+
+QgsPointXY QgsCompactGeometry::vertexAt( int vertex ) const
+{
+  int index = vertex * stride();
+  return QgsPointXY( coordinate( index, 0 ), coordinate( index + 1, 1 ) );
+}
+
+QPolygonF QgsCompactGeometry::ringAsPolygon( int part, int ring ) const
+{
+  int ringIndex = mPartOffsets.at( part ) + ring;
+  int start = mRingOffsets.at( ringIndex );
+  int end = mRingOffsets.at( ringIndex + 1 );
+  const int stride = this->stride();
+
+  QPolygonF polygon( end - start );
+  QPointF *dest = polygon.data();
+  if ( mPrecision == DoublePrecision )
+  {
+    const double *src = mDoubles.constData() + start * stride;
+    for ( int i = start; i < end; ++i, src += stride )
+      *dest++ = QPointF( src[0], src[1] );
+  }
+  else
+  {
+    const double originX = mBoundingBox.xMinimum();
+    const double originY = mBoundingBox.yMinimum();
+    const float *src = mFloats.constData() + start * stride;
+    for ( int i = start; i < end; ++i, src += stride )
+      *dest++ = QPointF( originX + src[0], originY + src[1] );
+  }
+  return polygon;
+}
+
+QgsGeometry QgsCompactGeometry::toGeometry() const
+{
+  if ( isNull() )
+    return QgsGeometry();
+
+  const bool hasZ = QgsWkbTypes::hasZ( mWkbType );
+  const bool hasM = QgsWkbTypes::hasM( mWkbType );
+  const int stride = this->stride();
+
+  auto ringToLineString = [&]( int ringIndex ) -> QgsLineString *
+  {
+    int start = mRingOffsets.at( ringIndex );
+    int end = mRingOffsets.at( ringIndex + 1 );
+    QVector<double> x( end - start );
+    QVector<double> y( end - start );
+    QVector<double> z( hasZ ? end - start : 0 );
+    QVector<double> m( hasM ? end - start : 0 );
+    for ( int i = start; i < end; ++i )
+    {
+      int index = i * stride;
+      x[i - start] = coordinate( index, 0 );
+      y[i - start] = coordinate( index + 1, 1 );
+      if ( hasZ )
+        z[i - start] = coordinate( index + 2, 2 );
+      if ( hasM )
+        m[i - start] = coordinate( index + 2 + ( hasZ ? 1 : 0 ), 3 );
+    }
+    return new QgsLineString( x, y, z, m );
+  };
+
+  QgsWkbTypes::Type partType = QgsWkbTypes::singleType( mWkbType );
+  auto createPart = [&]( int part ) -> QgsAbstractGeometry *
+  {
+    int firstRing = mPartOffsets.at( part );
+    int lastRing = mPartOffsets.at( part + 1 );
+    switch ( QgsWkbTypes::flatType( partType ) )
+    {
+      case QgsWkbTypes::Point:
+      {
+        int index = mRingOffsets.at( firstRing ) * stride;
+        return new QgsPoint( partType, coordinate( index, 0 ), coordinate( index + 1, 1 ),
+                             hasZ ? coordinate( index + 2, 2 ) : std::numeric_limits<double>::quiet_NaN(),
+                             hasM ? coordinate( index + 2 + ( hasZ ? 1 : 0 ), 3 ) : std::numeric_limits<double>::quiet_NaN() );
+      }
+
+      case QgsWkbTypes::LineString:
+        return ringToLineString( firstRing );
+
+      default:
+      {
+        QgsPolygonV2 *polygon = new QgsPolygonV2();
+        for ( int ring = firstRing; ring < lastRing; ++ring )
+        {
+          if ( ring == firstRing )
+            polygon->setExteriorRing( ringToLineString( ring ) );
+          else
+            polygon->addInteriorRing( ringToLineString( ring ) );
+        }
+        return polygon;
+      }
+    }
+  };
+
+  if ( !QgsWkbTypes::isMultiType( mWkbType ) )
+    return QgsGeometry( createPart( 0 ) );
+
+  std::unique_ptr< QgsGeometryCollection > collection = QgsGeometryFactory::createCollectionOfType( mWkbType );
+  for ( int part = 0; part < partCount(); ++part )
+    collection->addGeometry( createPart( part ) );
+  return QgsGeometry( collection.release() );
+}
+
+int QgsCompactGeometry::memoryUsage() const
+{
+  return sizeof( QgsCompactGeometry )
+         + ( mPartOffsets.capacity() + mRingOffsets.capacity() ) * sizeof( int )
+         + mDoubles.capacity() * sizeof( double )
+         + mFloats.capacity() * sizeof( float );
+}
@@ -0,0 +1,139 @@
+/***************************************************************************
+  qgscompactgeometry.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSCOMPACTGEOMETRY_H
+#define QGSCOMPACTGEOMETRY_H
+
+#include "qgis_core.h"
+#include "qgis.h"
+#include "qgspointxy.h"
+#include "qgsrectangle.h"
+#include "qgswkbtypes.h"
+
+#include <QPolygonF>
+#include <QVector>
+
+class QgsGeometry;
+
+/**
+ * \ingroup core
+ * \class QgsCompactGeometry
+ * A read-only geometry with all its coordinates stored in a single contiguous buffer.
+ *
+ * A QgsGeometry holds a tree of objects, with separate arrays for the x, y, z and m
+ * coordinates of every linestring and ring. A compact geometry stores the coordinates
+ * of all its vertices interleaved (x, y, [z], [m]) in one buffer, plus the offsets of its
+ * parts and rings, which reduces the memory use and the number of allocations of large
+ * multipolygons considerably.
+ *
+ * With SinglePrecision, coordinates are stored as 32 bit floats relative to the corner
+ * of the bounding box, which halves the size of the buffer again. The error this
+ * introduces is far below a pixel at any reasonable map scale, so it is meant for
+ * geometries kept only for drawing.
+ *
+ * Only points, linestrings and polygons and their multi types are supported. Curved
+ * geometries and geometry collections can not be stored in compact form.
+ *
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsCompactGeometry
+{
+  public:
+
+    //! Precision of the stored coordinates
+    enum Precision
+    {
+      DoublePrecision, //!< Coordinates are stored as doubles, the geometry is stored without loss
+      SinglePrecision, //!< Coordinates are stored as floats relative to the bounding box corner
+    };
+
+    //! Constructor for a null QgsCompactGeometry
+    QgsCompactGeometry() = default;
+
+    /**
+     * Creates a compact geometry from a \a geometry, with coordinates stored in the specified \a precision.
+     * Returns a null compact geometry if the geometry is null or its type is not supported.
+     * \see isSupported()
+     */
+    static QgsCompactGeometry fromGeometry( const QgsGeometry &geometry, Precision precision = DoublePrecision );
+
+    /**
+     * Returns true if geometries of the specified \a type can be stored in compact form.
+     */
+    static bool isSupported( QgsWkbTypes::Type type );
+
+    //! Returns true if the compact geometry is null
+    bool isNull() const { return mWkbType == QgsWkbTypes::Unknown; }
+
+    //! Returns the WKB type of the geometry
+    QgsWkbTypes::Type wkbType() const { return mWkbType; }
+
+    //! Returns the precision of the stored coordinates
+    Precision precision() const { return mPrecision; }
+
+    //! Returns the bounding box of the geometry
+    QgsRectangle boundingBox() const { return mBoundingBox; }
+
+    //! Returns the number of parts of the geometry
+    int partCount() const { return mPartOffsets.isEmpty() ? 0 : mPartOffsets.count() - 1; }
+
+    //! Returns the number of rings of a \a part, 1 for points and linestrings
+    int ringCount( int part ) const { return mPartOffsets.at( part + 1 ) - mPartOffsets.at( part ); }
+
+    //! Returns the number of vertices of a \a ring of a \a part
+    int vertexCount( int part, int ring ) const;
+
+    //! Returns the total number of vertices of the geometry
+    int vertexCount() const { return mRingOffsets.isEmpty() ? 0 : mRingOffsets.last(); }
+
+    //! Returns the x and y coordinates of a \a vertex, counted over all parts and rings
+    QgsPointXY vertexAt( int vertex ) const;
+
+    /**
+     * Returns the x and y coordinates of a \a ring of a \a part as a polygon,
+     * e.g. for drawing it.
+     */
+    QPolygonF ringAsPolygon( int part, int ring ) const;
+
+    //! Converts the compact geometry back to a geometry
+    QgsGeometry toGeometry() const;
+
+    //! Returns the approximate memory used by the compact geometry, in bytes
+    int memoryUsage() const;
+
+  private:
+
+    //! Returns the value of a \a dimension (0 to 3 for x, y, z and m) at \a index in the coordinate buffer
+    double coordinate( int index, int dimension ) const
+    {
+      return mPrecision == DoublePrecision ? mDoubles.at( index ) : mFloats.at( index ) + ( dimension == 0 ? mBoundingBox.xMinimum() : dimension == 1 ? mBoundingBox.yMinimum() : 0.0 );
+    }
+
+    //! Number of values per vertex in the coordinate buffer
+    int stride() const { return 2 + ( QgsWkbTypes::hasZ( mWkbType ) ? 1 : 0 ) + ( QgsWkbTypes::hasM( mWkbType ) ? 1 : 0 ); }
+
+    QgsWkbTypes::Type mWkbType = QgsWkbTypes::Unknown;
+    Precision mPrecision = DoublePrecision;
+    QgsRectangle mBoundingBox;
+
+    //! index of the first ring of each part, plus the total number of rings
+    QVector<int> mPartOffsets;
+    //! index of the first vertex of each ring, plus the total number of vertices
+    QVector<int> mRingOffsets;
+
+    QVector<double> mDoubles;
+    QVector<float> mFloats;
+};
+
+#endif // QGSCOMPACTGEOMETRY_H
@@ -0,0 +1,186 @@
+/***************************************************************************
+  qgswkbgeometryview.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswkbgeometryview.h"
+#include "qgsgeometry.h"
+#include "qgswkbptr.h"
+
+#include <algorithm>
+
+///@cond PRIVATE
+
+// Moves wkbPtr past the coordinates of a single point, linestring or polygon, whose header has been read
+static void skipSingle( QgsConstWkbPtr &wkbPtr, QgsWkbTypes::Type type )
+{
+  const int pointSize = QgsWkbTypes::coordDimensions( type ) * sizeof( double );
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+      wkbPtr += pointSize;
+      break;
+
+    case QgsWkbTypes::LineString:
+    {
+      unsigned int nPoints;
+      wkbPtr >> nPoints;
+      if ( nPoints > static_cast< unsigned int >( wkbPtr.remaining() / pointSize ) )
+        throw QgsWkbException( QStringLiteral( "wkb access out of bounds" ) );
+      wkbPtr += nPoints * pointSize;
+      break;
+    }
+
+    case QgsWkbTypes::Polygon:
+    {
+      unsigned int nRings;
+      wkbPtr >> nRings;
+      for ( unsigned int ring = 0; ring < nRings; ++ring )
+      {
+        unsigned int nPoints;
+        wkbPtr >> nPoints;
+        if ( nPoints > static_cast< unsigned int >( wkbPtr.remaining() / pointSize ) )
+          throw QgsWkbException( QStringLiteral( "wkb access out of bounds" ) );
+        wkbPtr += nPoints * pointSize;
+      }
+      break;
+    }
+
+    default:
+      throw QgsWkbException( QStringLiteral( "unsupported wkb type" ) );
+  }
+}
+
+///@endcond
+
+QgsWkbGeometryView::QgsWkbGeometryView( const unsigned char *wkb, int size )
+  : mWkb( wkb )
+  , mSize( size )
+{
+  if ( !wkb || size < 5 )
+    return;
+
+  try
+  {
+    QgsConstWkbPtr wkbPtr( wkb, size );
+    QgsWkbTypes::Type type = wkbPtr.readHeader();
+    if ( !isSupported( type ) )
+      return;
+
+    if ( QgsWkbTypes::isMultiType( type ) )
+    {
+      const QgsWkbTypes::Type partType = QgsWkbTypes::flatType( QgsWkbTypes::singleType( type ) );
+      unsigned int nParts;
+      wkbPtr >> nParts;
+      mPartOffsets.reserve( std::min( nParts, static_cast< unsigned int >( size ) ) + 1 );
+      for ( unsigned int part = 0; part < nParts; ++part )
+      {
+        mPartOffsets << static_cast< const unsigned char * >( wkbPtr ) - wkb;
+        QgsWkbTypes::Type partWkbType = wkbPtr.readHeader();
+        if ( QgsWkbTypes::flatType( partWkbType ) != partType )
+        {
+          mPartOffsets.clear();
+          return;
+        }
+        skipSingle( wkbPtr, partWkbType );
+      }
+      mPartOffsets << static_cast< const unsigned char * >( wkbPtr ) - wkb;
+    }
+    else
+    {
+      skipSingle( wkbPtr, type );
+    }
+    mWkbType = type;
+  }
+  catch ( const QgsWkbException & )
+  {
+    mPartOffsets.clear();
+  }
+}
+
+QgsWkbGeometryView::QgsWkbGeometryView( const unsigned char *wkb, int size, QgsWkbTypes::Type type )
+  : mWkb( wkb )
+  , mSize( size )
+  , mWkbType( type )
+{
+}
+
+bool QgsWkbGeometryView::isSupported( QgsWkbTypes::Type type )
+{
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+    case QgsWkbTypes::LineString:
+    case QgsWkbTypes::Polygon:
+    case QgsWkbTypes::MultiPoint:
+    case QgsWkbTypes::MultiLineString:
+    case QgsWkbTypes::MultiPolygon:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+QgsWkbGeometryView QgsWkbGeometryView::part( int index ) const
+{
+  if ( !QgsWkbTypes::isMultiType( mWkbType ) )
+    return *this;
+
+  const int start = mPartOffsets.at( index );
+  const int end = mPartOffsets.at( index + 1 );
+  QgsConstWkbPtr wkbPtr( mWkb + start, end - start );
+  return QgsWkbGeometryView( mWkb + start, end - start, wkbPtr.readHeader() );
+}
+
+QPointF QgsWkbGeometryView::point() const
+{
+  QgsConstWkbPtr wkbPtr( mWkb, mSize );
+  wkbPtr.readHeader();
+  QPointF point;
+  wkbPtr >> point;
+  return point;
+}
+
+QPolygonF QgsWkbGeometryView::lineString() const
+{
+  QgsConstWkbPtr wkbPtr( mWkb, mSize );
+  wkbPtr.readHeader();
+  QPolygonF points;
+  wkbPtr >> points;
+  return points;
+}
+
+QList<QPolygonF> QgsWkbGeometryView::rings() const
+{
+  QgsConstWkbPtr wkbPtr( mWkb, mSize );
+  wkbPtr.readHeader();
+  unsigned int nRings;
+  wkbPtr >> nRings;
+
+  QList<QPolygonF> rings;
+  rings.reserve( nRings );
+  for ( unsigned int ring = 0; ring < nRings; ++ring )
+  {
+    QPolygonF points;
+    wkbPtr >> points;
+    rings << points;
+  }
+  return rings;
+}
+
+QgsGeometry QgsWkbGeometryView::toGeometry() const
+{
+  QgsGeometry geometry;
+  geometry.fromWkb( QByteArray( reinterpret_cast< const char * >( mWkb ), mSize ) );
+  return geometry;
+}
@@ -0,0 +1,110 @@
+/***************************************************************************
+  qgswkbgeometryview.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSWKBGEOMETRYVIEW_H
+#define QGSWKBGEOMETRYVIEW_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgswkbtypes.h"
+
+#include <QList>
+#include <QPolygonF>
+#include <QVector>
+
+class QgsGeometry;
+
+/**
+ * \ingroup core
+ * \class QgsWkbGeometryView
+ * A read-only view of a geometry stored as WKB.
+ *
+ * The view does not copy nor parse the WKB into geometry objects, it reads the
+ * coordinates straight from the buffer when they are requested, e.g. as the
+ * QPolygonF used for drawing. This avoids building a QgsAbstractGeometry tree for
+ * features which are only drawn.
+ *
+ * Only points, linestrings and polygons and their multi types are supported. The
+ * buffer is checked when the view is created, a view of a malformed or unsupported
+ * geometry is not valid.
+ *
+ * The view refers to the buffer, which must stay unchanged while the view is used.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsWkbGeometryView
+{
+  public:
+
+    /**
+     * Constructor for a view of the \a size bytes of WKB at \a wkb.
+     */
+    QgsWkbGeometryView( const unsigned char *wkb, int size );
+
+    /**
+     * Returns true if the view holds a supported and well-formed geometry.
+     */
+    bool isValid() const { return mWkbType != QgsWkbTypes::Unknown; }
+
+    /**
+     * Returns true if geometries of the specified \a type can be viewed.
+     */
+    static bool isSupported( QgsWkbTypes::Type type );
+
+    //! Returns the WKB type of the geometry
+    QgsWkbTypes::Type wkbType() const { return mWkbType; }
+
+    //! Returns the number of parts of the geometry, 1 for single types
+    int partCount() const { return QgsWkbTypes::isMultiType( mWkbType ) ? mPartOffsets.count() - 1 : ( isValid() ? 1 : 0 ); }
+
+    /**
+     * Returns a view of the part at \a index. For single types the view itself is returned.
+     */
+    QgsWkbGeometryView part( int index ) const;
+
+    /**
+     * Returns the x and y coordinates of a point geometry.
+     */
+    QPointF point() const;
+
+    /**
+     * Returns the x and y coordinates of a linestring geometry.
+     */
+    QPolygonF lineString() const;
+
+    /**
+     * Returns the x and y coordinates of the rings of a polygon geometry, exterior ring first.
+     */
+    QList<QPolygonF> rings() const;
+
+    /**
+     * Parses the WKB into a geometry.
+     */
+    QgsGeometry toGeometry() const;
+
+  private:
+
+    //! Constructor for a view of an already checked part
+    QgsWkbGeometryView( const unsigned char *wkb, int size, QgsWkbTypes::Type type );
+
+    const unsigned char *mWkb = nullptr;
+    int mSize = 0;
+    QgsWkbTypes::Type mWkbType = QgsWkbTypes::Unknown;
+    //! offsets of the parts of multi types, plus the end of the last part
+    QVector<int> mPartOffsets;
+};
+
+#endif // QGSWKBGEOMETRYVIEW_H
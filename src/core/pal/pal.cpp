@@ -474,10 +474,13 @@ QList<LabelPosition *> *Pal::labeller( double bbox[4], PalStat **stats, bool dis
   // reduce number of candidates
   // (remove candidates which surely won't be used)
   prob->reduce();
+  prob->findReusedCandidates();
   prob->displayAll = displayAll;
 
   // search a solution
-  if ( searchMethod == FALP )
+  if ( mSolveInParallel )
+    prob->solveComponents();
+  else if ( searchMethod == FALP )
     prob->init_sol_falp();
   else if ( searchMethod == CHAIN )
     prob->chain_search();
@@ -509,6 +512,12 @@ void Pal::registerCancelationCallback( Pal::FnIsCanceled fnCanceled, void *conte
   fnIsCanceledContext = context;
 }
 
+void Pal::registerReuseCallback( Pal::FnIsReusedCandidate fnIsReused, void *context )
+{
+  this->fnIsReused = fnIsReused;
+  fnIsReusedContext = context;
+}
+
 Problem *Pal::extractProblem( double bbox[4] )
 {
   return extract( bbox[0], bbox[1], bbox[2], bbox[3] );
@@ -520,10 +529,13 @@ QList<LabelPosition *> *Pal::solveProblem( Problem *prob, bool displayAll )
     return new QList<LabelPosition *>();
 
   prob->reduce();
+  prob->findReusedCandidates();
 
   try
   {
-    if ( searchMethod == FALP )
+    if ( mSolveInParallel )
+      prob->solveComponents();
+    else if ( searchMethod == FALP )
       prob->init_sol_falp();
     else if ( searchMethod == CHAIN )
       prob->chain_search();
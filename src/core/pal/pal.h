@@ -149,6 +149,19 @@ namespace pal
       //! Check whether the job has been canceled
       inline bool isCanceled() { return fnIsCanceled ? fnIsCanceled( fnIsCanceledContext ) : false; }
 
+      typedef bool ( *FnIsReusedCandidate )( LabelPosition *candidate, void *ctx );
+
+      /**
+       * Register a function that returns whether a candidate is the placement of its label in a previous
+       * solution. Reused candidates form the initial solution and the search only revisits their features
+       * if they conflict with labels which could not be reused.
+       * \since QGIS 3.0
+       */
+      void registerReuseCallback( FnIsReusedCandidate fnIsReused, void *context );
+
+      //! Check whether a candidate is reused from a previous solution
+      inline bool isReusedCandidate( LabelPosition *candidate ) { return fnIsReused ? fnIsReused( candidate, fnIsReusedContext ) : false; }
+
       Problem *extractProblem( double bbox[4] );
 
       QList<LabelPosition *> *solveProblem( Problem *prob, bool displayAll );
@@ -167,6 +180,21 @@ namespace pal
        */
       bool getShowPartial();
 
+      /**
+       * Sets whether the problem is split in components (groups of features whose candidates only
+       * conflict with candidates of the same group) which are solved concurrently.
+       * \see solveInParallel()
+       * \since QGIS 3.0
+       */
+      void setSolveInParallel( bool parallel ) { mSolveInParallel = parallel; }
+
+      /**
+       * Returns whether the independent components of the problem are solved concurrently.
+       * \see setSolveInParallel()
+       * \since QGIS 3.0
+       */
+      bool solveInParallel() const { return mSolveInParallel; }
+
       /**
        * \brief set # candidates to generate for points features
        * Higher the value is, longer Pal::labeller will spend time
@@ -263,11 +291,19 @@ namespace pal
        */
       bool showPartial;
 
+      //! Whether independent components of the problem are solved concurrently
+      bool mSolveInParallel = false;
+
       //! Callback that may be called from PAL to check whether the job has not been canceled in meanwhile
       FnIsCanceled fnIsCanceled;
       //! Application-specific context for the cancelation check function
       void *fnIsCanceledContext = nullptr;
 
+      //! Callback that may be called from PAL to check whether a candidate is reused from a previous solution
+      FnIsReusedCandidate fnIsReused = nullptr;
+      //! Application-specific context for the reused candidate check function
+      void *fnIsReusedContext = nullptr;
+
       /**
        * \brief Problem factory
        * Extract features to label and generates candidates for them,
@@ -40,6 +40,7 @@
 #include "internalexception.h"
 #include <cfloat>
 #include <limits> //for INT_MAX
+#include <QtConcurrentMap>
 
 #include "qgslabelingengine.h"
 
@@ -103,6 +104,8 @@ Problem::~Problem()
   if ( inactiveCost )
     delete[] inactiveCost;
 
+  delete[] reusedLabel;
+
   delete candidates;
   delete candidates_sol;
 
@@ -190,6 +193,29 @@ void Problem::reduce()
   delete[] ok;
 }
 
+void Problem::findReusedCandidates()
+{
+  delete[] reusedLabel;
+  reusedLabel = nullptr;
+
+  if ( !pal->fnIsReused )
+    return;
+
+  reusedLabel = new int[nbft];
+  for ( int i = 0; i < nbft; i++ )
+  {
+    reusedLabel[i] = -1;
+    for ( int j = 0; j < featNbLp[i]; j++ )
+    {
+      if ( pal->isReusedCandidate( mLabelPositions.at( featStartId[i] + j ) ) )
+      {
+        reusedLabel[i] = featStartId[i] + j;
+        break;
+      }
+    }
+  }
+}
+
 void Problem::init_sol_empty()
 {
   int i;
@@ -310,6 +336,31 @@ void Problem::init_sol_falp()
       }
     }
 
+  // place labels reused from a previous solution first, the others are then placed around them
+  if ( reusedLabel )
+  {
+    for ( int f = 0; f < nbft; f++ )
+    {
+      label = reusedLabel[f];
+      if ( label < 0 || !list->isIn( label ) )
+        continue; // not reused or in conflict with another reused label
+
+      lp = mLabelPositions.at( label );
+      sol->s[f] = label;
+
+      for ( int c = featStartId[f]; c < featStartId[f] + featNbLp[f]; c++ )
+      {
+        ignoreLabel( mLabelPositions.at( c ), list, candidates );
+      }
+
+      lp->getBoundingBox( amin, amax );
+
+      context->lp = lp;
+      candidates->Search( amin, amax, falpCallback1, reinterpret_cast< void * >( context ) );
+      candidates_sol->Insert( amin, amax, lp );
+    }
+  }
+
   while ( list->getSize() > 0 ) // O (log size)
   {
     if ( pal->isCanceled() )
@@ -390,6 +441,18 @@ void Problem::init_sol_falp()
   delete list;
 }
 
+void Problem::markReusedLabelsOk( bool *ok )
+{
+  if ( !reusedLabel )
+    return;
+
+  for ( int i = 0; i < nbft; i++ )
+  {
+    if ( reusedLabel[i] >= 0 && sol->s[i] == reusedLabel[i] )
+      ok[i] = true;
+  }
+}
+
 void Problem::popmusic()
 {
 
@@ -435,6 +498,9 @@ void Problem::popmusic()
 
   init_sol_falp();
 
+  // reused labels are only revisited when a neighboring label changes
+  markReusedLabelsOk( ok );
+
   solution_cost();
 
   int popit = 0;
@@ -2169,6 +2235,9 @@ void Problem::chain_search()
   //initialization();
   init_sol_falp();
 
+  // reused labels are only revisited when a neighboring label changes
+  markReusedLabelsOk( ok );
+
   //check_solution();
   solution_cost();
 
@@ -2237,6 +2306,212 @@ void Problem::chain_search()
   delete[] ok;
 }
 
+typedef struct
+{
+  LabelPosition *lp = nullptr;
+  int *parent = nullptr;
+} ComponentContext;
+
+//! Returns the root of the component of feature \a i, compressing the path on the way
+inline int findComponent( int *parent, int i )
+{
+  while ( parent[i] != i )
+  {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+bool mergeComponentsCallback( LabelPosition *lp, void *ctx )
+{
+  ComponentContext *context = reinterpret_cast< ComponentContext * >( ctx );
+  int root1 = findComponent( context->parent, context->lp->getProblemFeatureId() );
+  int root2 = findComponent( context->parent, lp->getProblemFeatureId() );
+
+  if ( root1 != root2 && context->lp->isInConflict( lp ) )
+  {
+    // the lowest feature stays the root, so components are ordered by their first feature
+    if ( root1 < root2 )
+      context->parent[root2] = root1;
+    else
+      context->parent[root1] = root2;
+  }
+  return true;
+}
+
+//! Minimum number of features solved together, small components are grouped to limit the overhead of sub problems
+static const int COMPONENT_BATCH_SIZE = 256;
+
+typedef struct
+{
+  QList<int> features;
+  Problem *problem = nullptr;
+  SearchMethod searchMethod = CHAIN;
+} ComponentJob;
+
+void solveComponentJob( ComponentJob &job )
+{
+  Problem *prob = job.problem;
+  SearchMethod searchMethod = job.searchMethod;
+
+  try
+  {
+    if ( searchMethod == FALP )
+      prob->init_sol_falp();
+    else if ( searchMethod == CHAIN )
+      prob->chain_search();
+    else
+      prob->popmusic();
+  }
+  catch ( InternalException::Empty )
+  {
+    prob->init_sol_empty();
+  }
+}
+
+Problem *Problem::componentProblem( const QList<int> &features )
+{
+  Problem *prob = new Problem();
+  prob->pal = pal;
+  prob->displayAll = displayAll;
+  memcpy( prob->bbox, bbox, sizeof( double ) * 4 );
+
+  prob->nbft = features.count();
+  prob->featStartId = new int[prob->nbft];
+  prob->featNbLp = new int[prob->nbft];
+  prob->inactiveCost = new double[prob->nbft];
+  if ( reusedLabel )
+    prob->reusedLabel = new int[prob->nbft];
+
+  int lpId = 0;
+  int nbOverlaps = 0;
+  for ( int i = 0; i < prob->nbft; i++ )
+  {
+    int f = features.at( i );
+    prob->featStartId[i] = lpId;
+    prob->featNbLp[i] = featNbLp[f];
+    prob->inactiveCost[i] = inactiveCost[f];
+    if ( reusedLabel )
+      prob->reusedLabel[i] = reusedLabel[f] < 0 ? -1 : lpId + reusedLabel[f] - featStartId[f];
+
+    for ( int j = 0; j < featNbLp[f]; j++ )
+    {
+      LabelPosition *lp = mLabelPositions.at( featStartId[f] + j );
+      lp->setProblemIds( i, lpId++ );
+      lp->insertIntoIndex( prob->candidates );
+      nbOverlaps += lp->getNumOverlaps();
+      prob->mLabelPositions.append( lp );
+    }
+  }
+
+  prob->nblp = lpId;
+  prob->all_nblp = lpId;
+  prob->nbOverlap = nbOverlaps / 2;
+  return prob;
+}
+
+void Problem::solveComponents()
+{
+  if ( nbft == 0 )
+    return;
+
+  int i;
+  double amin[2];
+  double amax[2];
+
+  // union-find over the features, two features are merged as soon as two of their candidates conflict
+  int *parent = new int[nbft];
+  for ( i = 0; i < nbft; i++ )
+    parent[i] = i;
+
+  ComponentContext context;
+  context.parent = parent;
+  for ( i = 0; i < nbft; i++ )
+  {
+    for ( int j = 0; j < featNbLp[i]; j++ )
+    {
+      context.lp = mLabelPositions.at( featStartId[i] + j );
+      context.lp->getBoundingBox( amin, amax );
+      candidates->Search( amin, amax, mergeComponentsCallback, &context );
+    }
+  }
+
+  int *componentSize = new int[nbft];
+  memset( componentSize, 0, sizeof( int ) * nbft );
+  for ( i = 0; i < nbft; i++ )
+    componentSize[findComponent( parent, i )]++;
+
+  // consecutive components are batched up to a fixed size, so the jobs only depend on the problem
+  int *componentJob = new int[nbft];
+  QList< ComponentJob > jobs;
+  int batchSize = COMPONENT_BATCH_SIZE;
+  for ( i = 0; i < nbft; i++ )
+  {
+    int root = findComponent( parent, i );
+    if ( root == i )
+    {
+      if ( batchSize >= COMPONENT_BATCH_SIZE )
+      {
+        jobs.append( ComponentJob() );
+        batchSize = 0;
+      }
+      componentJob[i] = jobs.count() - 1;
+      batchSize += componentSize[i];
+    }
+    // roots are the lowest feature of their component, so they were already assigned
+    jobs[componentJob[root]].features.append( i );
+  }
+
+  delete[] componentJob;
+  delete[] componentSize;
+  delete[] parent;
+
+  if ( jobs.count() == 1 )
+  {
+    // nothing to split
+    ComponentJob job;
+    job.problem = this;
+    job.searchMethod = pal->searchMethod;
+    solveComponentJob( job );
+    return;
+  }
+
+  for ( ComponentJob &job : jobs )
+  {
+    job.problem = componentProblem( job.features );
+    job.searchMethod = pal->searchMethod;
+  }
+
+  QtConcurrent::blockingMap( jobs, solveComponentJob );
+
+  // gather the solutions in feature order and restore the ids of the candidates
+  init_sol_empty();
+  sol->cost = 0.0;
+  nbActive = 0;
+  for ( const ComponentJob &job : qAsConst( jobs ) )
+  {
+    Problem *prob = job.problem;
+    for ( i = 0; i < prob->nbft; i++ )
+    {
+      int f = job.features.at( i );
+      for ( int j = 0; j < featNbLp[f]; j++ )
+        mLabelPositions.at( featStartId[f] + j )->setProblemIds( f, featStartId[f] + j );
+
+      int label = prob->sol ? prob->sol->s[i] : -1;
+      sol->s[f] = label < 0 ? -1 : featStartId[f] + label - prob->featStartId[i];
+    }
+
+    if ( prob->sol )
+      sol->cost += prob->sol->cost;
+    nbActive += prob->nbActive;
+
+    // candidates are owned by this problem
+    prob->mLabelPositions.clear();
+    delete prob;
+  }
+}
+
 bool Problem::compareLabelArea( pal::LabelPosition *l1, pal::LabelPosition *l2 )
 {
   return l1->getWidth() * l1->getHeight() > l2->getWidth() * l2->getHeight();
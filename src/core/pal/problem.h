@@ -139,6 +139,13 @@ namespace pal
 
       void reduce();
 
+      /**
+       * Finds candidates reused from a previous solution (see Pal::registerReuseCallback()).
+       * Must be called after reduce() and before searching a solution.
+       * \since QGIS 3.0
+       */
+      void findReusedCandidates();
+
       /**
        * \brief popmusic framework
        */
@@ -149,6 +156,16 @@ namespace pal
        */
       void chain_search();
 
+      /**
+       * Splits the problem in independent components, i.e. groups of features whose candidates
+       * only conflict with candidates of the same group, and searches a solution for each of them
+       * concurrently on the global thread pool using the search method of the Pal instance.
+       * The solution does not depend on the number of threads or on their scheduling.
+       * Must be called after reduce() and findReusedCandidates().
+       * \since QGIS 3.0
+       */
+      void solveComponents();
+
       QList<LabelPosition *> *getSolution( bool returnInactive );
 
       PalStat *getStats();
@@ -236,6 +253,7 @@ namespace pal
       int *featStartId; // [nbft]
       int *featNbLp;    // [nbft]
       double *inactiveCost; //
+      int *reusedLabel = nullptr; // [nbft] candidate reused from a previous solution, or -1
 
       Sol *sol;         // [nbft]
       int nbActive;
@@ -244,6 +262,12 @@ namespace pal
 
       int *featWrap = nullptr;
 
+      /**
+       * Creates a problem with the given features (ordered by feature id) and their active candidates.
+       * The candidates are renumbered for the new problem, which does not take their ownership.
+       */
+      Problem *componentProblem( const QList<int> &features );
+
       Chain *chain( SubPart *part, int seed );
 
       Chain *chain( int seed );
@@ -252,6 +276,9 @@ namespace pal
 
       void solution_cost();
       void check_solution();
+
+      //! Flags features whose label placement was reused from a previous solution as ok for the search
+      void markReusedLabelsOk( bool *ok );
   };
 
 } // namespace
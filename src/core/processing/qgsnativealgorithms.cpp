@@ -17,6 +17,8 @@
 
 #include "qgsnativealgorithms.h"
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturebatch.h"
+#include "qgsexpressionbatch.h"
 #include "qgsprocessingcontext.h"
 #include "qgsprocessingfeedback.h"
 #include "qgsprocessingutils.h"
@@ -810,27 +812,33 @@ QVariantMap QgsExtractByExpressionAlgorithm::processAlgorithm( const QVariantMap
     expressionContext.setFields( source->fields() );
     expression.prepare( &expressionContext );
 
+    // evaluate the expression for batches of features at once. The features are read into the
+    // batches column by column, and only created when they are written to one of the sinks
+    QgsFeatureBatch batch( source->fields() );
+    QgsExpressionBatchValues results;
     QgsFeatureIterator it = source->getFeatures();
-    QgsFeature f;
-    while ( it.nextFeature( f ) )
+    while ( it.nextBatch( batch, 1000 ) > 0 )
     {
       if ( feedback->isCanceled() )
       {
         break;
       }
 
-      expressionContext.setFeature( f );
-      if ( expression.evaluate( &expressionContext ).toBool() )
-      {
-        matchingSink->addFeature( f, QgsFeatureSink::FastInsert );
-      }
-      else
+      expression.evaluateBatch( batch, &expressionContext, results );
+      for ( int row = 0; row < batch.count(); ++row )
       {
-        nonMatchingSink->addFeature( f, QgsFeatureSink::FastInsert );
+        if ( results.value( row ).toBool() )
+        {
+          matchingSink->addFeature( batch.feature( row ), QgsFeatureSink::FastInsert );
+        }
+        else
+        {
+          nonMatchingSink->addFeature( batch.feature( row ), QgsFeatureSink::FastInsert );
+        }
       }
 
+      current += batch.count();
       feedback->setProgress( current * step );
-      current++;
     }
   }
 
@@ -14,6 +14,7 @@
  ***************************************************************************/
 #include "qgsmemoryfeatureiterator.h"
 #include "qgsmemoryprovider.h"
+#include "qgsfeaturebatch.h"
 
 #include "qgsgeometry.h"
 #include "qgsgeometryengine.h"
@@ -100,6 +101,38 @@ bool QgsMemoryFeatureIterator::fetchFeature( QgsFeature &feature )
     return nextFeatureTraverseAll( feature );
 }
 
+int QgsMemoryFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  if ( mClosed )
+    return 0;
+
+  if ( mUsingFeatureIdList || !mFilterRect.isNull() || mSubsetExpression || mTransform.isValid() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxFeatures );
+
+  // read the stored features directly, without copying them
+  bool fetchGeometry = !( mRequest.flags() & QgsFeatureRequest::NoGeometry );
+  int fetched = 0;
+  for ( ; fetched < maxFeatures && mSelectIterator != mSource->mFeatures.constEnd(); ++fetched, ++mSelectIterator )
+  {
+    batch.appendRow( mSelectIterator->id() );
+
+    const QgsAttributes attributes = mSelectIterator->attributes();
+    for ( int idx = 0; idx < attributes.count(); ++idx )
+    {
+      int column = batch.columnIndex( idx );
+      if ( column >= 0 )
+        batch.setValue( column, attributes.at( idx ) );
+    }
+
+    if ( fetchGeometry && mSelectIterator->hasGeometry() )
+      batch.setGeometry( mSelectIterator->geometry() );
+  }
+
+  if ( fetched == 0 )
+    close();
+
+  return fetched;
+}
 
 bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
 {
@@ -63,6 +63,7 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
   protected:
 
     virtual bool fetchFeature( QgsFeature &feature ) override;
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
 
   private:
     bool nextFeatureUsingList( QgsFeature &feature );
@@ -20,6 +20,7 @@
 #include "qgsgeometry.h"
 #include "qgscurve.h"
 #include "qgslogger.h"
+#include "qgssimd_p.h"
 
 // Where has all the code gone?
 
@@ -38,10 +39,92 @@ const double QgsClipper::MIN_Y = -16000;
 
 const double QgsClipper::SMALL_NUM = 1e-12;
 
-QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent )
+///@cond PRIVATE
+
+// The kernels below check the points against the boundaries with the same strict
+// comparisons as QgsClipper::inside(), so NaN coordinates are never inside.
+// They return a combination of 1 << QgsClipper::Boundary flags.
+
+#ifndef QGIS_SIMD_SSE2
+static int insideBoundariesScalar( const QPointF *points, int count, const QgsRectangle &rect )
+{
+  bool xMax = true, xMin = true, yMax = true, yMin = true;
+  for ( int i = 0; i < count; ++i, ++points )
+  {
+    xMax &= points->x() < rect.xMaximum();
+    xMin &= points->x() > rect.xMinimum();
+    yMax &= points->y() < rect.yMaximum();
+    yMin &= points->y() > rect.yMinimum();
+  }
+  return ( xMax ? 1 << QgsClipper::XMax : 0 ) | ( xMin ? 1 << QgsClipper::XMin : 0 )
+         | ( yMax ? 1 << QgsClipper::YMax : 0 ) | ( yMin ? 1 << QgsClipper::YMin : 0 );
+}
+#else
+// maxMask and minMask hold the (x, y) lanes of the comparisons done so far
+static int boundaryFlags( int maxMask, int minMask )
+{
+  return ( maxMask & 1 ? 1 << QgsClipper::XMax : 0 ) | ( maxMask & 2 ? 1 << QgsClipper::YMax : 0 )
+         | ( minMask & 1 ? 1 << QgsClipper::XMin : 0 ) | ( minMask & 2 ? 1 << QgsClipper::YMin : 0 );
+}
+
+static int insideBoundariesSse2( const QPointF *points, int count, const QgsRectangle &rect, int maxMask = 3, int minMask = 3 )
 {
-  const int nPoints = curve.numPoints();
+  const double *xy = reinterpret_cast< const double * >( points );
+  const __m128d max = _mm_set_pd( rect.yMaximum(), rect.xMaximum() );
+  const __m128d min = _mm_set_pd( rect.yMinimum(), rect.xMinimum() );
+  __m128d belowMax = _mm_castsi128_pd( _mm_set1_epi32( -1 ) );
+  __m128d aboveMin = belowMax;
+  for ( int i = 0; i < count; ++i, xy += 2 )
+  {
+    const __m128d p = _mm_loadu_pd( xy );
+    belowMax = _mm_and_pd( belowMax, _mm_cmplt_pd( p, max ) );
+    aboveMin = _mm_and_pd( aboveMin, _mm_cmpgt_pd( p, min ) );
+  }
+  return boundaryFlags( maxMask & _mm_movemask_pd( belowMax ), minMask & _mm_movemask_pd( aboveMin ) );
+}
+#endif
 
+#ifdef QGIS_SIMD_AVX2_DISPATCH
+// two points per iteration, the odd point left is checked with SSE2
+static QGIS_TARGET_AVX2 int insideBoundariesAvx2( const QPointF *points, int count, const QgsRectangle &rect )
+{
+  const double *xy = reinterpret_cast< const double * >( points );
+  const __m256d max = _mm256_set_pd( rect.yMaximum(), rect.xMaximum(), rect.yMaximum(), rect.xMaximum() );
+  const __m256d min = _mm256_set_pd( rect.yMinimum(), rect.xMinimum(), rect.yMinimum(), rect.xMinimum() );
+  __m256d belowMax = _mm256_castsi256_pd( _mm256_set1_epi32( -1 ) );
+  __m256d aboveMin = belowMax;
+  int i = 0;
+  for ( ; i + 1 < count; i += 2, xy += 4 )
+  {
+    const __m256d p = _mm256_loadu_pd( xy );
+    belowMax = _mm256_and_pd( belowMax, _mm256_cmp_pd( p, max, _CMP_LT_OQ ) );
+    aboveMin = _mm256_and_pd( aboveMin, _mm256_cmp_pd( p, min, _CMP_GT_OQ ) );
+  }
+  // fold the lanes of both points
+  const int maxMask = _mm256_movemask_pd( belowMax );
+  const int minMask = _mm256_movemask_pd( aboveMin );
+  return insideBoundariesSse2( points + i, count - i, rect, maxMask & ( maxMask >> 2 ), minMask & ( minMask >> 2 ) );
+}
+#endif
+
+///@endcond
+
+int QgsClipper::insideBoundaries( const QPolygonF &points, const QgsRectangle &clipRect )
+{
+#if defined(QGIS_SIMD_AVX2_DISPATCH)
+  if ( qgsCpuHasAvx2() )
+    return insideBoundariesAvx2( points.constData(), points.size(), clipRect );
+#endif
+#if defined(QGIS_SIMD_SSE2)
+  return insideBoundariesSse2( points.constData(), points.size(), clipRect );
+#else
+  return insideBoundariesScalar( points.constData(), points.size(), clipRect );
+#endif
+}
+
+template<typename X, typename Y>
+QPolygonF QgsClipper::clippedLine( int nPoints, const X &xAt, const Y &yAt, const QgsRectangle &clipExtent )
+{
   double p0x, p0y, p1x = 0.0, p1y = 0.0; //original coordinates
   double p1x_c, p1y_c; //clipped end coordinates
   double lastClipX = 0.0, lastClipY = 0.0; //last successfully clipped coords
@@ -53,8 +136,8 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
   {
     if ( i == 0 )
     {
-      p1x = curve.xAt( i );
-      p1y = curve.yAt( i );
+      p1x = xAt( i );
+      p1y = yAt( i );
       continue;
     }
     else
@@ -62,8 +145,8 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
       p0x = p1x;
       p0y = p1y;
 
-      p1x = curve.xAt( i );
-      p1y = curve.yAt( i );
+      p1x = xAt( i );
+      p1y = yAt( i );
 
       p1x_c = p1x;
       p1y_c = p1y;
@@ -92,6 +175,25 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
   return line;
 }
 
+QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent )
+{
+  auto xAt = [&curve]( int i ) { return curve.xAt( i ); };
+  auto yAt = [&curve]( int i ) { return curve.yAt( i ); };
+  return clippedLine( curve.numPoints(), xAt, yAt, clipExtent );
+}
+
+QPolygonF QgsClipper::clippedLine( const QPolygonF &curve, const QgsRectangle &clipExtent )
+{
+  // a line completely inside the extent is returned as is
+  if ( curve.size() > 1 && insideBoundaries( curve, clipExtent ) == ( 1 << XMax | 1 << XMin | 1 << YMax | 1 << YMin ) )
+    return curve;
+
+  const QPointF *points = curve.constData();
+  auto xAt = [points]( int i ) { return points[i].x(); };
+  auto yAt = [points]( int i ) { return points[i].y(); };
+  return clippedLine( curve.size(), xAt, yAt, clipExtent );
+}
+
 void QgsClipper::connectSeparatedLines( double x0, double y0, double x1, double y1,
                                         const QgsRectangle &clipRect, QPolygonF &pts )
 {
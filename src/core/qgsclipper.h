@@ -106,8 +106,23 @@ class CORE_EXPORT QgsClipper
      */
     static QPolygonF clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent );
 
+    /** Takes a linestring and clips it to clipExtent
+     * \param curve the linestring coordinates
+     * \param clipExtent clipping bounds
+     * \returns clipped line coordinates
+     * \since QGIS 3.0
+     */
+    static QPolygonF clippedLine( const QPolygonF &curve, const QgsRectangle &clipExtent );
+
   private:
 
+    // Returns the boundaries of clipRect which all points are strictly inside of, as a combination of 1 << Boundary
+    // flags. Trimming to these boundaries would leave the points unchanged.
+    static int insideBoundaries( const QPolygonF &points, const QgsRectangle &clipRect );
+
+    // Clips a linestring of nPoints points, whose coordinates are returned by xAt( i ) and yAt( i )
+    template<typename X, typename Y> static QPolygonF clippedLine( int nPoints, const X &xAt, const Y &yAt, const QgsRectangle &clipExtent );
+
     // Used when testing for equivalance to 0.0
     static const double SMALL_NUM;
 
@@ -198,16 +213,40 @@ inline void QgsClipper::trimFeature( QVector<double> &x,
 
 inline void QgsClipper::trimPolygon( QPolygonF &pts, const QgsRectangle &clipRect )
 {
+  // trimming to a boundary which all points are inside of is a copy, so skip it
+  const int inside = insideBoundaries( pts, clipRect );
+  if ( inside == ( 1 << XMax | 1 << XMin | 1 << YMax | 1 << YMin ) )
+    return;
+
   QPolygonF tmpPts;
   tmpPts.reserve( pts.size() );
 
-  trimPolygonToBoundary( pts, tmpPts, clipRect, XMax, clipRect.xMaximum() );
-  pts.resize( 0 );
-  trimPolygonToBoundary( tmpPts, pts, clipRect, YMax, clipRect.yMaximum() );
-  tmpPts.resize( 0 );
-  trimPolygonToBoundary( pts, tmpPts, clipRect, XMin, clipRect.xMinimum() );
-  pts.resize( 0 );
-  trimPolygonToBoundary( tmpPts, pts, clipRect, YMin, clipRect.yMinimum() );
+  const Boundary boundaries[] = { XMax, YMax, XMin, YMin };
+  for ( Boundary b : boundaries )
+  {
+    if ( inside & ( 1 << b ) )
+      continue;
+
+    double boundaryValue = 0.0;
+    switch ( b )
+    {
+      case XMax:
+        boundaryValue = clipRect.xMaximum();
+        break;
+      case YMax:
+        boundaryValue = clipRect.yMaximum();
+        break;
+      case XMin:
+        boundaryValue = clipRect.xMinimum();
+        break;
+      case YMin:
+        boundaryValue = clipRect.yMinimum();
+        break;
+    }
+    trimPolygonToBoundary( pts, tmpPts, clipRect, b, boundaryValue );
+    pts.swap( tmpPts );
+    tmpPts.resize( 0 );
+  }
 }
 
 // An auxiliary function that is part of the polygon trimming
@@ -31,6 +31,8 @@
 #include <QStringList>
 #include <QVector>
 
+#include <type_traits>
+
 extern "C"
 {
 #include <proj_api.h>
@@ -227,6 +229,25 @@ void QgsCoordinateTransform::transformPolygon( QPolygonF &poly, TransformDirecti
   //create x, y arrays
   int nVertices = poly.size();
 
+  if ( std::is_same< qreal, double >::value )
+  {
+    // transform the interleaved coordinates of the points directly. z values are
+    // needed by proj for geocentric systems, and must have the same offset
+    double *xy = reinterpret_cast< double * >( poly.data() );
+    QVector<double> z( 2 * nVertices );
+    try
+    {
+      transformCoords( nVertices, xy, xy + 1, z.data(), 2, direction );
+    }
+    catch ( const QgsCsException & )
+    {
+      // rethrow the exception
+      QgsDebugMsg( "rethrowing exception" );
+      throw;
+    }
+    return;
+  }
+
   QVector<double> x( nVertices );
   QVector<double> y( nVertices );
   QVector<double> z( nVertices );
@@ -446,6 +467,11 @@ QgsRectangle QgsCoordinateTransform::transformBoundingBox( const QgsRectangle &r
 }
 
 void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *y, double *z, TransformDirection direction ) const
+{
+  transformCoords( numPoints, x, y, z, 1, direction );
+}
+
+void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *y, double *z, int pointOffset, TransformDirection direction ) const
 {
   if ( !d->mIsValid || d->mShortCircuit )
     return;
@@ -481,7 +507,7 @@ void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *
   if ( ( pj_is_latlong( destProj ) && ( direction == ReverseTransform ) )
        || ( pj_is_latlong( sourceProj ) && ( direction == ForwardTransform ) ) )
   {
-    for ( int i = 0; i < numPoints; ++i )
+    for ( int i = 0; i < numPoints * pointOffset; i += pointOffset )
     {
       x[i] *= DEG_TO_RAD;
       y[i] *= DEG_TO_RAD;
@@ -491,13 +517,13 @@ void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *
   int projResult;
   if ( direction == ReverseTransform )
   {
-    projResult = pj_transform( destProj, sourceProj, numPoints, 0, x, y, z );
+    projResult = pj_transform( destProj, sourceProj, numPoints, pointOffset, x, y, z );
   }
   else
   {
     Q_ASSERT( sourceProj );
     Q_ASSERT( destProj );
-    projResult = pj_transform( sourceProj, destProj, numPoints, 0, x, y, z );
+    projResult = pj_transform( sourceProj, destProj, numPoints, pointOffset, x, y, z );
   }
 
   if ( projResult != 0 )
@@ -505,7 +531,7 @@ void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *
     //something bad happened....
     QString points;
 
-    for ( int i = 0; i < numPoints; ++i )
+    for ( int i = 0; i < numPoints * pointOffset; i += pointOffset )
     {
       if ( direction == ForwardTransform )
       {
@@ -545,7 +571,7 @@ void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *
   if ( ( pj_is_latlong( destProj ) && ( direction == ForwardTransform ) )
        || ( pj_is_latlong( sourceProj ) && ( direction == ReverseTransform ) ) )
   {
-    for ( int i = 0; i < numPoints; ++i )
+    for ( int i = 0; i < numPoints * pointOffset; i += pointOffset )
     {
       x[i] *= RAD_TO_DEG;
       y[i] *= RAD_TO_DEG;
@@ -238,6 +238,23 @@ class CORE_EXPORT QgsCoordinateTransform
      */
     void transformCoords( int numPoint, double *x, double *y, double *z, TransformDirection direction = ForwardTransform ) const;
 
+    /** Transforms an array of coordinates in place to the destination CRS, where the coordinates of
+     * consecutive points are \a pointOffset values apart. This allows transforming coordinate
+     * buffers which store the coordinates of each point together without copying them to separate
+     * arrays, e.g. interleaved x and y values (a \a pointOffset of 2) as in a QPolygonF.
+     * If the direction is ForwardTransform then coordinates are transformed from source to destination,
+     * otherwise points are transformed from destination to source CRS.
+     * \param numPoints number of points
+     * \param x pointer to the x coordinate of the first point
+     * \param y pointer to the y coordinate of the first point
+     * \param z pointer to the z coordinate of the first point, or nullptr if there are no z coordinates
+     * \param pointOffset number of values between the coordinates of consecutive points
+     * \param direction transform direction
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void transformCoords( int numPoints, double *x, double *y, double *z, int pointOffset, TransformDirection direction ) const SIP_SKIP;
+
     /** Returns true if the transform short circuits because the source and destination are equivalent.
      */
     bool isShortCircuited() const;
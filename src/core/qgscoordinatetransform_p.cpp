@@ -30,6 +30,8 @@ extern "C"
 /// @cond PRIVATE
 
 thread_local QgsProjContextStore QgsCoordinateTransformPrivate::mProjContext;
+QAtomicInt QgsCoordinateTransformPrivate::sNextProjDataId( 1 );
+thread_local QgsCoordinateTransformPrivate::LastProjData QgsCoordinateTransformPrivate::sLastProjData;
 
 QgsProjContextStore::QgsProjContextStore()
 {
@@ -191,6 +193,10 @@ bool QgsCoordinateTransformPrivate::initialize()
 
 QPair<projPJ, projPJ> QgsCoordinateTransformPrivate::threadLocalProjData()
 {
+  // transforms are usually done in long runs with the same transform, e.g. while rendering a layer
+  if ( mProjDataId != 0 && sLastProjData.id == mProjDataId )
+    return sLastProjData.projData;
+
   mProjLock.lockForRead();
 
   QMap < uintptr_t, QPair< projPJ, projPJ > >::const_iterator it = mProjProjections.constFind( reinterpret_cast< uintptr_t>( mProjContext.get() ) );
@@ -198,6 +204,8 @@ QPair<projPJ, projPJ> QgsCoordinateTransformPrivate::threadLocalProjData()
   {
     QPair<projPJ, projPJ> res = it.value();
     mProjLock.unlock();
+    sLastProjData.id = mProjDataId;
+    sLastProjData.projData = res;
     return res;
   }
 
@@ -208,6 +216,8 @@ QPair<projPJ, projPJ> QgsCoordinateTransformPrivate::threadLocalProjData()
                                          pj_init_plus_ctx( mProjContext.get(), mDestProjString.toUtf8() ) );
   mProjProjections.insert( reinterpret_cast< uintptr_t>( mProjContext.get() ), res );
   mProjLock.unlock();
+  sLastProjData.id = mProjDataId;
+  sLastProjData.projData = res;
   return res;
 }
 
@@ -339,6 +349,8 @@ void QgsCoordinateTransformPrivate::freeProj()
     pj_free( it.value().second );
   }
   mProjProjections.clear();
+  // projections cached by threads for the old id must not be used anymore
+  mProjDataId = sNextProjDataId.fetchAndAddRelaxed( 1 );
   mProjLock.unlock();
 }
 
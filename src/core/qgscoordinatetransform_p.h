@@ -30,6 +30,7 @@
 // version without notice, or even be removed.
 //
 
+#include <QAtomicInt>
 #include <QSharedData>
 #include "qgscoordinatereferencesystem.h"
 
@@ -103,6 +104,12 @@ class QgsCoordinateTransformPrivate : public QSharedData
     QReadWriteLock mProjLock;
     QMap < uintptr_t, QPair< projPJ, projPJ > > mProjProjections;
 
+    /**
+     * Identifies the current set of proj projections. A new id is assigned whenever
+     * the projections are freed, so ids are never reused for different projections.
+     */
+    int mProjDataId = 0;
+
     static QString datumTransformString( int datumTransform );
 
   private:
@@ -116,6 +123,20 @@ class QgsCoordinateTransformPrivate : public QSharedData
     void setFinder();
 
     void freeProj();
+
+    //! Source of unique projection data ids
+    static QAtomicInt sNextProjDataId;
+
+    /**
+     * The projections last returned by threadLocalProjData() in the current thread,
+     * which lets repeated transforms with the same transform skip the lock and lookup.
+     */
+    struct LastProjData
+    {
+      int id = 0;
+      QPair< projPJ, projPJ > projData;
+    };
+    static thread_local LastProjData sLastProjData;
 };
 
 /// @endcond
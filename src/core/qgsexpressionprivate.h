@@ -24,6 +24,7 @@
 #include "qgsdistancearea.h"
 #include "qgsunittypes.h"
 #include "qgsexpressionnode.h"
+#include "qgsexpressionprogram.h"
 
 ///@cond
 
@@ -52,6 +53,7 @@ class QgsExpressionPrivate
       , mCalc( other.mCalc )
       , mDistanceUnit( other.mDistanceUnit )
       , mAreaUnit( other.mAreaUnit )
+      , mCompilationEnabled( other.mCompilationEnabled )
     {}
 
     ~QgsExpressionPrivate()
@@ -63,6 +65,9 @@ class QgsExpressionPrivate
 
     QgsExpressionNode *mRootNode = nullptr;
 
+    //! Compiled prepared tree, not copied since it refers to the nodes of mRootNode
+    std::unique_ptr< QgsExpressionProgram > mProgram;
+
     QString mParserErrorString;
     QString mEvalErrorString;
 
@@ -71,6 +76,9 @@ class QgsExpressionPrivate
     std::shared_ptr<QgsDistanceArea> mCalc;
     QgsUnitTypes::DistanceUnit mDistanceUnit;
     QgsUnitTypes::AreaUnit mAreaUnit;
+
+    //! Whether prepare() compiles the tree to mProgram
+    bool mCompilationEnabled = true;
 };
 ///@endcond
 
@@ -0,0 +1,236 @@
+/***************************************************************************
+  qgsfeaturebatch.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfeaturebatch.h"
+#include "qgsgeometry.h"
+
+#include <cstring>
+
+QgsFeatureBatch::QgsFeatureBatch( const QgsFields &fields, const QgsAttributeList &attributes )
+  : mFields( fields )
+{
+  mFieldColumns.fill( -1, fields.count() );
+  Q_FOREACH ( int fieldIndex, attributes.isEmpty() ? fields.allAttributesList() : attributes )
+  {
+    if ( fieldIndex < 0 || fieldIndex >= fields.count() || mFieldColumns.at( fieldIndex ) >= 0 )
+      continue;
+
+    Column column;
+    column.field = fieldIndex;
+    switch ( fields.at( fieldIndex ).type() )
+    {
+      case QVariant::Double:
+        column.type = DoubleColumn;
+        break;
+
+      case QVariant::Int:
+      case QVariant::UInt:
+      case QVariant::LongLong:
+      case QVariant::ULongLong:
+      case QVariant::Bool:
+        column.type = IntegerColumn;
+        break;
+
+      case QVariant::String:
+        column.type = StringColumn;
+        break;
+
+      default:
+        column.type = VariantColumn;
+        break;
+    }
+
+    mFieldColumns[fieldIndex] = mColumns.count();
+    mColumns.append( column );
+    mAttributes.append( fieldIndex );
+  }
+
+  mWkbOffsets.append( 0 );
+}
+
+void QgsFeatureBatch::clear()
+{
+  // resizing keeps the capacity of the vectors, so a batch reused for the next call does not allocate again
+  for ( Column &column : mColumns )
+  {
+    column.doubles.resize( 0 );
+    column.integers.resize( 0 );
+    column.strings.resize( 0 );
+    column.variants.resize( 0 );
+    column.nulls.resize( 0 );
+  }
+  mIds.resize( 0 );
+  mWkb.resize( 0 );
+  mWkbOffsets.resize( 1 );
+}
+
+QVariant QgsFeatureBatch::value( int row, int column ) const
+{
+  const Column &c = mColumns.at( column );
+  QVariant::Type fieldType = mFields.at( c.field ).type();
+  if ( c.nulls.at( row ) )
+    return QVariant( fieldType );
+
+  switch ( c.type )
+  {
+    case DoubleColumn:
+      return c.doubles.at( row );
+
+    case IntegerColumn:
+    {
+      QVariant v( c.integers.at( row ) );
+      v.convert( fieldType );
+      return v;
+    }
+
+    case StringColumn:
+      return c.strings.at( row );
+
+    case VariantColumn:
+      break;
+  }
+  return c.variants.at( row );
+}
+
+QgsGeometry QgsFeatureBatch::geometry( int row ) const
+{
+  QgsGeometry geometry;
+  int size = 0;
+  const unsigned char *data = wkb( row, size );
+  if ( size > 0 )
+    geometry.fromWkb( QByteArray( reinterpret_cast< const char * >( data ), size ) );
+  return geometry;
+}
+
+const unsigned char *QgsFeatureBatch::wkb( int row, int &size ) const
+{
+  int start = mWkbOffsets.at( row );
+  size = mWkbOffsets.at( row + 1 ) - start;
+  return reinterpret_cast< const unsigned char * >( mWkb.constData() ) + start;
+}
+
+QgsFeature QgsFeatureBatch::feature( int row ) const
+{
+  QgsFeature f( mFields, mIds.at( row ) );
+  for ( int column = 0; column < mColumns.count(); ++column )
+  {
+    f.setAttribute( mColumns.at( column ).field, value( row, column ) );
+  }
+  if ( hasGeometry( row ) )
+    f.setGeometry( geometry( row ) );
+  return f;
+}
+
+void QgsFeatureBatch::appendFeature( const QgsFeature &feature )
+{
+  appendRow( feature.id() );
+
+  const QgsAttributes attributes = feature.attributes();
+  for ( int column = 0; column < mColumns.count(); ++column )
+  {
+    int field = mColumns.at( column ).field;
+    if ( field < attributes.count() )
+      setValue( column, attributes.at( field ) );
+  }
+
+  if ( feature.hasGeometry() )
+    setGeometry( feature.geometry() );
+}
+
+void QgsFeatureBatch::appendRow( QgsFeatureId id )
+{
+  mIds.append( id );
+  for ( Column &column : mColumns )
+  {
+    switch ( column.type )
+    {
+      case DoubleColumn:
+        column.doubles.append( 0.0 );
+        break;
+      case IntegerColumn:
+        column.integers.append( 0 );
+        break;
+      case StringColumn:
+        column.strings.append( QString() );
+        break;
+      case VariantColumn:
+        column.variants.append( QVariant() );
+        break;
+    }
+    column.nulls.append( 1 );
+  }
+  mWkbOffsets.append( mWkb.size() );
+}
+
+void QgsFeatureBatch::setDouble( int column, double value )
+{
+  Column &c = mColumns[column];
+  c.doubles.last() = value;
+  c.nulls.last() = 0;
+}
+
+void QgsFeatureBatch::setInteger( int column, qint64 value )
+{
+  Column &c = mColumns[column];
+  c.integers.last() = value;
+  c.nulls.last() = 0;
+}
+
+void QgsFeatureBatch::setString( int column, const QString &value )
+{
+  Column &c = mColumns[column];
+  c.strings.last() = value;
+  c.nulls.last() = value.isNull() ? 1 : 0;
+}
+
+void QgsFeatureBatch::setValue( int column, const QVariant &value )
+{
+  if ( value.isNull() )
+    return;
+
+  Column &c = mColumns[column];
+  switch ( c.type )
+  {
+    case DoubleColumn:
+      c.doubles.last() = value.toDouble();
+      break;
+    case IntegerColumn:
+      c.integers.last() = value.toLongLong();
+      break;
+    case StringColumn:
+      c.strings.last() = value.toString();
+      break;
+    case VariantColumn:
+      c.variants.last() = value;
+      break;
+  }
+  c.nulls.last() = 0;
+}
+
+unsigned char *QgsFeatureBatch::appendWkb( int size )
+{
+  int start = mWkb.size();
+  mWkb.resize( start + size );
+  mWkbOffsets.last() = start + size;
+  return reinterpret_cast< unsigned char * >( mWkb.data() ) + start;
+}
+
+void QgsFeatureBatch::setGeometry( const QgsGeometry &geometry )
+{
+  if ( geometry.isNull() )
+    return;
+
+  QByteArray data = geometry.exportToWkb();
+  std::memcpy( appendWkb( data.size() ), data.constData(), data.size() );
+}
@@ -0,0 +1,201 @@
+/***************************************************************************
+  qgsfeaturebatch.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFEATUREBATCH_H
+#define QGSFEATUREBATCH_H
+
+#include "qgis_core.h"
+#include "qgis.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+
+#include <QByteArray>
+#include <QVector>
+
+class QgsGeometry;
+
+/**
+ * \ingroup core
+ * \class QgsFeatureBatch
+ * A batch of features stored column by column.
+ *
+ * Attribute values are kept in typed arrays (doubles, 64 bit integers and strings),
+ * without QVariant boxing, and geometries are stored as WKB in one contiguous buffer.
+ * Batches are filled by QgsFeatureIterator::nextBatch(). A batch can be reused for
+ * subsequent calls, in which case its buffers are not reallocated.
+ *
+ * The columns of a batch are set when it is constructed: one column for each of the
+ * requested field indexes, or for all fields if no attributes are specified.
+ *
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsFeatureBatch
+{
+  public:
+
+    //! Storage type of a column
+    enum ColumnType
+    {
+      DoubleColumn, //!< Values are stored as doubles
+      IntegerColumn, //!< Values are stored as 64 bit integers (integer and boolean fields)
+      StringColumn, //!< Values are stored as strings
+      VariantColumn, //!< Values are stored as variants (all other field types)
+    };
+
+    /**
+     * Constructor for QgsFeatureBatch with columns for the specified field \a attributes
+     * of \a fields. If \a attributes is empty, the batch contains all fields.
+     */
+    QgsFeatureBatch( const QgsFields &fields = QgsFields(), const QgsAttributeList &attributes = QgsAttributeList() );
+
+    //! Returns the fields of the features in the batch
+    QgsFields fields() const { return mFields; }
+
+    //! Returns the field indexes stored as columns, in column order (invalid and duplicated indexes are dropped)
+    QgsAttributeList attributes() const { return mAttributes; }
+
+    //! Returns the number of columns in the batch
+    int columnCount() const { return mColumns.count(); }
+
+    //! Returns the column storing the field with index \a fieldIndex, or -1 if the field is not part of the batch
+    int columnIndex( int fieldIndex ) const { return fieldIndex >= 0 && fieldIndex < mFieldColumns.count() ? mFieldColumns.at( fieldIndex ) : -1; }
+
+    //! Returns the storage type of a \a column
+    ColumnType columnType( int column ) const { return mColumns.at( column ).type; }
+
+    //! Returns the number of features in the batch
+    int count() const { return mIds.count(); }
+
+    //! Returns true if the batch does not contain any feature
+    bool isEmpty() const { return mIds.isEmpty(); }
+
+    //! Removes all features from the batch, keeping the columns and the allocated memory
+    void clear();
+
+    //! Returns the id of the feature at \a row
+    QgsFeatureId id( int row ) const { return mIds.at( row ); }
+
+    //! Returns true if the value of \a column is NULL for the feature at \a row
+    bool isNull( int row, int column ) const { return mColumns.at( column ).nulls.at( row ); }
+
+    //! Returns the value of \a column for the feature at \a row
+    QVariant value( int row, int column ) const;
+
+    /**
+     * Returns the values of a DoubleColumn, one per feature. NULL values are stored as 0.
+     * \note not available in Python bindings
+     */
+    const double *doubleColumn( int column ) const SIP_SKIP { return mColumns.at( column ).doubles.constData(); }
+
+    /**
+     * Returns the values of an IntegerColumn, one per feature. NULL values are stored as 0.
+     * \note not available in Python bindings
+     */
+    const qint64 *integerColumn( int column ) const SIP_SKIP { return mColumns.at( column ).integers.constData(); }
+
+    /**
+     * Returns the values of a StringColumn, one per feature. NULL values are stored as null strings.
+     * \note not available in Python bindings
+     */
+    const QString *stringColumn( int column ) const SIP_SKIP { return mColumns.at( column ).strings.constData(); }
+
+    //! Returns true if the feature at \a row has a geometry
+    bool hasGeometry( int row ) const { return mWkbOffsets.at( row + 1 ) > mWkbOffsets.at( row ); }
+
+    //! Returns the geometry of the feature at \a row
+    QgsGeometry geometry( int row ) const;
+
+    /**
+     * Returns the WKB of the geometry of the feature at \a row and stores its length in \a size.
+     * The returned pointer points into the batch's geometry buffer, it stays valid until the batch is modified.
+     * \note not available in Python bindings
+     */
+    const unsigned char *wkb( int row, int &size ) const SIP_SKIP;
+
+    //! Returns the feature at \a row as a QgsFeature
+    QgsFeature feature( int row ) const;
+
+    //! Appends a \a feature at the end of the batch
+    void appendFeature( const QgsFeature &feature );
+
+    /**
+     * Appends a feature with id \a id, NULL values and no geometry at the end of the batch.
+     * Its values and geometry can then be set with the set...() and appendWkb() methods.
+     * \note not available in Python bindings
+     */
+    void appendRow( QgsFeatureId id ) SIP_SKIP;
+
+    /**
+     * Sets the \a value of a DoubleColumn for the last appended feature.
+     * \note not available in Python bindings
+     */
+    void setDouble( int column, double value ) SIP_SKIP;
+
+    /**
+     * Sets the \a value of an IntegerColumn for the last appended feature.
+     * \note not available in Python bindings
+     */
+    void setInteger( int column, qint64 value ) SIP_SKIP;
+
+    /**
+     * Sets the \a value of a StringColumn for the last appended feature.
+     * \note not available in Python bindings
+     */
+    void setString( int column, const QString &value ) SIP_SKIP;
+
+    /**
+     * Sets the \a value of a column of any type for the last appended feature. The value is
+     * converted to the storage type of the column, a null variant sets a NULL value.
+     * \note not available in Python bindings
+     */
+    void setValue( int column, const QVariant &value ) SIP_SKIP;
+
+    /**
+     * Reserves \a size bytes of WKB for the geometry of the last appended feature and returns a pointer
+     * where the WKB must be written. The pointer is only valid until the batch is modified.
+     * \note not available in Python bindings
+     */
+    unsigned char *appendWkb( int size ) SIP_SKIP;
+
+    /**
+     * Sets the \a geometry of the last appended feature. Must be called at most once per feature.
+     * \note not available in Python bindings
+     */
+    void setGeometry( const QgsGeometry &geometry ) SIP_SKIP;
+
+  private:
+
+    struct Column
+    {
+      ColumnType type = VariantColumn;
+      int field = -1;
+      QVector<double> doubles;
+      QVector<qint64> integers;
+      QVector<QString> strings;
+      QVector<QVariant> variants;
+      QVector<char> nulls;
+    };
+
+    QgsFields mFields;
+    QgsAttributeList mAttributes;
+    QVector<int> mFieldColumns;
+    QVector<Column> mColumns;
+
+    QVector<QgsFeatureId> mIds;
+    QByteArray mWkb;
+    //! start of the WKB of each feature, plus the end of the buffer
+    QVector<int> mWkbOffsets;
+};
+
+#endif // QGSFEATUREBATCH_H
@@ -13,6 +13,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturebatch.h"
 #include "qgslogger.h"
 
 #include "qgssimplifymethod.h"
@@ -77,6 +78,45 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
   return dataOk;
 }
 
+int QgsAbstractFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  batch.clear();
+
+  if ( mRequest.limit() >= 0 )
+    maxFeatures = static_cast< int >( qMin( static_cast< long >( maxFeatures ), mRequest.limit() - mFetchedCount ) );
+  if ( maxFeatures <= 0 )
+    return 0;
+
+  int fetched = 0;
+  if ( !mUseCachedFeatures && mRequest.filterType() == QgsFeatureRequest::FilterNone )
+  {
+    fetched = fetchBatch( batch, maxFeatures );
+    mFetchedCount += fetched;
+  }
+  else
+  {
+    QgsFeature f;
+    while ( fetched < maxFeatures && nextFeature( f ) )
+    {
+      batch.appendFeature( f );
+      fetched++;
+    }
+  }
+  return fetched;
+}
+
+int QgsAbstractFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  int fetched = 0;
+  QgsFeature f;
+  while ( fetched < maxFeatures && fetchFeature( f ) )
+  {
+    batch.appendFeature( f );
+    fetched++;
+  }
+  return fetched;
+}
+
 bool QgsAbstractFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   while ( fetchFeature( f ) )
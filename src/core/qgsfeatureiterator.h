@@ -19,6 +19,8 @@
 #include "qgsfeaturerequest.h"
 #include "qgsindexedfeature.h"
 
+class QgsFeatureBatch;
+
 
 
 /** \ingroup core
@@ -58,6 +60,15 @@ class CORE_EXPORT QgsAbstractFeatureIterator
     //! fetch next feature, return true on success
     virtual bool nextFeature( QgsFeature &f );
 
+    /**
+     * Fetches up to \a maxFeatures features into \a batch, replacing its previous content.
+     * Requests without filter expression or feature id filter are delegated to fetchBatch(),
+     * other requests are served by nextFeature().
+     * \returns number of fetched features, 0 when there are no more features
+     * \since QGIS 3.0
+     */
+    virtual int nextBatch( QgsFeatureBatch &batch, int maxFeatures );
+
     //! reset the iterator to the starting position
     virtual bool rewind() = 0;
     //! end of iterating: free the resources / lock
@@ -89,6 +100,20 @@ class CORE_EXPORT QgsAbstractFeatureIterator
      */
     virtual bool fetchFeature( QgsFeature &f ) = 0;
 
+    /**
+     * Appends up to \a maxFeatures features to \a batch.
+     * Iterators which can read their source straight into typed columns should
+     * implement this method. The default implementation appends the features
+     * returned by fetchFeature().
+     * It is only called for requests without filter expression or feature id filter.
+     *
+     * \param batch The batch to append features to
+     * \param maxFeatures Maximum number of features to append
+     * \returns number of appended features
+     * \since QGIS 3.0
+     */
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures );
+
     /**
      * By default, the iterator will fetch all features and check if the feature
      * matches the expression.
@@ -269,6 +294,15 @@ class CORE_EXPORT QgsFeatureIterator
     QgsFeatureIterator &operator=( const QgsFeatureIterator &other );
 
     bool nextFeature( QgsFeature &f );
+
+    /**
+     * Fetches up to \a maxFeatures features into \a batch, replacing its previous content.
+     * The columns of the batch must have been set up for the fields of the iterated source.
+     * \returns number of fetched features, 0 when there are no more features
+     * \since QGIS 3.0
+     */
+    int nextBatch( QgsFeatureBatch &batch, int maxFeatures );
+
     bool rewind();
     bool close();
 
@@ -330,6 +364,11 @@ inline bool QgsFeatureIterator::nextFeature( QgsFeature &f )
   return mIter ? mIter->nextFeature( f ) : false;
 }
 
+inline int QgsFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  return mIter ? mIter->nextBatch( batch, maxFeatures ) : 0;
+}
+
 inline bool QgsFeatureIterator::rewind()
 {
   if ( mIter )
@@ -24,6 +24,7 @@
 #include "pal.h"
 #include "problem.h"
 #include "qgsrendercontext.h"
+#include "qgslabelplacementcache.h"
 #include "qgsmaplayer.h"
 
 
@@ -33,6 +34,11 @@ static bool _palIsCanceled( void *ctx )
   return ( reinterpret_cast< QgsRenderContext * >( ctx ) )->renderingStopped();
 }
 
+static bool _palIsReusedCandidate( pal::LabelPosition *candidate, void *ctx )
+{
+  return ( reinterpret_cast< QgsLabelPlacementCache * >( ctx ) )->isCachedPlacement( candidate );
+}
+
 /** \ingroup core
  * \class QgsLabelSorter
  * Helper class for sorting labels into correct draw order
@@ -219,6 +225,7 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
   p.setPolyP( candPolygon );
 
   p.setShowPartial( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
+  p.setSolveInParallel( settings.testFlag( QgsLabelingEngineSettings::SolveInParallel ) );
 
 
   // for each provider: get labels and register them in PAL
@@ -251,6 +258,13 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
 
   p.registerCancelationCallback( &_palIsCanceled, reinterpret_cast< void * >( &context ) );
 
+  QgsLabelPlacementCache *placementCache = settings.testFlag( QgsLabelingEngineSettings::ReusePlacements ) ? mPlacementCache : nullptr;
+  if ( placementCache )
+  {
+    placementCache->prepare( mMapSettings );
+    p.registerReuseCallback( &_palIsReusedCandidate, reinterpret_cast< void * >( placementCache ) );
+  }
+
   QTime t;
   t.start();
 
@@ -318,6 +332,10 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
     delete labels;
     return;
   }
+
+  if ( placementCache )
+    placementCache->storeSolution( *labels );
+
   painter->setRenderHint( QPainter::Antialiasing );
 
   // sort labels
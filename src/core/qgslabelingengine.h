@@ -26,6 +26,7 @@
 
 
 class QgsLabelingEngine;
+class QgsLabelPlacementCache;
 
 
 /** \ingroup core
@@ -196,6 +197,21 @@ class CORE_EXPORT QgsLabelingEngine
     //! Remove provider if the provider's initialization failed. Provider instance is deleted.
     void removeProvider( QgsAbstractLabelProvider *provider );
 
+    /**
+     * Sets the \a cache of label placements used when the QgsLabelingEngineSettings::ReusePlacements
+     * flag is set. Ownership is not transferred.
+     * \see placementCache()
+     * \since QGIS 3.0
+     */
+    void setPlacementCache( QgsLabelPlacementCache *cache ) { mPlacementCache = cache; }
+
+    /**
+     * Returns the cache of label placements, or nullptr if not set.
+     * \see setPlacementCache()
+     * \since QGIS 3.0
+     */
+    QgsLabelPlacementCache *placementCache() const { return mPlacementCache; }
+
     //! compute the labeling with given map settings and providers
     void run( QgsRenderContext &context );
 
@@ -219,6 +235,9 @@ class CORE_EXPORT QgsLabelingEngine
     //! Resulting labeling layout
     std::unique_ptr< QgsLabelingResults > mResults;
 
+    //! Cache of label placements from previous redraws (not owned)
+    QgsLabelPlacementCache *mPlacementCache = nullptr;
+
 };
 
 
@@ -22,6 +22,8 @@ class CORE_EXPORT QgsLabelingEngineSettings
       RenderOutlineLabels   = 1 << 3,  //!< Whether to render labels as text or outlines
       DrawLabelRectOnly     = 1 << 4,  //!< Whether to only draw the label rect and not the actual label text (used for unit tests)
       DrawCandidates        = 1 << 5,  //!< Whether to draw rectangles of generated candidates (good for debugging)
+      ReusePlacements       = 1 << 6,  //!< Whether to start from label placements of the previous redraw at the same scale (keeps labels stable while panning and speeds up solving). Added in QGIS 3.0
+      SolveInParallel       = 1 << 7,  //!< Whether to split the placement problem in groups of labels which do not conflict with each other and solve them concurrently. Added in QGIS 3.0
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
@@ -0,0 +1,115 @@
+/***************************************************************************
+  qgslabelplacementcache.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgslabelplacementcache.h"
+
+#include "qgslabelfeature.h"
+#include "qgslabelingengine.h"
+#include "qgsmapsettings.h"
+#include "feature.h"
+#include "labelposition.h"
+
+void QgsLabelPlacementCache::prepare( const QgsMapSettings &settings )
+{
+  QMutexLocker locker( &mMutex );
+
+  if ( qgsDoubleNear( settings.scale(), mScale ) &&
+       qgsDoubleNear( settings.rotation(), mRotation ) &&
+       qgsDoubleNear( settings.outputDpi(), mDpi ) )
+    return;
+
+  mPlacements.clear();
+  mScale = settings.scale();
+  mRotation = settings.rotation();
+  mDpi = settings.outputDpi();
+  // candidates are generated from the same geometries, so matching placements differ only by rounding errors
+  mTolerance = settings.mapUnitsPerPixel() * 0.01;
+}
+
+bool QgsLabelPlacementCache::isCachedPlacement( pal::LabelPosition *candidate ) const
+{
+  QgsLabelFeature *lf = candidate->getFeaturePart()->feature();
+  if ( !lf || !lf->provider() )
+    return false;
+
+  QMutexLocker locker( &mMutex );
+
+  QHash< QString, QHash< QgsFeatureId, QList< Placement > > >::const_iterator providerIt = mPlacements.constFind( providerKey( candidate ) );
+  if ( providerIt == mPlacements.constEnd() )
+    return false;
+
+  QHash< QgsFeatureId, QList< Placement > >::const_iterator featureIt = providerIt->constFind( lf->id() );
+  if ( featureIt == providerIt->constEnd() )
+    return false;
+
+  Q_FOREACH ( const Placement &placement, featureIt.value() )
+  {
+    if ( qgsDoubleNear( placement.x, candidate->getX(), mTolerance ) &&
+         qgsDoubleNear( placement.y, candidate->getY(), mTolerance ) &&
+         qgsDoubleNear( placement.alpha, candidate->getAlpha() ) &&
+         qgsDoubleNear( placement.width, candidate->getWidth(), mTolerance ) &&
+         qgsDoubleNear( placement.height, candidate->getHeight(), mTolerance ) )
+      return true;
+  }
+  return false;
+}
+
+void QgsLabelPlacementCache::storeSolution( const QList<pal::LabelPosition *> &labels )
+{
+  QHash< QString, QHash< QgsFeatureId, QList< Placement > > > placements;
+  Q_FOREACH ( pal::LabelPosition *label, labels )
+  {
+    QgsLabelFeature *lf = label->getFeaturePart()->feature();
+    if ( !lf || !lf->provider() )
+      continue;
+
+    Placement placement;
+    placement.x = label->getX();
+    placement.y = label->getY();
+    placement.alpha = label->getAlpha();
+    placement.width = label->getWidth();
+    placement.height = label->getHeight();
+    placements[ providerKey( label )][ lf->id()] << placement;
+  }
+
+  QMutexLocker locker( &mMutex );
+  mPlacements = placements;
+}
+
+void QgsLabelPlacementCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mPlacements.clear();
+}
+
+void QgsLabelPlacementCache::clearLayer( const QString &layerId )
+{
+  QMutexLocker locker( &mMutex );
+
+  const QString prefix = layerId + '|';
+  QHash< QString, QHash< QgsFeatureId, QList< Placement > > >::iterator it = mPlacements.begin();
+  while ( it != mPlacements.end() )
+  {
+    if ( it.key().startsWith( prefix ) )
+      it = mPlacements.erase( it );
+    else
+      ++it;
+  }
+}
+
+QString QgsLabelPlacementCache::providerKey( pal::LabelPosition *label )
+{
+  QgsAbstractLabelProvider *provider = label->getFeaturePart()->feature()->provider();
+  return provider->layerId() + '|' + provider->providerId();
+}
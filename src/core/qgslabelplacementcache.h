@@ -0,0 +1,106 @@
+/***************************************************************************
+  qgslabelplacementcache.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSLABELPLACEMENTCACHE_H
+#define QGSLABELPLACEMENTCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeature.h"
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+class QgsMapSettings;
+
+namespace pal
+{
+  class LabelPosition;
+}
+
+/** \ingroup core
+ * \brief Keeps label placements of a labeling solution so that they can be reused
+ * by the labeling engine when the map is redrawn.
+ *
+ * Placements are stored in map units, so they stay valid when the map is panned, but
+ * they are dropped whenever the scale, rotation or output DPI of the map changes.
+ * The labeling engine uses the cached placements as the initial solution and only
+ * re-solves labels which conflict with labels that could not be reused (typically the
+ * labels of features in the area newly exposed by panning).
+ *
+ * The class is thread-safe (multiple labeling engines can access the same instance safely).
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsLabelPlacementCache
+{
+  public:
+
+    //! Constructor for QgsLabelPlacementCache
+    QgsLabelPlacementCache() = default;
+
+    /**
+     * Prepares the cache for labeling a map with the specified \a settings. Cached placements
+     * are cleared if they were computed for a different scale, rotation or output DPI.
+     */
+    void prepare( const QgsMapSettings &settings );
+
+    /**
+     * Returns true if the \a candidate matches the placement of the same label
+     * in the last stored solution.
+     */
+    bool isCachedPlacement( pal::LabelPosition *candidate ) const;
+
+    /**
+     * Replaces the cached placements with the \a labels of a new labeling solution.
+     */
+    void storeSolution( const QList< pal::LabelPosition * > &labels );
+
+    //! Removes all cached placements
+    void clear();
+
+    //! Removes cached placements of labels from the layer with matching \a layerId
+    void clearLayer( const QString &layerId );
+
+  private:
+
+    //! Placement of a single label part in map units
+    struct Placement
+    {
+      double x;
+      double y;
+      double alpha;
+      double width;
+      double height;
+    };
+
+    //! Returns the key identifying the label provider (and its layer) of a label
+    static QString providerKey( pal::LabelPosition *label );
+
+    mutable QMutex mMutex;
+
+    double mScale = 0;
+    double mRotation = 0;
+    double mDpi = 0;
+    //! Maximum difference (in map units) between coordinates of matching placements
+    double mTolerance = 0;
+
+    //! Map of provider key to placements of the labels of the provider's features
+    QHash< QString, QHash< QgsFeatureId, QList< Placement > > > mPlacements;
+};
+
+#endif // QGSLABELPLACEMENTCACHE_H
@@ -17,16 +17,56 @@
 
 #include "qgsmaplayer.h"
 #include "qgsmaplayerlistutils.h"
+#include "qgsmapsettings.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+///@cond PRIVATE
+
+// Integer division rounding towards negative infinity, for tile indices of negative pixel positions
+static qint64 floorDiv( qint64 a, qint64 b )
+{
+  return a >= 0 ? a / b : -( ( -a + b - 1 ) / b );
+}
+
+// Copies the pixels of sourceRect from source to the position destPoint of dest. Both images have the same format.
+static void copyPixels( const QImage &source, const QRect &sourceRect, QImage &dest, QPoint destPoint )
+{
+  const int bytesPerPixel = source.depth() / 8;
+  for ( int row = 0; row < sourceRect.height(); ++row )
+  {
+    memcpy( dest.scanLine( destPoint.y() + row ) + destPoint.x() * bytesPerPixel,
+            source.constScanLine( sourceRect.y() + row ) + sourceRect.x() * bytesPerPixel,
+            sourceRect.width() * bytesPerPixel );
+  }
+}
+
+///@endcond
 
 QgsMapRendererCache::QgsMapRendererCache()
 {
   clear();
 }
 
+QgsMapRendererCache::~QgsMapRendererCache()
+{
+  // remove tiles written to disk
+  QMutexLocker lock( &mMutex );
+  clearTilesInternal();
+}
+
 void QgsMapRendererCache::clear()
 {
   QMutexLocker lock( &mMutex );
+  clearTilesInternal();
   clearInternal();
+  mLabelPlacementCache.clear();
 }
 
 void QgsMapRendererCache::clearInternal()
@@ -34,17 +74,22 @@ void QgsMapRendererCache::clearInternal()
   mExtent.setMinimal();
   mScale = 0;
 
-  // make sure we are disconnected from all layers
-  Q_FOREACH ( const QgsWeakMapLayerPointer &layer, mConnectedLayers )
+  // make sure we are disconnected from all layers which are not needed by tiles anymore
+  mCachedImages.clear();
+  dropUnusedConnections();
+}
+
+void QgsMapRendererCache::connectLayers( const QList<QgsMapLayer *> &layers )
+{
+  Q_FOREACH ( QgsMapLayer *layer, layers )
   {
-    if ( layer.data() )
+    if ( layer && !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
     {
-      disconnect( layer.data(), &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-      disconnect( layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
+      connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
+      connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
+      mConnectedLayers << layer;
     }
   }
-  mCachedImages.clear();
-  mConnectedLayers.clear();
 }
 
 void QgsMapRendererCache::dropUnusedConnections()
@@ -75,6 +120,15 @@ QSet<QgsWeakMapLayerPointer > QgsMapRendererCache::dependentLayers() const
         result << l;
     }
   }
+  QMap<QString, QgsWeakMapLayerPointerList>::const_iterator tileIt = mTileDependentLayers.constBegin();
+  for ( ; tileIt != mTileDependentLayers.constEnd(); ++tileIt )
+  {
+    Q_FOREACH ( const QgsWeakMapLayerPointer &l, tileIt.value() )
+    {
+      if ( l.data() )
+        result << l;
+    }
+  }
   return result;
 }
 
@@ -107,16 +161,9 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
   Q_FOREACH ( QgsMapLayer *layer, dependentLayers )
   {
     if ( layer )
-    {
       params.dependentLayers << layer;
-      if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
-      {
-        connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-        connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
-        mConnectedLayers << layer;
-      }
-    }
   }
+  connectLayers( dependentLayers );
 
   mCachedImages[cacheKey] = params;
 }
@@ -147,6 +194,8 @@ void QgsMapRendererCache::layerRequestedRepaint()
   if ( !layer )
     return;
 
+  mLabelPlacementCache.clearLayer( layer->id() );
+
   QMutexLocker lock( &mMutex );
 
   // check through all cached images to clear any which depend on this layer
@@ -161,6 +210,28 @@ void QgsMapRendererCache::layerRequestedRepaint()
 
     it = mCachedImages.erase( it );
   }
+
+  // and all tiles
+  QMap<QString, QgsWeakMapLayerPointerList>::iterator depIt = mTileDependentLayers.begin();
+  for ( ; depIt != mTileDependentLayers.end(); )
+  {
+    if ( !depIt.value().contains( layer ) )
+    {
+      ++depIt;
+      continue;
+    }
+
+    const QString cacheKey = depIt.key();
+    QHash<QString, CachedTile>::iterator tileIt = mTiles.begin();
+    while ( tileIt != mTiles.end() )
+    {
+      if ( tileIt.value().cacheKey == cacheKey )
+        tileIt = removeTile( tileIt );
+      else
+        ++tileIt;
+    }
+    depIt = mTileDependentLayers.erase( depIt );
+  }
   dropUnusedConnections();
 }
 
@@ -171,3 +242,322 @@ void QgsMapRendererCache::clearCacheImage( const QString &cacheKey )
   mCachedImages.remove( cacheKey );
   dropUnusedConnections();
 }
+
+void QgsMapRendererCache::setTileCacheEnabled( bool enabled )
+{
+  QMutexLocker lock( &mMutex );
+  mTileCacheEnabled = enabled;
+  if ( !enabled )
+  {
+    clearTilesInternal();
+    mTileGrid.clear();
+    dropUnusedConnections();
+  }
+}
+
+bool QgsMapRendererCache::isTileCacheEnabled() const
+{
+  QMutexLocker lock( &mMutex );
+  return mTileCacheEnabled;
+}
+
+void QgsMapRendererCache::setTileMemoryBudget( qint64 bytes )
+{
+  QMutexLocker lock( &mMutex );
+  mTileMemoryBudget = bytes;
+  enforceTileBudgets();
+}
+
+qint64 QgsMapRendererCache::tileMemoryBudget() const
+{
+  QMutexLocker lock( &mMutex );
+  return mTileMemoryBudget;
+}
+
+void QgsMapRendererCache::setTileSpillDirectory( const QString &directory, qint64 diskBudget )
+{
+  QMutexLocker lock( &mMutex );
+  mTileSpillDirectory = directory;
+  mTileDiskBudget = directory.isEmpty() ? 0 : diskBudget;
+  enforceTileBudgets();
+}
+
+QString QgsMapRendererCache::tileSpillDirectory() const
+{
+  QMutexLocker lock( &mMutex );
+  return mTileSpillDirectory;
+}
+
+qint64 QgsMapRendererCache::tileMemoryUsage() const
+{
+  QMutexLocker lock( &mMutex );
+  return mTileMemoryUsage;
+}
+
+bool QgsMapRendererCache::initTiles( const QgsMapSettings &settings )
+{
+  QMutexLocker lock( &mMutex );
+
+  mTileGrid.clear();
+  if ( !mTileCacheEnabled || !qgsDoubleNear( settings.rotation(), 0.0 ) )
+    return false;
+
+  const double mapUnitsPerPixel = settings.mapUnitsPerPixel();
+  const QgsRectangle extent = settings.visibleExtent();
+  const double x = extent.xMinimum() / mapUnitsPerPixel;
+  const double y = -extent.yMaximum() / mapUnitsPerPixel;
+  if ( mapUnitsPerPixel <= 0 || !std::isfinite( x ) || !std::isfinite( y ) || settings.outputImageFormat() == QImage::Format_Invalid )
+    return false;
+
+  // The grid of a scale is offset by the sub-pixel position of the extent, so that all extents
+  // reached by panning the map by whole pixels share the same grid
+  const int phaseX = static_cast< int >( std::floor( ( x - std::floor( x ) ) * 100 + 0.5 ) ) % 100;
+  const int phaseY = static_cast< int >( std::floor( ( y - std::floor( y ) ) * 100 + 0.5 ) ) % 100;
+  mTileViewX = static_cast< qint64 >( std::floor( x - phaseX / 100.0 + 0.5 ) );
+  mTileViewY = static_cast< qint64 >( std::floor( y - phaseY / 100.0 + 0.5 ) );
+  mTileViewSize = settings.outputSize();
+  mTileImageFormat = settings.outputImageFormat();
+
+  // everything else which changes the rendered images is part of the grid
+  mTileGrid = QStringLiteral( "%1:%2:%3:%4:%5:%6:%7" ).arg( QString::number( mapUnitsPerPixel, 'g', 12 ) )
+              .arg( phaseX ).arg( phaseY )
+              .arg( settings.outputDpi() )
+              .arg( static_cast< int >( settings.outputImageFormat() ) )
+              .arg( static_cast< int >( settings.flags() ) )
+              .arg( settings.destinationCrs().toWkt() );
+  return true;
+}
+
+QString QgsMapRendererCache::tileKey( const QString &cacheKey, qint64 column, qint64 row ) const
+{
+  return QStringLiteral( "%1|%2|%3|%4" ).arg( cacheKey, mTileGrid ).arg( column ).arg( row );
+}
+
+QRect QgsMapRendererCache::viewRectInTile( qint64 column, qint64 row ) const
+{
+  const QRect view( static_cast< int >( mTileViewX - column * TILE_SIZE ), static_cast< int >( mTileViewY - row * TILE_SIZE ),
+                    mTileViewSize.width(), mTileViewSize.height() );
+  return view.intersected( QRect( 0, 0, TILE_SIZE, TILE_SIZE ) );
+}
+
+void QgsMapRendererCache::setCacheTiles( const QString &cacheKey, const QImage &image, const QList<QgsMapLayer *> &dependentLayers, int margin )
+{
+  QMutexLocker lock( &mMutex );
+
+  if ( mTileGrid.isEmpty() || image.size() != mTileViewSize || image.format() != mTileImageFormat || image.depth() % 8 != 0 || margin < 0 )
+    return;
+
+  // the part of the image stored in tiles, in grid pixels
+  const qint64 x0 = mTileViewX + margin;
+  const qint64 y0 = mTileViewY + margin;
+  const qint64 x1 = mTileViewX + mTileViewSize.width() - margin;
+  const qint64 y1 = mTileViewY + mTileViewSize.height() - margin;
+  if ( x1 <= x0 || y1 <= y0 )
+    return;
+
+  for ( qint64 row = floorDiv( y0, TILE_SIZE ); row <= floorDiv( y1 - 1, TILE_SIZE ); ++row )
+  {
+    for ( qint64 column = floorDiv( x0, TILE_SIZE ); column <= floorDiv( x1 - 1, TILE_SIZE ); ++column )
+    {
+      const QRect rect = QRect( static_cast< int >( x0 - column * TILE_SIZE ), static_cast< int >( y0 - row * TILE_SIZE ),
+                                static_cast< int >( x1 - x0 ), static_cast< int >( y1 - y0 ) ).intersected( QRect( 0, 0, TILE_SIZE, TILE_SIZE ) );
+
+      CachedTile &tile = mTiles[ tileKey( cacheKey, column, row )];
+      if ( tile.image.isNull() && !loadTile( tile ) )
+      {
+        tile.cacheKey = cacheKey;
+        tile.image = QImage( TILE_SIZE, TILE_SIZE, image.format() );
+        tile.image.fill( Qt::transparent );
+        tile.coverage = QRegion();
+        tile.bytes = tile.image.byteCount();
+        mTileMemoryUsage += tile.bytes;
+      }
+
+      copyPixels( image, rect.translated( static_cast< int >( column * TILE_SIZE - mTileViewX ), static_cast< int >( row * TILE_SIZE - mTileViewY ) ),
+                  tile.image, rect.topLeft() );
+      tile.coverage += rect;
+      tile.lastUsed = ++mTileUseCounter;
+    }
+  }
+
+  QgsWeakMapLayerPointerList &layers = mTileDependentLayers[cacheKey];
+  Q_FOREACH ( QgsMapLayer *layer, dependentLayers )
+  {
+    if ( layer && !layers.contains( layer ) )
+      layers << layer;
+  }
+  connectLayers( dependentLayers );
+
+  enforceTileBudgets();
+}
+
+bool QgsMapRendererCache::hasCacheTiles( const QString &cacheKey ) const
+{
+  QMutexLocker lock( &mMutex );
+
+  if ( mTileGrid.isEmpty() || mTileViewSize.isEmpty() )
+    return false;
+
+  for ( qint64 row = floorDiv( mTileViewY, TILE_SIZE ); row <= floorDiv( mTileViewY + mTileViewSize.height() - 1, TILE_SIZE ); ++row )
+  {
+    for ( qint64 column = floorDiv( mTileViewX, TILE_SIZE ); column <= floorDiv( mTileViewX + mTileViewSize.width() - 1, TILE_SIZE ); ++column )
+    {
+      QHash<QString, CachedTile>::const_iterator it = mTiles.constFind( tileKey( cacheKey, column, row ) );
+      if ( it == mTiles.constEnd() || !QRegion( viewRectInTile( column, row ) ).subtracted( it.value().coverage ).isEmpty() )
+        return false;
+    }
+  }
+  return true;
+}
+
+QImage QgsMapRendererCache::tiledCacheImage( const QString &cacheKey )
+{
+  QMutexLocker lock( &mMutex );
+
+  if ( mTileGrid.isEmpty() || mTileViewSize.isEmpty() )
+    return QImage();
+
+  QImage image( mTileViewSize, mTileImageFormat );
+  if ( image.isNull() )
+    return QImage();
+
+  for ( qint64 row = floorDiv( mTileViewY, TILE_SIZE ); row <= floorDiv( mTileViewY + mTileViewSize.height() - 1, TILE_SIZE ); ++row )
+  {
+    for ( qint64 column = floorDiv( mTileViewX, TILE_SIZE ); column <= floorDiv( mTileViewX + mTileViewSize.width() - 1, TILE_SIZE ); ++column )
+    {
+      QHash<QString, CachedTile>::iterator it = mTiles.find( tileKey( cacheKey, column, row ) );
+      const QRect rect = viewRectInTile( column, row );
+      if ( it == mTiles.end() || !QRegion( rect ).subtracted( it.value().coverage ).isEmpty() )
+        return QImage();
+
+      CachedTile &tile = it.value();
+      if ( !loadTile( tile ) || tile.image.format() != mTileImageFormat )
+      {
+        removeTile( it );
+        return QImage();
+      }
+
+      copyPixels( tile.image, rect, image, rect.topLeft() + QPoint( static_cast< int >( column * TILE_SIZE - mTileViewX ), static_cast< int >( row * TILE_SIZE - mTileViewY ) ) );
+      tile.lastUsed = ++mTileUseCounter;
+    }
+  }
+
+  enforceTileBudgets();
+  return image;
+}
+
+void QgsMapRendererCache::clearTilesInternal()
+{
+  QHash<QString, CachedTile>::iterator it = mTiles.begin();
+  while ( it != mTiles.end() )
+    it = removeTile( it );
+  mTileDependentLayers.clear();
+}
+
+QHash<QString, QgsMapRendererCache::CachedTile>::iterator QgsMapRendererCache::removeTile( QHash<QString, CachedTile>::iterator it )
+{
+  CachedTile &tile = it.value();
+  if ( !tile.image.isNull() )
+  {
+    mTileMemoryUsage -= tile.bytes;
+  }
+  else if ( !tile.spillFile.isEmpty() )
+  {
+    QFile::remove( tile.spillFile );
+    mTileDiskUsage -= tile.bytes;
+  }
+  return mTiles.erase( it );
+}
+
+bool QgsMapRendererCache::loadTile( CachedTile &tile )
+{
+  if ( !tile.image.isNull() )
+    return true;
+  if ( tile.spillFile.isEmpty() )
+    return false;
+
+  QFile file( tile.spillFile );
+  bool ok = false;
+  if ( file.open( QIODevice::ReadOnly ) )
+  {
+    qint32 header[3];
+    if ( file.read( reinterpret_cast< char * >( header ), sizeof( header ) ) == sizeof( header ) )
+    {
+      QImage image( header[0], header[1], static_cast< QImage::Format >( header[2] ) );
+      if ( !image.isNull() && file.read( reinterpret_cast< char * >( image.bits() ), image.byteCount() ) == image.byteCount() )
+      {
+        tile.image = image;
+        ok = true;
+      }
+    }
+    file.close();
+  }
+
+  file.remove();
+  tile.spillFile.clear();
+  mTileDiskUsage -= tile.bytes;
+  if ( ok )
+    mTileMemoryUsage += tile.bytes;
+  return ok;
+}
+
+void QgsMapRendererCache::enforceTileBudgets()
+{
+  if ( mTileMemoryUsage <= mTileMemoryBudget && mTileDiskUsage <= mTileDiskBudget )
+    return;
+
+  // least recently used tiles first
+  QVector< QPair< qint64, QString > > order;
+  order.reserve( mTiles.count() );
+  for ( QHash<QString, CachedTile>::const_iterator it = mTiles.constBegin(); it != mTiles.constEnd(); ++it )
+    order << qMakePair( it.value().lastUsed, it.key() );
+  std::sort( order.begin(), order.end() );
+
+  bool canSpill = !mTileSpillDirectory.isEmpty() && QDir().mkpath( mTileSpillDirectory );
+  for ( int i = 0; i < order.count() && mTileMemoryUsage > mTileMemoryBudget; ++i )
+  {
+    QHash<QString, CachedTile>::iterator it = mTiles.find( order.at( i ).second );
+    if ( it == mTiles.end() || it.value().image.isNull() )
+      continue;
+
+    CachedTile &tile = it.value();
+
+    bool spilled = false;
+    if ( canSpill )
+    {
+      QTemporaryFile file( mTileSpillDirectory + QStringLiteral( "/tileXXXXXX.tile" ) );
+      file.setAutoRemove( false );
+      if ( file.open() )
+      {
+        const qint32 header[3] = { tile.image.width(), tile.image.height(), static_cast< qint32 >( tile.image.format() ) };
+        spilled = file.write( reinterpret_cast< const char * >( header ), sizeof( header ) ) == sizeof( header )
+                  && file.write( reinterpret_cast< const char * >( tile.image.constBits() ), tile.image.byteCount() ) == tile.image.byteCount();
+        file.close();
+        if ( spilled )
+          tile.spillFile = file.fileName();
+        else
+          file.remove();
+      }
+      // stop trying for the remaining tiles, e.g. if the disk is full
+      canSpill = spilled;
+    }
+
+    if ( spilled )
+    {
+      tile.image = QImage();
+      mTileMemoryUsage -= tile.bytes;
+      mTileDiskUsage += tile.bytes;
+    }
+    else
+    {
+      removeTile( it );
+    }
+  }
+
+  for ( int i = 0; i < order.count() && mTileDiskUsage > mTileDiskBudget; ++i )
+  {
+    QHash<QString, CachedTile>::iterator it = mTiles.find( order.at( i ).second );
+    if ( it != mTiles.end() && !it.value().spillFile.isEmpty() )
+      removeTile( it );
+  }
+}
@@ -18,12 +18,16 @@
 
 #include "qgis_core.h"
 #include <QMap>
+#include <QHash>
 #include <QImage>
 #include <QMutex>
+#include <QRegion>
 
 #include "qgsrectangle.h"
 #include "qgsmaplayer.h"
+#include "qgslabelplacementcache.h"
 
+class QgsMapSettings;
 
 /** \ingroup core
  * This class is responsible for keeping cache of rendered images resulting from
@@ -34,6 +38,16 @@
  * If triggered, the cache removes the rendered image (and disconnects from the
  * layers).
  *
+ * Besides images, the cache keeps label placements of the last labeling solution, which
+ * survive changes of the map extent (but not of the scale) - see labelPlacementCache().
+ *
+ * Images are only reused for the exact same extent and scale. With the tile cache enabled
+ * (see setTileCacheEnabled()), rendered layer images are additionally cut into tiles of a fixed
+ * pixel grid per scale, which are kept when the extent changes. When the map is panned, or
+ * zoomed back to a previous scale, a layer image can then be composed from these tiles instead
+ * of rendering the layer again. Tiles are evicted least recently used first once their memory
+ * budget is exceeded, and can optionally be moved to disk instead of being dropped.
+ *
  * The class is thread-safe (multiple classes can access the same instance safely).
  *
  * \since QGIS 2.4
@@ -44,9 +58,10 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
   public:
 
     QgsMapRendererCache();
+    ~QgsMapRendererCache();
 
     /**
-     * Invalidates the cache contents, clearing all cached images.
+     * Invalidates the cache contents, clearing all cached images and label placements.
      * \see clearCacheImage()
      */
     void clear();
@@ -96,6 +111,109 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     void clearCacheImage( const QString &cacheKey );
 
+    /**
+     * Sets whether rendered layer images are also cached as tiles, which survive
+     * changes of the map extent and scale. The tile cache is disabled by default.
+     * \see isTileCacheEnabled()
+     * \since QGIS 3.0
+     */
+    void setTileCacheEnabled( bool enabled );
+
+    /**
+     * Returns true if rendered layer images are also cached as tiles.
+     * \see setTileCacheEnabled()
+     * \since QGIS 3.0
+     */
+    bool isTileCacheEnabled() const;
+
+    /**
+     * Sets the maximum memory used by cached tiles, in bytes. When it is exceeded,
+     * the least recently used tiles are moved to disk (if a spill directory is set)
+     * or dropped.
+     * \see tileMemoryBudget()
+     * \since QGIS 3.0
+     */
+    void setTileMemoryBudget( qint64 bytes );
+
+    /**
+     * Returns the maximum memory used by cached tiles, in bytes.
+     * \see setTileMemoryBudget()
+     * \since QGIS 3.0
+     */
+    qint64 tileMemoryBudget() const;
+
+    /**
+     * Sets a \a directory where tiles evicted from memory are written to, using at most
+     * \a diskBudget bytes. Tiles are read back from disk when they are needed again.
+     * An empty directory disables writing tiles to disk.
+     * \see tileSpillDirectory()
+     * \since QGIS 3.0
+     */
+    void setTileSpillDirectory( const QString &directory, qint64 diskBudget = 1024 * 1024 * 1024 );
+
+    /**
+     * Returns the directory where tiles evicted from memory are written to, or an empty
+     * string if they are dropped.
+     * \see setTileSpillDirectory()
+     * \since QGIS 3.0
+     */
+    QString tileSpillDirectory() const;
+
+    /**
+     * Sets up the tile grid for the map \a settings of a render. Tiles are only used for
+     * maps without rotation, and for extents which are aligned to the pixel grid of tiles
+     * rendered earlier at the same scale, e.g. after panning the map by whole pixels.
+     * \returns true if tiles can be stored and reused for these settings
+     * \see setCacheTiles()
+     * \see hasCacheTiles()
+     * \since QGIS 3.0
+     */
+    bool initTiles( const QgsMapSettings &settings );
+
+    /**
+     * Stores the parts of a rendered layer \a image covering the current map extent as tiles
+     * for the specified \a cacheKey, which usually matches the QgsMapLayer::id() which the image
+     * is a render of. The image must cover the extent of the settings passed to initTiles().
+     * Tiles are cleared if any of the \a dependentLayers triggers a repaint.
+     *
+     * A \a margin (in pixels) along the edges of the image is not stored. It must be at least
+     * the distance by which the symbols of features outside of the extent can be drawn into the image,
+     * as these features were not rendered.
+     * \see hasCacheTiles()
+     * \since QGIS 3.0
+     */
+    void setCacheTiles( const QString &cacheKey, const QImage &image, const QList< QgsMapLayer * > &dependentLayers = QList< QgsMapLayer * >(), int margin = 16 );
+
+    /**
+     * Returns true if the cached tiles for the specified \a cacheKey cover the whole current map extent.
+     * \see tiledCacheImage()
+     * \since QGIS 3.0
+     */
+    bool hasCacheTiles( const QString &cacheKey ) const;
+
+    /**
+     * Returns an image of the current map extent composed from the cached tiles for the
+     * specified \a cacheKey, or a null image if the tiles do not cover the whole extent.
+     * \see hasCacheTiles()
+     * \since QGIS 3.0
+     */
+    QImage tiledCacheImage( const QString &cacheKey );
+
+    /**
+     * Returns the memory used by cached tiles, in bytes.
+     * \since QGIS 3.0
+     */
+    qint64 tileMemoryUsage() const;
+
+    /**
+     * Returns the cache of label placements from previous redraws. Unlike cached images,
+     * label placements are kept when the map extent changes, and are only removed
+     * when the map scale changes or a labeled layer requests a repaint.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QgsLabelPlacementCache *labelPlacementCache() SIP_SKIP { return &mLabelPlacementCache; }
+
   private slots:
     //! Remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
@@ -108,9 +226,49 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
       QgsWeakMapLayerPointerList dependentLayers;
     };
 
+    //! A tile of a rendered layer image
+    struct CachedTile
+    {
+      QString cacheKey;
+      //! Tile image, null while the tile is stored on disk
+      QImage image;
+      //! Pixels of the tile which hold rendered content, in tile coordinates
+      QRegion coverage;
+      //! File holding the tile image if it was moved to disk
+      QString spillFile;
+      //! Size of the tile image in bytes
+      qint64 bytes = 0;
+      //! Value of the use counter when the tile was last used, for the LRU order
+      qint64 lastUsed = 0;
+    };
+
+    //! Size of tiles in pixels
+    static const int TILE_SIZE = 256;
+
     //! Invalidate cache contents (without locking)
     void clearInternal();
 
+    //! Connects to the repaint signals of \a layers which the cache is not connected to yet (without locking)
+    void connectLayers( const QList< QgsMapLayer * > &layers );
+
+    //! Removes all tiles (without locking)
+    void clearTilesInternal();
+
+    //! Removes the tile at \a it, deleting its file on disk (without locking)
+    QHash< QString, CachedTile >::iterator removeTile( QHash< QString, CachedTile >::iterator it );
+
+    //! Returns the key of a tile in the current grid (without locking)
+    QString tileKey( const QString &cacheKey, qint64 column, qint64 row ) const;
+
+    //! Returns the pixel rectangle of the current map extent in the tile grid, relative to the tile at \a column, \a row
+    QRect viewRectInTile( qint64 column, qint64 row ) const;
+
+    //! Makes sure the image of a tile is in memory, returns false if it can not be read (without locking)
+    bool loadTile( CachedTile &tile );
+
+    //! Moves tiles to disk or drops them until the memory and disk budgets are met (without locking)
+    void enforceTileBudgets();
+
     //! Disconnects from layers we no longer care about
     void dropUnusedConnections();
 
@@ -124,6 +282,29 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     QMap<QString, CacheParameters> mCachedImages;
     //! List of all layers on which this cache is currently connected
     QSet< QgsWeakMapLayerPointer > mConnectedLayers;
+
+    QgsLabelPlacementCache mLabelPlacementCache;
+
+    bool mTileCacheEnabled = false;
+    qint64 mTileMemoryBudget = 256 * 1024 * 1024;
+    QString mTileSpillDirectory;
+    qint64 mTileDiskBudget = 0;
+
+    //! Identifies the tile grid of the current render, empty if tiles can not be used
+    QString mTileGrid;
+    //! Position of the current map extent in the tile grid, in pixels
+    qint64 mTileViewX = 0;
+    qint64 mTileViewY = 0;
+    QSize mTileViewSize;
+    QImage::Format mTileImageFormat = QImage::Format_ARGB32_Premultiplied;
+
+    //! Map of tile key to tile
+    QHash< QString, CachedTile > mTiles;
+    //! Layers on which the tiles of each cache key depend
+    QMap< QString, QgsWeakMapLayerPointerList > mTileDependentLayers;
+    qint64 mTileMemoryUsage = 0;
+    qint64 mTileDiskUsage = 0;
+    qint64 mTileUseCounter = 0;
 };
 
 
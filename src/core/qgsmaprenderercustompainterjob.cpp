@@ -17,6 +17,7 @@
 
 #include "qgsfeedback.h"
 #include "qgslabelingengine.h"
+#include "qgsmaprenderercache.h"
 #include "qgslogger.h"
 #include "qgsproject.h"
 #include "qgsmaplayerrenderer.h"
@@ -76,6 +77,8 @@ void QgsMapRendererCustomPainterJob::start()
   {
     mLabelingEngineV2.reset( new QgsLabelingEngine() );
     mLabelingEngineV2->setMapSettings( mSettings );
+    if ( mCache )
+      mLabelingEngineV2->setPlacementCache( mCache->labelPlacementCache() );
   }
 
   bool canUseLabelCache = prepareLabelCache();
@@ -36,6 +36,12 @@
 #include "qgsmaplayerlistutils.h"
 #include "qgsvectorlayerlabeling.h"
 #include "qgssettings.h"
+#include "qgsrasterlayer.h"
+#include "qgsrasterrenderer.h"
+#include "qgsrenderer.h"
+#include "qgssymbol.h"
+#include "qgsmarkersymbollayer.h"
+#include "qgspainteffect.h"
 
 ///@cond PRIVATE
 
@@ -209,6 +215,105 @@ bool QgsMapRendererJob::reprojectToLayerExtent( const QgsMapLayer *ml, const Qgs
 
 
 
+///@cond PRIVATE
+
+//! Pixels along the edges of rendered images which are never stored in tiles, against antialiasing and resampling
+static const int MIN_CACHE_TILE_MARGIN = 2;
+
+// Returns how far (in pixels) the symbols of a symbol can be drawn from their feature,
+// or -1 if it can not be estimated
+static double maxSymbolBleed( QgsSymbol *symbol, const QgsRenderContext &context )
+{
+  double bleed = 0;
+  for ( int i = 0; i < symbol->symbolLayerCount(); ++i )
+  {
+    QgsSymbolLayer *layer = symbol->symbolLayer( i );
+
+    // other symbol layers may draw far from their feature (geometry generators, arrows...), or are
+    // aligned to the map image (pattern, SVG, raster and gradient fills)
+    const QString type = layer->layerType();
+    if ( type != QLatin1String( "SimpleLine" ) && type != QLatin1String( "MarkerLine" ) &&
+         type != QLatin1String( "SimpleFill" ) && type != QLatin1String( "CentroidFill" ) &&
+         type != QLatin1String( "SimpleMarker" ) && type != QLatin1String( "FilledMarker" ) &&
+         type != QLatin1String( "SvgMarker" ) && type != QLatin1String( "FontMarker" ) )
+      return -1;
+    if ( layer->dataDefinedProperties().hasActiveProperties() || ( layer->paintEffect() && layer->paintEffect()->enabled() ) )
+      return -1;
+
+    double layerBleed = layer->estimateMaxBleed( context );
+    if ( QgsMarkerSymbolLayer *marker = dynamic_cast< QgsMarkerSymbolLayer * >( layer ) )
+    {
+      // markers may be anchored by a corner, rotated, or higher than their size
+      double markerBleed = 2 * context.convertToPainterUnits( marker->size(), marker->sizeUnit(), marker->sizeMapUnitScale() )
+                           + context.convertToPainterUnits( std::fabs( marker->offset().x() ) + std::fabs( marker->offset().y() ), marker->offsetUnit(), marker->offsetMapUnitScale() );
+      if ( QgsSimpleMarkerSymbolLayer *simpleMarker = dynamic_cast< QgsSimpleMarkerSymbolLayer * >( layer ) )
+        markerBleed += context.convertToPainterUnits( simpleMarker->strokeWidth(), simpleMarker->strokeWidthUnit(), simpleMarker->strokeWidthMapUnitScale() );
+      else if ( QgsSvgMarkerSymbolLayer *svgMarker = dynamic_cast< QgsSvgMarkerSymbolLayer * >( layer ) )
+        markerBleed += context.convertToPainterUnits( svgMarker->strokeWidth(), svgMarker->strokeWidthUnit(), svgMarker->strokeWidthMapUnitScale() );
+      else if ( QgsFontMarkerSymbolLayer *fontMarker = dynamic_cast< QgsFontMarkerSymbolLayer * >( layer ) )
+        markerBleed += context.convertToPainterUnits( fontMarker->strokeWidth(), fontMarker->strokeWidthUnit(), fontMarker->strokeWidthMapUnitScale() );
+      layerBleed = std::max( layerBleed, markerBleed );
+    }
+
+    // markers along lines and at centroids
+    if ( QgsSymbol *subSymbol = layer->subSymbol() )
+    {
+      const double subSymbolBleed = maxSymbolBleed( subSymbol, context );
+      if ( subSymbolBleed < 0 )
+        return -1;
+      layerBleed += subSymbolBleed;
+    }
+    bleed = std::max( bleed, layerBleed );
+  }
+  return bleed;
+}
+
+// Returns the width (in pixels) of the edges of a rendered layer image which can not be stored in tiles,
+// as they may miss the symbols of features just outside of the extent. Returns -1 if the image of the
+// layer can not be composed from tiles rendered for other extents.
+static int cacheTileMargin( QgsMapLayer *ml, QgsRenderContext &context, const QgsMapSettings &settings )
+{
+  // the cached tiles do not depend on the style
+  if ( settings.layerStyleOverrides().contains( ml->id() ) )
+    return -1;
+
+  if ( QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml ) )
+  {
+    QgsFeatureRenderer *renderer = vl->renderer();
+    if ( !renderer || ( renderer->paintEffect() && renderer->paintEffect()->enabled() ) )
+      return -1;
+
+    // these renderers look at all features within the extent together, or draw outside of the features
+    const QString type = renderer->type();
+    if ( type == QLatin1String( "heatmapRenderer" ) || type == QLatin1String( "pointDisplacement" ) || type == QLatin1String( "pointCluster" ) ||
+         type == QLatin1String( "invertedPolygonRenderer" ) || type == QLatin1String( "25dRenderer" ) )
+      return -1;
+
+    double bleed = 0;
+    Q_FOREACH ( QgsSymbol *symbol, renderer->symbols( context ) )
+    {
+      const double symbolBleed = maxSymbolBleed( symbol, context );
+      if ( symbolBleed < 0 )
+        return -1;
+      bleed = std::max( bleed, symbolBleed );
+    }
+    // tiles are useless when they have to be cut that much
+    if ( !( bleed < 256 ) )
+      return -1;
+    return static_cast< int >( std::ceil( bleed ) ) + MIN_CACHE_TILE_MARGIN;
+  }
+  else if ( QgsRasterLayer *rl = qobject_cast<QgsRasterLayer *>( ml ) )
+  {
+    // contrast enhancement using the statistics of the current extent
+    if ( !rl->renderer() || rl->renderer()->minMaxOrigin().extent() == QgsRasterMinMaxOrigin::UpdatedCanvas )
+      return -1;
+    return MIN_CACHE_TILE_MARGIN;
+  }
+  return -1;
+}
+
+///@endcond
+
 LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEngine *labelingEngine2 )
 {
   LayerRenderJobs layerJobs;
@@ -222,6 +327,7 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
     bool cacheValid = mCache->init( mSettings.visibleExtent(), mSettings.scale() );
     Q_UNUSED( cacheValid );
     QgsDebugMsg( QString( "CACHE VALID: %1" ).arg( cacheValid ) );
+    mCache->initTiles( mSettings );
   }
 
   bool requiresLabelRedraw = !( mCache && mCache->hasCacheImage( LABEL_CACHE_ID ) );
@@ -261,6 +367,7 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
 
     // Force render of layers that are being edited
     // or if there's a labeling engine that needs the layer to register features
+    bool forceRender = false;
     if ( mCache && ml->type() == QgsMapLayer::VectorLayer )
     {
       QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
@@ -269,6 +376,7 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
       if ( vl->isEditable() || requiresLabeling )
       {
         mCache->clearCacheImage( ml->id() );
+        forceRender = true;
       }
     }
 
@@ -306,6 +414,22 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
       continue;
     }
 
+    // or compose the image from tiles rendered for other extents
+    if ( mCache && !forceRender && cacheTileMargin( ml, job.context, mSettings ) >= 0 && mCache->hasCacheTiles( ml->id() ) )
+    {
+      QImage tiledImage = mCache->tiledCacheImage( ml->id() );
+      if ( !tiledImage.isNull() )
+      {
+        mCache->setCacheImage( ml->id(), tiledImage, QList< QgsMapLayer * >() << ml );
+        job.cached = true;
+        job.imageInitialized = true;
+        job.img = new QImage( tiledImage );
+        job.renderer = nullptr;
+        job.context.setPainter( nullptr );
+        continue;
+      }
+    }
+
     // If we are drawing with an alternative blending mode then we need to render to a separate image
     // before compositing this on the map. This effectively flattens the layer and prevents
     // blending occurring between objects on the layer
@@ -396,10 +520,13 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs &jobs )
       delete job.context.painter();
       job.context.setPainter( nullptr );
 
-      if ( mCache && !job.cached && !job.context.renderingStopped() && job.layer )
+      if ( mCache && !job.cached && !job.tile && !job.context.renderingStopped() && job.layer )
       {
         QgsDebugMsg( "caching image for " + ( job.layer ? job.layer->id() : QString() ) );
         mCache->setCacheImage( job.layer->id(), *job.img, QList< QgsMapLayer * >() << job.layer );
+        const int tileMargin = cacheTileMargin( job.layer, job.context, mSettings );
+        if ( tileMargin >= 0 )
+          mCache->setCacheTiles( job.layer->id(), *job.img, QList< QgsMapLayer * >() << job.layer, tileMargin );
       }
 
       delete job.img;
@@ -459,7 +586,7 @@ QImage QgsMapRendererJob::composeImage( const QgsMapSettings &settings, const La
 
     Q_ASSERT( job.img );
 
-    painter.drawImage( 0, 0, *job.img );
+    painter.drawImage( job.imageOffset, *job.img );
   }
 
   // IMPORTANT - don't draw labelJob img before the label job is complete,
@@ -488,7 +615,7 @@ QImage QgsMapRendererJob::composeImage( const QgsMapSettings &settings, const La
 
     Q_ASSERT( job.img );
 
-    painter.drawImage( 0, 0, *job.img );
+    painter.drawImage( job.imageOffset, *job.img );
   }
 
   painter.end();
@@ -54,6 +54,14 @@ struct LayerRenderJob
   bool cached; // if true, img already contains cached image from previous rendering
   QgsWeakMapLayerPointer layer;
   int renderingTime; //!< Time it took to render the layer in ms (it is -1 if not rendered or still rendering)
+
+  /**
+   * True if the job renders a single spatial tile of the layer of the closest preceding non-tile job.
+   * Tile images are composed into the image of that job once all tiles are rendered.
+   */
+  bool tile = false;
+  //! Position of img within the map image (only set for tile jobs, otherwise img covers the whole map)
+  QPoint imageOffset;
 };
 
 typedef QList<LayerRenderJob> LayerRenderJobs;
@@ -17,15 +17,26 @@
 
 #include "qgsfeedback.h"
 #include "qgslabelingengine.h"
+#include "qgsmaprenderercache.h"
 #include "qgslogger.h"
 #include "qgsmaplayerrenderer.h"
 #include "qgsproject.h"
 #include "qgsmaplayer.h"
 #include "qgsmaplayerlistutils.h"
+#include "qgspainteffect.h"
+#include "qgspallabeling.h"
+#include "qgsrenderer.h"
+#include "qgsvectorlayer.h"
+#include "qgsexception.h"
 
 #include <QtConcurrentMap>
 #include <QtConcurrentRun>
 
+#include <cmath>
+
+// margin (in pixels) added around the extent of each tile, so that symbols of features just outside the tile are still drawn within it
+static const int TILE_EXTENT_MARGIN = 64;
+
 QgsMapRendererParallelJob::QgsMapRendererParallelJob( const QgsMapSettings &settings )
   : QgsMapRendererQImageJob( settings )
   , mStatus( Idle )
@@ -55,10 +66,13 @@ void QgsMapRendererParallelJob::start()
   {
     mLabelingEngineV2.reset( new QgsLabelingEngine() );
     mLabelingEngineV2->setMapSettings( mSettings );
+    if ( mCache )
+      mLabelingEngineV2->setPlacementCache( mCache->labelPlacementCache() );
   }
 
   bool canUseLabelCache = prepareLabelCache();
   mLayerJobs = prepareJobs( nullptr, mLabelingEngineV2.get() );
+  prepareTileJobs();
   mLabelJob = prepareLabelingJob( nullptr, mLabelingEngineV2.get(), canUseLabelCache );
 
   QgsDebugMsg( QString( "QThreadPool max thread count is %1" ).arg( QThreadPool::globalInstance()->maxThreadCount() ) );
@@ -195,6 +209,8 @@ void QgsMapRendererParallelJob::renderLayersFinished()
 {
   Q_ASSERT( mStatus == RenderingLayers );
 
+  composeTileJobs();
+
   // compose final image
   mFinalImage = composeImage( mSettings, mLayerJobs, mLabelJob );
 
@@ -234,6 +250,183 @@ void QgsMapRendererParallelJob::renderingFinished()
   emit finished();
 }
 
+void QgsMapRendererParallelJob::prepareTileJobs()
+{
+  if ( !mSettings.testFlag( QgsMapSettings::RenderLayerTiles ) )
+    return;
+
+  int renderJobCount = 0;
+  QList< int > tiledJobs;
+  for ( int i = 0; i < mLayerJobs.count(); ++i )
+  {
+    const LayerRenderJob &job = mLayerJobs.at( i );
+    if ( job.cached || !job.renderer )
+      continue;
+
+    renderJobCount++;
+    if ( canRenderInTiles( job ) )
+      tiledJobs << i;
+  }
+
+  if ( tiledJobs.isEmpty() )
+    return;
+
+  // split layers only if there are threads which would otherwise stay idle
+  int freeThreads = QThreadPool::globalInstance()->maxThreadCount() - ( renderJobCount - tiledJobs.count() );
+  int tilesPerLayer = freeThreads / tiledJobs.count();
+  if ( tilesPerLayer < 2 )
+    return;
+
+  int rows = std::max( 1, static_cast< int >( std::sqrt( static_cast< double >( tilesPerLayer ) ) ) );
+  int cols = tilesPerLayer / rows;
+
+  QgsDebugMsg( QString( "Splitting %1 layers into %2x%3 tiles" ).arg( tiledJobs.count() ).arg( cols ).arg( rows ) );
+
+  const QSize size = mSettings.outputSize();
+  const QgsMapToPixel &mtp = mSettings.mapToPixel();
+
+  // go from the last job, so that inserting tile jobs does not shift the position of remaining jobs
+  for ( int t = tiledJobs.count() - 1; t >= 0; --t )
+  {
+    int jobIndex = tiledJobs.at( t );
+    QgsMapLayer *ml = mLayerJobs.at( jobIndex ).layer.data();
+    QgsCoordinateTransform ct = mLayerJobs.at( jobIndex ).context.coordinateTransform();
+
+    // first find extents of all tiles, give up on the layer if any of them can't be transformed
+    QList< QRect > tileRects;
+    QList< QgsRectangle > tileExtents;
+    try
+    {
+      for ( int row = 0; row < rows; ++row )
+      {
+        for ( int col = 0; col < cols; ++col )
+        {
+          QRect rect( QPoint( size.width() * col / cols, size.height() * row / rows ),
+                      QPoint( size.width() * ( col + 1 ) / cols - 1, size.height() * ( row + 1 ) / rows - 1 ) );
+          if ( rect.isEmpty() )
+            continue;
+
+          QgsRectangle extent( mtp.toMapCoordinates( rect.left() - TILE_EXTENT_MARGIN, rect.top() - TILE_EXTENT_MARGIN ),
+                               mtp.toMapCoordinates( rect.right() + 1 + TILE_EXTENT_MARGIN, rect.bottom() + 1 + TILE_EXTENT_MARGIN ) );
+          // same reprojection as the extent of the whole layer, which handles the antimeridian and
+          // extents beyond the valid area of geographic CRSes
+          QgsRectangle r2;
+          if ( ct.isValid() )
+            reprojectToLayerExtent( ml, ct, extent, r2 );
+
+          // unlimited extents are used when the transform fails, the tiles would fetch every feature
+          static const QgsRectangle UNLIMITED_EXTENT( -DBL_MAX, -DBL_MAX, DBL_MAX, DBL_MAX );
+          if ( !extent.isFinite() || !r2.isFinite() || extent == UNLIMITED_EXTENT )
+            throw QgsCsException( QStringLiteral( "Invalid tile extent" ) );
+
+          tileRects << rect;
+          tileExtents << extent;
+        }
+      }
+    }
+    catch ( QgsCsException &cse )
+    {
+      Q_UNUSED( cse );
+      QgsDebugMsg( QString( "Cannot transform tile extents of layer %1, rendering it in one piece" ).arg( ml->id() ) );
+      continue;
+    }
+
+    for ( int i = 0; i < tileRects.count(); ++i )
+    {
+      const QRect &rect = tileRects.at( i );
+
+      // the list stores pointers to the jobs, so existing jobs (and contexts referenced by their renderers) do not move
+      mLayerJobs.insert( jobIndex + 1 + i, LayerRenderJob() );
+      LayerRenderJob &parent = mLayerJobs[ jobIndex ];
+      LayerRenderJob &job = mLayerJobs[ jobIndex + 1 + i ];
+      job.tile = true;
+      job.imageOffset = rect.topLeft();
+      job.cached = false;
+      job.blendMode = parent.blendMode;
+      job.opacity = parent.opacity;
+      job.layer = parent.layer;
+      job.renderingTime = -1;
+
+      job.context = QgsRenderContext::fromMapSettings( mSettings );
+      job.context.expressionContext().appendScope( QgsExpressionContextUtils::layerScope( ml ) );
+      job.context.setCoordinateTransform( ct );
+      job.context.setExtent( tileExtents.at( i ) );
+      if ( featureFilterProvider() )
+        job.context.setFeatureFilterProvider( featureFilterProvider() );
+
+      job.img = new QImage( rect.size(), mSettings.outputImageFormat() );
+      QPainter *painter = new QPainter( job.img );
+      painter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+      painter->translate( -rect.topLeft() );
+      job.context.setPainter( painter );
+
+      job.renderer = ml->createMapRenderer( job.context );
+    }
+
+    // the layer's own renderer is not needed anymore - its image only collects the tiles
+    LayerRenderJob &parent = mLayerJobs[ jobIndex ];
+    delete parent.renderer;
+    parent.renderer = nullptr;
+  }
+}
+
+bool QgsMapRendererParallelJob::canRenderInTiles( const LayerRenderJob &job ) const
+{
+  QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( job.layer.data() );
+  if ( !vl || !vl->renderer() || !job.img )
+    return false;
+
+  // tiles of a rotated map do not correspond to rectangular map extents
+  if ( !qgsDoubleNear( mSettings.rotation(), 0.0 ) )
+    return false;
+
+  if ( mSettings.layerStyleOverrides().contains( vl->id() ) )
+    return false;
+
+  // features would be registered for labeling by every tile they intersect
+  if ( job.context.labelingEngine() && ( QgsPalLabeling::staticWillUseLayer( vl ) || vl->diagramsEnabled() ) )
+    return false;
+
+  // effects like drop shadows would be cut at tile boundaries
+  if ( vl->renderer()->paintEffect() && vl->renderer()->paintEffect()->enabled() )
+    return false;
+
+  // only renderers which draw each feature independently of the others, so that
+  // the result does not depend on which features are fetched for a tile
+  static const QStringList TILED_RENDERERS = QStringList() << QStringLiteral( "singleSymbol" )
+      << QStringLiteral( "categorizedSymbol" )
+      << QStringLiteral( "graduatedSymbol" )
+      << QStringLiteral( "RuleRenderer" );
+  return TILED_RENDERERS.contains( vl->renderer()->type() );
+}
+
+void QgsMapRendererParallelJob::composeTileJobs()
+{
+  for ( int i = 0; i < mLayerJobs.count(); ++i )
+  {
+    LayerRenderJob &job = mLayerJobs[i];
+    if ( job.tile || i + 1 >= mLayerJobs.count() || !mLayerJobs.at( i + 1 ).tile )
+      continue;
+
+    // a canceled layer stays composed from its (partial) tiles
+    if ( job.context.renderingStopped() )
+      continue;
+
+    job.img->fill( 0 );
+    job.renderingTime = 0;
+    for ( int j = i + 1; j < mLayerJobs.count() && mLayerJobs.at( j ).tile; ++j )
+    {
+      LayerRenderJob &tileJob = mLayerJobs[j];
+      if ( tileJob.imageInitialized )
+        job.context.painter()->drawImage( tileJob.imageOffset, *tileJob.img );
+      // from now on the tile is composed through the layer's image
+      tileJob.imageInitialized = false;
+      job.renderingTime = std::max( job.renderingTime, tileJob.renderingTime );
+    }
+    job.imageInitialized = true;
+  }
+}
+
 void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
 {
   if ( job.context.renderingStopped() )
@@ -242,6 +435,9 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
   if ( job.cached )
     return;
 
+  if ( !job.renderer )
+    return; // the layer is rendered by its tile jobs
+
   if ( job.img )
   {
     job.img->fill( 0 );
@@ -26,6 +26,10 @@
  * The resulting map image can be retrieved with renderedImage() function.
  * It is safe to call that function while rendering is active to see preview of the map.
  *
+ * If the QgsMapSettings::RenderLayerTiles flag is set and there are fewer layers to render
+ * than threads available, suitable vector layers are additionally split into spatial tiles
+ * of the map which are rendered concurrently.
+ *
  * \since QGIS 2.4
  */
 class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
@@ -55,6 +59,18 @@ class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
 
   private:
 
+    /**
+     * Splits eligible vector layer jobs into tile jobs when the QgsMapSettings::RenderLayerTiles
+     * flag is set. Tile jobs are inserted directly after the job of their layer.
+     */
+    void prepareTileJobs();
+
+    //! Returns true if the vector layer of a job can be rendered as a set of independent tiles
+    bool canRenderInTiles( const LayerRenderJob &job ) const;
+
+    //! Composes rendered tile images into the images of their layer jobs
+    void composeTileJobs();
+
     //! \note not available in Python bindings
     static void renderLayerStatic( LayerRenderJob &job ) SIP_SKIP;
     //! \note not available in Python bindings
@@ -23,6 +23,7 @@
 
 #include "qgslogger.h"
 #include "qgspointxy.h"
+#include "qgssimd_p.h"
 
 
 QgsMapToPixel::QgsMapToPixel( double mapUnitsPerPixel,
@@ -261,6 +262,137 @@ void QgsMapToPixel::transformInPlace( float &x, float &y ) const
   y = my;
 }
 
+///@cond PRIVATE
+
+// The kernels below transform interleaved x/y coordinates. They evaluate the terms in
+// the same order as QTransform::map() does, so that the results are bit for bit identical.
+
+#ifndef QGIS_SIMD_SSE2
+// x' = m11 * x + dx, y' = m22 * y + dy
+static void scaleScalar( double *xy, int count, const QTransform &m )
+{
+  for ( int i = 0; i < count; ++i, xy += 2 )
+  {
+    xy[0] = m.m11() * xy[0] + m.dx();
+    xy[1] = m.m22() * xy[1] + m.dy();
+  }
+}
+
+// x' = m11 * x + m21 * y + dx, y' = m12 * x + m22 * y + dy
+static void affineScalar( double *xy, int count, const QTransform &m )
+{
+  for ( int i = 0; i < count; ++i, xy += 2 )
+  {
+    const double x = xy[0];
+    const double y = xy[1];
+    xy[0] = m.m11() * x + m.m21() * y + m.dx();
+    xy[1] = m.m12() * x + m.m22() * y + m.dy();
+  }
+}
+#else
+static void scaleSse2( double *xy, int count, const QTransform &m )
+{
+  const __m128d scale = _mm_set_pd( m.m22(), m.m11() );
+  const __m128d offset = _mm_set_pd( m.dy(), m.dx() );
+  for ( int i = 0; i < count; ++i, xy += 2 )
+  {
+    _mm_storeu_pd( xy, _mm_add_pd( _mm_mul_pd( _mm_loadu_pd( xy ), scale ), offset ) );
+  }
+}
+
+static void affineSse2( double *xy, int count, const QTransform &m )
+{
+  const __m128d mx = _mm_set_pd( m.m12(), m.m11() );
+  const __m128d my = _mm_set_pd( m.m22(), m.m21() );
+  const __m128d offset = _mm_set_pd( m.dy(), m.dx() );
+  for ( int i = 0; i < count; ++i, xy += 2 )
+  {
+    const __m128d p = _mm_loadu_pd( xy );
+    const __m128d x = _mm_unpacklo_pd( p, p );
+    const __m128d y = _mm_unpackhi_pd( p, p );
+    _mm_storeu_pd( xy, _mm_add_pd( _mm_add_pd( _mm_mul_pd( x, mx ), _mm_mul_pd( y, my ) ), offset ) );
+  }
+}
+#endif
+
+#ifdef QGIS_SIMD_AVX2_DISPATCH
+// two points per iteration, the odd point left is done with SSE2
+static QGIS_TARGET_AVX2 void scaleAvx2( double *xy, int count, const QTransform &m )
+{
+  const __m256d scale = _mm256_set_pd( m.m22(), m.m11(), m.m22(), m.m11() );
+  const __m256d offset = _mm256_set_pd( m.dy(), m.dx(), m.dy(), m.dx() );
+  int i = 0;
+  for ( ; i + 1 < count; i += 2, xy += 4 )
+  {
+    _mm256_storeu_pd( xy, _mm256_add_pd( _mm256_mul_pd( _mm256_loadu_pd( xy ), scale ), offset ) );
+  }
+  scaleSse2( xy, count - i, m );
+}
+
+static QGIS_TARGET_AVX2 void affineAvx2( double *xy, int count, const QTransform &m )
+{
+  const __m256d mx = _mm256_set_pd( m.m12(), m.m11(), m.m12(), m.m11() );
+  const __m256d my = _mm256_set_pd( m.m22(), m.m21(), m.m22(), m.m21() );
+  const __m256d offset = _mm256_set_pd( m.dy(), m.dx(), m.dy(), m.dx() );
+  int i = 0;
+  for ( ; i + 1 < count; i += 2, xy += 4 )
+  {
+    const __m256d p = _mm256_loadu_pd( xy );
+    const __m256d x = _mm256_unpacklo_pd( p, p );
+    const __m256d y = _mm256_unpackhi_pd( p, p );
+    _mm256_storeu_pd( xy, _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( x, mx ), _mm256_mul_pd( y, my ) ), offset ) );
+  }
+  affineSse2( xy, count - i, m );
+}
+#endif
+
+///@endcond
+
+void QgsMapToPixel::transformInPlace( QPolygonF &points ) const
+{
+  const int count = points.size();
+  if ( count == 0 )
+    return;
+
+  const QTransform::TransformationType type = mMatrix.type();
+  if ( type == QTransform::TxNone )
+    return;
+
+  if ( type == QTransform::TxProject )
+  {
+    // never set up by QgsMapToPixel, but handle it anyway
+    QPointF *ptr = points.data();
+    for ( int i = 0; i < count; ++i, ++ptr )
+      transformInPlace( ptr->rx(), ptr->ry() );
+    return;
+  }
+
+  double *xy = &points.data()->rx();
+  // QTransform::map() handles translations the same way as scales, as m11 and m22 are 1
+  const bool scaleOnly = type <= QTransform::TxScale;
+#if defined(QGIS_SIMD_AVX2_DISPATCH)
+  if ( qgsCpuHasAvx2() )
+  {
+    if ( scaleOnly )
+      scaleAvx2( xy, count, mMatrix );
+    else
+      affineAvx2( xy, count, mMatrix );
+    return;
+  }
+#endif
+#if defined(QGIS_SIMD_SSE2)
+  if ( scaleOnly )
+    scaleSse2( xy, count, mMatrix );
+  else
+    affineSse2( xy, count, mMatrix );
+#else
+  if ( scaleOnly )
+    scaleScalar( xy, count, mMatrix );
+  else
+    affineScalar( xy, count, mMatrix );
+#endif
+}
+
 QTransform QgsMapToPixel::transform() const
 {
   // NOTE: operations are done in the reverse order in which
@@ -20,6 +20,7 @@
 #include "qgis_core.h"
 #include "qgis_sip.h"
 #include <QTransform>
+#include <QPolygonF>
 #include <vector>
 #include "qgsunittypes.h"
 #include <cassert>
@@ -98,6 +99,16 @@ class CORE_EXPORT QgsMapToPixel
     //! \note not available in Python bindings
     void transformInPlace( float &x, float &y ) const SIP_SKIP;
 
+    /**
+     * Transforms all \a points from map coordinates to device coordinates in place.
+     * This is the fast way to transform many points, e.g. a whole linestring,
+     * as the points are transformed in batches using the SIMD instructions of the CPU.
+     * The results are identical to transforming each point with transformInPlace( double &, double & ).
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void transformInPlace( QPolygonF &points ) const SIP_SKIP;
+
 #ifndef SIP_RUN
 
     /**
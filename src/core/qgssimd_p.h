@@ -0,0 +1,54 @@
+/***************************************************************************
+  qgssimd_p.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSIMD_P_H
+#define QGSSIMD_P_H
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+// SSE2 is part of every x86-64 CPU, so the SSE2 kernels are selected at compile time.
+// Coordinates are read as pairs of doubles, which requires qreal to be double.
+#if ( defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 ) ) && !defined(QT_COORD_TYPE)
+#define QGIS_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 kernels are compiled for the AVX2 target only and selected at runtime, so that
+// the binaries still run on older CPUs. This needs the GCC/clang target attribute.
+#if defined(QGIS_SIMD_SSE2) && ( defined(__GNUC__) || defined(__clang__) ) && ( defined(__x86_64__) || defined(__i386__) )
+#define QGIS_SIMD_AVX2_DISPATCH
+#include <immintrin.h>
+
+#define QGIS_TARGET_AVX2 __attribute__((target("avx2")))
+
+// Returns true if the CPU running the code supports AVX2
+inline bool qgsCpuHasAvx2()
+{
+  static const bool sHasAvx2 = __builtin_cpu_supports( "avx2" );
+  return sHasAvx2;
+}
+#endif
+
+/// @endcond
+
+#endif // QGSSIMD_P_H
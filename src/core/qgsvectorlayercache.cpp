@@ -78,6 +78,16 @@ void QgsVectorLayerCache::setCacheGeometry( bool cacheGeometry )
   }
 }
 
+void QgsVectorLayerCache::setCompactGeometries( bool compact, QgsCompactGeometry::Precision precision )
+{
+  if ( compact == mCompactGeometries && ( !compact || precision == mCompactPrecision ) )
+    return;
+
+  mCompactGeometries = compact;
+  mCompactPrecision = precision;
+  invalidate();
+}
+
 void QgsVectorLayerCache::setCacheSubsetOfAttributes( const QgsAttributeList &attributes )
 {
   mCachedAttributes = attributes;
@@ -154,7 +164,7 @@ bool QgsVectorLayerCache::featureAtId( QgsFeatureId featureId, QgsFeature &featu
 
   if ( cachedFeature )
   {
-    feature = QgsFeature( *cachedFeature->feature() );
+    feature = cachedFeature->feature();
     featureFound = true;
   }
   else if ( mLayer->getFeatures( QgsFeatureRequest()
@@ -305,7 +315,7 @@ void QgsVectorLayerCache::geometryChanged( QgsFeatureId fid, const QgsGeometry &
 
   if ( cachedFeat )
   {
-    cachedFeat->mFeature->setGeometry( geom );
+    cachedFeat->setGeometry( geom );
   }
 }
 
@@ -25,6 +25,7 @@
 #include <QCache>
 
 #include "qgsvectorlayer.h"
+#include "qgscompactgeometry.h"
 
 class QgsCachedFeatureIterator;
 class QgsAbstractCacheIndex;
@@ -63,6 +64,8 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
           : mCache( vlCache )
         {
           mFeature = new QgsFeature( feat );
+          if ( vlCache->mCompactGeometries )
+            setGeometry( feat.geometry() );
         }
 
         ~QgsCachedFeature()
@@ -73,10 +76,28 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
           delete mFeature;
         }
 
-        inline const QgsFeature *feature() { return mFeature; }
+        //! Returns a copy of the cached feature, with its geometry restored from compact storage
+        inline QgsFeature feature() const
+        {
+          QgsFeature feature( *mFeature );
+          if ( !mGeometry.isNull() )
+            feature.setGeometry( mGeometry.toGeometry() );
+          return feature;
+        }
+
+        /**
+         * Sets the geometry of the cached feature. The geometry is kept in compact
+         * form if the cache stores compact geometries and the geometry type is supported.
+         */
+        void setGeometry( const QgsGeometry &geometry )
+        {
+          mGeometry = mCache->mCompactGeometries ? QgsCompactGeometry::fromGeometry( geometry, mCache->mCompactPrecision ) : QgsCompactGeometry();
+          mFeature->setGeometry( mGeometry.isNull() ? geometry : QgsGeometry() );
+        }
 
       private:
         QgsFeature *mFeature = nullptr;
+        QgsCompactGeometry mGeometry;
         QgsVectorLayerCache *mCache = nullptr;
 
         friend class QgsVectorLayerCache;
@@ -119,6 +140,27 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
      */
     bool cacheGeometry() const { return mCacheGeometry; }
 
+    /**
+     * Sets whether cached geometries are stored in compact form. Compact geometries keep all
+     * their coordinates in a single buffer, which uses considerably less memory for large
+     * caches, at the cost of rebuilding the geometry whenever a cached feature is returned.
+     * With single \a precision coordinates are stored as floats, which halves the memory
+     * used again but introduces small rounding errors in the returned geometries.
+     *
+     * Geometries of types not supported by QgsCompactGeometry are always cached as they are.
+     * Changing this setting clears the cache.
+     * \see compactGeometries()
+     * \since QGIS 3.0
+     */
+    void setCompactGeometries( bool compact, QgsCompactGeometry::Precision precision = QgsCompactGeometry::DoublePrecision );
+
+    /**
+     * Returns true if cached geometries are stored in compact form.
+     * \see setCompactGeometries()
+     * \since QGIS 3.0
+     */
+    bool compactGeometries() const { return mCompactGeometries; }
+
     /**
      * Set the subset of attributes to be cached
      *
@@ -387,6 +429,8 @@ class CORE_EXPORT QgsVectorLayerCache : public QObject
     QCache< QgsFeatureId, QgsCachedFeature > mCache;
 
     bool mCacheGeometry = true;
+    bool mCompactGeometries = false;
+    QgsCompactGeometry::Precision mCompactPrecision = QgsCompactGeometry::DoublePrecision;
     bool mFullCache = false;
     QList<QgsAbstractCacheIndex *> mCacheIndices;
 
@@ -15,6 +15,7 @@
 #include "qgsvectorlayerfeatureiterator.h"
 
 #include "qgsexpressionfieldbuffer.h"
+#include "qgsfeaturebatch.h"
 #include "qgsgeometrysimplifier.h"
 #include "qgssimplifymethod.h"
 #include "qgsvectordataprovider.h"
@@ -370,6 +371,22 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
 }
 
 
+int QgsVectorLayerFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  if ( mClosed )
+    return 0;
+
+  if ( mSource->mHasEditBuffer || mHasVirtualAttributes || mTransform.isValid()
+       || mRequest.invalidGeometryCheck() != QgsFeatureRequest::GeometryNoCheck )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxFeatures );
+
+  // without edit buffer and virtual fields, layer fields match the provider fields
+  int fetched = mProviderIterator.nextBatch( batch, maxFeatures );
+  if ( fetched == 0 )
+    close();
+
+  return fetched;
+}
 
 bool QgsVectorLayerFeatureIterator::rewind()
 {
@@ -139,6 +139,13 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! fetch next feature, return true on success
     virtual bool fetchFeature( QgsFeature &feature ) override;
 
+    /**
+     * Passes batches of the provider straight through when features are not modified by the layer
+     * (no edit buffer, joins, expression fields, reprojection or geometry check).
+     * \since QGIS 3.0
+     */
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
+
     //! Overrides default method as we only need to filter features in the edit buffer
     //! while for others filtering is left to the provider implementation.
     virtual bool nextFeatureFilterExpression( QgsFeature &f ) override { return fetchFeature( f ); }
@@ -33,6 +33,8 @@
 #include "qgspainteffect.h"
 #include "qgsfeaturefilterprovider.h"
 #include "qgsexception.h"
+#include "qgsfeaturebatch.h"
+#include "qgswkbgeometryview.h"
 #include "qgslogger.h"
 #include "qgssettings.h"
 
@@ -246,6 +248,10 @@ bool QgsVectorLayerRenderer::render()
 
   if ( ( mRenderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && mRenderer->usingSymbolLevels() )
     drawRendererLevels( fit );
+  else if ( ( mRenderer->capabilities() & QgsFeatureRenderer::WkbRendering )
+            && featureRequest.filterType() == QgsFeatureRequest::FilterNone && !mRenderer->orderByEnabled()
+            && !mLabelProvider && !mDiagramProvider && !mDrawVertexMarkers )
+    drawRendererWkb( fit, featureRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ? featureRequest.subsetOfAttributes() : QgsAttributeList() );
   else
     drawRenderer( fit );
 
@@ -328,6 +334,69 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
   stopRenderer( nullptr );
 }
 
+void QgsVectorLayerRenderer::drawRendererWkb( QgsFeatureIterator &fit, const QgsAttributeList &attributes )
+{
+  QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+  mContext.expressionContext().appendScope( symbolScope );
+
+  QgsFeatureBatch batch( mFields, attributes );
+  const QgsAttributeList batchAttributes = batch.attributes();
+  bool stopped = false;
+  while ( !stopped && fit.nextBatch( batch, 1000 ) > 0 )
+  {
+    for ( int row = 0; row < batch.count(); ++row )
+    {
+      if ( mContext.renderingStopped() )
+      {
+        QgsDebugMsg( QString( "Drawing of vector layer %1 canceled." ).arg( layerId() ) );
+        stopped = true;
+        break;
+      }
+
+      if ( !batch.hasGeometry( row ) )
+        continue; // skip features without geometry
+
+      // the feature only gets the attributes, its geometry is read from the WKB
+      QgsFeature fet( mFields, batch.id( row ) );
+      for ( int column = 0; column < batchAttributes.count(); ++column )
+      {
+        fet.setAttribute( batchAttributes.at( column ), batch.value( row, column ) );
+      }
+
+      try
+      {
+        int size = 0;
+        const unsigned char *wkb = batch.wkb( row, size );
+        QgsWkbGeometryView geometry( wkb, size );
+
+        mContext.expressionContext().setFeature( fet );
+        bool sel = mContext.showSelection() && mSelectedFeatureIds.contains( fet.id() );
+
+        if ( geometry.isValid() )
+        {
+          mRenderer->renderFeatureWkb( fet, geometry, mContext, sel );
+        }
+        else
+        {
+          // curved geometries and collections
+          fet.setGeometry( batch.geometry( row ) );
+          mRenderer->renderFeature( fet, mContext, -1, sel, false );
+        }
+      }
+      catch ( const QgsCsException &cse )
+      {
+        Q_UNUSED( cse );
+        QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                     .arg( fet.id() ).arg( cse.what() ) );
+      }
+    }
+  }
+
+  delete mContext.expressionContext().popScope();
+
+  stopRenderer( nullptr );
+}
+
 void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
 {
   QHash< QgsSymbol *, QList<QgsFeature> > features; // key = symbol, value = array of features
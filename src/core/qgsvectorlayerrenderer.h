@@ -90,6 +90,14 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
      */
     void drawRendererLevels( QgsFeatureIterator &fit );
 
+    /** Draw layer with renderer V2, reading the geometries straight from the WKB of feature batches.
+     * Only used for renderers with the WkbRendering capability when features are not labeled and
+     * no vertex markers are drawn. QgsFeatureRenderer::startRender() needs to be called before using this method
+     * \param fit feature iterator
+     * \param attributes indexes of the fetched attributes, empty for all attributes
+     */
+    void drawRendererWkb( QgsFeatureIterator &fit, const QgsAttributeList &attributes );
+
     //! Stop version 2 renderer and selected renderer (if required)
     void stopRenderer( QgsSingleSymbolRenderer *selRenderer );
 
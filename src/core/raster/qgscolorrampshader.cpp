@@ -29,7 +29,63 @@ originally part of the larger QgsRasterLayer class
 #include "qgsrasterinterface.h"
 #include "qgsrasterminmaxorigin.h"
 
+#include <QAtomicInt>
+#include <QMutex>
+
+#include <algorithm>
 #include <cmath>
+#include <vector>
+
+///@cond PRIVATE
+
+/**
+ * Colors compiled from a color ramp, for the integer values covered by the ramp and for
+ * the steps of quantized values. The tables are built by the first shader which needs them,
+ * and are shared read-only by all copies of the shader, e.g. those used by rendering threads.
+ */
+class QgsColorRampShaderLookupTable
+{
+  public:
+
+    //! Maximum number of integer values compiled into a table
+    static const int MAXIMUM_INTEGER_VALUES = 65536;
+
+    //! Colors of equally spaced values
+    struct Table
+    {
+      QAtomicInt built;
+      QMutex mutex;
+      std::vector< QRgb > colors;
+      //! false for values which are not colored by the shader
+      std::vector< bool > hasColor;
+    };
+
+    Table integerValues;
+    Table quantizedValues;
+
+    //! Makes sure the colors of \a count values from \a minimum in steps of \a step are compiled into \a table
+    void build( Table &table, QgsColorRampShader *shader, double minimum, double step, int count )
+    {
+      if ( table.built.loadAcquire() )
+        return;
+
+      QMutexLocker locker( &table.mutex );
+      if ( table.built.load() )
+        return;
+
+      table.colors.resize( count );
+      table.hasColor.resize( count );
+      for ( int i = 0; i < count; ++i )
+      {
+        int red = 0, green = 0, blue = 0, alpha = 0;
+        table.hasColor[i] = shader->shadeValue( minimum + i * step, &red, &green, &blue, &alpha );
+        table.colors[i] = qRgba( red, green, blue, alpha );
+      }
+      table.built.storeRelease( 1 );
+    }
+};
+
+///@endcond
 QgsColorRampShader::QgsColorRampShader( double minimumValue, double maximumValue, QgsColorRamp *colorRamp, Type type, ClassificationMode classificationMode )
   : QgsRasterShaderFunction( minimumValue, maximumValue )
   , mColorRampType( type )
@@ -38,6 +94,7 @@ QgsColorRampShader::QgsColorRampShader( double minimumValue, double maximumValue
   , mLUTFactor( 1.0 )
   , mLUTInitialized( false )
   , mClip( false )
+  , mLookupTable( std::make_shared< QgsColorRampShaderLookupTable >() )
 {
   QgsDebugMsgLevel( "called.", 4 );
 
@@ -46,6 +103,7 @@ QgsColorRampShader::QgsColorRampShader( double minimumValue, double maximumValue
 
 QgsColorRampShader::QgsColorRampShader( const QgsColorRampShader &other )
   : QgsRasterShaderFunction( other )
+  , mColorRampItemList( other.mColorRampItemList )
   , mColorRampType( other.mColorRampType )
   , mClassificationMode( other.mClassificationMode )
   , mLUT( other.mLUT )
@@ -53,13 +111,20 @@ QgsColorRampShader::QgsColorRampShader( const QgsColorRampShader &other )
   , mLUTFactor( other.mLUTFactor )
   , mLUTInitialized( other.mLUTInitialized )
   , mClip( other.mClip )
+  , mQuantizedLookupTableSteps( other.mQuantizedLookupTableSteps )
+  , mLookupTable( other.mLookupTable )
 {
-  mSourceColorRamp.reset( other.sourceColorRamp()->clone() );
+  if ( other.sourceColorRamp() )
+    mSourceColorRamp.reset( other.sourceColorRamp()->clone() );
 }
 
 QgsColorRampShader &QgsColorRampShader::operator=( const QgsColorRampShader &other )
 {
-  mSourceColorRamp.reset( other.sourceColorRamp()->clone() );
+  if ( other.sourceColorRamp() )
+    mSourceColorRamp.reset( other.sourceColorRamp()->clone() );
+  else
+    mSourceColorRamp.reset();
+  mColorRampItemList = other.mColorRampItemList;
   mColorRampType = other.mColorRampType;
   mClassificationMode = other.mClassificationMode;
   mLUT = other.mLUT;
@@ -67,6 +132,8 @@ QgsColorRampShader &QgsColorRampShader::operator=( const QgsColorRampShader &oth
   mLUTFactor = other.mLUTFactor;
   mLUTInitialized = other.mLUTInitialized;
   mClip = other.mClip;
+  mQuantizedLookupTableSteps = other.mQuantizedLookupTableSteps;
+  mLookupTable = other.mLookupTable;
   return *this;
 }
 
@@ -90,11 +157,13 @@ void QgsColorRampShader::setColorRampItemList( const QList<QgsColorRampShader::C
   // Reset the look up table when the color ramp is changed
   mLUTInitialized = false;
   mLUT.clear();
+  resetLookupTable();
 }
 
 void QgsColorRampShader::setColorRampType( QgsColorRampShader::Type colorRampType )
 {
   mColorRampType = colorRampType;
+  resetLookupTable();
 }
 
 void QgsColorRampShader::setColorRampType( const QString &type )
@@ -111,6 +180,25 @@ void QgsColorRampShader::setColorRampType( const QString &type )
   {
     mColorRampType = Exact;
   }
+  resetLookupTable();
+}
+
+void QgsColorRampShader::setClip( bool clip )
+{
+  mClip = clip;
+  resetLookupTable();
+}
+
+void QgsColorRampShader::setQuantizedLookupTableSteps( int steps )
+{
+  mQuantizedLookupTableSteps = std::max( 0, steps );
+  resetLookupTable();
+}
+
+void QgsColorRampShader::resetLookupTable()
+{
+  // copies of the shader keep the table of their own color ramp
+  mLookupTable = std::make_shared< QgsColorRampShaderLookupTable >();
 }
 
 QgsColorRamp *QgsColorRampShader::sourceColorRamp() const
@@ -316,6 +404,51 @@ bool QgsColorRampShader::shade( double value, int *returnRedValue, int *returnGr
   if ( std::isnan( value ) || std::isinf( value ) )
     return false;
 
+  // values within the ramp are shaded with the compiled colors where possible
+  const double firstValue = mColorRampItemList.first().value;
+  const double lastValue = mColorRampItemList.last().value;
+  QgsColorRampShaderLookupTable::Table *table = nullptr;
+  int index = 0;
+  if ( value >= firstValue && value <= lastValue )
+  {
+    if ( value == std::floor( value ) )
+    {
+      const double minimum = std::ceil( firstValue );
+      const double count = std::floor( lastValue ) - minimum + 1;
+      if ( count <= QgsColorRampShaderLookupTable::MAXIMUM_INTEGER_VALUES )
+      {
+        table = &mLookupTable->integerValues;
+        mLookupTable->build( *table, this, minimum, 1.0, static_cast< int >( count ) );
+        index = static_cast< int >( value - minimum );
+      }
+    }
+    else if ( mQuantizedLookupTableSteps > 0 && mColorRampType == Interpolated && lastValue > firstValue )
+    {
+      const double step = ( lastValue - firstValue ) / mQuantizedLookupTableSteps;
+      table = &mLookupTable->quantizedValues;
+      mLookupTable->build( *table, this, firstValue, step, mQuantizedLookupTableSteps + 1 );
+      index = std::min( static_cast< int >( std::floor( ( value - firstValue ) / step + 0.5 ) ), mQuantizedLookupTableSteps );
+    }
+  }
+
+  if ( table )
+  {
+    if ( !table->hasColor[index] )
+      return false;
+
+    const QRgb color = table->colors[index];
+    *returnRedValue = qRed( color );
+    *returnGreenValue = qGreen( color );
+    *returnBlueValue = qBlue( color );
+    *returnAlphaValue = qAlpha( color );
+    return true;
+  }
+
+  return shadeValue( value, returnRedValue, returnGreenValue, returnBlueValue, returnAlphaValue );
+}
+
+bool QgsColorRampShader::shadeValue( double value, int *returnRedValue, int *returnGreenValue, int *returnBlueValue, int *returnAlphaValue )
+{
   int colorRampItemListCount = mColorRampItemList.count();
   int idx;
   if ( !mLUTInitialized )
@@ -32,6 +32,8 @@ originally part of the larger QgsRasterLayer class
 #include "qgsrastershaderfunction.h"
 #include "qgsrectangle.h"
 
+class QgsColorRampShaderLookupTable;
+
 /** \ingroup core
  * A ramp shader will color a raster pixel based on a list of values ranges in a ramp.
  */
@@ -164,13 +166,33 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
      * \param clip set to true to clip values which are out of range.
      * \see clip()
      */
-    void setClip( bool clip ) { mClip = clip; }
+    void setClip( bool clip );
 
     /** Returns whether the shader will clip values which are out of range.
      * \see setClip()
      */
     bool clip() const { return mClip; }
 
+    /** Sets the number of \a steps of the lookup table used to shade non integer values with
+     * an interpolated color ramp. The range between the first and the last color ramp item is
+     * divided into this number of steps, and values are shaded with the color of the nearest step.
+     * This is much faster than interpolating the color of every value, but not exact.
+     * Set \a steps to 0 to interpolate the colors exactly, which is the default.
+     *
+     * Integer values are always shaded through a lookup table of the exact color of each
+     * value, if the color ramp does not span too many of them.
+     * \see quantizedLookupTableSteps()
+     * \since QGIS 3.0
+     */
+    void setQuantizedLookupTableSteps( int steps );
+
+    /** Returns the number of steps of the lookup table used to shade non integer values,
+     * or 0 if they are shaded exactly.
+     * \see setQuantizedLookupTableSteps()
+     * \since QGIS 3.0
+     */
+    int quantizedLookupTableSteps() const { return mQuantizedLookupTableSteps; }
+
   protected:
 
     //! Source color ramp
@@ -197,6 +219,21 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
 
     //! Do not render values out of range
     bool mClip;
+
+    //! Number of steps of the lookup table for non integer values, 0 if disabled
+    int mQuantizedLookupTableSteps = 0;
+
+    /** Colors compiled from the color ramp, shared with the copies of the shader.
+     * It is replaced by a new table whenever the color ramp changes. */
+    std::shared_ptr< QgsColorRampShaderLookupTable > mLookupTable;
+
+    //! Shades a value by searching the color ramp items
+    bool shadeValue( double value, int *returnRedValue, int *returnGreenValue, int *returnBlueValue, int *returnAlphaValue );
+
+    //! Discards the compiled colors after the color ramp changed
+    void resetLookupTable();
+
+    friend class QgsColorRampShaderLookupTable;
 };
 
 #endif
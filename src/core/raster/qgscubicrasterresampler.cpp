@@ -17,6 +17,8 @@
 
 #include "qgscubicrasterresampler.h"
 #include <QImage>
+#include <cmath>
+#include <vector>
 
 QgsCubicRasterResampler::QgsCubicRasterResampler()
 // red
@@ -92,7 +94,6 @@ void QgsCubicRasterResampler::resample( const QImage &srcImage, QImage &dstImage
   double nSrcPerDstY = ( double ) srcImage.height() / ( double ) dstImage.height();
 
   double currentSrcRow = nSrcPerDstY / 2.0 - 0.5;
-  double currentSrcCol;
   int currentSrcColInt;
   int currentSrcRowInt;
   int lastSrcColInt = -100;
@@ -102,18 +103,36 @@ void QgsCubicRasterResampler::resample( const QImage &srcImage, QImage &dstImage
   double bp0u, bp1u, bp2u, bp3u, bp0v, bp1v, bp2v, bp3v;
   double u, v;
 
+  // the source columns and their bernstein polynomials are the same in every row, so they are computed once
+  const int dstWidth = dstImage.width();
+  std::vector< int > srcColInts( dstWidth );
+  std::vector< double > srcColFractions( dstWidth );
+  std::vector< double > bernsteinU( 4 * static_cast< size_t >( dstWidth ) );
+  double currentSrcCol = nSrcPerDstX / 2.0 - 0.5;
+  for ( int x = 0; x < dstWidth; ++x )
+  {
+    srcColInts[x] = std::floor( currentSrcCol );
+    srcColFractions[x] = currentSrcCol - srcColInts[x];
+    for ( int i = 0; i < 4; ++i )
+      bernsteinU[4 * x + i] = calcBernsteinPolyN3( i, srcColFractions[x] );
+    currentSrcCol += nSrcPerDstX;
+  }
+
   for ( int y = 0; y < dstImage.height(); ++y )
   {
     currentSrcRowInt = std::floor( currentSrcRow );
     v = currentSrcRow - currentSrcRowInt;
 
-    currentSrcCol = nSrcPerDstX / 2.0 - 0.5;
+    bp0v = calcBernsteinPolyN3( 0, v );
+    bp1v = calcBernsteinPolyN3( 1, v );
+    bp2v = calcBernsteinPolyN3( 2, v );
+    bp3v = calcBernsteinPolyN3( 3, v );
 
     QRgb *scanLine = ( QRgb * )dstImage.scanLine( y );
-    for ( int x = 0; x < dstImage.width(); ++x )
+    for ( int x = 0; x < dstWidth; ++x )
     {
-      currentSrcColInt = std::floor( currentSrcCol );
-      u = currentSrcCol - currentSrcColInt;
+      currentSrcColInt = srcColInts[x];
+      u = srcColFractions[x];
 
       //handle eight edge-cases
       if ( ( currentSrcRowInt < 0 || currentSrcRowInt >= ( srcImage.height() - 1 ) || currentSrcColInt < 0 || currentSrcColInt >= ( srcImage.width() - 1 ) ) )
@@ -173,7 +192,6 @@ void QgsCubicRasterResampler::resample( const QImage &srcImage, QImage &dstImage
                                             yDerivativeMatrixAlpha[ idx1], yDerivativeMatrixRed[ idx2 ], yDerivativeMatrixGreen[ idx2 ], yDerivativeMatrixBlue[ idx2],
                                             yDerivativeMatrixAlpha[ idx2] );
         }
-        currentSrcCol += nSrcPerDstX;
         continue;
       }
 
@@ -186,14 +204,10 @@ void QgsCubicRasterResampler::resample( const QImage &srcImage, QImage &dstImage
       }
 
       //bernstein polynomials
-      bp0u = calcBernsteinPolyN3( 0, u );
-      bp1u = calcBernsteinPolyN3( 1, u );
-      bp2u = calcBernsteinPolyN3( 2, u );
-      bp3u = calcBernsteinPolyN3( 3, u );
-      bp0v = calcBernsteinPolyN3( 0, v );
-      bp1v = calcBernsteinPolyN3( 1, v );
-      bp2v = calcBernsteinPolyN3( 2, v );
-      bp3v = calcBernsteinPolyN3( 3, v );
+      bp0u = bernsteinU[4 * x];
+      bp1u = bernsteinU[4 * x + 1];
+      bp2u = bernsteinU[4 * x + 2];
+      bp3u = bernsteinU[4 * x + 3];
 
       //then calculate value based on bernstein form of Bezier patch
       //todo: move into function
@@ -268,7 +282,6 @@ void QgsCubicRasterResampler::resample( const QImage &srcImage, QImage &dstImage
       scanLine[x] = createPremultipliedColor( r, g, b, a );
 
       lastSrcColInt = currentSrcColInt;
-      currentSrcCol += nSrcPerDstX;
     }
     lastSrcRowInt = currentSrcRowInt;
     currentSrcRow += nSrcPerDstY;
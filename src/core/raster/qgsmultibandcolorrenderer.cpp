@@ -19,11 +19,14 @@
 #include "qgscontrastenhancement.h"
 #include "qgsrastertransparency.h"
 #include "qgsrasterviewport.h"
+#include "qgsrasterrendererutils_p.h"
 #include <QDomDocument>
 #include <QDomElement>
 #include <QImage>
 #include <QSet>
 
+#include <vector>
+
 QgsMultiBandColorRenderer::QgsMultiBandColorRenderer( QgsRasterInterface *input, int redBand, int greenBand, int blueBand,
     QgsContrastEnhancement *redEnhancement,
     QgsContrastEnhancement *greenEnhancement,
@@ -227,6 +230,49 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
 
   QRgb myDefaultColor = NODATA_COLOR;
 
+  if ( redBlock && greenBlock && blueBlock && !usesTransparency() )
+  {
+    // without transparency the color of a cell is made of the band values stretched to 0-255,
+    // so each band can be converted by data type and through a lookup table for integer rasters.
+    // -1 marks cells drawn with the default color.
+    const qgssize count = ( qgssize )width * height;
+    std::vector< int > redValues( count );
+    std::vector< int > greenValues( count );
+    std::vector< int > blueValues( count );
+
+    // like below, the displayable range of all bands is tested with the red value
+    qgsRasterMapBlockValues( redBlock, redValues.data(), -1, [this]( double value ) -> int
+    {
+      if ( ( mRedContrastEnhancement && !mRedContrastEnhancement->isValueInDisplayableRange( value ) )
+           || ( mGreenContrastEnhancement && !mGreenContrastEnhancement->isValueInDisplayableRange( value ) )
+           || ( mBlueContrastEnhancement && !mBlueContrastEnhancement->isValueInDisplayableRange( value ) ) )
+      {
+        return -1;
+      }
+      return ( mRedContrastEnhancement ? mRedContrastEnhancement->enhanceContrast( value ) : static_cast< int >( value ) ) & 0xff;
+    } );
+    qgsRasterMapBlockValues( greenBlock, greenValues.data(), -1, [this]( double value ) -> int
+    {
+      return ( mGreenContrastEnhancement ? mGreenContrastEnhancement->enhanceContrast( value ) : static_cast< int >( value ) ) & 0xff;
+    } );
+    qgsRasterMapBlockValues( blueBlock, blueValues.data(), -1, [this]( double value ) -> int
+    {
+      return ( mBlueContrastEnhancement ? mBlueContrastEnhancement->enhanceContrast( value ) : static_cast< int >( value ) ) & 0xff;
+    } );
+
+    QRgb *output = reinterpret_cast< QRgb * >( outputBlock->bits() );
+    for ( qgssize i = 0; i < count; i++ )
+    {
+      if ( redValues[i] < 0 || greenValues[i] < 0 || blueValues[i] < 0 )
+        output[i] = myDefaultColor;
+      else
+        output[i] = qRgba( redValues[i], greenValues[i], blueValues[i], 255 );
+    }
+
+    qDeleteAll( bandBlocks );
+    return outputBlock.release();
+  }
+
   for ( qgssize i = 0; i < ( qgssize )width * height; i++ )
   {
     if ( fastDraw ) //fast rendering if no transparency, stretching, color inversion, etc.
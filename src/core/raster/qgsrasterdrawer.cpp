@@ -23,14 +23,84 @@
 #include "qgsrasterviewport.h"
 #include "qgsmaptopixel.h"
 #include "qgsrendercontext.h"
+#include "qgsrasterpipe.h"
+#include <QAtomicInt>
 #include <QImage>
+#include <QMutex>
 #include <QPainter>
 #include <QPrinter>
+#include <QWaitCondition>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+///@cond PRIVATE
+
+// A part of the raster, fetched by any of the drawing threads
+struct QgsRasterDrawerPart
+{
+  int columns = 0;
+  int rows = 0;
+  int topLeftColumn = 0;
+  int topLeftRow = 0;
+  QgsRectangle extent;
+  QImage image;
+  bool finished = false;
+};
+
+// Parts of the raster shared by the drawing threads. The image and finished flag of parts are protected by the mutex.
+struct QgsRasterDrawerParts
+{
+  std::vector< QgsRasterDrawerPart > parts;
+  QAtomicInt nextPart;
+  QMutex mutex;
+  QWaitCondition partFinished;
+};
+
+// Fetches the next part which was not taken by another thread yet, returns false if all parts are taken
+static bool fetchNextPart( QgsRasterDrawerParts *parts, QgsRasterInterface *input, QgsRasterBlockFeedback *feedback )
+{
+  const int index = parts->nextPart.fetchAndAddOrdered( 1 );
+  if ( index >= static_cast< int >( parts->parts.size() ) )
+    return false;
+
+  QgsRasterDrawerPart &part = parts->parts[index];
+  QImage image;
+  if ( !feedback || !feedback->isCanceled() )
+  {
+    // last pipe filter has only 1 band
+    std::unique_ptr< QgsRasterBlock > block( input->block( 1, part.extent, part.columns, part.rows, feedback ) );
+    if ( block )
+      image = block->image();
+  }
+
+  QMutexLocker locker( &parts->mutex );
+  part.image = image;
+  part.finished = true;
+  parts->partFinished.wakeAll();
+  return true;
+}
+
+static void fetchParts( QgsRasterDrawerParts *parts, QgsRasterInterface *input, QgsRasterBlockFeedback *feedback )
+{
+  while ( fetchNextPart( parts, input, feedback ) )
+    ;
+}
+
+///@endcond
 
 QgsRasterDrawer::QgsRasterDrawer( QgsRasterIterator *iterator ): mIterator( iterator )
 {
 }
 
+void QgsRasterDrawer::setParallelRendering( QgsRasterPipe *pipe, const QList< QgsRasterPipe * > &threadPipes )
+{
+  mPipe = pipe;
+  mThreadPipes = threadPipes;
+}
+
 void QgsRasterDrawer::draw( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback )
 {
   QgsDebugMsgLevel( "Entered", 4 );
@@ -39,6 +109,9 @@ void QgsRasterDrawer::draw( QPainter *p, QgsRasterViewPort *viewPort, const QgsM
     return;
   }
 
+  if ( mPipe && !mThreadPipes.isEmpty() && drawParallel( p, viewPort, qgsMapToPixel, feedback ) )
+    return;
+
   // last pipe filter has only 1 band
   int bandNumber = 1;
   mIterator->startRasterRead( bandNumber, viewPort->mWidth, viewPort->mHeight, viewPort->mDrawnExtent, feedback );
@@ -64,54 +137,135 @@ void QgsRasterDrawer::draw( QPainter *p, QgsRasterViewPort *viewPort, const QgsM
       continue;
     }
 
-    QImage img = block->image();
+    drawPartImage( p, viewPort, block->image(), topLeftCol, topLeftRow, qgsMapToPixel, feedback );
 
-#ifndef QT_NO_PRINTER
-    // Because of bug in Acrobat Reader we must use "white" transparent color instead
-    // of "black" for PDF. See #9101.
-    QPrinter *printer = dynamic_cast<QPrinter *>( p->device() );
-    if ( printer && printer->outputFormat() == QPrinter::PdfFormat )
+    delete block;
+
+    // OK this does not matter much anyway as the tile size quite big so most of the time
+    // there would be just one tile for the whole display area, but it won't hurt...
+    if ( feedback && feedback->isCanceled() )
+      break;
+  }
+}
+
+bool QgsRasterDrawer::drawParallel( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback )
+{
+  // split the raster into strips, a few per thread so that the threads stay busy
+  // when some strips take longer than others
+  const int threadCount = mThreadPipes.count() + 1;
+  const int partHeight = std::max( 64, ( viewPort->mHeight + 2 * threadCount - 1 ) / ( 2 * threadCount ) );
+  mIterator->setMaximumTileHeight( std::min( mIterator->maximumTileHeight(), partHeight ) );
+
+  // last pipe filter has only 1 band
+  int bandNumber = 1;
+  QgsRasterDrawerParts parts;
+  QgsRasterDrawerPart newPart;
+  mIterator->startRasterRead( bandNumber, viewPort->mWidth, viewPort->mHeight, viewPort->mDrawnExtent, feedback );
+  while ( mIterator->next( bandNumber, newPart.columns, newPart.rows, newPart.topLeftColumn, newPart.topLeftRow, newPart.extent ) )
+  {
+    parts.parts.push_back( newPart );
+  }
+  mIterator->stopRasterRead( bandNumber );
+
+  if ( parts.parts.size() < 2 )
+    return false;
+
+  // every thread reads from its own copy of the pipe, as providers and filters are not thread safe.
+  // The calling thread fetches parts too, so drawing progresses even if the thread pool is busy.
+  const int threads = std::min( threadCount, static_cast< int >( parts.parts.size() ) );
+  std::vector< std::unique_ptr< QgsRasterBlockFeedback > > feedbacks;
+  QList< QFuture< void > > futures;
+  for ( int i = 1; i < threads; ++i )
+  {
+    feedbacks.emplace_back( new QgsRasterBlockFeedback() );
+    futures << QtConcurrent::run( fetchParts, &parts, mThreadPipes.at( i - 1 )->last(), feedbacks.back().get() );
+  }
+
+  bool canceled = false;
+  for ( size_t i = 0; i < parts.parts.size() && !canceled; ++i )
+  {
+    const QgsRasterDrawerPart &part = parts.parts[i];
+
+    // draw the parts in order, fetching more parts while waiting for this one
+    parts.mutex.lock();
+    while ( !part.finished )
     {
-      QgsDebugMsgLevel( "PdfFormat", 4 );
+      parts.mutex.unlock();
+      const bool fetched = fetchNextPart( &parts, mPipe->last(), feedback );
+      parts.mutex.lock();
+      if ( !fetched && !part.finished )
+        parts.partFinished.wait( &parts.mutex, 100 );
 
-      img = img.convertToFormat( QImage::Format_ARGB32 );
-      QRgb transparentBlack = qRgba( 0, 0, 0, 0 );
-      QRgb transparentWhite = qRgba( 255, 255, 255, 0 );
-      for ( int x = 0; x < img.width(); x++ )
-      {
-        for ( int y = 0; y < img.height(); y++ )
-        {
-          if ( img.pixel( x, y ) == transparentBlack )
-          {
-            img.setPixel( x, y, transparentWhite );
-          }
-        }
-      }
+      if ( feedback && feedback->isCanceled() )
+        break;
     }
-#endif
+    const QImage image = part.image;
+    parts.mutex.unlock();
+
+    canceled = feedback && feedback->isCanceled();
+    if ( canceled )
+      break;
 
-    if ( feedback && feedback->renderPartialOutput() )
+    if ( image.isNull() )
     {
-      // there could have been partial preview written before
-      // so overwrite anything with the resulting image.
-      // (we are guaranteed to have a temporary image for this layer, see QgsMapRendererJob::needTemporaryImage)
-      p->setCompositionMode( QPainter::CompositionMode_Source );
+      QgsDebugMsg( "Cannot get block" );
+      continue;
     }
 
-    drawImage( p, viewPort, img, topLeftCol, topLeftRow, qgsMapToPixel );
+    drawPartImage( p, viewPort, image, part.topLeftColumn, part.topLeftRow, qgsMapToPixel, feedback );
+  }
 
-    delete block;
+  if ( canceled )
+  {
+    for ( const std::unique_ptr< QgsRasterBlockFeedback > &threadFeedback : feedbacks )
+      threadFeedback->cancel();
+  }
+  Q_FOREACH ( QFuture< void > future, futures )
+    future.waitForFinished();
+
+  return true;
+}
+
+void QgsRasterDrawer::drawPartImage( QPainter *p, QgsRasterViewPort *viewPort, QImage img, int topLeftCol, int topLeftRow, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback ) const
+{
+#ifndef QT_NO_PRINTER
+  // Because of bug in Acrobat Reader we must use "white" transparent color instead
+  // of "black" for PDF. See #9101.
+  QPrinter *printer = dynamic_cast<QPrinter *>( p->device() );
+  if ( printer && printer->outputFormat() == QPrinter::PdfFormat )
+  {
+    QgsDebugMsgLevel( "PdfFormat", 4 );
 
-    if ( feedback && feedback->renderPartialOutput() )
+    img = img.convertToFormat( QImage::Format_ARGB32 );
+    QRgb transparentBlack = qRgba( 0, 0, 0, 0 );
+    QRgb transparentWhite = qRgba( 255, 255, 255, 0 );
+    for ( int x = 0; x < img.width(); x++ )
     {
-      // go back to the default composition mode
-      p->setCompositionMode( QPainter::CompositionMode_SourceOver );
+      for ( int y = 0; y < img.height(); y++ )
+      {
+        if ( img.pixel( x, y ) == transparentBlack )
+        {
+          img.setPixel( x, y, transparentWhite );
+        }
+      }
     }
+  }
+#endif
 
-    // OK this does not matter much anyway as the tile size quite big so most of the time
-    // there would be just one tile for the whole display area, but it won't hurt...
-    if ( feedback && feedback->isCanceled() )
-      break;
+  if ( feedback && feedback->renderPartialOutput() )
+  {
+    // there could have been partial preview written before
+    // so overwrite anything with the resulting image.
+    // (we are guaranteed to have a temporary image for this layer, see QgsMapRendererJob::needTemporaryImage)
+    p->setCompositionMode( QPainter::CompositionMode_Source );
+  }
+
+  drawImage( p, viewPort, img, topLeftCol, topLeftRow, qgsMapToPixel );
+
+  if ( feedback && feedback->renderPartialOutput() )
+  {
+    // go back to the default composition mode
+    p->setCompositionMode( QPainter::CompositionMode_SourceOver );
   }
 }
 
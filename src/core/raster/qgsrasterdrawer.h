@@ -20,6 +20,7 @@
 
 #include "qgis_core.h"
 #include "qgis_sip.h"
+#include <QList>
 #include <QMap>
 
 class QPainter;
@@ -29,6 +30,7 @@ class QgsRenderContext;
 struct QgsRasterViewPort;
 class QgsRasterBlockFeedback;
 class QgsRasterIterator;
+class QgsRasterPipe;
 
 /** \ingroup core
  * The drawing pipe for raster layers.
@@ -46,6 +48,17 @@ class CORE_EXPORT QgsRasterDrawer
      */
     void draw( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback = nullptr );
 
+    /** Sets the drawer to fetch the parts of the raster concurrently. The thread calling draw() reads
+     * from the raster \a pipe, whose last interface must be the input of the iterator. Each additional
+     * thread reads from one of the \a threadPipes, which must be copies of \a pipe as providers and
+     * filters are not thread safe. The pipes are not owned by the drawer, so that callers can keep them
+     * between draws. The parts are still painted in order, on the thread calling draw().
+     * The maximum tile height of the iterator is reduced, so that the raster is split into enough parts.
+     * Empty \a threadPipes or a null \a pipe disable parallel drawing.
+     * \since QGIS 3.0
+     */
+    void setParallelRendering( QgsRasterPipe *pipe, const QList< QgsRasterPipe * > &threadPipes );
+
   protected:
 
     /** Draws raster part
@@ -61,6 +74,14 @@ class CORE_EXPORT QgsRasterDrawer
 
   private:
     QgsRasterIterator *mIterator = nullptr;
+    QgsRasterPipe *mPipe = nullptr;
+    QList< QgsRasterPipe * > mThreadPipes;
+
+    //! Draws the image of a raster part, including the fixes needed for the output device
+    void drawPartImage( QPainter *p, QgsRasterViewPort *viewPort, QImage img, int topLeftCol, int topLeftRow, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback ) const;
+
+    //! Draws the raster with the parts fetched concurrently, returns false if it is not split into enough parts
+    bool drawParallel( QPainter *p, QgsRasterViewPort *viewPort, const QgsMapToPixel *qgsMapToPixel, QgsRasterBlockFeedback *feedback );
 };
 
 #endif // QGSRASTERDRAWER_H
@@ -63,9 +63,21 @@ bool QgsRasterIterator::readNextRasterPart( int bandNumber,
     int &nCols, int &nRows,
     QgsRasterBlock **block,
     int &topLeftCol, int &topLeftRow )
+{
+  QgsRectangle blockExtent;
+  return readNextRasterPartInternal( bandNumber, nCols, nRows, block, topLeftCol, topLeftRow, blockExtent );
+}
+
+bool QgsRasterIterator::next( int bandNumber, int &columns, int &rows, int &topLeftColumn, int &topLeftRow, QgsRectangle &blockExtent )
+{
+  return readNextRasterPartInternal( bandNumber, columns, rows, nullptr, topLeftColumn, topLeftRow, blockExtent );
+}
+
+bool QgsRasterIterator::readNextRasterPartInternal( int bandNumber, int &nCols, int &nRows, QgsRasterBlock **block, int &topLeftCol, int &topLeftRow, QgsRectangle &blockExtent )
 {
   QgsDebugMsgLevel( "Entered", 4 );
-  *block = nullptr;
+  if ( block )
+    *block = nullptr;
   //get partinfo
   QMap<int, RasterPartInfo>::iterator partIt = mRasterPartInfos.find( bandNumber );
   if ( partIt == mRasterPartInfos.end() )
@@ -104,9 +116,10 @@ bool QgsRasterIterator::readNextRasterPart( int bandNumber,
   double ymin = pInfo.currentRow + nRows == pInfo.nRows ? viewPortExtent.yMinimum() :  // avoid extra FP math if not necessary
                 viewPortExtent.yMaximum() - ( pInfo.currentRow + nRows ) / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
   double ymax = viewPortExtent.yMaximum() - pInfo.currentRow / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
-  QgsRectangle blockRect( xmin, ymin, xmax, ymax );
+  blockExtent = QgsRectangle( xmin, ymin, xmax, ymax );
 
-  *block = mInput->block( bandNumber, blockRect, nCols, nRows, mFeedback );
+  if ( block )
+    *block = mInput->block( bandNumber, blockExtent, nCols, nRows, mFeedback );
   topLeftCol = pInfo.currentCol;
   topLeftRow = pInfo.currentRow;
 
@@ -16,6 +16,7 @@
 #define QGSRASTERITERATOR_H
 
 #include "qgis_core.h"
+#include "qgis_sip.h"
 #include "qgsrectangle.h"
 #include <QMap>
 
@@ -58,6 +59,20 @@ class CORE_EXPORT QgsRasterIterator
                              QgsRasterBlock **block,
                              int &topLeftCol, int &topLeftRow );
 
+    /**
+     * Fetches the details of the next part of the raster, without reading its data.
+     * This allows the parts to be read separately, e.g. by different threads.
+     * \param bandNumber band to read
+     * \param columns number of columns of the part
+     * \param rows number of rows of the part
+     * \param topLeftColumn top left column of the part
+     * \param topLeftRow top left row of the part
+     * \param blockExtent extent of the part
+     * \returns false if the last part was already returned
+     * \since QGIS 3.0
+     */
+    bool next( int bandNumber, int &columns SIP_OUT, int &rows SIP_OUT, int &topLeftColumn SIP_OUT, int &topLeftRow SIP_OUT, QgsRectangle &blockExtent SIP_OUT );
+
     void stopRasterRead( int bandNumber );
 
     const QgsRasterInterface *input() const { return mInput; }
@@ -92,6 +107,9 @@ class CORE_EXPORT QgsRasterIterator
 
     //! Remove part into and release memory
     void removePartInfo( int bandNumber );
+
+    //! Advances to the next part, and reads its data if \a block is not null
+    bool readNextRasterPartInternal( int bandNumber, int &nCols, int &nRows, QgsRasterBlock **block, int &topLeftCol, int &topLeftRow, QgsRectangle &blockExtent );
 };
 
 #endif // QGSRASTERITERATOR_H
@@ -53,6 +53,7 @@ email                : tim at linfiniti.com
 #include <typeinfo>
 
 #include <QApplication>
+#include <QAtomicInt>
 #include <QCursor>
 #include <QDomElement>
 #include <QDomNode>
@@ -72,6 +73,7 @@ email                : tim at linfiniti.com
 #include <QRegExp>
 #include <QSlider>
 #include <QTime>
+#include <QTimer>
 
 // typedefs for provider plugin functions of interest
 typedef bool isvalidrasterfilename_t( QString const &fileNameQString, QString &retErrMsg );
@@ -141,6 +143,7 @@ QgsRasterLayer::~QgsRasterLayer()
   emit willBeDeleted();
 
   mValid = false;
+  clearDrawingPipes();
   // Note: provider and other interfaces are owned and deleted by pipe
 }
 
@@ -586,6 +589,10 @@ void QgsRasterLayer::init()
   //Initialize the last view port structure, should really be a class
   mLastViewPort.mWidth = 0;
   mLastViewPort.mHeight = 0;
+
+  mDrawingPipesTimer = new QTimer( this );
+  mDrawingPipesTimer->setInterval( DRAWING_PIPES_EXPIRATION_TIME * 1000 );
+  connect( mDrawingPipesTimer, &QTimer::timeout, this, [ = ] { expireDrawingPipes(); } );
 }
 
 void QgsRasterLayer::setDataProvider( QString const &provider )
@@ -593,6 +600,7 @@ void QgsRasterLayer::setDataProvider( QString const &provider )
   QgsDebugMsgLevel( "Entered", 4 );
   mValid = false; // assume the layer is invalid until we determine otherwise
 
+  clearDrawingPipes();
   mPipe.remove( mDataProvider ); // deletes if exists
   mDataProvider = nullptr;
 
@@ -795,10 +803,102 @@ void QgsRasterLayer::setDataProvider( QString const &provider )
 void QgsRasterLayer::closeDataProvider()
 {
   mValid = false;
+  clearDrawingPipes();
   mPipe.remove( mDataProvider );
   mDataProvider = nullptr;
 }
 
+//! Number of copies of pipes open for drawing by all the layers
+static QAtomicInt sDrawingPipeCount;
+
+QList< QgsRasterPipe * > QgsRasterLayer::takeDrawingPipes( int count )
+{
+  QMutexLocker locker( &mDrawingPipesMutex );
+  QList< QgsRasterPipe * > pipes;
+  while ( pipes.count() < count && !mDrawingPipes.isEmpty() )
+    pipes << mDrawingPipes.takeLast().pipe;
+  return pipes;
+}
+
+void QgsRasterLayer::releaseDrawingPipes( const QList< QgsRasterPipe * > &pipes )
+{
+  QList< QgsRasterPipe * > deletedPipes;
+  bool keptPipes = false;
+  {
+    QMutexLocker locker( &mDrawingPipesMutex );
+    Q_FOREACH ( QgsRasterPipe *pipe, pipes )
+    {
+      // the data source may have changed while the pipes were used, and concurrent renders
+      // may give back more copies than a single render uses
+      QgsRasterDataProvider *provider = pipe->provider();
+      if ( mDataProvider && provider && provider->name() == mDataProvider->name() && provider->dataSourceUri() == mDataProvider->dataSourceUri()
+           && mDrawingPipes.count() < MAX_DRAWING_THREADS - 1 )
+      {
+        DrawingPipe drawingPipe;
+        drawingPipe.pipe = pipe;
+        drawingPipe.lastUsed.start();
+        mDrawingPipes << drawingPipe;
+        keptPipes = true;
+      }
+      else
+        deletedPipes << pipe;
+    }
+  }
+  deleteDrawingPipes( deletedPipes );
+
+  // will call the slot directly or queue the call (if the layer lives in a different thread)
+  if ( keptPipes )
+    QMetaObject::invokeMethod( mDrawingPipesTimer, "start" );
+}
+
+void QgsRasterLayer::clearDrawingPipes()
+{
+  QList< QgsRasterPipe * > deletedPipes;
+  {
+    QMutexLocker locker( &mDrawingPipesMutex );
+    Q_FOREACH ( const DrawingPipe &drawingPipe, mDrawingPipes )
+      deletedPipes << drawingPipe.pipe;
+    mDrawingPipes.clear();
+  }
+  deleteDrawingPipes( deletedPipes );
+}
+
+void QgsRasterLayer::expireDrawingPipes()
+{
+  QList< QgsRasterPipe * > deletedPipes;
+  {
+    QMutexLocker locker( &mDrawingPipesMutex );
+    for ( int i = mDrawingPipes.count() - 1; i >= 0; --i )
+    {
+      if ( mDrawingPipes.at( i ).lastUsed.hasExpired( DRAWING_PIPES_EXPIRATION_TIME * 1000 ) )
+        deletedPipes << mDrawingPipes.takeAt( i ).pipe;
+    }
+
+    // no need to run if nothing can expire
+    if ( mDrawingPipes.isEmpty() )
+      mDrawingPipesTimer->stop();
+  }
+  deleteDrawingPipes( deletedPipes );
+}
+
+bool QgsRasterLayer::reserveDrawingPipe()
+{
+  for ( ;; )
+  {
+    int count = sDrawingPipeCount.load();
+    if ( count >= MAX_DRAWING_PIPES )
+      return false;
+    if ( sDrawingPipeCount.testAndSetOrdered( count, count + 1 ) )
+      return true;
+  }
+}
+
+void QgsRasterLayer::deleteDrawingPipes( const QList< QgsRasterPipe * > &pipes )
+{
+  qDeleteAll( pipes );
+  sDrawingPipeCount.fetchAndAddOrdered( -pipes.count() );
+}
+
 void QgsRasterLayer::computeMinMax( int band,
                                     const QgsRasterMinMaxOrigin &mmo,
                                     QgsRasterMinMaxOrigin::Limits limits,
@@ -25,8 +25,10 @@
 #include "qgis_sip.h"
 #include <QColor>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QList>
 #include <QMap>
+#include <QMutex>
 #include <QPair>
 #include <QVector>
 
@@ -46,6 +48,7 @@ class QImage;
 class QLibrary;
 class QPixmap;
 class QSlider;
+class QTimer;
 
 typedef QList < QPair< QString, QColor > > QgsLegendColorList;
 
@@ -424,6 +427,56 @@ class CORE_EXPORT QgsRasterLayer : public QgsMapLayer
 
     //! To save computations and possible infinite cycle of notifications
     QgsRectangle mLastRectangleUsedByRefreshContrastEnhancementIfNeeded;
+
+    /**
+     * Returns up to \a count copies of the pipe, read by the threads drawing the layer. They are kept
+     * between renders so that their providers are not opened again for each render, and must be given
+     * back with releaseDrawingPipes().
+     */
+    QList< QgsRasterPipe * > takeDrawingPipes( int count );
+
+    /**
+     * Gives back copies of the pipe taken with takeDrawingPipes(). Those of another data source and those
+     * beyond MAX_DRAWING_THREADS - 1 idle copies are deleted, the others are deleted after
+     * DRAWING_PIPES_EXPIRATION_TIME seconds without being used.
+     */
+    void releaseDrawingPipes( const QList< QgsRasterPipe * > &pipes );
+
+    //! Deletes the copies of the pipe kept for drawing
+    void clearDrawingPipes();
+
+    //! Deletes the copies of the pipe kept for drawing which were not used for DRAWING_PIPES_EXPIRATION_TIME seconds
+    void expireDrawingPipes();
+
+    /**
+     * Reserves a new copy of a pipe for drawing, returns false if MAX_DRAWING_PIPES copies are
+     * already open by all the layers. Reserved copies are freed with deleteDrawingPipes().
+     */
+    static bool reserveDrawingPipe();
+
+    //! Deletes copies of pipes reserved with reserveDrawingPipe()
+    static void deleteDrawingPipes( const QList< QgsRasterPipe * > &pipes );
+
+    //! Maximum number of threads drawing a layer
+    static const int MAX_DRAWING_THREADS = 8;
+    //! Maximum number of copies of pipes open for drawing by all the layers, each one may keep a file open
+    static const int MAX_DRAWING_PIPES = 64;
+    //! Time in seconds after which unused copies of the pipe are deleted
+    static const int DRAWING_PIPES_EXPIRATION_TIME = 60;
+
+    struct DrawingPipe
+    {
+      QgsRasterPipe *pipe = nullptr;
+      QElapsedTimer lastUsed;
+    };
+
+    //! Copies of the pipe kept for the threads drawing the layer
+    QList< DrawingPipe > mDrawingPipes;
+    QMutex mDrawingPipesMutex;
+    //! Deletes the copies of the pipe which are no longer used
+    QTimer *mDrawingPipesTimer = nullptr;
+
+    friend class QgsRasterLayerRenderer;
 };
 
 #endif
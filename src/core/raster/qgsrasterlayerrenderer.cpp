@@ -25,6 +25,8 @@
 #include "qgsproject.h"
 #include "qgsexception.h"
 
+#include <QThread>
+
 
 ///@cond PRIVATE
 
@@ -61,6 +63,39 @@ void QgsRasterLayerRendererFeedback::onNewData()
   mLastPreview = QTime::currentTime();
 }
 
+// Makes a copy of the pipe kept from a previous render match the \a pipe, without cloning its provider again
+static bool updateThreadPipe( QgsRasterPipe *threadPipe, const QgsRasterPipe *pipe )
+{
+  QgsRasterDataProvider *provider = pipe->provider();
+  QgsRasterDataProvider *threadProvider = threadPipe->provider();
+  if ( !provider || !threadProvider || threadPipe->at( 0 ) != threadProvider || pipe->at( 0 ) != provider )
+    return false;
+
+  threadProvider->setDpi( provider->dpi() );
+  for ( int band = 1; band <= provider->bandCount(); ++band )
+  {
+    if ( threadProvider->useSourceNoDataValue( band ) != provider->useSourceNoDataValue( band ) )
+      threadProvider->setUseSourceNoDataValue( band, provider->useSourceNoDataValue( band ) );
+    threadProvider->setUserNoDataValue( band, provider->userNoDataValues( band ) );
+  }
+
+  while ( threadPipe->size() > 1 )
+  {
+    if ( !threadPipe->remove( threadPipe->size() - 1 ) )
+      return false;
+  }
+  for ( int i = 1; i < pipe->size(); ++i )
+  {
+    QgsRasterInterface *interface = pipe->at( i )->clone();
+    if ( !threadPipe->insert( i, interface ) )
+    {
+      delete interface;
+      return false;
+    }
+  }
+  return true;
+}
+
 ///@endcond
 ///
 QgsRasterLayerRenderer::QgsRasterLayerRenderer( QgsRasterLayer *layer, QgsRenderContext &rendererContext )
@@ -219,6 +254,16 @@ QgsRasterLayerRenderer::QgsRasterLayerRenderer( QgsRasterLayer *layer, QgsRender
   QgsRasterRenderer *rasterRenderer = mPipe->renderer();
   if ( rasterRenderer )
     layer->refreshRendererIfNeeded( rasterRenderer, rendererContext.extent() );
+
+  // parts of rasters read from local files are fetched concurrently, e.g. reprojected mosaics are
+  // bound by the projector and renderer. Services would receive many more requests instead.
+  QgsRasterDataProvider *provider = mPipe->provider();
+  if ( provider && provider->name() == QLatin1String( "gdal" ) && QThread::idealThreadCount() > 1 )
+  {
+    mThreadCount = QThread::idealThreadCount() < QgsRasterLayer::MAX_DRAWING_THREADS ? QThread::idealThreadCount() : QgsRasterLayer::MAX_DRAWING_THREADS;
+    mLayer = layer;
+    mThreadPipes = layer->takeDrawingPipes( mThreadCount - 1 );
+  }
 }
 
 QgsRasterLayerRenderer::~QgsRasterLayerRenderer()
@@ -227,6 +272,12 @@ QgsRasterLayerRenderer::~QgsRasterLayerRenderer()
 
   delete mRasterViewPort;
   delete mPipe;
+
+  // the copies of the pipe are kept by the layer for the next renders
+  if ( mLayer )
+    mLayer->releaseDrawingPipes( mThreadPipes );
+  else
+    QgsRasterLayer::deleteDrawingPipes( mThreadPipes );
 }
 
 bool QgsRasterLayerRenderer::render()
@@ -257,6 +308,24 @@ bool QgsRasterLayerRenderer::render()
   // Drawer to pipe?
   QgsRasterIterator iterator( mPipe->last() );
   QgsRasterDrawer drawer( &iterator );
+  if ( mThreadCount > 1 )
+  {
+    // copies of the pipe kept from previous renders only need the interfaces following their provider
+    for ( int i = 0; i < mThreadPipes.count(); ++i )
+    {
+      if ( !updateThreadPipe( mThreadPipes.at( i ), mPipe ) )
+      {
+        delete mThreadPipes.at( i );
+        mThreadPipes[i] = new QgsRasterPipe( *mPipe );
+      }
+    }
+    // fewer threads are used when the copies open by all the layers reach their limit
+    while ( mThreadPipes.count() < mThreadCount - 1 && QgsRasterLayer::reserveDrawingPipe() )
+      mThreadPipes << new QgsRasterPipe( *mPipe );
+
+    if ( !mThreadPipes.isEmpty() )
+      drawer.setParallelRendering( mPipe, mThreadPipes );
+  }
   drawer.draw( mPainter, mRasterViewPort, mMapToPixel, mFeedback );
 
   QgsDebugMsgLevel( QString( "total raster draw time (ms):     %1" ).arg( time.elapsed(), 5 ), 4 );
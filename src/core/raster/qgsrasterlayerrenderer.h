@@ -20,6 +20,9 @@
 
 #include "qgsmaplayerrenderer.h"
 
+#include <QList>
+#include <QPointer>
+
 class QPainter;
 
 class QgsMapToPixel;
@@ -82,6 +85,13 @@ class CORE_EXPORT QgsRasterLayerRenderer : public QgsMapLayerRenderer
     QgsRasterPipe *mPipe = nullptr;
     QgsRenderContext &mContext;
 
+    //! Layer keeping the copies of the pipe read by the other drawing threads between renders
+    QPointer< QgsRasterLayer > mLayer;
+    //! Number of threads drawing the layer
+    int mThreadCount = 1;
+    //! Copies of the pipe read by the other drawing threads
+    QList< QgsRasterPipe * > mThreadPipes;
+
     //! feedback class for cancelation and preview generation
     QgsRasterLayerRendererFeedback *mFeedback = nullptr;
 
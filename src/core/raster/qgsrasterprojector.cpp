@@ -23,6 +23,155 @@
 #include "qgscoordinatetransform.h"
 #include "qgsexception.h"
 
+#include <QCache>
+#include <QMutex>
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+///@cond PRIVATE
+
+// Default memory budget of the cache of reprojection grids, in bytes
+static const qint64 DEFAULT_GRID_CACHE_BUDGET = 64 * 1024 * 1024;
+
+/**
+ * Source pixels of the destination pixels of a block, computed by ProjectorData for
+ * a destination extent and size and a transformation.
+ */
+struct QgsRasterProjectorGrid
+{
+  QgsRectangle srcExtent;
+  int srcRows = 0;
+  int srcCols = 0;
+  //! Index of the source pixel of each destination pixel, -1 if it is outside the source
+  std::vector< qint64 > srcIndexes;
+
+  //! Returns the memory used by the grid, in bytes
+  qint64 memoryUsage() const { return sizeof( QgsRasterProjectorGrid ) + srcIndexes.capacity() * sizeof( qint64 ); }
+};
+
+/**
+ * Identifies a reprojection grid: everything ProjectorData depends on.
+ */
+struct QgsRasterProjectorGridKey
+{
+  QString srcAuthId;
+  QString destAuthId;
+  int srcDatumTransform = -1;
+  int destDatumTransform = -1;
+  QgsRasterProjector::Precision precision = QgsRasterProjector::Approximate;
+  int width = 0;
+  int height = 0;
+  //! destination extent, then source raster extent and resolution
+  double values[10];
+
+  bool operator==( const QgsRasterProjectorGridKey &other ) const
+  {
+    return srcAuthId == other.srcAuthId && destAuthId == other.destAuthId
+           && srcDatumTransform == other.srcDatumTransform && destDatumTransform == other.destDatumTransform
+           && precision == other.precision && width == other.width && height == other.height
+           && std::equal( values, values + 10, other.values );
+  }
+};
+
+static uint qHash( const QgsRasterProjectorGridKey &key )
+{
+  uint hash = qHash( key.srcAuthId ) ^ ( qHash( key.destAuthId ) << 1 );
+  hash ^= qHash( key.width ) * 31 + qHash( key.height ) + key.precision;
+  hash ^= qHash( key.srcDatumTransform ) * 17 + qHash( key.destDatumTransform );
+  for ( double value : key.values )
+    hash = hash * 31 + qHash( value );
+  return hash;
+}
+
+/**
+ * Reprojection grids shared by all projectors, e.g. those of the render jobs of tiled
+ * map requests, which keep asking for the same blocks. Grids are evicted least recently
+ * used first when their memory budget is exceeded.
+ */
+class QgsRasterProjectorGridCache
+{
+  public:
+
+    static QgsRasterProjectorGridCache *instance()
+    {
+      static QgsRasterProjectorGridCache sInstance;
+      return &sInstance;
+    }
+
+    //! Returns the grid for \a key, or nullptr if it is not cached
+    std::shared_ptr< const QgsRasterProjectorGrid > grid( const QgsRasterProjectorGridKey &key )
+    {
+      QMutexLocker locker( &mMutex );
+      std::shared_ptr< const QgsRasterProjectorGrid > *grid = mGrids.object( key );
+      return grid ? *grid : nullptr;
+    }
+
+    //! Returns true if a grid for \a width by \a height pixels can be cached
+    bool fits( int width, int height )
+    {
+      QMutexLocker locker( &mMutex );
+      return static_cast< qint64 >( width ) * height * static_cast< qint64 >( sizeof( qint64 ) ) < mBudget;
+    }
+
+    void insert( const QgsRasterProjectorGridKey &key, const std::shared_ptr< const QgsRasterProjectorGrid > &grid )
+    {
+      QMutexLocker locker( &mMutex );
+      mGrids.insert( key, new std::shared_ptr< const QgsRasterProjectorGrid >( grid ), cost( grid->memoryUsage() ) );
+    }
+
+    void setMemoryBudget( qint64 bytes )
+    {
+      QMutexLocker locker( &mMutex );
+      mBudget = std::max( static_cast< qint64 >( 0 ), bytes );
+      mGrids.setMaxCost( cost( mBudget ) );
+    }
+
+    qint64 memoryBudget()
+    {
+      QMutexLocker locker( &mMutex );
+      return mBudget;
+    }
+
+    void clear()
+    {
+      QMutexLocker locker( &mMutex );
+      mGrids.clear();
+    }
+
+  private:
+
+    QgsRasterProjectorGridCache()
+    {
+      mGrids.setMaxCost( cost( mBudget ) );
+    }
+
+    //! QCache costs are in kilobytes, so that budgets over 2 GB do not overflow
+    static int cost( qint64 bytes ) { return static_cast< int >( std::min( bytes / 1024, static_cast< qint64 >( std::numeric_limits< int >::max() ) ) ); }
+
+    QMutex mMutex;
+    qint64 mBudget = DEFAULT_GRID_CACHE_BUDGET;
+    QCache< QgsRasterProjectorGridKey, std::shared_ptr< const QgsRasterProjectorGrid > > mGrids;
+};
+
+// Gets the extent of the source raster and its resolution, if it has a fixed resolution
+static void sourceExtentAndResolution( QgsRasterInterface *input, QgsRectangle &extent, double &xRes, double &yRes )
+{
+  QgsRasterDataProvider *provider = input ? dynamic_cast<QgsRasterDataProvider *>( input->sourceInput() ) : nullptr;
+  if ( !provider )
+    return;
+
+  if ( provider->capabilities() & QgsRasterDataProvider::Size )
+  {
+    xRes = provider->extent().width() / provider->xSize();
+    yRes = provider->extent().height() / provider->ySize();
+  }
+  extent = provider->extent();
+}
+
+///@endcond
+
 
 QgsRasterProjector::QgsRasterProjector()
   : QgsRasterInterface( nullptr )
@@ -99,23 +248,7 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   QgsDebugMsgLevel( "Entered", 4 );
 
   // Get max source resolution and extent if possible
-  if ( input )
-  {
-    QgsRasterDataProvider *provider = dynamic_cast<QgsRasterDataProvider *>( input->sourceInput() );
-    if ( provider )
-    {
-      if ( provider->capabilities() & QgsRasterDataProvider::Size )
-      {
-        mMaxSrcXRes = provider->extent().width() / provider->xSize();
-        mMaxSrcYRes = provider->extent().height() / provider->ySize();
-      }
-      // Get source extent
-      if ( mExtent.isEmpty() )
-      {
-        mExtent = provider->extent();
-      }
-    }
-  }
+  sourceExtentAndResolution( input, mExtent, mMaxSrcXRes, mMaxSrcYRes );
 
   mDestXRes = mDestExtent.width() / ( mDestCols );
   mDestYRes = mDestExtent.height() / ( mDestRows );
@@ -759,21 +892,73 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
     return mInput->block( bandNo, extent, width, height, feedback );
   }
 
-  QgsCoordinateTransform inverseCt = QgsCoordinateTransformCache::instance()->transform( mDestCRS.authid(), mSrcCRS.authid(), mDestDatumTransform, mSrcDatumTransform );
+  // The source pixels of the destination pixels only depend on the extent, size and transformation,
+  // so they are cached for projectors which keep asking for the same blocks, e.g. of map tiles
+  QgsRasterProjectorGridKey key;
+  key.srcAuthId = mSrcCRS.authid();
+  key.destAuthId = mDestCRS.authid();
+  key.srcDatumTransform = mSrcDatumTransform;
+  key.destDatumTransform = mDestDatumTransform;
+  key.precision = mPrecision;
+  key.width = width;
+  key.height = height;
+  QgsRectangle sourceExtent;
+  double sourceXRes = 0;
+  double sourceYRes = 0;
+  sourceExtentAndResolution( mInput, sourceExtent, sourceXRes, sourceYRes );
+  const double keyValues[] = { extent.xMinimum(), extent.yMinimum(), extent.xMaximum(), extent.yMaximum(),
+                               sourceExtent.xMinimum(), sourceExtent.yMinimum(), sourceExtent.xMaximum(), sourceExtent.yMaximum(),
+                               sourceXRes, sourceYRes
+                             };
+  std::copy( keyValues, keyValues + 10, key.values );
+
+  QgsRasterProjectorGridCache *gridCache = QgsRasterProjectorGridCache::instance();
+  std::shared_ptr< const QgsRasterProjectorGrid > grid = gridCache->grid( key );
+  std::unique_ptr< ProjectorData > pd;
+  if ( !grid )
+  {
+    QgsCoordinateTransform inverseCt = QgsCoordinateTransformCache::instance()->transform( mDestCRS.authid(), mSrcCRS.authid(), mDestDatumTransform, mSrcDatumTransform );
+    pd.reset( new ProjectorData( extent, width, height, mInput, inverseCt, mPrecision ) );
+    if ( gridCache->fits( width, height ) )
+    {
+      std::shared_ptr< QgsRasterProjectorGrid > newGrid = std::make_shared< QgsRasterProjectorGrid >();
+      newGrid->srcExtent = pd->srcExtent();
+      newGrid->srcRows = pd->srcRows();
+      newGrid->srcCols = pd->srcCols();
+      if ( newGrid->srcRows > 0 && newGrid->srcCols > 0 )
+      {
+        newGrid->srcIndexes.resize( static_cast< qgssize >( width ) * height, -1 );
+        int srcRow, srcCol;
+        for ( int i = 0; i < height; ++i )
+        {
+          for ( int j = 0; j < width; ++j )
+          {
+            if ( pd->srcRowCol( i, j, &srcRow, &srcCol ) )
+              newGrid->srcIndexes[ static_cast< qgssize >( i ) * width + j ] = static_cast< qint64 >( srcRow ) * newGrid->srcCols + srcCol;
+          }
+        }
+      }
+      gridCache->insert( key, newGrid );
+      grid = newGrid;
+      pd.reset();
+    }
+  }
 
-  ProjectorData pd( extent, width, height, mInput, inverseCt, mPrecision );
+  const QgsRectangle srcExtent = grid ? grid->srcExtent : pd->srcExtent();
+  const int srcRows = grid ? grid->srcRows : pd->srcRows();
+  const int srcCols = grid ? grid->srcCols : pd->srcCols();
 
-  QgsDebugMsgLevel( QString( "srcExtent:\n%1" ).arg( pd.srcExtent().toString() ), 4 );
-  QgsDebugMsgLevel( QString( "srcCols = %1 srcRows = %2" ).arg( pd.srcCols() ).arg( pd.srcRows() ), 4 );
+  QgsDebugMsgLevel( QString( "srcExtent:\n%1" ).arg( srcExtent.toString() ), 4 );
+  QgsDebugMsgLevel( QString( "srcCols = %1 srcRows = %2" ).arg( srcCols ).arg( srcRows ), 4 );
 
   // If we zoom out too much, projector srcRows / srcCols maybe 0, which can cause problems in providers
-  if ( pd.srcRows() <= 0 || pd.srcCols() <= 0 )
+  if ( srcRows <= 0 || srcCols <= 0 )
   {
     QgsDebugMsgLevel( "Zero srcRows or srcCols", 4 );
     return new QgsRasterBlock();
   }
 
-  std::unique_ptr< QgsRasterBlock > inputBlock( mInput->block( bandNo, pd.srcExtent(), pd.srcCols(), pd.srcRows(), feedback ) );
+  std::unique_ptr< QgsRasterBlock > inputBlock( mInput->block( bandNo, srcExtent, srcCols, srcRows, feedback ) );
   if ( !inputBlock || inputBlock->isEmpty() )
   {
     QgsDebugMsg( "No raster data!" );
@@ -810,6 +995,7 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
 
   outputBlock->setIsNoData();
 
+  const qint64 *srcIndexes = grid ? grid->srcIndexes.data() : nullptr;
   int srcRow, srcCol;
   for ( int i = 0; i < height; ++i )
   {
@@ -817,13 +1003,23 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
       break;
     for ( int j = 0; j < width; ++j )
     {
-      bool inside = pd.srcRowCol( i, j, &srcRow, &srcCol );
-      if ( !inside ) continue; // we have everything set to no data
+      qgssize srcIndex;
+      if ( srcIndexes )
+      {
+        const qint64 index = srcIndexes[ static_cast< qgssize >( i ) * width + j ];
+        if ( index < 0 ) continue; // we have everything set to no data
+        srcIndex = static_cast< qgssize >( index );
+      }
+      else
+      {
+        bool inside = pd->srcRowCol( i, j, &srcRow, &srcCol );
+        if ( !inside ) continue; // we have everything set to no data
 
-      qgssize srcIndex = static_cast< qgssize >( srcRow ) * pd.srcCols() + srcCol;
+        srcIndex = static_cast< qgssize >( srcRow ) * srcCols + srcCol;
+      }
 
       // isNoData() may be slow so we check doNoData first
-      if ( doNoData && inputBlock->isNoData( srcRow, srcCol ) )
+      if ( doNoData && inputBlock->isNoData( srcIndex ) )
       {
         outputBlock->setIsNoData( i, j );
         continue;
@@ -906,3 +1102,17 @@ bool QgsRasterProjector::extentSize( const QgsCoordinateTransform &ct,
   return true;
 }
 
+void QgsRasterProjector::setGridCacheMemoryBudget( qint64 bytes )
+{
+  QgsRasterProjectorGridCache::instance()->setMemoryBudget( bytes );
+}
+
+qint64 QgsRasterProjector::gridCacheMemoryBudget()
+{
+  return QgsRasterProjectorGridCache::instance()->memoryBudget();
+}
+
+void QgsRasterProjector::clearGridCache()
+{
+  QgsRasterProjectorGridCache::instance()->clear();
+}
@@ -90,6 +90,32 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
                             const QgsRectangle &srcExtent, int srcXSize, int srcYSize,
                             QgsRectangle &destExtent SIP_OUT, int &destXSize SIP_OUT, int &destYSize SIP_OUT );
 
+    /**
+     * Sets the maximum memory used by the cache of reprojection grids, in bytes.
+     *
+     * The source pixel of every destination pixel of a block is computed once for each
+     * destination extent and size, transformation and source raster, and kept in a cache
+     * shared by all projectors, so that blocks requested again (e.g. map tiles) are
+     * reprojected without transforming any coordinates. The least recently used grids
+     * are dropped when the budget is exceeded. A budget of 0 disables the cache.
+     * \see gridCacheMemoryBudget()
+     * \since QGIS 3.0
+     */
+    static void setGridCacheMemoryBudget( qint64 bytes );
+
+    /**
+     * Returns the maximum memory used by the cache of reprojection grids, in bytes.
+     * \see setGridCacheMemoryBudget()
+     * \since QGIS 3.0
+     */
+    static qint64 gridCacheMemoryBudget();
+
+    /**
+     * Removes all reprojection grids from the cache.
+     * \since QGIS 3.0
+     */
+    static void clearGridCache();
+
   private:
 
     //! Source CRS
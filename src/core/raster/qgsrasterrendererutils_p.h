@@ -0,0 +1,146 @@
+/***************************************************************************
+  qgsrasterrendererutils_p.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRASTERRENDERERUTILS_P_H
+#define QGSRASTERRENDERERUTILS_P_H
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgsrasterblock.h"
+
+#include <limits>
+#include <vector>
+
+/**
+ * Maps the values of the \a count cells of \a input, whose data has type T, to \a output.
+ * No data cells are set to \a noDataOutput, other cells to mapValue( value ).
+ *
+ * Blocks of integer types whose values span a range smaller than the block are mapped
+ * through a lookup table over that range, so mapValue() is only called once per
+ * distinct value instead of once per cell.
+ */
+template <typename T, typename O, typename F>
+void qgsRasterMapTypedValues( QgsRasterBlock *input, const T *data, qgssize count, O *output, O noDataOutput, F mapValue )
+{
+  const bool hasNoDataValue = input->hasNoDataValue();
+  // cells can also be flagged as no data in a bitmap, which is only used if there is no no data value
+  const bool hasNoDataBitmap = !hasNoDataValue && input->hasNoData();
+  const double noDataValue = input->noDataValue();
+
+  auto mapCell = [&]( T cell ) -> O
+  {
+    const double value = static_cast< double >( cell );
+    if ( hasNoDataValue && QgsRasterBlock::isNoDataValue( value, noDataValue ) )
+      return noDataOutput;
+    return mapValue( value );
+  };
+
+  if ( std::numeric_limits< T >::is_integer && count > 0 )
+  {
+    T min = data[0];
+    T max = data[0];
+    for ( qgssize i = 1; i < count; ++i )
+    {
+      if ( data[i] < min )
+        min = data[i];
+      else if ( data[i] > max )
+        max = data[i];
+    }
+
+    const qgssize range = static_cast< qgssize >( static_cast< qint64 >( max ) - static_cast< qint64 >( min ) ) + 1;
+    if ( range <= count )
+    {
+      std::vector< O > table( range );
+      for ( qgssize i = 0; i < range; ++i )
+        table[i] = mapCell( static_cast< T >( static_cast< qint64 >( min ) + static_cast< qint64 >( i ) ) );
+
+      for ( qgssize i = 0; i < count; ++i )
+      {
+        output[i] = hasNoDataBitmap && input->isNoData( i ) ? noDataOutput
+                    : table[ static_cast< qgssize >( static_cast< qint64 >( data[i] ) - static_cast< qint64 >( min ) )];
+      }
+      return;
+    }
+  }
+
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    output[i] = hasNoDataBitmap && input->isNoData( i ) ? noDataOutput : mapCell( data[i] );
+  }
+}
+
+/**
+ * Maps the values of all cells of \a input to \a output, which must hold a value for every cell.
+ * No data cells are set to \a noDataOutput, other cells to mapValue( value ), where mapValue
+ * is a functor taking the cell value as a double.
+ *
+ * The cells are read straight from the block data for each data type, instead of through
+ * QgsRasterBlock::value() and QgsRasterBlock::isNoData() for every cell.
+ */
+template <typename O, typename F>
+void qgsRasterMapBlockValues( QgsRasterBlock *input, O *output, O noDataOutput, F mapValue )
+{
+  const qgssize count = static_cast< qgssize >( input->width() ) * input->height();
+  void *data = input->bits();
+  if ( !data )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+      output[i] = noDataOutput;
+    return;
+  }
+
+  switch ( input->dataType() )
+  {
+    case Qgis::Byte:
+      qgsRasterMapTypedValues( input, static_cast< const quint8 * >( data ), count, output, noDataOutput, mapValue );
+      break;
+    case Qgis::UInt16:
+      qgsRasterMapTypedValues( input, static_cast< const quint16 * >( data ), count, output, noDataOutput, mapValue );
+      break;
+    case Qgis::Int16:
+      qgsRasterMapTypedValues( input, static_cast< const qint16 * >( data ), count, output, noDataOutput, mapValue );
+      break;
+    case Qgis::UInt32:
+      qgsRasterMapTypedValues( input, static_cast< const quint32 * >( data ), count, output, noDataOutput, mapValue );
+      break;
+    case Qgis::Int32:
+      qgsRasterMapTypedValues( input, static_cast< const qint32 * >( data ), count, output, noDataOutput, mapValue );
+      break;
+    case Qgis::Float32:
+      qgsRasterMapTypedValues( input, static_cast< const float * >( data ), count, output, noDataOutput, mapValue );
+      break;
+    case Qgis::Float64:
+      qgsRasterMapTypedValues( input, static_cast< const double * >( data ), count, output, noDataOutput, mapValue );
+      break;
+    default:
+      for ( qgssize i = 0; i < count; ++i )
+      {
+        output[i] = input->isNoData( i ) ? noDataOutput : mapValue( input->value( i ) );
+      }
+      break;
+  }
+}
+
+/// @endcond
+
+#endif // QGSRASTERRENDERERUTILS_P_H
@@ -142,6 +142,8 @@ void QgsRasterShader::writeXml( QDomDocument &doc, QDomElement &parent ) const
     colorRampShaderElem.setAttribute( "colorRampType", colorRampShader->colorRampTypeAsQString() );
     colorRampShaderElem.setAttribute( "classificationMode", colorRampShader->classificationMode() );
     colorRampShaderElem.setAttribute( QStringLiteral( "clip" ), colorRampShader->clip() );
+    if ( colorRampShader->quantizedLookupTableSteps() > 0 )
+      colorRampShaderElem.setAttribute( QStringLiteral( "lookupTableSteps" ), colorRampShader->quantizedLookupTableSteps() );
 
     // save source color ramp
     if ( colorRampShader->sourceColorRamp() )
@@ -185,6 +187,7 @@ void QgsRasterShader::readXml( const QDomElement &elem )
     colorRampShader->setColorRampType( colorRampShaderElem.attribute( QStringLiteral( "colorRampType" ), QStringLiteral( "INTERPOLATED" ) ) );
     colorRampShader->setClassificationMode( static_cast< QgsColorRampShader::ClassificationMode >( colorRampShaderElem.attribute( QStringLiteral( "classificationMode" ), QStringLiteral( "1" ) ).toInt() ) );
     colorRampShader->setClip( colorRampShaderElem.attribute( QStringLiteral( "clip" ), QStringLiteral( "0" ) ) == QLatin1String( "1" ) );
+    colorRampShader->setQuantizedLookupTableSteps( colorRampShaderElem.attribute( QStringLiteral( "lookupTableSteps" ), QStringLiteral( "0" ) ).toInt() );
 
     QList<QgsColorRampShader::ColorRampItem> itemList;
     QDomElement itemElem;
@@ -18,6 +18,7 @@
 #include "qgssinglebandgrayrenderer.h"
 #include "qgscontrastenhancement.h"
 #include "qgsrastertransparency.h"
+#include "qgsrasterrendererutils_p.h"
 #include <QDomDocument>
 #include <QDomElement>
 #include <QImage>
@@ -117,6 +118,43 @@ QgsRasterBlock *QgsSingleBandGrayRenderer::block( int bandNo, const QgsRectangle
   }
 
   QRgb myDefaultColor = NODATA_COLOR;
+
+  if ( !alphaBlock )
+  {
+    // without alpha band the color only depends on the cell value, so the cells can be converted
+    // by data type and through a lookup table for integer rasters
+    auto colorForValue = [&]( double grayVal ) -> QRgb
+    {
+      double currentAlpha = mOpacity;
+      if ( mRasterTransparency )
+      {
+        currentAlpha = mRasterTransparency->alphaValue( grayVal, mOpacity * 255 ) / 255.0;
+      }
+
+      if ( mContrastEnhancement )
+      {
+        if ( !mContrastEnhancement->isValueInDisplayableRange( grayVal ) )
+        {
+          return myDefaultColor;
+        }
+        grayVal = mContrastEnhancement->enhanceContrast( grayVal );
+      }
+
+      if ( mGradient == WhiteToBlack )
+      {
+        grayVal = 255 - grayVal;
+      }
+
+      if ( qgsDoubleNear( currentAlpha, 1.0 ) )
+      {
+        return qRgba( grayVal, grayVal, grayVal, 255 );
+      }
+      return qRgba( currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * 255 );
+    };
+    qgsRasterMapBlockValues( inputBlock.get(), reinterpret_cast< QRgb * >( outputBlock->bits() ), myDefaultColor, colorForValue );
+    return outputBlock.release();
+  }
+
   for ( qgssize i = 0; i < ( qgssize )width * height; i++ )
   {
     if ( inputBlock->isNoData( i ) )
@@ -21,6 +21,7 @@
 #include "qgsrastershader.h"
 #include "qgsrastertransparency.h"
 #include "qgsrasterviewport.h"
+#include "qgsrasterrendererutils_p.h"
 
 #include <QDomDocument>
 #include <QDomElement>
@@ -83,16 +84,10 @@ QgsSingleBandPseudoColorRenderer *QgsSingleBandPseudoColorRenderer::clone() cons
 
     if ( origColorRampShader )
     {
-      QgsColorRampShader *colorRampShader = new QgsColorRampShader( mShader->minimumValue(), mShader->maximumValue() );
-
-      if ( origColorRampShader->sourceColorRamp() )
-      {
-        colorRampShader->setSourceColorRamp( origColorRampShader->sourceColorRamp()->clone() );
-      }
-      colorRampShader->setColorRampType( origColorRampShader->colorRampType() );
-      colorRampShader->setClassificationMode( origColorRampShader->classificationMode() );
-      colorRampShader->setClip( origColorRampShader->clip() );
-      colorRampShader->setColorRampItemList( origColorRampShader->colorRampItemList() );
+      // the copy shares the colors compiled from the color ramp, e.g. with the renderers of other threads
+      QgsColorRampShader *colorRampShader = new QgsColorRampShader( *origColorRampShader );
+      colorRampShader->setMinimumValue( mShader->minimumValue() );
+      colorRampShader->setMaximumValue( mShader->maximumValue() );
       shader->setRasterShaderFunction( colorRampShader );
     }
   }
@@ -235,6 +230,43 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
 
   QRgb myDefaultColor = NODATA_COLOR;
 
+  if ( !alphaBlock )
+  {
+    // without alpha band the color only depends on the cell value, so the cells can be shaded
+    // by data type and through a lookup table for integer rasters
+    auto colorForValue = [&]( double val ) -> QRgb
+    {
+      int red, green, blue, alpha;
+      if ( !mShader->shade( val, &red, &green, &blue, &alpha ) )
+      {
+        return myDefaultColor;
+      }
+
+      if ( alpha < 255 )
+      {
+        // Working with premultiplied colors, so multiply values by alpha
+        red *= ( alpha / 255.0 );
+        blue *= ( alpha / 255.0 );
+        green *= ( alpha / 255.0 );
+      }
+
+      if ( !hasTransparency )
+      {
+        return qRgba( red, green, blue, alpha );
+      }
+
+      //opacity
+      double currentOpacity = mOpacity;
+      if ( mRasterTransparency )
+      {
+        currentOpacity = mRasterTransparency->alphaValue( val, mOpacity * 255 ) / 255.0;
+      }
+      return qRgba( currentOpacity * red, currentOpacity * green, currentOpacity * blue, currentOpacity * alpha );
+    };
+    qgsRasterMapBlockValues( inputBlock.get(), reinterpret_cast< QRgb * >( outputBlock->bits() ), myDefaultColor, colorForValue );
+    return outputBlock.release();
+  }
+
   for ( qgssize i = 0; i < ( qgssize )width * height; i++ )
   {
     if ( inputBlock->isNoData( i ) )
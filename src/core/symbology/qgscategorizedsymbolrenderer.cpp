@@ -416,6 +416,16 @@ void QgsCategorizedSymbolRenderer::stopRender( QgsRenderContext &context )
   mExpression.reset();
 }
 
+QgsFeatureRenderer::Capabilities QgsCategorizedSymbolRenderer::capabilities()
+{
+  // features can only be rendered without their geometry if the classification does not use it
+  QgsExpression expression( mAttrName );
+  if ( expression.needsGeometry() )
+    return SymbolLevels | Filter;
+
+  return SymbolLevels | Filter | WkbRendering;
+}
+
 QSet<QString> QgsCategorizedSymbolRenderer::usedAttributes( const QgsRenderContext &context ) const
 {
   QSet<QString> attributes;
@@ -89,7 +89,7 @@ class CORE_EXPORT QgsCategorizedSymbolRenderer : public QgsFeatureRenderer
     virtual QString dump() const override;
     virtual QgsCategorizedSymbolRenderer *clone() const override SIP_FACTORY;
     virtual void toSld( QDomDocument &doc, QDomElement &element, const QgsStringMap &props = QgsStringMap() ) const override;
-    virtual QgsFeatureRenderer::Capabilities capabilities() override { return SymbolLevels | Filter; }
+    virtual QgsFeatureRenderer::Capabilities capabilities() override;
     virtual QString filter( const QgsFields &fields = QgsFields() ) override;
     virtual QgsSymbolList symbols( QgsRenderContext &context ) override;
 
@@ -413,6 +413,16 @@ void QgsGraduatedSymbolRenderer::stopRender( QgsRenderContext &context )
   }
 }
 
+QgsFeatureRenderer::Capabilities QgsGraduatedSymbolRenderer::capabilities()
+{
+  // features can only be rendered without their geometry if the classification does not use it
+  QgsExpression expression( mAttrName );
+  if ( expression.needsGeometry() )
+    return SymbolLevels | Filter;
+
+  return SymbolLevels | Filter | WkbRendering;
+}
+
 QSet<QString> QgsGraduatedSymbolRenderer::usedAttributes( const QgsRenderContext &context ) const
 {
   QSet<QString> attributes;
@@ -146,7 +146,7 @@ class CORE_EXPORT QgsGraduatedSymbolRenderer : public QgsFeatureRenderer
     virtual QString dump() const override;
     virtual QgsGraduatedSymbolRenderer *clone() const override SIP_FACTORY;
     virtual void toSld( QDomDocument &doc, QDomElement &element, const QgsStringMap &props = QgsStringMap() ) const override;
-    virtual QgsFeatureRenderer::Capabilities capabilities() override { return SymbolLevels | Filter; }
+    virtual QgsFeatureRenderer::Capabilities capabilities() override;
     virtual QgsSymbolList symbols( QgsRenderContext &context ) override;
 
     QString classAttribute() const { return mAttrName; }
@@ -30,6 +30,47 @@
 
 #include <QDomDocument>
 #include <QDomElement>
+#include <QMutex>
+#include <QThread>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <cstring>
+
+///@cond PRIVATE
+
+// Number of points whose kernels are added to the density grid at once
+static const size_t POINT_BATCH_SIZE = 65536;
+
+// Maximum number of points kept until the end of a redraw, for reusing the cached density grid
+static const qint64 MAX_DEFERRED_POINTS = 2000000;
+
+/*
+ * The density grid of the last redraw, with the grid size, radius and checksum of the points
+ * it was computed from. Shared by the clones of a renderer, which may render concurrently.
+ */
+class QgsHeatmapDensityCache
+{
+  public:
+    QMutex mutex;
+    bool valid = false;
+    int width = 0;
+    int height = 0;
+    int radius = 0;
+    quint64 checksum = 0;
+    qint64 pointCount = 0;
+    QVector<double> values;
+    double maxValue = 0;
+};
+
+// Adds the values identifying a point to a checksum of points
+static quint64 addToChecksum( quint64 checksum, quint64 value )
+{
+  // FNV-1a on 64 bit words
+  return ( checksum ^ value ) * Q_UINT64_C( 1099511628211 );
+}
+
+///@endcond
 
 QgsHeatmapRenderer::QgsHeatmapRenderer()
   : QgsFeatureRenderer( QStringLiteral( "heatmapRenderer" ) )
@@ -43,6 +84,7 @@ QgsHeatmapRenderer::QgsHeatmapRenderer()
   , mExplicitMax( 0.0 )
   , mRenderQuality( 3 )
   , mFeaturesRendered( 0 )
+  , mDensityCache( std::make_shared< QgsHeatmapDensityCache >() )
 {
   mGradientRamp = new QgsGradientColorRamp( QColor( 255, 255, 255 ), QColor( 0, 0, 0 ) );
 
@@ -61,6 +103,94 @@ void QgsHeatmapRenderer::initializeValues( QgsRenderContext &context )
   mFeaturesRendered = 0;
   mRadiusPixels = std::round( context.convertToPainterUnits( mRadius, mRadiusUnit, mRadiusMapUnitScale ) / mRenderQuality );
   mRadiusSquared = mRadiusPixels * mRadiusPixels;
+  mGridWidth = context.painter()->device()->width() / mRenderQuality;
+  mGridHeight = context.painter()->device()->height() / mRenderQuality;
+
+  // the kernel only depends on the offset of the cell from the point, in [-radius, radius[
+  const int stencilSize = 2 * std::max( mRadiusPixels, 0 );
+  mKernelStencil.assign( static_cast< size_t >( stencilSize ) * stencilSize, -1.0 );
+  for ( int dy = -mRadiusPixels; dy < mRadiusPixels; ++dy )
+  {
+    for ( int dx = -mRadiusPixels; dx < mRadiusPixels; ++dx )
+    {
+      double distanceSquared = std::pow( dx, 2.0 ) + std::pow( dy, 2.0 );
+      if ( distanceSquared > mRadiusSquared )
+      {
+        continue;
+      }
+      mKernelStencil[( dy + mRadiusPixels ) * stencilSize + dx + mRadiusPixels ] = quarticKernel( std::sqrt( distanceSquared ), mRadiusPixels );
+    }
+  }
+
+  mPendingPoints.clear();
+  mDeferPoints = true;
+  mPointsChecksum = 0;
+  mPointCount = 0;
+}
+
+void QgsHeatmapRenderer::addPendingPoints()
+{
+  if ( mPendingPoints.empty() )
+    return;
+
+  const int width = mGridWidth;
+  const int height = std::min( mGridHeight, mValues.count() / std::max( width, 1 ) );
+  const int radius = mRadiusPixels;
+  const int stencilSize = 2 * std::max( radius, 0 );
+  double *values = mValues.data();
+
+  // each thread adds the kernels to a band of rows, in the order of the points, and returns its maximum value
+  auto addToRows = [this, width, radius, stencilSize, values]( int firstRow, int endRow ) -> double
+  {
+    double maxValue = 0;
+    for ( const DensityPoint &point : mPendingPoints )
+    {
+      const int firstY = std::max( point.y - radius, firstRow );
+      const int endY = std::min( point.y + radius, endRow );
+      if ( firstY >= endY )
+        continue;
+
+      const int firstX = std::max( point.x - radius, 0 );
+      const int endX = std::min( point.x + radius, width );
+      for ( int y = firstY; y < endY; ++y )
+      {
+        const double *kernel = mKernelStencil.data() + static_cast< size_t >( y - point.y + radius ) * stencilSize;
+        double *row = values + static_cast< size_t >( y ) * width;
+        for ( int x = firstX; x < endX; ++x )
+        {
+          const double kernelValue = kernel[ x - point.x + radius ];
+          if ( kernelValue < 0 )
+          {
+            continue;
+          }
+
+          double value = row[x] + point.weight * kernelValue;
+          if ( value > maxValue )
+          {
+            maxValue = value;
+          }
+          row[x] = value;
+        }
+      }
+    }
+    return maxValue;
+  };
+
+  const int threadCount = mPendingPoints.size() < 1024 ? 1 : std::max( 1, std::min( QThread::idealThreadCount(), height ) );
+  const int bandRows = ( height + threadCount - 1 ) / std::max( threadCount, 1 );
+  QList< QFuture< double > > futures;
+  for ( int firstRow = bandRows; firstRow < height; firstRow += bandRows )
+  {
+    futures << QtConcurrent::run( addToRows, firstRow, std::min( firstRow + bandRows, height ) );
+  }
+  double maxValue = addToRows( 0, std::min( bandRows, height ) );
+  for ( QFuture< double > &future : futures )
+  {
+    maxValue = std::max( maxValue, future.result() );
+  }
+  mCalculatedMaxValue = std::max( mCalculatedMaxValue, maxValue );
+
+  mPendingPoints.clear();
 }
 
 void QgsHeatmapRenderer::startRender( QgsRenderContext &context, const QgsFields &fields )
@@ -136,9 +266,6 @@ bool QgsHeatmapRenderer::renderFeature( QgsFeature &feature, QgsRenderContext &c
     }
   }
 
-  int width = context.painter()->device()->width() / mRenderQuality;
-  int height = context.painter()->device()->height() / mRenderQuality;
-
   //transform geometry if required
   QgsGeometry geom = feature.geometry();
   QgsCoordinateTransform xform = context.coordinateTransform();
@@ -154,32 +281,26 @@ bool QgsHeatmapRenderer::renderFeature( QgsFeature &feature, QgsRenderContext &c
   for ( QgsMultiPoint::const_iterator pointIt = multiPoint.constBegin(); pointIt != multiPoint.constEnd(); ++pointIt )
   {
     QgsPointXY pixel = context.mapToPixel().transform( *pointIt );
-    int pointX = pixel.x() / mRenderQuality;
-    int pointY = pixel.y() / mRenderQuality;
-    for ( int x = std::max( pointX - mRadiusPixels, 0 ); x < std::min( pointX + mRadiusPixels, width ); ++x )
-    {
-      for ( int y = std::max( pointY - mRadiusPixels, 0 ); y < std::min( pointY + mRadiusPixels, height ); ++y )
-      {
-        int index = y * width + x;
-        if ( index >= mValues.count() )
-        {
-          continue;
-        }
-        double distanceSquared = std::pow( pointX - x, 2.0 ) + std::pow( pointY - y, 2.0 );
-        if ( distanceSquared > mRadiusSquared )
-        {
-          continue;
-        }
+    DensityPoint point;
+    point.x = static_cast< int >( pixel.x() / mRenderQuality );
+    point.y = static_cast< int >( pixel.y() / mRenderQuality );
+    point.weight = weight;
+    mPendingPoints.push_back( point );
+
+    quint64 weightBits;
+    memcpy( &weightBits, &weight, sizeof( weightBits ) );
+    mPointsChecksum = addToChecksum( addToChecksum( addToChecksum( mPointsChecksum, static_cast< quint32 >( point.x ) ), static_cast< quint32 >( point.y ) ), weightBits );
+    ++mPointCount;
+  }
 
-        double score = weight * quarticKernel( std::sqrt( distanceSquared ), mRadiusPixels );
-        double value = mValues.at( index ) + score;
-        if ( value > mCalculatedMaxValue )
-        {
-          mCalculatedMaxValue = value;
-        }
-        mValues[ index ] = value;
-      }
-    }
+  // kernels are added in batches, unless the points are kept for reusing the cached density grid
+  if ( mDeferPoints && mPointCount > MAX_DEFERRED_POINTS )
+  {
+    mDeferPoints = false;
+  }
+  if ( !mDeferPoints && mPendingPoints.size() >= POINT_BATCH_SIZE )
+  {
+    addPendingPoints();
   }
 
   mFeaturesRendered++;
@@ -223,8 +344,50 @@ double QgsHeatmapRenderer::triangularKernel( const double distance, const int ba
 
 void QgsHeatmapRenderer::stopRender( QgsRenderContext &context )
 {
+  if ( context.painter() )
+  {
+    bool cached = false;
+    if ( mDeferPoints )
+    {
+      QMutexLocker locker( &mDensityCache->mutex );
+      if ( mDensityCache->valid && mDensityCache->width == mGridWidth && mDensityCache->height == mGridHeight
+           && mDensityCache->radius == mRadiusPixels && mDensityCache->pointCount == mPointCount
+           && mDensityCache->checksum == mPointsChecksum && mDensityCache->values.count() == mValues.count() )
+      {
+        mValues = mDensityCache->values;
+        mCalculatedMaxValue = mDensityCache->maxValue;
+        mPendingPoints.clear();
+        cached = true;
+      }
+    }
+
+    if ( !cached )
+    {
+      addPendingPoints();
+
+      QMutexLocker locker( &mDensityCache->mutex );
+      mDensityCache->valid = mDeferPoints;
+      if ( mDeferPoints )
+      {
+        mDensityCache->width = mGridWidth;
+        mDensityCache->height = mGridHeight;
+        mDensityCache->radius = mRadiusPixels;
+        mDensityCache->pointCount = mPointCount;
+        mDensityCache->checksum = mPointsChecksum;
+        mDensityCache->values = mValues;
+        mDensityCache->maxValue = mCalculatedMaxValue;
+      }
+      else
+      {
+        mDensityCache->values.clear();
+      }
+    }
+  }
+
   renderImage( context );
   mWeightExpression.reset();
+  mPendingPoints.clear();
+  mPendingPoints.shrink_to_fit();
 }
 
 void QgsHeatmapRenderer::renderImage( QgsRenderContext &context )
@@ -241,23 +404,42 @@ void QgsHeatmapRenderer::renderImage( QgsRenderContext &context )
 
   double scaleMax = mExplicitMax > 0 ? mExplicitMax : mCalculatedMaxValue;
 
-  int idx = 0;
-  double pixVal = 0;
-  QColor pixColor;
-  for ( int heightIndex = 0; heightIndex < image.height(); ++heightIndex )
+  // most cells are usually empty
+  const QRgb emptyColor = mGradientRamp->color( 0 ).rgba();
+  const int width = image.width();
+  const int height = image.height();
+  uchar *bits = image.bits();
+  const int bytesPerLine = image.bytesPerLine();
+
+  // bands of rows are converted concurrently
+  auto convertRows = [this, scaleMax, emptyColor, width, bits, bytesPerLine]( int firstRow, int endRow )
   {
-    QRgb *scanLine = reinterpret_cast< QRgb * >( image.scanLine( heightIndex ) );
-    for ( int widthIndex = 0; widthIndex < image.width(); ++widthIndex )
+    for ( int heightIndex = firstRow; heightIndex < endRow; ++heightIndex )
     {
-      //scale result to fit in the range [0, 1]
-      pixVal = mValues.at( idx ) > 0 ? std::min( ( mValues.at( idx ) / scaleMax ), 1.0 ) : 0;
-
-      //convert value to color from ramp
-      pixColor = mGradientRamp->color( pixVal );
+      QRgb *scanLine = reinterpret_cast< QRgb * >( bits + static_cast< size_t >( heightIndex ) * bytesPerLine );
+      int idx = heightIndex * width;
+      for ( int widthIndex = 0; widthIndex < width; ++widthIndex, ++idx )
+      {
+        //scale result to fit in the range [0, 1]
+        double pixVal = mValues.at( idx ) > 0 ? std::min( ( mValues.at( idx ) / scaleMax ), 1.0 ) : 0;
 
-      scanLine[widthIndex] = pixColor.rgba();
-      idx++;
+        //convert value to color from ramp
+        scanLine[widthIndex] = pixVal == 0 ? emptyColor : mGradientRamp->color( pixVal ).rgba();
+      }
     }
+  };
+
+  const int threadCount = std::max( 1, std::min( QThread::idealThreadCount(), height ) );
+  const int bandRows = std::max( 1, ( height + threadCount - 1 ) / threadCount );
+  QList< QFuture< void > > futures;
+  for ( int firstRow = bandRows; firstRow < height; firstRow += bandRows )
+  {
+    futures << QtConcurrent::run( convertRows, firstRow, std::min( firstRow + bandRows, height ) );
+  }
+  convertRows( 0, std::min( bandRows, height ) );
+  for ( QFuture< void > &future : futures )
+  {
+    future.waitForFinished();
   }
 
   if ( mRenderQuality > 1 )
@@ -290,6 +472,7 @@ QgsHeatmapRenderer *QgsHeatmapRenderer::clone() const
   newRenderer->setMaximumValue( mExplicitMax );
   newRenderer->setRenderQuality( mRenderQuality );
   newRenderer->setWeightExpression( mWeightExpressionString );
+  newRenderer->mDensityCache = mDensityCache;
   copyRendererData( newRenderer );
 
   return newRenderer;
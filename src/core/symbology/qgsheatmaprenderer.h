@@ -22,11 +22,20 @@
 #include "qgsexpression.h"
 #include "qgsgeometry.h"
 
+#include <memory>
+#include <vector>
+
 class QgsColorRamp;
+class QgsHeatmapDensityCache;
 
 /** \ingroup core
  * \class QgsHeatmapRenderer
  * \brief A renderer which draws points as a live heatmap
+ *
+ * The kernels of the points are added to the density grid in batches, by several threads which
+ * each own a band of rows of the grid. The density grid is kept between redraws, and reused
+ * when a redraw renders the same points at the same pixel positions (e.g. when another layer
+ * changed).
  * \since QGIS 2.7
  */
 class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
@@ -165,10 +174,32 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
 
   private:
 
+    //! A point whose kernel is added to the density grid, in grid cells
+    struct DensityPoint
+    {
+      int x;
+      int y;
+      double weight;
+    };
+
     QVector<double> mValues;
 
     double mCalculatedMaxValue;
 
+    int mGridWidth = 0;
+    int mGridHeight = 0;
+    //! Kernel values by offset from the point, negative outside the radius
+    std::vector< double > mKernelStencil;
+    //! Points whose kernels are not yet added to the density grid
+    std::vector< DensityPoint > mPendingPoints;
+    //! Whether all points are kept until stopRender(), so that the cached density grid can be used instead
+    bool mDeferPoints = false;
+    //! Checksum of the rendered points, identifying the density grid
+    quint64 mPointsChecksum = 0;
+    qint64 mPointCount = 0;
+    //! Density grid of the last redraw, shared by the clones of the renderer
+    std::shared_ptr< QgsHeatmapDensityCache > mDensityCache;
+
     double mRadius;
     int mRadiusPixels;
     double mRadiusSquared;
@@ -194,6 +225,8 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
 
     QgsMultiPoint convertToMultipoint( const QgsGeometry *geom );
     void initializeValues( QgsRenderContext &context );
+    //! Adds the kernels of the pending points to the density grid
+    void addPendingPoints();
     void renderImage( QgsRenderContext &context );
 };
 
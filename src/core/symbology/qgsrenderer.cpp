@@ -32,6 +32,7 @@
 #include "qgspainteffect.h"
 #include "qgseffectstack.h"
 #include "qgspainteffectregistry.h"
+#include "qgswkbgeometryview.h"
 #include "qgswkbptr.h"
 #include "qgspoint.h"
 #include "qgsproperty.h"
@@ -110,6 +111,24 @@ void QgsFeatureRenderer::renderFeatureWithSymbol( QgsFeature &feature, QgsSymbol
   symbol->renderFeature( feature, context, layer, selected, drawVertexMarker, mCurrentVertexMarkerType, mCurrentVertexMarkerSize );
 }
 
+bool QgsFeatureRenderer::renderFeatureWkb( QgsFeature &feature, const QgsWkbGeometryView &geometry, QgsRenderContext &context, bool selected )
+{
+  QgsSymbol *symbol = symbolForFeature( feature, context );
+  if ( !symbol )
+    return false;
+
+  if ( symbol->canRenderWkb( context ) )
+  {
+    symbol->renderWkb( geometry, feature, context, -1, selected );
+  }
+  else
+  {
+    feature.setGeometry( geometry.toGeometry() );
+    renderFeatureWithSymbol( feature, symbol, context, -1, selected, false );
+  }
+  return true;
+}
+
 QString QgsFeatureRenderer::dump() const
 {
   return QStringLiteral( "UNKNOWN RENDERER\n" );
@@ -37,6 +37,7 @@ class QgsFeature;
 class QgsVectorLayer;
 class QgsPaintEffect;
 class QgsReadWriteContext;
+class QgsWkbGeometryView;
 
 typedef QMap<QString, QString> QgsStringMap SIP_SKIP;
 
@@ -209,6 +210,18 @@ class CORE_EXPORT QgsFeatureRenderer
      */
     virtual bool renderFeature( QgsFeature &feature, QgsRenderContext &context, int layer = -1, bool selected = false, bool drawVertexMarker = false );
 
+    /**
+     * Renders a \a feature whose \a geometry is read straight from WKB, without building the feature
+     * geometry when the symbol for the feature allows it (see QgsSymbol::canRenderWkb()). The geometry
+     * of the \a feature itself is not used, it is only set if the symbol needs it.
+     * Must only be called for renderers with the WkbRendering capability, between startRender()
+     * and stopRender() calls.
+     * Returns true if the feature has been rendered.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    bool renderFeatureWkb( QgsFeature &feature, const QgsWkbGeometryView &geometry, QgsRenderContext &context, bool selected = false ) SIP_SKIP;
+
     //! Returns debug information about this renderer
     virtual QString dump() const;
 
@@ -221,7 +234,8 @@ class CORE_EXPORT QgsFeatureRenderer
       SymbolLevels          = 1,      //!< Rendering with symbol levels (i.e. implements symbols(), symbolForFeature())
       MoreSymbolsPerFeature = 1 << 2, //!< May use more than one symbol to render a feature: symbolsForFeature() will return them
       Filter                = 1 << 3, //!< Features may be filtered, i.e. some features may not be rendered (categorized, rule based ...)
-      ScaleDependent        = 1 << 4  //!< Depends on scale if feature will be rendered (rule based )
+      ScaleDependent        = 1 << 4, //!< Depends on scale if feature will be rendered (rule based )
+      WkbRendering          = 1 << 5  //!< Renders features with the default renderFeature() and a symbolForFeature() which does not use the feature geometry, so features can be rendered with renderFeatureWkb() (since QGIS 3.0)
     };
 
     Q_DECLARE_FLAGS( Capabilities, Capability )
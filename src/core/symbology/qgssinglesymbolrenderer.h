@@ -49,7 +49,7 @@ class CORE_EXPORT QgsSingleSymbolRenderer : public QgsFeatureRenderer
     virtual void toSld( QDomDocument &doc, QDomElement &element, const QgsStringMap &props = QgsStringMap() ) const override;
     static QgsFeatureRenderer *createFromSld( QDomElement &element, QgsWkbTypes::GeometryType geomType );
 
-    virtual QgsFeatureRenderer::Capabilities capabilities() override { return SymbolLevels; }
+    virtual QgsFeatureRenderer::Capabilities capabilities() override { return SymbolLevels | WkbRendering; }
     virtual QgsSymbolList symbols( QgsRenderContext &context ) override;
 
     //! create renderer from XML element
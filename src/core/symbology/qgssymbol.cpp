@@ -38,6 +38,7 @@
 #include "qgslinestring.h"
 #include "qgspolygon.h"
 #include "qgsclipper.h"
+#include "qgswkbgeometryview.h"
 #include "qgsproperty.h"
 
 #include <QColor>
@@ -99,77 +100,90 @@ QgsSymbol::QgsSymbol( SymbolType type, const QgsSymbolLayerList &layers )
   }
 }
 
+///@cond PRIVATE
+
+// Transforms points in map coordinates to screen coordinates
+static void transformToScreen( QgsRenderContext &context, QPolygonF &pts )
+{
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+  const QgsMapToPixel &mtp = context.mapToPixel();
+
+  //transform the QPolygonF to screen coordinates
+  if ( ct.isValid() )
+  {
+    ct.transformPolygon( pts );
+  }
+
+  mtp.transformInPlace( pts );
+}
+
+// Returns the clipping rectangle for lines and polygon rings, slightly larger than the extent of the context
+static QgsRectangle clipRectangle( const QgsRenderContext &context )
+{
+  const QgsRectangle &e = context.extent();
+  const double cw = e.width() / 10;
+  const double ch = e.height() / 10;
+  return QgsRectangle( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
+}
+
+///@endcond
+
 QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
   const unsigned int nPoints = curve.numPoints();
 
-  QgsCoordinateTransform ct = context.coordinateTransform();
-  const QgsMapToPixel &mtp = context.mapToPixel();
   QPolygonF pts;
 
   //apply clipping for large lines to achieve a better rendering performance
   if ( clipToExtent && nPoints > 1 )
   {
-    const QgsRectangle &e = context.extent();
-    const double cw = e.width() / 10;
-    const double ch = e.height() / 10;
-    const QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
-    pts = QgsClipper::clippedLine( curve, clipRect );
+    pts = QgsClipper::clippedLine( curve, clipRectangle( context ) );
   }
   else
   {
     pts = curve.asQPolygonF();
   }
 
-  //transform the QPolygonF to screen coordinates
-  if ( ct.isValid() )
+  transformToScreen( context, pts );
+  return pts;
+}
+
+QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QPolygonF &points, bool clipToExtent )
+{
+  QPolygonF pts;
+
+  //apply clipping for large lines to achieve a better rendering performance
+  if ( clipToExtent && points.size() > 1 )
   {
-    ct.transformPolygon( pts );
+    pts = QgsClipper::clippedLine( points, clipRectangle( context ) );
   }
-
-  QPointF *ptr = pts.data();
-  for ( int i = 0; i < pts.size(); ++i, ++ptr )
+  else
   {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
+    pts = points;
   }
 
+  transformToScreen( context, pts );
   return pts;
 }
 
 QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
-  const QgsCoordinateTransform ct = context.coordinateTransform();
-  const QgsMapToPixel &mtp = context.mapToPixel();
-  const QgsRectangle &e = context.extent();
-  const double cw = e.width() / 10;
-  const double ch = e.height() / 10;
-  QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
-
-  QPolygonF poly = curve.asQPolygonF();
+  return _getPolygonRing( context, curve.asQPolygonF(), clipToExtent );
+}
 
-  if ( curve.numPoints() < 1 )
+QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, QPolygonF points, bool clipToExtent )
+{
+  if ( points.isEmpty() )
     return QPolygonF();
 
-  //clip close to view extent, if needed
-  const QRectF ptsRect = poly.boundingRect();
-  if ( clipToExtent && !context.extent().contains( ptsRect ) )
-  {
-    QgsClipper::trimPolygon( poly, clipRect );
-  }
-
-  //transform the QPolygonF to screen coordinates
-  if ( ct.isValid() )
-  {
-    ct.transformPolygon( poly );
-  }
-
-  QPointF *ptr = poly.data();
-  for ( int i = 0; i < poly.size(); ++i, ++ptr )
+  //clip close to view extent, if needed. Rings inside the extent are left unchanged by the clipper
+  if ( clipToExtent )
   {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
+    QgsClipper::trimPolygon( points, clipRectangle( context ) );
   }
 
-  return poly;
+  transformToScreen( context, points );
+  return points;
 }
 
 void QgsSymbol::_getPolygon( QPolygonF &pts, QList<QPolygonF> &holes, QgsRenderContext &context, const QgsPolygonV2 &polygon, bool clipToExtent )
@@ -820,13 +834,19 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
         markers.reserve( mp.numGeometries() );
       }
 
+      // transform all points in one batch
+      QPolygonF points;
+      points.reserve( mp.numGeometries() );
+      for ( int i = 0; i < mp.numGeometries(); ++i )
+        points << static_cast< const QgsPoint * >( mp.geometryN( i ) )->toQPointF();
+      transformToScreen( context, points );
+
       for ( int i = 0; i < mp.numGeometries(); ++i )
       {
         mSymbolRenderContext->setGeometryPartNum( i + 1 );
         mSymbolRenderContext->expressionContextScope()->addVariable( QgsExpressionContextScope::StaticVariable( QgsExpressionContext::EXPR_GEOMETRY_PART_NUM, i + 1, true ) );
 
-        const QgsPoint &point = static_cast< const QgsPoint & >( *mp.geometryN( i ) );
-        const QPointF pt = _getPoint( context, point );
+        const QPointF pt = points.at( i );
         static_cast<QgsMarkerSymbol *>( this )->renderPoint( pt, &feature, context, layer, selected );
 
         if ( drawVertexMarker && !usingSegmentizedGeometry )
@@ -992,6 +1012,153 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
   }
 }
 
+bool QgsSymbol::canRenderWkb( const QgsRenderContext &context ) const
+{
+  if ( context.vectorSimplifyMethod().forceLocalOptimization()
+       && context.vectorSimplifyMethod().simplifyHints() != QgsVectorSimplifyMethod::NoSimplification )
+    return false;
+
+  // some marker symbol layers only account for the map rotation when the feature has a point geometry
+  if ( !qgsDoubleNear( context.mapToPixel().mapRotation(), 0.0 ) )
+    return false;
+
+  Q_FOREACH ( QgsSymbolLayer *layer, mLayers )
+  {
+    if ( layer->dataDefinedProperties().hasActiveProperties() )
+      return false;
+
+    // these symbol layers work on the geometry of the feature
+    if ( layer->layerType() == QLatin1String( "GeometryGenerator" ) || layer->layerType() == QLatin1String( "CentroidFill" ) )
+      return false;
+
+    if ( layer->subSymbol() && !layer->subSymbol()->canRenderWkb( context ) )
+      return false;
+  }
+  return true;
+}
+
+void QgsSymbol::renderWkb( const QgsWkbGeometryView &geometry, const QgsFeature &feature, QgsRenderContext &context, int layer, bool selected )
+{
+  if ( !geometry.isValid() )
+    return;
+
+  context.setGeometry( nullptr );
+  const bool clipToExtent = !context.testFlag( QgsRenderContext::RenderMapTile ) && clipFeaturesToExtent();
+  const int partCount = geometry.partCount();
+
+  mSymbolRenderContext->setGeometryPartCount( partCount );
+  mSymbolRenderContext->setGeometryPartNum( 1 );
+
+  ExpressionContextScopePopper scopePopper;
+  if ( mSymbolRenderContext->expressionContextScope() )
+  {
+    // see renderFeature() for the ownership of the scope
+    context.expressionContext().appendScope( mSymbolRenderContext->expressionContextScope() );
+    scopePopper.context = &context.expressionContext();
+
+    QgsExpressionContextUtils::updateSymbolScope( this, mSymbolRenderContext->expressionContextScope() );
+    mSymbolRenderContext->expressionContextScope()->addVariable( QgsExpressionContextScope::StaticVariable( QgsExpressionContext::EXPR_GEOMETRY_PART_COUNT, partCount, true ) );
+    mSymbolRenderContext->expressionContextScope()->addVariable( QgsExpressionContextScope::StaticVariable( QgsExpressionContext::EXPR_GEOMETRY_PART_NUM, 1, true ) );
+  }
+
+  auto setPartNum = [this]( int part )
+  {
+    mSymbolRenderContext->setGeometryPartNum( part + 1 );
+    if ( mSymbolRenderContext->expressionContextScope() )
+      mSymbolRenderContext->expressionContextScope()->addVariable( QgsExpressionContextScope::StaticVariable( QgsExpressionContext::EXPR_GEOMETRY_PART_NUM, part + 1, true ) );
+  };
+
+  switch ( QgsWkbTypes::flatType( QgsWkbTypes::singleType( geometry.wkbType() ) ) )
+  {
+    case QgsWkbTypes::Point:
+    {
+      if ( mType != QgsSymbol::Marker )
+      {
+        QgsDebugMsg( "point can be drawn only with marker symbol!" );
+        break;
+      }
+
+      // transform all points in one batch
+      QPolygonF points;
+      points.reserve( partCount );
+      for ( int i = 0; i < partCount; ++i )
+        points << geometry.part( i ).point();
+      transformToScreen( context, points );
+
+      for ( int i = 0; i < partCount; ++i )
+      {
+        setPartNum( i );
+        static_cast<QgsMarkerSymbol *>( this )->renderPoint( points.at( i ), &feature, context, layer, selected );
+      }
+      break;
+    }
+
+    case QgsWkbTypes::LineString:
+    {
+      if ( mType != QgsSymbol::Line )
+      {
+        QgsDebugMsg( "linestring can be drawn only with line symbol!" );
+        break;
+      }
+
+      for ( int i = 0; i < partCount; ++i )
+      {
+        setPartNum( i );
+        const QPolygonF pts = _getLineString( context, geometry.part( i ).lineString(), clipToExtent );
+        static_cast<QgsLineSymbol *>( this )->renderPolyline( pts, &feature, context, layer, selected );
+      }
+      break;
+    }
+
+    case QgsWkbTypes::Polygon:
+    {
+      if ( mType != QgsSymbol::Fill )
+      {
+        QgsDebugMsg( "polygon can be drawn only with fill symbol!" );
+        break;
+      }
+
+      QVector< QList<QPolygonF> > parts( partCount );
+      std::map<double, QList<int> > mapAreaToPartNum;
+      for ( int i = 0; i < partCount; ++i )
+      {
+        parts[i] = geometry.part( i ).rings();
+        const QRectF r = parts.at( i ).isEmpty() ? QRectF() : parts.at( i ).first().boundingRect();
+        mapAreaToPartNum[ r.width() * r.height()] << i;
+      }
+
+      // draw larger parts first, like renderFeature() does
+      std::map<double, QList<int> >::const_reverse_iterator iter = mapAreaToPartNum.rbegin();
+      for ( ; iter != mapAreaToPartNum.rend(); ++iter )
+      {
+        Q_FOREACH ( int i, iter->second )
+        {
+          const QList<QPolygonF> &rings = parts.at( i );
+          if ( rings.isEmpty() )
+          {
+            QgsDebugMsg( "cannot render polygon with no exterior ring" );
+            continue;
+          }
+
+          setPartNum( i );
+          const QPolygonF pts = _getPolygonRing( context, rings.at( 0 ), clipToExtent );
+          QList<QPolygonF> holes;
+          for ( int ring = 1; ring < rings.count(); ++ring )
+          {
+            const QPolygonF hole = _getPolygonRing( context, rings.at( ring ), clipToExtent );
+            if ( !hole.isEmpty() ) holes.append( hole );
+          }
+          static_cast<QgsFillSymbol *>( this )->renderPolygon( pts, ( !holes.isEmpty() ? &holes : nullptr ), &feature, context, layer, selected );
+        }
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
 QgsSymbolRenderContext *QgsSymbol::symbolRenderContext()
 {
   return mSymbolRenderContext.get();
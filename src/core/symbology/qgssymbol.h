@@ -48,6 +48,7 @@ class QgsLineSymbolLayer;
 class QgsFillSymbolLayer;
 class QgsSymbolRenderContext;
 class QgsFeatureRenderer;
+class QgsWkbGeometryView;
 class QgsCurve;
 class QgsPolygonV2;
 class QgsExpressionContext;
@@ -304,6 +305,25 @@ class CORE_EXPORT QgsSymbol
      */
     void renderFeature( const QgsFeature &feature, QgsRenderContext &context, int layer = -1, bool selected = false, bool drawVertexMarker = false, int currentVertexMarkerType = 0, int currentVertexMarkerSize = 0 );
 
+    /**
+     * Returns true if the symbol can render geometries read straight from WKB with renderWkb() in
+     * the given \a context. This is not possible when the symbol needs the geometry of the rendered
+     * feature, e.g. for data defined properties or geometry generators, or when the geometries
+     * must be simplified locally.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    bool canRenderWkb( const QgsRenderContext &context ) const SIP_SKIP;
+
+    /**
+     * Renders a \a geometry read straight from WKB, without building geometry objects. The \a feature
+     * provides the attributes of the rendered feature, its geometry is not used.
+     * Must only be called if canRenderWkb() returns true, between startRender() and stopRender() calls.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void renderWkb( const QgsWkbGeometryView &geometry, const QgsFeature &feature, QgsRenderContext &context, int layer = -1, bool selected = false ) SIP_SKIP;
+
     /**
      * Returns the symbol render context. Only valid between startRender and stopRender calls.
      *
@@ -351,6 +371,20 @@ class CORE_EXPORT QgsSymbol
      */
     static void _getPolygon( QPolygonF &pts, QList<QPolygonF> &holes, QgsRenderContext &context, const QgsPolygonV2 &polygon, bool clipToExtent = true );
 
+    /**
+     * Creates a line string in screen coordinates from \a points in map coordinates
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    static QPolygonF _getLineString( QgsRenderContext &context, const QPolygonF &points, bool clipToExtent = true ) SIP_SKIP;
+
+    /**
+     * Creates a polygon ring in screen coordinates from \a points in map coordinates
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    static QPolygonF _getPolygonRing( QgsRenderContext &context, QPolygonF points, bool clipToExtent ) SIP_SKIP;
+
     /**
      * Retrieve a cloned list of all layers that make up this symbol.
      * Ownership is transferred to the caller.
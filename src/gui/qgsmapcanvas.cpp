@@ -426,6 +426,10 @@ void QgsMapCanvas::setCachingEnabled( bool enabled )
   if ( enabled )
   {
     mCache = new QgsMapRendererCache;
+    // optionally keep rendered tiles, so that panning and zooming back reuses them
+    QgsSettings settings;
+    mCache->setTileCacheEnabled( settings.value( QStringLiteral( "qgis/enable_render_tile_caching" ), false ).toBool() );
+    mCache->setTileMemoryBudget( settings.value( QStringLiteral( "qgis/render_tile_cache_size" ), 256 ).toLongLong() * 1024 * 1024 );
   }
   else
   {
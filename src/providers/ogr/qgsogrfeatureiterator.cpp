@@ -19,6 +19,7 @@
 #include "qgssqliteexpressioncompiler.h"
 
 #include "qgsogrutils.h"
+#include "qgsfeaturebatch.h"
 #include "qgsapplication.h"
 #include "qgsgeometry.h"
 #include "qgslogger.h"
@@ -30,6 +31,13 @@
 #include <QTextCodec>
 #include <QFile>
 
+// Starting with GDAL 2.2, there are 2 concepts: unset fields and null fields
+// whereas previously there was only unset fields. For QGIS purposes, both
+// states (unset/null) are equivalent.
+#ifndef OGRNullMarker
+#define OGR_F_IsFieldSetAndNotNull OGR_F_IsFieldSet
+#endif
+
 // using from provider:
 // - setRelevantFields(), mRelevantFieldsForNextFeature
 // - ogrLayer
@@ -279,6 +287,98 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
   return false;
 }
 
+int QgsOgrFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  if ( mClosed || !ogrLayer )
+    return 0;
+
+  // exact intersection, geometry type filter and reprojection need a QgsGeometry for each feature
+  if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect
+       || mSource->mOgrGeometryTypeFilter != wkbUnknown
+       || mTransform.isValid() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxFeatures );
+
+  int fetched = 0;
+  OGRFeatureH fet;
+  while ( fetched < maxFeatures && ( fet = OGR_L_GetNextFeature( ogrLayer ) ) )
+  {
+    if ( !mFilterRect.isNull() && !OGR_F_GetGeometryRef( fet ) )
+    {
+      OGR_F_Destroy( fet );
+      continue;
+    }
+
+    appendFeatureToBatch( fet, batch );
+    OGR_F_Destroy( fet );
+    fetched++;
+  }
+
+  if ( fetched == 0 )
+    close();
+
+  return fetched;
+}
+
+void QgsOgrFeatureIterator::appendFeatureToBatch( OGRFeatureH fet, QgsFeatureBatch &batch ) const
+{
+  batch.appendRow( mOrigFidAdded ? OGR_F_GetFieldAsInteger64( fet, 0 ) : OGR_F_GetFID( fet ) );
+
+  OGRGeometryH geom = mFetchGeometry ? OGR_F_GetGeometryRef( fet ) : nullptr;
+  if ( geom )
+  {
+    if ( QgsWkbTypes::isMultiType( mSource->mWkbType )
+         && !QgsWkbTypes::isMultiType( static_cast< QgsWkbTypes::Type >( wkbFlatten( OGR_G_GetGeometryType( geom ) ) ) ) )
+    {
+      // insure that multipart datasets return multipart geometry
+      QgsGeometry g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
+      g.convertToMultiType();
+      batch.setGeometry( g );
+    }
+    else
+    {
+      // export the WKB straight into the batch buffer
+      int size = OGR_G_WkbSize( geom );
+      OGR_G_ExportToWkb( geom, ( OGRwkbByteOrder ) QgsApplication::endian(), batch.appendWkb( size ) );
+    }
+  }
+
+  const QgsAttributeList attributes = batch.attributes();
+  for ( int column = 0; column < batch.columnCount(); ++column )
+  {
+    int attindex = attributes.at( column );
+    if ( mSource->mFirstFieldIsFid && attindex == 0 )
+    {
+      batch.setInteger( column, static_cast<qint64>( OGR_F_GetFID( fet ) ) );
+      continue;
+    }
+
+    int ogrIndex = ( mSource->mFirstFieldIsFid ) ? attindex - 1 : attindex;
+    if ( !OGR_F_IsFieldSetAndNotNull( fet, ogrIndex ) )
+      continue;
+
+    switch ( batch.columnType( column ) )
+    {
+      case QgsFeatureBatch::DoubleColumn:
+        batch.setDouble( column, OGR_F_GetFieldAsDouble( fet, ogrIndex ) );
+        break;
+
+      case QgsFeatureBatch::IntegerColumn:
+        batch.setInteger( column, OGR_F_GetFieldAsInteger64( fet, ogrIndex ) );
+        break;
+
+      case QgsFeatureBatch::StringColumn:
+        if ( mSource->mEncoding )
+          batch.setString( column, mSource->mEncoding->toUnicode( OGR_F_GetFieldAsString( fet, ogrIndex ) ) );
+        else
+          batch.setString( column, QString::fromUtf8( OGR_F_GetFieldAsString( fet, ogrIndex ) ) );
+        break;
+
+      case QgsFeatureBatch::VariantColumn:
+        batch.setValue( column, QgsOgrUtils::getOgrFeatureAttribute( fet, mSource->mFieldsWithoutFid, ogrIndex, mSource->mEncoding ) );
+        break;
+    }
+  }
+}
 
 bool QgsOgrFeatureIterator::rewind()
 {
@@ -62,6 +62,7 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
 
   protected:
     virtual bool fetchFeature( QgsFeature &feature ) override;
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
 
   private:
@@ -71,6 +72,9 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
     //! Get an attribute associated with a feature
     void getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature &f, int attindex ) const;
 
+    //! Appends an OGR feature to a batch, reading its attributes straight into the typed columns
+    void appendFeatureToBatch( OGRFeatureH fet, QgsFeatureBatch &batch ) const;
+
     QgsOgrConn *mConn = nullptr;
     OGRLayerH ogrLayer;
 
@@ -12,6 +12,7 @@
  *   (at your option) any later version.                                   *
  *                                                                         *
  ***************************************************************************/
+#include "qgsfeaturebatch.h"
 #include "qgsgeometry.h"
 #include "qgspostgresconnpool.h"
 #include "qgspostgresexpressioncompiler.h"
@@ -26,6 +27,52 @@
 #include <QElapsedTimer>
 #include <QObject>
 
+/**
+ * Converts in place the WKB of a geometry returned by PostGIS into the WKB types of QGIS.
+ * PostGIS stores TIN as a collection of Triangles. Since Triangles are not supported,
+ * they are converted to Polygons.
+ */
+static void convertPostgisWkb( unsigned char *featureGeom )
+{
+  unsigned int wkbType;
+  memcpy( &wkbType, featureGeom + 1, sizeof( wkbType ) );
+  QgsWkbTypes::Type newType = QgsPostgresConn::wkbTypeFromOgcWkbType( wkbType );
+
+  if ( ( unsigned int )newType != wkbType )
+  {
+    // overwrite type
+    unsigned int n = newType;
+    memcpy( featureGeom + 1, &n, sizeof( n ) );
+  }
+
+  const int nDims = 2 + ( QgsWkbTypes::hasZ( newType ) ? 1 : 0 ) + ( QgsWkbTypes::hasM( newType ) ? 1 : 0 );
+  if ( wkbType % 1000 == 16 )
+  {
+    unsigned int numGeoms;
+    memcpy( &numGeoms, featureGeom + 5, sizeof( unsigned int ) );
+    unsigned char *wkb = featureGeom + 9;
+    for ( unsigned int i = 0; i < numGeoms; ++i )
+    {
+      const unsigned int localType = QgsWkbTypes::singleType( newType ); // polygon(Z|M)
+      memcpy( wkb + 1, &localType, sizeof( localType ) );
+
+      // skip endian and type info
+      wkb += sizeof( unsigned int ) + 1;
+
+      // skip coordinates
+      unsigned int nRings;
+      memcpy( &nRings, wkb, sizeof( int ) );
+      wkb += sizeof( int );
+      for ( unsigned int j = 0; j < nRings; ++j )
+      {
+        unsigned int nPoints;
+        memcpy( &nPoints, wkb, sizeof( int ) );
+        wkb += sizeof( nPoints ) + sizeof( double ) * nDims * nPoints;
+      }
+    }
+  }
+}
+
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
   , mFeatureQueueSize( 1 )
@@ -252,41 +299,7 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
     QElapsedTimer timer;
     timer.start();
 
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
-
-    lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
-    {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-    }
-
-    QgsPostgresResult queryResult;
-    for ( ;; )
-    {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
-        break;
-
-      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
-      {
-        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
-      }
-
-      int rows = queryResult.PQntuples();
-      if ( rows == 0 )
-        continue;
-
-      mLastFetch = rows < mFeatureQueueSize;
-
-      for ( int row = 0; row < rows; row++ )
-      {
-        mFeatureQueue.enqueue( QgsFeature() );
-        getFeature( queryResult, row, mFeatureQueue.back() );
-      } // for each row in queue
-    }
-    unlock();
+    fetchRows( mFeatureQueueSize, nullptr );
 
     if ( timer.elapsed() > 500 && mFeatureQueueSize > 1 )
     {
@@ -318,6 +331,93 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
   return true;
 }
 
+int QgsPostgresFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  if ( mClosed )
+    return 0;
+
+  // reprojection needs a QgsGeometry for each feature
+  if ( mTransform.isValid() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxFeatures );
+
+  // features already decoded by fetchFeature() come first
+  int fetched = 0;
+  while ( fetched < maxFeatures && !mFeatureQueue.empty() )
+  {
+    batch.appendFeature( mFeatureQueue.dequeue() );
+    fetched++;
+  }
+
+  while ( fetched < maxFeatures && !mLastFetch )
+  {
+    int rows = fetchRows( maxFeatures - fetched, &batch );
+    if ( rows == 0 )
+      break;
+    fetched += rows;
+  }
+  mFetched += fetched;
+
+  if ( fetched == 0 )
+  {
+    QgsDebugMsg( QString( "Finished after %1 features" ).arg( mFetched ) );
+    close();
+
+    mSource->mShared->ensureFeaturesCountedAtLeast( mFetched );
+  }
+
+  return fetched;
+}
+
+int QgsPostgresFeatureIterator::fetchRows( int count, QgsFeatureBatch *batch )
+{
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( count ).arg( mCursorName );
+  QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( count ), 4 );
+
+  int fetched = 0;
+  lock();
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+  }
+
+  QgsPostgresResult queryResult;
+  for ( ;; )
+  {
+    queryResult = mConn->PQgetResult();
+    if ( !queryResult.result() )
+      break;
+
+    if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+      break;
+    }
+
+    int rows = queryResult.PQntuples();
+    if ( rows == 0 )
+      continue;
+
+    mLastFetch = rows < count;
+
+    for ( int row = 0; row < rows; row++ )
+    {
+      if ( batch )
+      {
+        appendRowToBatch( queryResult, row, *batch );
+      }
+      else
+      {
+        mFeatureQueue.enqueue( QgsFeature() );
+        getFeature( queryResult, row, mFeatureQueue.back() );
+      }
+    } // for each row in queue
+    fetched += rows;
+  }
+  unlock();
+
+  return fetched;
+}
+
 bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   if ( !mExpressionCompiled )
@@ -686,45 +786,7 @@ bool QgsPostgresFeatureIterator::getFeature( QgsPostgresResult &queryResult, int
       memcpy( featureGeom, PQgetvalue( queryResult.result(), row, col ), returnedLength );
       memset( featureGeom + returnedLength, 0, 1 );
 
-      unsigned int wkbType;
-      memcpy( &wkbType, featureGeom + 1, sizeof( wkbType ) );
-      QgsWkbTypes::Type newType = QgsPostgresConn::wkbTypeFromOgcWkbType( wkbType );
-
-      if ( ( unsigned int )newType != wkbType )
-      {
-        // overwrite type
-        unsigned int n = newType;
-        memcpy( featureGeom + 1, &n, sizeof( n ) );
-      }
-
-      // PostGIS stores TIN as a collection of Triangles.
-      // Since Triangles are not supported, they have to be converted to Polygons
-      const int nDims = 2 + ( QgsWkbTypes::hasZ( newType ) ? 1 : 0 ) + ( QgsWkbTypes::hasM( newType ) ? 1 : 0 );
-      if ( wkbType % 1000 == 16 )
-      {
-        unsigned int numGeoms;
-        memcpy( &numGeoms, featureGeom + 5, sizeof( unsigned int ) );
-        unsigned char *wkb = featureGeom + 9;
-        for ( unsigned int i = 0; i < numGeoms; ++i )
-        {
-          const unsigned int localType = QgsWkbTypes::singleType( newType ); // polygon(Z|M)
-          memcpy( wkb + 1, &localType, sizeof( localType ) );
-
-          // skip endian and type info
-          wkb += sizeof( unsigned int ) + 1;
-
-          // skip coordinates
-          unsigned int nRings;
-          memcpy( &nRings, wkb, sizeof( int ) );
-          wkb += sizeof( int );
-          for ( unsigned int j = 0; j < nRings; ++j )
-          {
-            unsigned int nPoints;
-            memcpy( &nPoints, wkb, sizeof( int ) );
-            wkb += sizeof( nPoints ) + sizeof( double ) * nDims * nPoints;
-          }
-        }
-      }
+      convertPostgisWkb( featureGeom );
 
       QgsGeometry g;
       g.fromWkb( featureGeom, returnedLength + 1 );
@@ -824,6 +886,158 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
 }
 
 
+void QgsPostgresFeatureIterator::appendRowToBatch( QgsPostgresResult &queryResult, int row, QgsFeatureBatch &batch )
+{
+  int col = 0;
+
+  // the WKB of the geometry is copied once, straight into the batch buffer
+  int geometryLength = 0;
+  const char *geometry = nullptr;
+  if ( mFetchGeometry )
+  {
+    geometryLength = ::PQgetlength( queryResult.result(), row, col );
+    if ( geometryLength > 0 )
+      geometry = ::PQgetvalue( queryResult.result(), row, col );
+    col++;
+  }
+
+  QgsFeatureId fid = 0;
+  int pkCol = col;
+
+  switch ( mSource->mPrimaryKeyType )
+  {
+    case PktOid:
+    case PktTid:
+      fid = mConn->getBinaryInt( queryResult, row, col++ );
+      break;
+
+    case PktInt:
+    case PktUint64:
+      fid = mConn->getBinaryInt( queryResult, row, col++ );
+      if ( mSource->mPrimaryKeyType == PktInt )
+      {
+        fid = QgsPostgresUtils::int32pk_to_fid( fid );
+      }
+      break;
+
+    case PktFidMap:
+    {
+      QVariantList primaryKeyVals;
+
+      Q_FOREACH ( int idx, mSource->mPrimaryKeyAttrs )
+      {
+        QgsField fld = mSource->mFields.at( idx );
+        primaryKeyVals << QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+        col++;
+      }
+
+      fid = mSource->mShared->lookupFid( primaryKeyVals );
+    }
+    break;
+
+    case PktUnknown:
+      Q_ASSERT( !"FAILURE: cannot get feature with unknown primary key" );
+      return;
+  }
+
+  batch.appendRow( fid );
+  if ( geometry )
+  {
+    unsigned char *wkb = batch.appendWkb( geometryLength );
+    memcpy( wkb, geometry, geometryLength );
+    convertPostgisWkb( wkb );
+  }
+
+  // primary key values, like in getFeature()
+  switch ( mSource->mPrimaryKeyType )
+  {
+    case PktInt:
+    case PktUint64:
+    {
+      const int column = batch.columnIndex( mSource->mPrimaryKeyAttrs.at( 0 ) );
+      if ( column >= 0 )
+        batch.setValue( column, mConn->getBinaryInt( queryResult, row, pkCol ) );
+      break;
+    }
+
+    case PktFidMap:
+      Q_FOREACH ( int idx, mSource->mPrimaryKeyAttrs )
+      {
+        setBatchValue( batch, idx, queryResult, row, pkCol++ );
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  // iterate attributes, in the order of the query columns
+  bool subsetOfAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes;
+  const QgsAttributeList fetchAttributes = subsetOfAttributes ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
+  Q_FOREACH ( int idx, fetchAttributes )
+  {
+    if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
+      continue;
+
+    setBatchValue( batch, idx, queryResult, row, col++ );
+  }
+}
+
+void QgsPostgresFeatureIterator::setBatchValue( QgsFeatureBatch &batch, int idx, QgsPostgresResult &queryResult, int row, int col ) const
+{
+  const int column = batch.columnIndex( idx );
+  if ( column < 0 || queryResult.PQgetisnull( row, col ) )
+    return;
+
+  const QgsField fld = mSource->mFields.at( idx );
+  const char *value = ::PQgetvalue( queryResult.result(), row, col );
+  const int length = ::PQgetlength( queryResult.result(), row, col );
+  bool ok = false;
+  switch ( batch.columnType( column ) )
+  {
+    case QgsFeatureBatch::DoubleColumn:
+    {
+      double d = QByteArray::fromRawData( value, length ).toDouble( &ok );
+      if ( ok )
+        batch.setDouble( column, d );
+      break;
+    }
+
+    case QgsFeatureBatch::IntegerColumn:
+      if ( fld.type() == QVariant::Bool )
+      {
+        // other values are NULL, like in QgsPostgresProvider::convertValue()
+        if ( length == 1 && ( value[0] == 't' || value[0] == 'f' ) )
+          batch.setInteger( column, value[0] == 't' ? 1 : 0 );
+        return;
+      }
+      else if ( fld.type() == QVariant::Int )
+      {
+        int i = QByteArray::fromRawData( value, length ).toInt( &ok );
+        if ( ok )
+          batch.setInteger( column, i );
+      }
+      else
+      {
+        qint64 i = QByteArray::fromRawData( value, length ).toLongLong( &ok );
+        if ( ok )
+          batch.setInteger( column, i );
+      }
+      break;
+
+    case QgsFeatureBatch::StringColumn:
+      batch.setString( column, QString::fromUtf8( value, length ) );
+      return;
+
+    case QgsFeatureBatch::VariantColumn:
+      break;
+  }
+
+  // other values are converted like for single features
+  if ( !ok )
+    batch.setValue( column, QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) ) );
+}
+
 //  ------------------
 
 QgsPostgresFeatureSource::QgsPostgresFeatureSource( const QgsPostgresProvider *p )
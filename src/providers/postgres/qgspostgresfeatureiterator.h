@@ -81,6 +81,7 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
 
   protected:
     virtual bool fetchFeature( QgsFeature &feature ) override;
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
     virtual bool prepareSimplification( const QgsSimplifyMethod &simplifyMethod ) override;
 
@@ -92,6 +93,19 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     QString whereClauseRect();
     bool getFeature( QgsPostgresResult &queryResult, int row, QgsFeature &feature );
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
+
+    /**
+     * Fetches up to \a count rows from the cursor. The rows are appended to \a batch if set,
+     * otherwise they are decoded into features of the feature queue.
+     * \returns number of fetched rows
+     */
+    int fetchRows( int count, QgsFeatureBatch *batch );
+
+    //! Appends a row of a query result to a batch, reading its values straight into the typed columns
+    void appendRowToBatch( QgsPostgresResult &queryResult, int row, QgsFeatureBatch &batch );
+
+    //! Sets the value of a batch column from a row of a query result
+    void setBatchValue( QgsFeatureBatch &batch, int idx, QgsPostgresResult &queryResult, int row, int col ) const;
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
     QString mCursorName;
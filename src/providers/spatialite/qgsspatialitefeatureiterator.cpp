@@ -19,6 +19,7 @@
 #include "qgsspatialiteprovider.h"
 #include "qgssqliteexpressioncompiler.h"
 
+#include "qgsfeaturebatch.h"
 #include "qgsgeometry.h"
 #include "qgslogger.h"
 #include "qgsmessagelog.h"
@@ -252,6 +253,46 @@ bool QgsSpatiaLiteFeatureIterator::fetchFeature( QgsFeature &feature )
   return true;
 }
 
+int QgsSpatiaLiteFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  if ( mClosed )
+    return 0;
+
+  // reprojection needs a QgsGeometry for each feature
+  if ( mTransform.isValid() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxFeatures );
+
+  if ( !sqliteStatement )
+  {
+    QgsDebugMsg( "Invalid current SQLite statement" );
+    close();
+    return 0;
+  }
+
+  int fetched = 0;
+  while ( fetched < maxFeatures )
+  {
+    int ret = sqlite3_step( sqliteStatement );
+    if ( ret != SQLITE_ROW )
+    {
+      if ( ret != SQLITE_DONE )
+      {
+        // some unexpected error occurred
+        QgsMessageLog::logMessage( QObject::tr( "SQLite error getting feature: %1" ).arg( QString::fromUtf8( sqlite3_errmsg( mHandle->handle() ) ) ), QObject::tr( "SpatiaLite" ) );
+      }
+      sqlite3_finalize( sqliteStatement );
+      sqliteStatement = nullptr;
+      close();
+      break;
+    }
+
+    appendRowToBatch( sqliteStatement, batch );
+    fetched++;
+  }
+
+  return fetched;
+}
+
 bool QgsSpatiaLiteFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   if ( !mExpressionCompiled )
@@ -541,6 +582,82 @@ bool QgsSpatiaLiteFeatureIterator::getFeature( sqlite3_stmt *stmt, QgsFeature &f
   return true;
 }
 
+void QgsSpatiaLiteFeatureIterator::appendRowToBatch( sqlite3_stmt *stmt, QgsFeatureBatch &batch )
+{
+  bool subsetAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes;
+
+  // first column always contains the ROWID (or the primary key)
+  batch.appendRow( mHasPrimaryKey ? sqlite3_column_int64( stmt, 0 ) : ++mRowNumber );
+
+  int n_columns = sqlite3_column_count( stmt );
+  for ( int ic = 1; ic < n_columns; ic++ )
+  {
+    if ( mFetchGeometry && ic == mGeomColIdx )
+    {
+      if ( sqlite3_column_type( stmt, ic ) != SQLITE_BLOB )
+        continue;
+
+      unsigned char *featureGeom = nullptr;
+      int geom_size = 0;
+      const void *blob = sqlite3_column_blob( stmt, ic );
+      int blob_size = sqlite3_column_bytes( stmt, ic );
+      QgsSpatiaLiteProvider::convertToGeosWKB( ( const unsigned char * )blob, blob_size, &featureGeom, &geom_size );
+      if ( featureGeom )
+      {
+        memcpy( batch.appendWkb( geom_size ), featureGeom, geom_size );
+        delete [] featureGeom;
+      }
+      continue;
+    }
+
+    int attrIndex = ic - 1;
+    if ( subsetAttributes )
+    {
+      if ( ic > mRequest.subsetOfAttributes().size() )
+        continue;
+      attrIndex = mRequest.subsetOfAttributes().at( ic - 1 );
+    }
+    const int column = batch.columnIndex( attrIndex );
+    const int sqliteType = sqlite3_column_type( stmt, ic );
+    if ( column < 0 || sqliteType == SQLITE_NULL )
+      continue;
+
+    switch ( batch.columnType( column ) )
+    {
+      case QgsFeatureBatch::DoubleColumn:
+        if ( sqliteType == SQLITE_FLOAT || sqliteType == SQLITE_INTEGER )
+        {
+          batch.setDouble( column, sqliteType == SQLITE_FLOAT ? sqlite3_column_double( stmt, ic ) : static_cast< double >( sqlite3_column_int64( stmt, ic ) ) );
+          continue;
+        }
+        break;
+
+      case QgsFeatureBatch::IntegerColumn:
+        if ( sqliteType == SQLITE_INTEGER )
+        {
+          batch.setInteger( column, sqlite3_column_int64( stmt, ic ) );
+          continue;
+        }
+        break;
+
+      case QgsFeatureBatch::StringColumn:
+        if ( sqliteType == SQLITE_TEXT )
+        {
+          batch.setString( column, QString::fromUtf8( ( const char * ) sqlite3_column_text( stmt, ic ) ) );
+          continue;
+        }
+        break;
+
+      case QgsFeatureBatch::VariantColumn:
+        break;
+    }
+
+    // other storage types are converted like for single features
+    const QgsField field = mSource->mFields.at( attrIndex );
+    batch.setValue( column, getFeatureAttribute( stmt, ic, field.type(), field.subType() ) );
+  }
+}
+
 QVariant QgsSpatiaLiteFeatureIterator::getFeatureAttribute( sqlite3_stmt *stmt, int ic, QVariant::Type type, QVariant::Type subType )
 {
   if ( sqlite3_column_type( stmt, ic ) == SQLITE_INTEGER )
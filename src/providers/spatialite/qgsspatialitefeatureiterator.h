@@ -66,6 +66,7 @@ class QgsSpatiaLiteFeatureIterator : public QgsAbstractFeatureIteratorFromSource
   protected:
 
     virtual bool fetchFeature( QgsFeature &feature ) override;
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
 
   private:
@@ -81,6 +82,9 @@ class QgsSpatiaLiteFeatureIterator : public QgsAbstractFeatureIteratorFromSource
     QVariant getFeatureAttribute( sqlite3_stmt *stmt, int ic, QVariant::Type type, QVariant::Type subType );
     void getFeatureGeometry( sqlite3_stmt *stmt, int ic, QgsFeature &feature );
 
+    //! Appends the current row of the statement to a batch, reading its values straight into the typed columns
+    void appendRowToBatch( sqlite3_stmt *stmt, QgsFeatureBatch &batch );
+
     //! wrapper of the SQLite database connection
     QgsSqliteHandle *mHandle = nullptr;
 
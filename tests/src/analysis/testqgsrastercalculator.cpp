@@ -22,6 +22,8 @@ Email                : nyall dot dawson at gmail dot com
 #include "qgsapplication.h"
 #include "qgsproject.h"
 
+#include <cfloat>
+
 Q_DECLARE_METATYPE( QgsRasterCalcNode::Operator )
 
 class TestQgsRasterCalculator : public QObject
@@ -56,6 +58,7 @@ class TestQgsRasterCalculator : public QObject
 
     void calcWithLayers();
     void calcWithReprojectedLayers();
+    void calcInTiles();
 
   private:
 
@@ -531,5 +534,64 @@ void TestQgsRasterCalculator::calcWithReprojectedLayers()
   delete block;
 }
 
+void TestQgsRasterCalculator::calcInTiles()
+{
+  QgsRasterCalculatorEntry entry1;
+  entry1.bandNumber = 1;
+  entry1.raster = mpLandsatRasterLayer;
+  entry1.ref = QStringLiteral( "landsat@1" );
+
+  QgsRasterCalculatorEntry entry2;
+  entry2.bandNumber = 2;
+  entry2.raster = mpLandsatRasterLayer;
+  entry2.ref = QStringLiteral( "landsat@2" );
+
+  QVector<QgsRasterCalculatorEntry> entries;
+  entries << entry1 << entry2;
+
+  QgsRectangle extent = mpLandsatRasterLayer->extent();
+  int columns = mpLandsatRasterLayer->width();
+  int rows = mpLandsatRasterLayer->height();
+  QString formula = QStringLiteral( "( \"landsat@1\" - \"landsat@2\" ) / ( \"landsat@1\" + \"landsat@2\" - 250 ) > 0.01 OR sqrt( \"landsat@1\" - 125 ) ^ 1.5 < 2 * log10( \"landsat@2\" )" );
+
+  // expected values, calculated on whole matrices
+  QString error;
+  std::unique_ptr< QgsRasterCalcNode > calcNode( QgsRasterCalcNode::parseRasterCalcString( formula, error ) );
+  QVERIFY( calcNode );
+  std::unique_ptr< QgsRasterBlock > block1( mpLandsatRasterLayer->dataProvider()->block( 1, extent, columns, rows ) );
+  std::unique_ptr< QgsRasterBlock > block2( mpLandsatRasterLayer->dataProvider()->block( 2, extent, columns, rows ) );
+  QMap<QString, QgsRasterBlock *> rasterData;
+  rasterData.insert( QStringLiteral( "landsat@1" ), block1.get() );
+  rasterData.insert( QStringLiteral( "landsat@2" ), block2.get() );
+  QgsRasterMatrix expected;
+  expected.setNodataValue( -FLT_MAX );
+  QVERIFY( calcNode->calculate( rasterData, expected ) );
+  QCOMPARE( expected.nColumns(), columns );
+  QCOMPARE( expected.nRows(), rows );
+
+  QTemporaryFile tmpFile;
+  tmpFile.open(); // fileName is no avialable until open
+  QString tmpName = tmpFile.fileName();
+  tmpFile.close();
+
+  // tiles computed one after the other and by several threads give the same results
+  Q_FOREACH ( int threadCount, QList< int >() << 1 << 4 )
+  {
+    QgsRasterCalculator rc( formula, tmpName, QStringLiteral( "GTiff" ), extent, mpLandsatRasterLayer->crs(), columns, rows, entries );
+    rc.setThreadCount( threadCount );
+    QCOMPARE( rc.threadCount(), threadCount );
+    QCOMPARE( rc.processCalculation(), 0 );
+
+    std::unique_ptr< QgsRasterLayer > result( new QgsRasterLayer( tmpName, QStringLiteral( "result" ) ) );
+    QCOMPARE( result->width(), columns );
+    QCOMPARE( result->height(), rows );
+    std::unique_ptr< QgsRasterBlock > block( result->dataProvider()->block( 1, extent, columns, rows ) );
+    for ( int i = 0; i < columns * rows; ++i )
+    {
+      QCOMPARE( static_cast< float >( block->value( i ) ), static_cast< float >( expected.data()[i] ) );
+    }
+  }
+}
+
 QGSTEST_MAIN( TestQgsRasterCalculator )
 #include "testqgsrastercalculator.moc"
@@ -22,6 +22,7 @@
 //header for class being tested
 #include <qgsclipper.h>
 #include <qgspoint.h>
+#include "qgslinestring.h"
 #include "qgslogger.h"
 
 class TestQgsClipper: public QObject
@@ -34,6 +35,8 @@ class TestQgsClipper: public QObject
     void init() {} // will be called before each testfunction is executed.
     void cleanup() {} // will be called after every testfunction.
     void basic();
+    void clippedLine();
+    void trimPolygon();
   private:
     bool checkBoundingBox( const QPolygonF &polygon, const QgsRectangle &clipRect );
 };
@@ -78,6 +81,52 @@ void TestQgsClipper::basic()
   QVERIFY( ! checkBoundingBox( polygon, clipRectInner ) );
 }
 
+void TestQgsClipper::clippedLine()
+{
+  QgsRectangle clipRect( 0.0, 0.0, 10.0, 10.0 );
+
+  QPolygonF line;
+  line << QPointF( -5.0, 5.0 ) << QPointF( 5.0, 5.0 ) << QPointF( 5.0, 15.0 ) << QPointF( 8.0, 15.0 ) << QPointF( 8.0, 5.0 );
+
+  QPolygonF clipped = QgsClipper::clippedLine( line, clipRect );
+  QVERIFY( checkBoundingBox( clipped, clipRect ) );
+  QCOMPARE( clipped.first(), QPointF( 0.0, 5.0 ) );
+  QCOMPARE( clipped.last(), QPointF( 8.0, 5.0 ) );
+
+  // same result as for a linestring
+  QgsLineString lineString;
+  lineString.setPoints( QgsPointSequence() << QgsPoint( -5, 5 ) << QgsPoint( 5, 5 ) << QgsPoint( 5, 15 ) << QgsPoint( 8, 15 ) << QgsPoint( 8, 5 ) );
+  QCOMPARE( QgsClipper::clippedLine( lineString, clipRect ), clipped );
+
+  QVERIFY( QgsClipper::clippedLine( QPolygonF(), clipRect ).isEmpty() );
+}
+
+void TestQgsClipper::trimPolygon()
+{
+  QgsRectangle clipRect( 0.0, 0.0, 10.0, 10.0 );
+
+  // polygon inside the clip rectangle is left unchanged
+  QPolygonF inside;
+  inside << QPointF( 1, 1 ) << QPointF( 9, 1 ) << QPointF( 9, 9 ) << QPointF( 1, 9 ) << QPointF( 1, 1 );
+  QPolygonF trimmed = inside;
+  QgsClipper::trimPolygon( trimmed, clipRect );
+  QCOMPARE( trimmed, inside );
+
+  // polygon crossing only the right boundary
+  QPolygonF crossing;
+  crossing << QPointF( 5, 2 ) << QPointF( 15, 2 ) << QPointF( 15, 8 ) << QPointF( 5, 8 ) << QPointF( 5, 2 );
+  QgsClipper::trimPolygon( crossing, clipRect );
+  QVERIFY( checkBoundingBox( crossing, clipRect ) );
+  QCOMPARE( crossing.boundingRect(), QRectF( 5, 2, 5, 6 ) );
+
+  // polygon crossing all boundaries
+  QPolygonF around;
+  around << QPointF( -5, -5 ) << QPointF( 15, -5 ) << QPointF( 15, 15 ) << QPointF( -5, 15 ) << QPointF( -5, -5 );
+  QgsClipper::trimPolygon( around, clipRect );
+  QVERIFY( checkBoundingBox( around, clipRect ) );
+  QCOMPARE( around.boundingRect(), QRectF( 0, 0, 10, 10 ) );
+}
+
 bool TestQgsClipper::checkBoundingBox( const QPolygonF &polygon, const QgsRectangle &clipRect )
 {
   QgsRectangle bBox( polygon.boundingRect() );
@@ -32,6 +32,8 @@ class TestQgsCoordinateTransform: public QObject
     void assignment();
     void isValid();
     void isShortCircuited();
+    void transformPolygon();
+    void transformInterleavedCoords();
 
   private:
 
@@ -206,5 +208,65 @@ void TestQgsCoordinateTransform::transformBoundingBox()
   QGSCOMPARENEAR( resultRect.yMaximum(), expectedRect.yMaximum(), 0.001 );
 }
 
+void TestQgsCoordinateTransform::transformPolygon()
+{
+  QgsCoordinateReferenceSystem sourceSrs;
+  sourceSrs.createFromId( 4326, QgsCoordinateReferenceSystem::EpsgCrsId );
+  QgsCoordinateReferenceSystem destSrs;
+  destSrs.createFromId( 3857, QgsCoordinateReferenceSystem::EpsgCrsId );
+  QgsCoordinateTransform tr( sourceSrs, destSrs );
+
+  QPolygonF polygon;
+  polygon << QPointF( 150, -30 ) << QPointF( 151, -30 ) << QPointF( 151, -31 ) << QPointF( 150, -30 );
+  QPolygonF transformed = polygon;
+  tr.transformPolygon( transformed );
+  QCOMPARE( transformed.size(), polygon.size() );
+  for ( int i = 0; i < polygon.size(); ++i )
+  {
+    QgsPointXY expected = tr.transform( polygon.at( i ).x(), polygon.at( i ).y() );
+    QGSCOMPARENEAR( transformed.at( i ).x(), expected.x(), 0.0001 );
+    QGSCOMPARENEAR( transformed.at( i ).y(), expected.y(), 0.0001 );
+  }
+
+  // and back again
+  tr.transformPolygon( transformed, QgsCoordinateTransform::ReverseTransform );
+  for ( int i = 0; i < polygon.size(); ++i )
+  {
+    QGSCOMPARENEAR( transformed.at( i ).x(), polygon.at( i ).x(), 0.000001 );
+    QGSCOMPARENEAR( transformed.at( i ).y(), polygon.at( i ).y(), 0.000001 );
+  }
+
+  // transforming with another transform after reinitializing must not reuse the old projections
+  tr.setDestinationCrs( sourceSrs );
+  transformed = polygon;
+  tr.transformPolygon( transformed );
+  QCOMPARE( transformed, polygon );
+  destSrs.createFromId( 28356, QgsCoordinateReferenceSystem::EpsgCrsId );
+  tr.setDestinationCrs( destSrs );
+  tr.transformPolygon( transformed );
+  QgsPointXY expected = QgsCoordinateTransform( sourceSrs, destSrs ).transform( polygon.at( 0 ).x(), polygon.at( 0 ).y() );
+  QGSCOMPARENEAR( transformed.at( 0 ).x(), expected.x(), 0.0001 );
+  QGSCOMPARENEAR( transformed.at( 0 ).y(), expected.y(), 0.0001 );
+}
+
+void TestQgsCoordinateTransform::transformInterleavedCoords()
+{
+  QgsCoordinateReferenceSystem sourceSrs;
+  sourceSrs.createFromId( 4326, QgsCoordinateReferenceSystem::EpsgCrsId );
+  QgsCoordinateReferenceSystem destSrs;
+  destSrs.createFromId( 3857, QgsCoordinateReferenceSystem::EpsgCrsId );
+  QgsCoordinateTransform tr( sourceSrs, destSrs );
+
+  // x, y, z triplets
+  double coords[] = { 150, -30, 0, 151, -31, 0, 152, -32, 0 };
+  tr.transformCoords( 3, coords, coords + 1, coords + 2, 3, QgsCoordinateTransform::ForwardTransform );
+  for ( int i = 0; i < 3; ++i )
+  {
+    QgsPointXY expected = tr.transform( 150 + i, -30 - i );
+    QGSCOMPARENEAR( coords[3 * i], expected.x(), 0.0001 );
+    QGSCOMPARENEAR( coords[3 * i + 1], expected.y(), 0.0001 );
+  }
+}
+
 QGSTEST_MAIN( TestQgsCoordinateTransform )
 #include "testqgscoordinatetransform.moc"
@@ -33,6 +33,8 @@
 #include "qgsrasterlayer.h"
 #include "qgsproject.h"
 #include "qgsexpressionnodeimpl.h"
+#include "qgsfeaturebatch.h"
+#include "qgsexpressionbatch.h"
 
 static void _parseAndEvalExpr( int arg )
 {
@@ -44,6 +46,23 @@ static void _parseAndEvalExpr( int arg )
   }
 }
 
+//! Function returning its argument, which counts its calls
+class TestCountCallsFunction : public QgsExpressionFunction
+{
+  public:
+    TestCountCallsFunction()
+      : QgsExpressionFunction( QStringLiteral( "test_count_calls" ), 1, QStringLiteral( "Tests" ) )
+    {}
+
+    QVariant func( const QVariantList &values, const QgsExpressionContext *, QgsExpression * ) override
+    {
+      ++calls;
+      return values.at( 0 );
+    }
+
+    int calls = 0;
+};
+
 class TestQgsExpression: public QObject
 {
     Q_OBJECT
@@ -60,6 +79,34 @@ class TestQgsExpression: public QObject
 
   private:
 
+    //! Returns the features used to compare the evaluation of an expression for batches and compiled programs with the tree
+    static QgsFeatureList evalFeatures( QgsFields &fields )
+    {
+      fields = QgsFields();
+      fields.append( QgsField( QStringLiteral( "i" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "d" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "s" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "b" ), QVariant::Bool ) );
+
+      QList< QgsAttributes > attributes;
+      attributes << ( QgsAttributes() << 1 << 1.5 << QStringLiteral( "a" ) << true )
+                 << ( QgsAttributes() << 0 << -2.25 << QStringLiteral( "b" ) << false )
+                 << ( QgsAttributes() << QVariant( QVariant::Int ) << QVariant( QVariant::Double ) << QVariant( QVariant::String ) << QVariant( QVariant::Bool ) )
+                 << ( QgsAttributes() << QVariant() << QVariant() << QVariant() << QVariant() )
+                 << ( QgsAttributes() << 7 << 0.0 << QStringLiteral( "12" ) << true )
+                 << ( QgsAttributes() << -4 << 9.75 << QStringLiteral( " C " ) << false );
+
+      QgsFeatureList features;
+      for ( int i = 0; i < attributes.count(); ++i )
+      {
+        QgsFeature f( fields, i );
+        f.setAttributes( attributes.at( i ) );
+        f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( i, 2 * i ) ) );
+        features << f;
+      }
+      return features;
+    }
+
     QgsVectorLayer *mPointsLayer = nullptr;
     QgsVectorLayer *mMemoryLayer = nullptr;
     QgsVectorLayer *mAggregatesLayer = nullptr;
@@ -1360,6 +1407,201 @@ class TestQgsExpression: public QObject
       }
     }
 
+    void eval_batch_data()
+    {
+      QTest::addColumn<QString>( "string" );
+
+      QTest::newRow( "column int" ) << "\"i\"";
+      QTest::newRow( "column double" ) << "\"d\"";
+      QTest::newRow( "column string" ) << "\"s\"";
+      QTest::newRow( "column bool" ) << "\"b\"";
+      QTest::newRow( "literal" ) << "3";
+      QTest::newRow( "int arithmetic" ) << "\"i\" * 2 + 1 - \"i\" % 3";
+      QTest::newRow( "int division" ) << "\"i\" / 2";
+      QTest::newRow( "int modulo zero" ) << "10 % \"i\"";
+      QTest::newRow( "double arithmetic" ) << "\"d\" * \"i\" - 1.5";
+      QTest::newRow( "double division zero" ) << "\"d\" / \"i\"";
+      QTest::newRow( "power" ) << "\"i\" ^ 2";
+      QTest::newRow( "integer division" ) << "\"d\" // 2";
+      QTest::newRow( "unary minus" ) << "-\"d\"";
+      QTest::newRow( "unary minus null" ) << "-\"i\"";
+      QTest::newRow( "null arithmetic" ) << "\"i\" + NULL";
+      QTest::newRow( "comparison" ) << "\"i\" > 2";
+      QTest::newRow( "comparison double" ) << "\"d\" <= \"i\"";
+      QTest::newRow( "comparison string" ) << "\"s\" = 'b'";
+      QTest::newRow( "comparison mixed" ) << "\"s\" = 2";
+      QTest::newRow( "and or" ) << "\"i\" > 1 AND \"d\" < 5 OR \"s\" = 'a'";
+      QTest::newRow( "not" ) << "NOT \"i\" > 2";
+      QTest::newRow( "is null" ) << "\"i\" IS NULL";
+      QTest::newRow( "is not" ) << "\"s\" IS NOT 'a'";
+      QTest::newRow( "string plus" ) << "\"s\" + 'x'";
+      QTest::newRow( "string plus null" ) << "\"s\" + \"s\"";
+      QTest::newRow( "string plus null is null" ) << "(\"s\" + \"s\") IS NULL";
+      QTest::newRow( "string plus null empty" ) << "\"s\" + \"s\" = ''";
+      QTest::newRow( "concat" ) << "\"s\" || 'x'";
+      QTest::newRow( "functions" ) << "abs(-\"d\") + sqrt(abs(\"i\")) + floor(\"d\") + ceil(\"d\")";
+      QTest::newRow( "string functions" ) << "upper(\"s\") || lower(\"s\") || trim(' ' || \"s\")";
+      QTest::newRow( "length" ) << "length(\"s\")";
+      QTest::newRow( "fallback function" ) << "left(\"s\", 1) || to_string(\"i\" + 1)";
+      QTest::newRow( "fallback operand" ) << "coalesce(\"i\", 0) * 2";
+      QTest::newRow( "geometry" ) << "$x + \"i\"";
+      QTest::newRow( "conditional" ) << "CASE WHEN \"i\" > 2 THEN \"s\" ELSE 'small' END";
+      QTest::newRow( "eval error" ) << "to_int(\"s\")";
+    }
+
+    void eval_batch()
+    {
+      QFETCH( QString, string );
+
+      QgsFields fields;
+      const QgsFeatureList features = evalFeatures( fields );
+      QgsFeatureBatch batch( fields );
+      for ( const QgsFeature &f : features )
+        batch.appendFeature( f );
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+      QgsExpression exp( string );
+      QVERIFY( !exp.hasParserError() );
+      exp.prepare( &context );
+
+      QVariantList results = exp.evaluateBatch( batch, &context );
+      QString batchError = exp.evalErrorString();
+      QCOMPARE( results.count(), batch.count() );
+
+      // results must be the same as the ones of the features evaluated one by one
+      QString firstError;
+      for ( int row = 0; row < batch.count(); ++row )
+      {
+        context.setFeature( batch.feature( row ) );
+        QVariant expected = exp.evaluate( &context );
+        if ( exp.hasEvalError() )
+        {
+          if ( firstError.isNull() )
+            firstError = exp.evalErrorString();
+          expected = QVariant();
+        }
+
+        QCOMPARE( results.at( row ).isNull(), expected.isNull() );
+        if ( !expected.isNull() )
+        {
+          QCOMPARE( results.at( row ).type(), expected.type() );
+          QCOMPARE( results.at( row ), expected );
+        }
+      }
+      QCOMPARE( batchError, firstError );
+
+      // the same results when the nodes evaluated feature by feature use the original features
+      QgsExpressionBatchValues values;
+      exp.evaluateBatch( batch, &context, values, &features );
+      QCOMPARE( exp.evalErrorString(), firstError );
+      for ( int row = 0; row < batch.count(); ++row )
+      {
+        QCOMPARE( values.value( row ).isNull(), results.at( row ).isNull() );
+        if ( !results.at( row ).isNull() )
+          QCOMPARE( values.value( row ), results.at( row ) );
+      }
+    }
+
+    void eval_compiled_data()
+    {
+      eval_batch_data();
+    }
+
+    void eval_compiled()
+    {
+      QFETCH( QString, string );
+
+      QgsFields fields;
+      const QgsFeatureList features = evalFeatures( fields );
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+
+      // a prepared expression is compiled, the other one evaluates its prepared tree
+      QgsExpression compiled( string );
+      QVERIFY( !compiled.hasParserError() );
+      QVERIFY( compiled.compilationEnabled() );
+      compiled.prepare( &context );
+      QgsExpression interpreted( string );
+      interpreted.setCompilationEnabled( false );
+      QVERIFY( !interpreted.compilationEnabled() );
+      interpreted.prepare( &context );
+
+      for ( const QgsFeature &f : features )
+      {
+        context.setFeature( f );
+
+        QVariant result = compiled.evaluate( &context );
+        QString error = compiled.evalErrorString();
+        QVariant expected = interpreted.evaluate( &context );
+
+        QCOMPARE( error, interpreted.evalErrorString() );
+        QCOMPARE( result.isNull(), expected.isNull() );
+        QCOMPARE( result.type(), expected.type() );
+        if ( !expected.isNull() )
+          QCOMPARE( result, expected );
+      }
+    }
+
+    void eval_compilation_disabled()
+    {
+      TestCountCallsFunction function;
+      QgsExpression::registerFunction( &function );
+
+      // disabling the compilation of a prepared expression evaluates its tree again
+      QgsExpressionContext context;
+      QgsExpression exp( QStringLiteral( "test_count_calls(2) + 3" ) );
+      exp.prepare( &context );
+      QCOMPARE( exp.evaluate( &context ), QVariant( 5 ) );
+      QgsExpression copy( exp );
+      copy.setCompilationEnabled( false );
+      QVERIFY( exp.compilationEnabled() );
+      QVERIFY( !copy.compilationEnabled() );
+      QCOMPARE( copy.evaluate( &context ), QVariant( 5 ) );
+      copy.prepare( &context );
+      QCOMPARE( copy.evaluate( &context ), QVariant( 5 ) );
+      QCOMPARE( QgsExpression( copy ).compilationEnabled(), false );
+
+      QgsExpression::unregisterFunction( function.name() );
+      QCOMPARE( function.calls, 3 );
+    }
+
+    void eval_compiled_fallback_data()
+    {
+      QTest::addColumn<QString>( "string" );
+      QTest::addColumn<QVariant>( "result" );
+
+      QTest::newRow( "binary operator" ) << "test_count_calls(to_date('2017-10-17')) + to_interval('1 day')" << QVariant( QDateTime( QDate( 2017, 10, 18 ), QTime( 0, 0 ) ) );
+      QTest::newRow( "unary operator" ) << "-test_count_calls(to_date('2017-10-17'))" << QVariant();
+      QTest::newRow( "function" ) << "upper(test_count_calls(to_date('2017-10-17')))" << QVariant( "2017-10-17" );
+      QTest::newRow( "nested" ) << "length(upper(test_count_calls(to_date('2017-10-17'))) || '')" << QVariant( 10 );
+    }
+
+    void eval_compiled_fallback()
+    {
+      QFETCH( QString, string );
+      QFETCH( QVariant, result );
+
+      // instructions receiving operands they do not handle must not evaluate the operand nodes again
+      TestCountCallsFunction function;
+      QgsExpression::registerFunction( &function );
+
+      QgsExpressionContext context;
+      QgsExpression exp( string );
+      bool parserError = exp.hasParserError();
+      exp.prepare( &context );
+      QVariant value = exp.evaluate( &context );
+
+      QgsExpression::unregisterFunction( function.name() );
+
+      QVERIFY( !parserError );
+      QCOMPARE( function.calls, 1 );
+      QCOMPARE( value.isNull(), result.isNull() );
+      if ( !result.isNull() )
+        QCOMPARE( value, result );
+    }
+
     void aggregate_data()
     {
       QTest::addColumn<QString>( "string" );
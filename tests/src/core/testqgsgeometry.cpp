@@ -44,6 +44,8 @@
 #include "qgscircularstring.h"
 #include "qgsgeometrycollection.h"
 #include "qgsgeometryfactory.h"
+#include "qgscompactgeometry.h"
+#include "qgswkbgeometryview.h"
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
@@ -126,6 +128,8 @@ class TestQgsGeometry : public QObject
 
     void reshapeGeometryLineMerge();
     void createCollectionOfType();
+    void compactGeometry();
+    void wkbGeometryView();
 
     void minimalEnclosingCircle( );
 
@@ -5596,6 +5600,97 @@ void TestQgsGeometry::createCollectionOfType()
   QVERIFY( dynamic_cast< QgsMultiSurface *>( collect.get() ) );
 }
 
+void TestQgsGeometry::compactGeometry()
+{
+  // null and unsupported geometries
+  QVERIFY( QgsCompactGeometry().isNull() );
+  QVERIFY( QgsCompactGeometry::fromGeometry( QgsGeometry() ).isNull() );
+  QVERIFY( QgsCompactGeometry::fromGeometry( QgsGeometry::fromWkt( QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) ) ).isNull() );
+  QVERIFY( QgsCompactGeometry::fromGeometry( QgsGeometry::fromWkt( QStringLiteral( "GeometryCollection (Point (1 2))" ) ) ).isNull() );
+  QVERIFY( !QgsCompactGeometry::isSupported( QgsWkbTypes::LineString25D ) );
+  QVERIFY( QgsCompactGeometry::isSupported( QgsWkbTypes::MultiPolygonZM ) );
+
+  // double precision round trips without loss
+  QStringList wkts;
+  wkts << QStringLiteral( "Point (1.5 -2.25)" )
+       << QStringLiteral( "PointZM (1 2 3 4)" )
+       << QStringLiteral( "LineStringM (0 0 1, 10.1 10.2 2, 20 5 3)" )
+       << QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0),(2 2, 4 2, 4 4, 2 2))" )
+       << QStringLiteral( "MultiPointZ ((1 2 3),(4 5 6))" )
+       << QStringLiteral( "MultiLineString ((0 0, 1 1),(2 2, 3 3, 4 4))" )
+       << QStringLiteral( "MultiPolygonZ (((0 0 1, 10 0 1, 10 10 1, 0 0 1)),((20 20 2, 30 20 2, 30 30 2, 20 20 2),(22 22 2, 24 22 2, 24 24 2, 22 22 2)))" );
+  Q_FOREACH ( const QString &wkt, wkts )
+  {
+    QgsGeometry geom = QgsGeometry::fromWkt( wkt );
+    QgsCompactGeometry compact = QgsCompactGeometry::fromGeometry( geom );
+    QVERIFY( !compact.isNull() );
+    QCOMPARE( compact.wkbType(), geom.wkbType() );
+    QCOMPARE( compact.vertexCount(), geom.geometry()->nCoordinates() );
+    QCOMPARE( compact.toGeometry().exportToWkt(), geom.exportToWkt() );
+  }
+
+  QgsCompactGeometry compact = QgsCompactGeometry::fromGeometry( QgsGeometry::fromWkt( wkts.last() ) );
+  QCOMPARE( compact.partCount(), 2 );
+  QCOMPARE( compact.ringCount( 0 ), 1 );
+  QCOMPARE( compact.ringCount( 1 ), 2 );
+  QCOMPARE( compact.vertexCount( 1, 1 ), 4 );
+  QCOMPARE( compact.vertexAt( 4 ), QgsPointXY( 20, 20 ) );
+  QCOMPARE( compact.ringAsPolygon( 1, 1 ), QPolygonF() << QPointF( 22, 22 ) << QPointF( 24, 22 ) << QPointF( 24, 24 ) << QPointF( 22, 22 ) );
+  QCOMPARE( compact.boundingBox(), QgsRectangle( 0, 0, 30, 30 ) );
+
+  // single precision stores coordinates relative to the bounding box
+  QgsGeometry line = QgsGeometry::fromWkt( QStringLiteral( "LineString (2500000.123 1200000.456, 2500100.789 1200050.012)" ) );
+  compact = QgsCompactGeometry::fromGeometry( line, QgsCompactGeometry::SinglePrecision );
+  QCOMPARE( compact.precision(), QgsCompactGeometry::SinglePrecision );
+  QVERIFY( compact.memoryUsage() < QgsCompactGeometry::fromGeometry( line ).memoryUsage() );
+  QgsGeometry restored = compact.toGeometry();
+  QCOMPARE( restored.wkbType(), QgsWkbTypes::LineString );
+  QVERIFY( qgsDoubleNear( restored.vertexAt( 0 ).x(), 2500000.123, 0.0001 ) );
+  QVERIFY( qgsDoubleNear( restored.vertexAt( 0 ).y(), 1200000.456, 0.0001 ) );
+  QVERIFY( qgsDoubleNear( restored.vertexAt( 1 ).x(), 2500100.789, 0.0001 ) );
+  QVERIFY( qgsDoubleNear( restored.vertexAt( 1 ).y(), 1200050.012, 0.0001 ) );
+}
+
+void TestQgsGeometry::wkbGeometryView()
+{
+  // invalid and unsupported wkb
+  QVERIFY( !QgsWkbGeometryView( nullptr, 0 ).isValid() );
+  QByteArray wkb = QgsGeometry::fromWkt( QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) ).exportToWkb();
+  QVERIFY( !QgsWkbGeometryView( reinterpret_cast< const unsigned char * >( wkb.constData() ), wkb.size() ).isValid() );
+  wkb = QgsGeometry::fromWkt( QStringLiteral( "LineString (0 0, 1 1, 2 0)" ) ).exportToWkb();
+  QVERIFY( !QgsWkbGeometryView( reinterpret_cast< const unsigned char * >( wkb.constData() ), wkb.size() - 8 ).isValid() );
+  QCOMPARE( QgsWkbGeometryView( reinterpret_cast< const unsigned char * >( wkb.constData() ), wkb.size() - 8 ).partCount(), 0 );
+
+  // point
+  wkb = QgsGeometry::fromWkt( QStringLiteral( "PointZ (1.5 -2.5 3)" ) ).exportToWkb();
+  QgsWkbGeometryView view( reinterpret_cast< const unsigned char * >( wkb.constData() ), wkb.size() );
+  QVERIFY( view.isValid() );
+  QCOMPARE( view.wkbType(), QgsWkbTypes::PointZ );
+  QCOMPARE( view.partCount(), 1 );
+  QCOMPARE( view.point(), QPointF( 1.5, -2.5 ) );
+  QCOMPARE( view.toGeometry().exportToWkt(), QStringLiteral( "PointZ (1.5 -2.5 3)" ) );
+
+  // linestring
+  wkb = QgsGeometry::fromWkt( QStringLiteral( "LineStringM (0 0 1, 10 10 2, 20 5 3)" ) ).exportToWkb();
+  view = QgsWkbGeometryView( reinterpret_cast< const unsigned char * >( wkb.constData() ), wkb.size() );
+  QVERIFY( view.isValid() );
+  QCOMPARE( view.lineString(), QPolygonF() << QPointF( 0, 0 ) << QPointF( 10, 10 ) << QPointF( 20, 5 ) );
+
+  // multipolygon
+  QString wkt = QStringLiteral( "MultiPolygon (((0 0, 10 0, 10 10, 0 0)),((20 20, 30 20, 30 30, 20 20),(22 22, 24 22, 24 24, 22 22)))" );
+  wkb = QgsGeometry::fromWkt( wkt ).exportToWkb();
+  view = QgsWkbGeometryView( reinterpret_cast< const unsigned char * >( wkb.constData() ), wkb.size() );
+  QVERIFY( view.isValid() );
+  QCOMPARE( view.wkbType(), QgsWkbTypes::MultiPolygon );
+  QCOMPARE( view.partCount(), 2 );
+  QCOMPARE( view.part( 0 ).wkbType(), QgsWkbTypes::Polygon );
+  QCOMPARE( view.part( 0 ).rings().count(), 1 );
+  QList<QPolygonF> rings = view.part( 1 ).rings();
+  QCOMPARE( rings.count(), 2 );
+  QCOMPARE( rings.at( 1 ), QPolygonF() << QPointF( 22, 22 ) << QPointF( 24, 22 ) << QPointF( 24, 24 ) << QPointF( 22, 22 ) );
+  QCOMPARE( view.toGeometry().exportToWkt(), QgsGeometry::fromWkt( wkt ).exportToWkt() );
+}
+
 void TestQgsGeometry::minimalEnclosingCircle()
 {
   QgsGeometry geomTest;
@@ -19,8 +19,10 @@
 #include <qgslabelingengine.h>
 #include <qgsproject.h>
 #include <qgsmaprenderersequentialjob.h>
+#include <qgsmaprenderercache.h>
 #include <qgsreadwritecontext.h>
 #include <qgsrulebasedlabeling.h>
+#include <qgsvectordataprovider.h>
 #include <qgsvectorlayer.h>
 #include <qgsvectorlayerdiagramprovider.h>
 #include <qgsvectorlayerlabeling.h>
@@ -48,6 +50,8 @@ class TestQgsLabelingEngine : public QObject
     void testCapitalization();
     void testParticipatingLayers();
     void testRegisterFeatureUnprojectible();
+    void testReusePlacements();
+    void testSolveInParallel();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -623,5 +627,120 @@ void TestQgsLabelingEngine::testRegisterFeatureUnprojectible()
   QCOMPARE( provider->mLabels.size(), 0 );
 }
 
+void TestQgsLabelingEngine::testReusePlacements()
+{
+  QgsPalLayerSettings settings;
+  settings.fieldName = "Class";
+  setDefaultLabelParams( settings );
+  vl->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 640, 480 ) );
+  mapSettings.setExtent( vl->extent() );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl );
+  mapSettings.setOutputDpi( 96 );
+  QgsLabelingEngineSettings engineSettings = mapSettings.labelingEngineSettings();
+  engineSettings.setFlag( QgsLabelingEngineSettings::ReusePlacements, true );
+  mapSettings.setLabelingEngineSettings( engineSettings );
+
+  QgsMapRendererCache cache;
+  QgsMapRendererSequentialJob job( mapSettings );
+  job.setCache( &cache );
+  job.start();
+  job.waitForFinished();
+  std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+  QList<QgsLabelPosition> labels = results->labelsWithinRect( mapSettings.visibleExtent() );
+  QVERIFY( !labels.isEmpty() );
+
+  // pan the map by a few pixels - labels away from the newly exposed strip keep their placement
+  QgsRectangle extent = mapSettings.visibleExtent();
+  double dx = 5 * mapSettings.mapUnitsPerPixel();
+  mapSettings.setExtent( QgsRectangle( extent.xMinimum() + dx, extent.yMinimum(), extent.xMaximum() + dx, extent.yMaximum() ) );
+  QgsMapRendererSequentialJob job2( mapSettings );
+  job2.setCache( &cache );
+  job2.start();
+  job2.waitForFinished();
+  QVERIFY( !job2.usedCachedLabels() );
+  std::unique_ptr< QgsLabelingResults > results2( job2.takeLabelingResults() );
+
+  QgsRectangle interior = mapSettings.visibleExtent();
+  interior.scale( 0.6 );
+  int compared = 0;
+  Q_FOREACH ( const QgsLabelPosition &label, labels )
+  {
+    if ( !interior.contains( label.labelRect ) )
+      continue;
+
+    Q_FOREACH ( const QgsLabelPosition &label2, results2->labelsWithinRect( interior ) )
+    {
+      if ( label2.featureId != label.featureId )
+        continue;
+
+      QCOMPARE( label2.labelRect, label.labelRect );
+      compared++;
+    }
+  }
+  QVERIFY( compared > 0 );
+
+  vl->setLabeling( nullptr );
+}
+
+void TestQgsLabelingEngine::testSolveInParallel()
+{
+  // enough pairs of close points to split the problem in several jobs
+  std::unique_ptr< QgsVectorLayer> vl2( new QgsVectorLayer( "Point?field=id:integer", "vl", "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < 30; i++ )
+  {
+    for ( int j = 0; j < 20; j++ )
+    {
+      QgsFeature f( vl2->fields() );
+      f.setAttribute( 0, i * 20 + j );
+      f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( i * 100, j * 100 ) ) );
+      features << f;
+      f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( i * 100 + 10, j * 100 ) ) );
+      features << f;
+    }
+  }
+  vl2->dataProvider()->addFeatures( features );
+  vl2->updateExtents();
+
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "'x'" );
+  settings.isExpression = true;
+  setDefaultLabelParams( settings );
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 1200, 800 ) );
+  mapSettings.setExtent( vl2->extent().buffer( 50 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  auto placeLabels = [&mapSettings]( bool parallel )
+  {
+    QgsLabelingEngineSettings engineSettings = mapSettings.labelingEngineSettings();
+    engineSettings.setFlag( QgsLabelingEngineSettings::SolveInParallel, parallel );
+    mapSettings.setLabelingEngineSettings( engineSettings );
+
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    QMap< QgsFeatureId, QgsRectangle > rects;
+    Q_FOREACH ( const QgsLabelPosition &label, results->labelsWithinRect( mapSettings.visibleExtent() ) )
+      rects.insert( label.featureId, label.labelRect );
+    return rects;
+  };
+
+  QMap< QgsFeatureId, QgsRectangle > serial = placeLabels( false );
+  QMap< QgsFeatureId, QgsRectangle > parallel = placeLabels( true );
+  QCOMPARE( serial.count(), features.count() );
+  QCOMPARE( parallel.count(), features.count() );
+
+  // the solution does not depend on the scheduling of the threads
+  QCOMPARE( placeLabels( true ), parallel );
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
@@ -29,6 +29,7 @@ class TestQgsMapToPixel: public QObject
     void getters();
     void fromScale();
     void toMapPoint();
+    void transformPolygon();
 };
 
 void TestQgsMapToPixel::rotation()
@@ -119,6 +120,36 @@ void TestQgsMapToPixel::toMapPoint()
   QCOMPARE( p, QgsPointXY( 20, 20 ) );
 }
 
+void TestQgsMapToPixel::transformPolygon()
+{
+  // batch transform must give the same results as transforming each point, with and without rotation
+  QList< double > rotations;
+  rotations << 0 << 30 << 90;
+  Q_FOREACH ( double rotation, rotations )
+  {
+    QgsMapToPixel m2p( 0.37, 2500000.5, 1200000.25, 800, 600, rotation );
+    QPolygonF points;
+    for ( int i = 0; i < 7; ++i )
+      points << QPointF( 2500000.0 + i * 13.1, 1200000.0 - i * 7.3 );
+
+    QPolygonF transformed = points;
+    m2p.transformInPlace( transformed );
+    QCOMPARE( transformed.size(), points.size() );
+    for ( int i = 0; i < points.size(); ++i )
+    {
+      double x = points.at( i ).x();
+      double y = points.at( i ).y();
+      m2p.transformInPlace( x, y );
+      QCOMPARE( transformed.at( i ).x(), x );
+      QCOMPARE( transformed.at( i ).y(), y );
+    }
+  }
+
+  QPolygonF empty;
+  QgsMapToPixel( 1, 5, 5, 10, 10, 0 ).transformInPlace( empty );
+  QVERIFY( empty.isEmpty() );
+}
+
 QGSTEST_MAIN( TestQgsMapToPixel )
 #include "testqgsmaptopixel.moc"
 
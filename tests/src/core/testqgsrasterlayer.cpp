@@ -42,6 +42,12 @@
 #include "qgsrasterdataprovider.h"
 #include "qgsrastershader.h"
 #include "qgsrastertransparency.h"
+#include "qgsmaptopixel.h"
+#include "qgsrasterdrawer.h"
+#include "qgsrasteriterator.h"
+#include "qgsrasterpipe.h"
+#include "qgsrasterprojector.h"
+#include "qgsrasterviewport.h"
 
 //qgis unit test includes
 #include <qgsrenderchecker.h>
@@ -91,6 +97,8 @@ class TestQgsRasterLayer : public QObject
     void setRenderer();
     void regression992(); //test for issue #992 - GeoJP2 images improperly displayed as all black
     void testRefreshRendererIfNeeded();
+    void parallelDrawing();
+    void reprojectionGridCache();
 
 
   private:
@@ -727,5 +735,112 @@ void TestQgsRasterLayer::testRefreshRendererIfNeeded()
   QGSCOMPARENOTNEAR( initMinVal, newMinVal, 1e-5 );
 }
 
+void TestQgsRasterLayer::parallelDrawing()
+{
+  QVERIFY2( mpLandsatRasterLayer->isValid(), "landsat.tif layer is not valid!" );
+  QgsRasterPipe pipe( *mpLandsatRasterLayer->pipe() );
+
+  QgsRasterViewPort viewPort;
+  viewPort.mTopLeftPoint = QgsPointXY( 0, 0 );
+  viewPort.mBottomRightPoint = QgsPointXY( 300, 500 );
+  viewPort.mWidth = 300;
+  viewPort.mHeight = 500;
+  viewPort.mDrawnExtent = mpLandsatRasterLayer->extent();
+  QgsMapToPixel mapToPixel( mpLandsatRasterLayer->extent().width() / 300, viewPort.mDrawnExtent.center().x(), viewPort.mDrawnExtent.center().y(), 300, 500, 0 );
+
+  // the parts of the raster cover it without gaps
+  QgsRasterIterator iterator( pipe.last() );
+  iterator.setMaximumTileHeight( 64 );
+  iterator.startRasterRead( 1, 300, 500, viewPort.mDrawnExtent );
+  int columns, rows, topLeftColumn, topLeftRow;
+  QgsRectangle blockExtent;
+  int nextRow = 0;
+  while ( iterator.next( 1, columns, rows, topLeftColumn, topLeftRow, blockExtent ) )
+  {
+    QCOMPARE( topLeftColumn, 0 );
+    QCOMPARE( columns, 300 );
+    QCOMPARE( topLeftRow, nextRow );
+    QGSCOMPARENEAR( blockExtent.yMaximum(), viewPort.mDrawnExtent.yMaximum() - topLeftRow * viewPort.mDrawnExtent.height() / 500, 1e-6 );
+    nextRow += rows;
+  }
+  QCOMPARE( nextRow, 500 );
+
+  QImage expected( 300, 500, QImage::Format_ARGB32_Premultiplied );
+  expected.fill( 0 );
+  QPainter painter( &expected );
+  QgsRasterIterator sequentialIterator( pipe.last() );
+  sequentialIterator.setMaximumTileHeight( 64 );
+  QgsRasterDrawer sequentialDrawer( &sequentialIterator );
+  sequentialDrawer.draw( &painter, &viewPort, &mapToPixel );
+  painter.end();
+
+  // drawing with threads gives the same image
+  QImage image( 300, 500, QImage::Format_ARGB32_Premultiplied );
+  image.fill( 0 );
+  painter.begin( &image );
+  QgsRasterIterator parallelIterator( pipe.last() );
+  QgsRasterDrawer parallelDrawer( &parallelIterator );
+  QList< QgsRasterPipe * > threadPipes;
+  for ( int i = 0; i < 3; ++i )
+    threadPipes << new QgsRasterPipe( pipe );
+  parallelDrawer.setParallelRendering( &pipe, threadPipes );
+  parallelDrawer.draw( &painter, &viewPort, &mapToPixel );
+  painter.end();
+  QCOMPARE( parallelIterator.maximumTileHeight(), 64 );
+  QVERIFY( image == expected );
+
+  // the copies of the pipe can be drawn from again
+  QImage secondImage( 300, 500, QImage::Format_ARGB32_Premultiplied );
+  secondImage.fill( 0 );
+  painter.begin( &secondImage );
+  QgsRasterIterator secondIterator( pipe.last() );
+  QgsRasterDrawer secondDrawer( &secondIterator );
+  secondDrawer.setParallelRendering( &pipe, threadPipes );
+  secondDrawer.draw( &painter, &viewPort, &mapToPixel );
+  painter.end();
+  qDeleteAll( threadPipes );
+  QVERIFY( secondImage == expected );
+}
+
+void TestQgsRasterLayer::reprojectionGridCache()
+{
+  QVERIFY2( mpLandsatRasterLayer->isValid(), "landsat.tif layer is not valid!" );
+  const qint64 budget = QgsRasterProjector::gridCacheMemoryBudget();
+  QVERIFY( budget > 0 );
+
+  QgsRasterProjector projector;
+  projector.setInput( mpLandsatRasterLayer->dataProvider() );
+  QgsCoordinateReferenceSystem destCrs( QStringLiteral( "EPSG:4326" ) );
+  projector.setCrs( mpLandsatRasterLayer->crs(), destCrs );
+  QgsRectangle extent;
+  int width, height;
+  QVERIFY( projector.destExtentSize( mpLandsatRasterLayer->extent(), 200, 200, extent, width, height ) );
+
+  // reprojected without the cache
+  QgsRasterProjector::setGridCacheMemoryBudget( 0 );
+  std::unique_ptr< QgsRasterBlock > expected( projector.block( 1, extent, width, height ) );
+  QVERIFY( expected->isValid() );
+
+  // computing the grid and reusing it give the same block
+  QgsRasterProjector::setGridCacheMemoryBudget( budget );
+  QgsRasterProjector::clearGridCache();
+  for ( int i = 0; i < 2; ++i )
+  {
+    std::unique_ptr< QgsRasterBlock > block( projector.block( 1, extent, width, height ) );
+    QCOMPARE( block->width(), expected->width() );
+    QCOMPARE( block->height(), expected->height() );
+    QCOMPARE( block->data(), expected->data() );
+  }
+
+  // grids of other extents are not mixed up
+  QgsRectangle half( extent.xMinimum(), extent.yMinimum(), extent.center().x(), extent.yMaximum() );
+  QgsRasterProjector::setGridCacheMemoryBudget( 0 );
+  expected.reset( projector.block( 1, half, width, height ) );
+  QgsRasterProjector::setGridCacheMemoryBudget( budget );
+  std::unique_ptr< QgsRasterBlock > block( projector.block( 1, half, width, height ) );
+  QCOMPARE( block->data(), expected->data() );
+  QCOMPARE( QgsRasterProjector::gridCacheMemoryBudget(), budget );
+}
+
 QGSTEST_MAIN( TestQgsRasterLayer )
 #include "testqgsrasterlayer.moc"
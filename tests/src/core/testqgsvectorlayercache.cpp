@@ -56,6 +56,7 @@ class TestVectorLayerCache : public QObject
     void testFullCacheThroughRequest();
     void testCanUseCacheForRequest();
     void testCacheGeom();
+    void testCompactGeometries();
 
     void onCommittedFeaturesAdded( const QString &, const QgsFeatureList & );
 
@@ -393,6 +394,39 @@ void TestVectorLayerCache::testCacheGeom()
   QVERIFY( !cache.hasFullCache() );
 }
 
+void TestVectorLayerCache::testCompactGeometries()
+{
+  QgsVectorLayerCache cache( mPointsLayer, 100 );
+  cache.setFullCache( true );
+  QVERIFY( !cache.compactGeometries() );
+
+  // switching to compact geometries clears the cache
+  cache.setCompactGeometries( true );
+  QVERIFY( cache.compactGeometries() );
+  QVERIFY( !cache.hasFullCache() );
+  cache.setFullCache( true );
+
+  QgsFeature f;
+  QgsFeature cachedFeature;
+  QgsFeatureIterator it = mPointsLayer->getFeatures();
+  while ( it.nextFeature( f ) )
+  {
+    QVERIFY( cache.featureAtId( f.id(), cachedFeature ) );
+    QCOMPARE( cachedFeature.attributes(), f.attributes() );
+    QCOMPARE( cachedFeature.geometry().exportToWkt(), f.geometry().exportToWkt() );
+  }
+
+  // geometry changes are stored in compact form too
+  it = mPointsLayer->getFeatures();
+  it.nextFeature( f );
+  mPointsLayer->startEditing();
+  QVERIFY( mPointsLayer->changeGeometry( f.id(), QgsGeometry::fromPoint( QgsPointXY( 5, 6 ) ) ) );
+  QVERIFY( cache.isFidCached( f.id() ) );
+  QVERIFY( cache.featureAtId( f.id(), cachedFeature ) );
+  QCOMPARE( cachedFeature.geometry().exportToWkt(), QStringLiteral( "Point (5 6)" ) );
+  mPointsLayer->rollBack();
+}
+
 void TestVectorLayerCache::onCommittedFeaturesAdded( const QString &layerId, const QgsFeatureList &features )
 {
   Q_UNUSED( layerId )
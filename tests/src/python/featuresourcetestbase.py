@@ -19,6 +19,7 @@ from qgis.core import (
     QgsRectangle,
     QgsFeatureRequest,
     QgsFeature,
+    QgsFeatureBatch,
     QgsWkbTypes,
     QgsGeometry,
     QgsAbstractFeatureIterator,
@@ -636,6 +637,38 @@ class FeatureSourceTestCase(object):
             assert f.hasGeometry(), 'Expected geometry, got none'
             self.assertTrue(f.isValid())
 
+    def testGetFeaturesBatch(self):
+        """ Test that features fetched in batches match the features fetched one by one """
+        expected = {f.id(): f for f in self.source.getFeatures()}
+
+        fields = self.source.fields()
+        batch = QgsFeatureBatch(fields)
+        self.assertEqual(batch.columnCount(), fields.count())
+        result = {}
+        it = self.source.getFeatures()
+        while it.nextBatch(batch, 2):
+            self.assertLessEqual(batch.count(), 2)
+            for row in range(batch.count()):
+                result[batch.id(row)] = batch.feature(row)
+
+        self.assertEqual(set(result.keys()), set(expected.keys()))
+        for fid, f in expected.items():
+            self.assertEqual(result[fid].attributes(), f.attributes())
+            self.assertEqual(result[fid].hasGeometry(), f.hasGeometry())
+            if f.hasGeometry():
+                self.assertEqual(result[fid].geometry().exportToWkt(), f.geometry().exportToWkt())
+
+        # limit and subset of attributes
+        request = QgsFeatureRequest().setLimit(3).setSubsetOfAttributes(['cnt'], fields)
+        batch = QgsFeatureBatch(fields, [fields.lookupField('cnt')])
+        self.assertEqual(batch.columnCount(), 1)
+        values = []
+        it = self.source.getFeatures(request)
+        while it.nextBatch(batch, 2):
+            values.extend([batch.value(row, 0) for row in range(batch.count())])
+        self.assertEqual(len(values), 3)
+        self.assertTrue(set(values).issubset(set([-200, 300, 100, 200, 400])))
+
     def testUniqueValues(self):
         self.assertEqual(set(self.source.uniqueValues(1)), set([-200, 100, 200, 300, 400]))
         assert set(['Apple', 'Honey', 'Orange', 'Pear', NULL]) == set(self.source.uniqueValues(2)), 'Got {}'.format(set(self.source.uniqueValues(2)))
@@ -0,0 +1,142 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsContractionHierarchy.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Development Team'
+__date__ = '17/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+import math
+import os
+import random
+import struct
+
+from qgis.PyQt.QtCore import QTemporaryDir
+from qgis.core import QgsPointXY
+from qgis.analysis import QgsGraph, QgsGraphAnalyzer, QgsCompactGraph, QgsContractionHierarchy
+
+from qgis.testing import start_app, unittest
+
+start_app()
+
+
+def roadGraph(seed, size):
+    """ A grid of two way roads with random speeds, some of them missing """
+    rng = random.Random(seed)
+    graph = QgsGraph()
+    for y in range(size):
+        for x in range(size):
+            graph.addVertex(QgsPointXY(x, y))
+    for y in range(size):
+        for x in range(size):
+            vertex = y * size + x
+            for neighbor in ([vertex + 1] if x + 1 < size else []) + ([vertex + size] if y + 1 < size else []):
+                if rng.random() < 0.1:
+                    continue
+                cost = rng.randint(1, 20)
+                graph.addEdge(vertex, neighbor, [cost])
+                if rng.random() < 0.9:
+                    graph.addEdge(neighbor, vertex, [cost])
+    return graph
+
+
+class TestQgsContractionHierarchy(unittest.TestCase):
+
+    def checkPath(self, graph, start, end, cost, path):
+        vertex = start
+        total = 0
+        for edgeId in path:
+            edge = graph.edge(edgeId)
+            self.assertEqual(edge.outVertex(), vertex)
+            total += edge.cost(0)
+            vertex = edge.inVertex()
+        self.assertEqual(vertex, end)
+        self.assertEqual(total, cost)
+
+    def checkQueries(self, graph, hierarchy):
+        rng = random.Random(1)
+        vertexCount = graph.vertexCount()
+        for i in range(20):
+            start = rng.randrange(vertexCount)
+            tree, expected = QgsGraphAnalyzer.dijkstra(graph, start, 0)
+            targets = [rng.randrange(vertexCount) for j in range(10)]
+            self.assertEqual(hierarchy.costsToVertices(start, targets), [expected[t] for t in targets])
+            for end in targets:
+                cost, path = hierarchy.shortestPath(start, end)
+                self.assertEqual(cost, expected[end])
+                if not math.isinf(cost):
+                    self.checkPath(graph, start, end, cost, path)
+
+    def testQueries(self):
+        graph = roadGraph(1, 20)
+        hierarchy = QgsContractionHierarchy(QgsCompactGraph(graph))
+        self.assertTrue(hierarchy.isValid())
+        self.assertEqual(hierarchy.vertexCount(), 400)
+        self.assertEqual(hierarchy.edgeCount(), graph.edgeCount() + hierarchy.shortcutCount())
+        self.assertEqual(hierarchy.vertexPoint(21), QgsPointXY(1, 1))
+        self.checkQueries(graph, hierarchy)
+        self.assertEqual(hierarchy.shortestPath(7, 7), (0.0, []))
+
+    def testFile(self):
+        graph = roadGraph(2, 15)
+        hierarchy = QgsContractionHierarchy(QgsCompactGraph(graph))
+        tempDir = QTemporaryDir()
+        fileName = os.path.join(tempDir.path(), 'roads.qch')
+        self.assertTrue(hierarchy.writeToFile(fileName))
+
+        loaded = QgsContractionHierarchy()
+        self.assertTrue(loaded.readFromFile(fileName))
+        self.assertTrue(loaded.isValid())
+        self.assertEqual(loaded.vertexCount(), hierarchy.vertexCount())
+        self.assertEqual(loaded.shortcutCount(), hierarchy.shortcutCount())
+        self.assertEqual(loaded.vertexPoint(16), QgsPointXY(1, 1))
+        self.checkQueries(graph, loaded)
+
+        with open(fileName, 'rb') as f:
+            data = f.read()
+
+        # corrupted edge costs. The file holds a header of five 32 bit values, the vertex
+        # points and then the sizes and values of the first, second and cost edge arrays
+        vertexCount = struct.unpack('>I', data[16:20])[0]
+        firstOffset = 20 + 16 * vertexCount
+        edgeCount = struct.unpack('>I', data[firstOffset:firstOffset + 4])[0]
+        costOffset = firstOffset + 2 * (4 + 4 * edgeCount) + 4
+        self.assertEqual(struct.unpack('>I', data[costOffset - 4:costOffset])[0], edgeCount)
+        for cost in [-1.0, float('nan'), float('inf')]:
+            corrupted = data[:costOffset + 8] + struct.pack('>d', cost) + data[costOffset + 16:]
+            with open(fileName, 'wb') as f:
+                f.write(corrupted)
+            self.assertFalse(loaded.readFromFile(fileName))
+            self.assertFalse(loaded.isValid())
+
+        # truncated file
+        with open(fileName, 'wb') as f:
+            f.write(data[:len(data) // 2])
+        self.assertFalse(loaded.readFromFile(fileName))
+        self.assertFalse(loaded.isValid())
+        self.assertFalse(loaded.readFromFile(os.path.join(tempDir.path(), 'missing.qch')))
+
+    def testInvalid(self):
+        hierarchy = QgsContractionHierarchy()
+        self.assertFalse(hierarchy.isValid())
+        self.assertTrue(math.isinf(hierarchy.shortestPath(0, 1)[0]))
+        self.assertFalse(hierarchy.writeToFile('/dev/null'))
+
+        graph = roadGraph(3, 3)
+        self.assertFalse(QgsContractionHierarchy(QgsCompactGraph(graph), 1).isValid())
+
+        # the queries rely on non negative costs
+        graph.addEdge(0, 1, [-1])
+        self.assertFalse(QgsContractionHierarchy(QgsCompactGraph(graph)).isValid())
+
+
+if __name__ == '__main__':
+    unittest.main()
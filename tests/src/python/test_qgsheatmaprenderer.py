@@ -0,0 +1,90 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsHeatmapRenderer.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Development Team'
+__date__ = '17/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+import random
+
+from qgis.PyQt.QtCore import QSize
+from qgis.PyQt.QtGui import QColor
+from qgis.core import (QgsVectorLayer,
+                       QgsFeature,
+                       QgsGeometry,
+                       QgsPointXY,
+                       QgsRectangle,
+                       QgsMapSettings,
+                       QgsMapRendererSequentialJob,
+                       QgsHeatmapRenderer,
+                       QgsUnitTypes)
+from qgis.testing import start_app, unittest
+
+start_app()
+
+
+class TestQgsHeatmapRenderer(unittest.TestCase):
+
+    def setUp(self):
+        self.layer = QgsVectorLayer('Point?crs=epsg:3857&field=weight:double', 'points', 'memory')
+        rng = random.Random(3)
+        features = []
+        for i in range(5000):
+            f = QgsFeature(self.layer.fields())
+            f.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(rng.uniform(0, 100), rng.uniform(0, 100))))
+            f.setAttributes([1 + i % 4])
+            features.append(f)
+        self.assertTrue(self.layer.dataProvider().addFeatures(features)[0])
+
+    def createRenderer(self):
+        renderer = QgsHeatmapRenderer()
+        renderer.setRadius(10)
+        renderer.setRadiusUnit(QgsUnitTypes.RenderPixels)
+        renderer.setRenderQuality(1)
+        renderer.setWeightExpression('weight')
+        return renderer
+
+    def render(self):
+        settings = QgsMapSettings()
+        settings.setLayers([self.layer])
+        settings.setExtent(QgsRectangle(0, 0, 100, 100))
+        settings.setOutputSize(QSize(300, 300))
+        settings.setBackgroundColor(QColor(255, 255, 255))
+        job = QgsMapRendererSequentialJob(settings)
+        job.start()
+        job.waitForFinished()
+        return job.renderedImage()
+
+    def testDensityCache(self):
+        """Test that the cached density grid is only reused for the same points"""
+        self.layer.setRenderer(self.createRenderer())
+        first = self.render()
+        # redraw with the density grid of the first one
+        self.assertEqual(self.render(), first)
+
+        # a new renderer computes the same heatmap
+        self.layer.setRenderer(self.createRenderer())
+        self.assertEqual(self.render(), first)
+
+        # changed points are not drawn from the cache
+        f = QgsFeature(self.layer.fields())
+        f.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(50, 50)))
+        f.setAttributes([100])
+        self.assertTrue(self.layer.dataProvider().addFeatures([f])[0])
+        changed = self.render()
+        self.assertNotEqual(changed, first)
+        self.layer.setRenderer(self.createRenderer())
+        self.assertEqual(self.render(), changed)
+
+
+if __name__ == '__main__':
+    unittest.main()
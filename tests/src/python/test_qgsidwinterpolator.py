@@ -0,0 +1,203 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsIDWInterpolator and QgsGridFileWriter.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Development Team'
+__date__ = '17/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+import math
+import os
+import random
+import shutil
+import sys
+import tempfile
+
+from qgis.core import QgsFeature, QgsGeometry, QgsPointXY, QgsRectangle, QgsVectorLayer
+from qgis.analysis import QgsGridFileWriter, QgsIDWInterpolator, QgsInterpolator
+
+from qgis.testing import start_app, unittest
+
+start_app()
+
+
+def bruteForceValue(points, x, y, maxNeighbors, searchRadius):
+    """Returns the IDW value at x, y from the nearest points, or None if no point is used.
+    Ties between equally distant points go to the first ones."""
+    candidates = []
+    for i, (px, py, pz) in enumerate(points):
+        sqrDistance = (px - x) * (px - x) + (py - y) * (py - y)
+        if searchRadius <= 0 or sqrDistance <= searchRadius * searchRadius:
+            candidates.append((sqrDistance, i))
+    candidates.sort()
+    if maxNeighbors > 0:
+        candidates = candidates[:maxNeighbors]
+
+    sumCounter = 0.0
+    sumDenominator = 0.0
+    for i in sorted(i for d, i in candidates):
+        px, py, pz = points[i]
+        distance = math.sqrt((px - x) * (px - x) + (py - y) * (py - y))
+        if distance < sys.float_info.min:
+            return pz
+        weight = 1 / math.pow(distance, 2.0)
+        sumCounter += weight * pz
+        sumDenominator += weight
+    if sumDenominator == 0.0:
+        return None
+    return sumCounter / sumDenominator
+
+
+def bruteForceGrid(points, extent, columns, rows, maxNeighbors, searchRadius):
+    """Returns the values of the cells by rows, as computed at their centers by QgsGridFileWriter"""
+    cellSizeX = extent.width() / columns
+    cellSizeY = extent.height() / rows
+    values = []
+    y = extent.yMaximum() - cellSizeY / 2.0
+    for i in range(rows):
+        x = extent.xMinimum() + cellSizeX / 2.0
+        for j in range(columns):
+            values.append(bruteForceValue(points, x, y, maxNeighbors, searchRadius))
+            x += cellSizeX
+        y -= cellSizeY
+    return values
+
+
+class TestQgsIDWInterpolator(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.basetestpath = tempfile.mkdtemp()
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.basetestpath, True)
+
+    def createLayer(self, points):
+        layer = QgsVectorLayer('Point?crs=epsg:3857&field=value:double', 'points', 'memory')
+        features = []
+        for x, y, z in points:
+            f = QgsFeature(layer.fields())
+            f.setGeometry(QgsGeometry.fromPoint(QgsPointXY(x, y)))
+            f.setAttributes([z])
+            features.append(f)
+        self.assertTrue(layer.dataProvider().addFeatures(features))
+        return layer
+
+    def createInterpolator(self, layer, maxNeighbors, searchRadius):
+        data = QgsInterpolator.LayerData()
+        data.vectorLayer = layer
+        data.zCoordInterpolation = False
+        data.interpolationAttribute = 0
+        data.mInputType = QgsInterpolator.POINTS
+        interpolator = QgsIDWInterpolator([data])
+        interpolator.setMaxNeighbors(maxNeighbors)
+        interpolator.setSearchRadius(searchRadius)
+        self.assertEqual(interpolator.maxNeighbors(), maxNeighbors)
+        self.assertEqual(interpolator.searchRadius(), searchRadius)
+        return interpolator
+
+    def writeGrid(self, points, extent, columns, rows, maxNeighbors, searchRadius, threadCount):
+        layer = self.createLayer(points)
+        interpolator = self.createInterpolator(layer, maxNeighbors, searchRadius)
+        path = os.path.join(self.basetestpath, 'grid_{}_{}_{}.asc'.format(maxNeighbors, searchRadius, threadCount))
+        writer = QgsGridFileWriter(interpolator, path, extent, columns, rows, extent.width() / columns, extent.height() / rows)
+        if threadCount is None:
+            # the ideal thread count of the system
+            self.assertGreaterEqual(writer.threadCount(), 1)
+        else:
+            writer.setThreadCount(threadCount)
+            self.assertEqual(writer.threadCount(), threadCount)
+        self.assertEqual(writer.writeFile(), 0)
+        return path
+
+    def readGrid(self, path):
+        with open(path, 'r') as f:
+            lines = f.read().splitlines()
+        header = lines.index('NODATA_VALUE -9999') + 1
+        return [float(v) for line in lines[header:] for v in line.split()]
+
+    def assertGrid(self, points, extent, columns, rows, maxNeighbors, searchRadius):
+        """Checks the grid written by QgsGridFileWriter against the brute force values, returns the grid"""
+        values = self.readGrid(self.writeGrid(points, extent, columns, rows, maxNeighbors, searchRadius, 1))
+        expected = bruteForceGrid(points, extent, columns, rows, maxNeighbors, searchRadius)
+        self.assertEqual(len(values), len(expected))
+        for i, (value, expectedValue) in enumerate(zip(values, expected)):
+            message = 'cell {} with {} neighbors in radius {}'.format(i, maxNeighbors, searchRadius)
+            if expectedValue is None:
+                self.assertEqual(value, -9999, message)
+            else:
+                # values are written with 8 significant digits
+                self.assertAlmostEqual(value, expectedValue, delta=1e-6 * max(1, abs(expectedValue)), msg=message)
+        return values
+
+    def testNeighbors(self):
+        rng = random.Random(1)
+        # integer coordinates and cell centers on halves give many equally distant points
+        points = [(rng.randint(0, 50), rng.randint(0, 50), rng.uniform(0, 100)) for i in range(200)]
+        # the grid extends beyond the data points, queries outside of the index are tested too
+        extent = QgsRectangle(-20, -20, 70, 70)
+        for maxNeighbors, searchRadius in [(1, 0), (5, 0), (500, 0), (0, 6), (0, 100), (8, 10)]:
+            self.assertGrid(points, extent, 30, 30, maxNeighbors, searchRadius)
+
+        # without limits, every point is used
+        self.assertEqual(self.readGrid(self.writeGrid(points, extent, 30, 30, 500, 0, 1)),
+                         self.readGrid(self.writeGrid(points, extent, 30, 30, 0, 0, 1)))
+
+    def testNoPointInRadius(self):
+        points = [(0, 0, 1), (1, 0, 2), (0, 1, 3)]
+        values = self.assertGrid(points, QgsRectangle(-5, -5, 5, 5), 10, 10, 0, 2)
+        # top left cell, centered on (-4.5, 4.5)
+        self.assertEqual(values[0], -9999)
+        # cell centered on (0.5, 0.5)
+        self.assertNotEqual(values[4 * 10 + 5], -9999)
+        self.assertEqual(values.count(-9999), bruteForceGrid(points, QgsRectangle(-5, -5, 5, 5), 10, 10, 0, 2).count(None))
+
+        values = self.assertGrid(points, QgsRectangle(-5, -5, 5, 5), 10, 10, 2, 2)
+        self.assertEqual(values[0], -9999)
+
+    def testDegenerateExtents(self):
+        extent = QgsRectangle(-10, -10, 30, 30)
+        # points on a vertical line and on a horizontal line
+        vertical = [(10, y, y * 2.5) for y in range(0, 21)]
+        horizontal = [(x, 10, x * 2.5) for x in range(0, 21)]
+        for points in (vertical, horizontal):
+            for maxNeighbors, searchRadius in [(2, 0), (0, 5), (3, 8)]:
+                self.assertGrid(points, extent, 20, 20, maxNeighbors, searchRadius)
+
+        # a single point, at the center of a cell
+        for maxNeighbors, searchRadius in [(1, 0), (3, 0), (0, 12), (2, 12)]:
+            values = self.assertGrid([(3, 5, 7)], extent, 20, 20, maxNeighbors, searchRadius)
+            self.assertEqual(values[12 * 20 + 6], 7)
+
+        # equally distant points at the same location, the first ones are used
+        values = self.assertGrid([(3, 4, 1), (3, 4, 2), (3, 4, 3)], extent, 20, 20, 2, 0)
+        self.assertEqual(set(values), {1.5})
+
+    def testThreadCount(self):
+        rng = random.Random(2)
+        points = [(rng.uniform(0, 100), rng.uniform(0, 100), rng.uniform(0, 100)) for i in range(300)]
+        # more rows than the blocks of rows queued by 4 threads
+        extent = QgsRectangle(-10, -10, 110, 110)
+        for maxNeighbors, searchRadius in [(0, 0), (6, 0), (0, 8), (4, 15)]:
+            with open(self.writeGrid(points, extent, 50, 200, maxNeighbors, searchRadius, 1), 'rb') as f:
+                singleThread = f.read()
+            with open(self.writeGrid(points, extent, 50, 200, maxNeighbors, searchRadius, 4), 'rb') as f:
+                fourThreads = f.read()
+            self.assertEqual(singleThread, fourThreads)
+            # the workers call the interpolator while the caller waits, which must not hold the GIL
+            with open(self.writeGrid(points, extent, 50, 200, maxNeighbors, searchRadius, None), 'rb') as f:
+                self.assertEqual(f.read(), singleThread)
+        self.assertIn(b'-9999', fourThreads)
+
+
+if __name__ == '__main__':
+    unittest.main()
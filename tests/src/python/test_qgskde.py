@@ -0,0 +1,124 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsKernelDensityEstimation.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Development Team'
+__date__ = '17/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+import math
+import os
+import random
+import struct
+
+from osgeo import gdal
+from qgis.PyQt.QtCore import QTemporaryDir
+from qgis.core import QgsVectorLayer, QgsFeature, QgsGeometry, QgsPointXY
+from qgis.analysis import QgsKernelDensityEstimation
+
+from qgis.testing import start_app, unittest
+
+start_app()
+
+NO_DATA = -9999
+
+
+def toFloat32(value):
+    return struct.unpack('f', struct.pack('f', value))[0]
+
+
+class TestQgsKernelDensityEstimation(unittest.TestCase):
+
+    def setUp(self):
+        self.tempDir = QTemporaryDir()
+
+        # points spread over a surface of several tiles
+        self.layer = QgsVectorLayer('Point?crs=epsg:3857&field=weight:double', 'points', 'memory')
+        rng = random.Random(5)
+        features = []
+        for i in range(2000):
+            f = QgsFeature(self.layer.fields())
+            f.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(rng.uniform(0, 40), rng.uniform(0, 30))))
+            f.setAttributes([1 + i % 3])
+            features.append(f)
+        self.assertTrue(self.layer.dataProvider().addFeatures(features)[0])
+
+    def parameters(self):
+        parameters = QgsKernelDensityEstimation.Parameters()
+        parameters.source = self.layer
+        parameters.radius = 0.5
+        parameters.weightField = 'weight'
+        parameters.pixelSize = 0.1
+        parameters.shape = QgsKernelDensityEstimation.KernelQuartic
+        parameters.decayRatio = 0
+        parameters.outputValues = QgsKernelDensityEstimation.OutputRaw
+        return parameters
+
+    def runKde(self, threadCount):
+        outputFile = os.path.join(self.tempDir.path(), 'kde_{}.tif'.format(threadCount))
+        kde = QgsKernelDensityEstimation(self.parameters(), outputFile, 'GTiff')
+        kde.setThreadCount(threadCount)
+        self.assertEqual(kde.threadCount(), threadCount)
+        self.assertEqual(kde.run(), QgsKernelDensityEstimation.Success)
+
+        dataset = gdal.Open(outputFile)
+        band = dataset.GetRasterBand(1)
+        width = band.XSize
+        height = band.YSize
+        values = struct.unpack('%df' % (width * height), band.ReadRaster(0, 0, width, height, buf_type=gdal.GDT_Float32))
+        return width, height, values
+
+    def expectedValues(self, width, height):
+        """Adds the kernel of each point to the cells, one point after the other"""
+        # the surface covers the points, expanded by the radius
+        extent = self.layer.extent()
+        xMin = extent.xMinimum() - 0.5
+        yMin = extent.yMinimum() - 0.5
+        yMax = extent.yMaximum() + 0.5
+        pixelSize = 0.1
+        radius = 0.5
+        buffer = 5
+        blockSize = 2 * buffer + 1
+        values = [float(NO_DATA)] * (width * height)
+        for f in self.layer.getFeatures():
+            p = f.geometry().asPoint()
+            xPosition = int((p.x() - xMin) / pixelSize - buffer)
+            yPosition = int((p.y() - yMin) / pixelSize - buffer)
+            yPositionIO = int((yMax - p.y()) / pixelSize - buffer)
+            for xp in range(blockSize):
+                for yp in range(blockSize):
+                    distance = math.sqrt(((xPosition + xp + 0.5) * pixelSize + xMin - p.x()) ** 2 +
+                                         ((yPosition + yp + 0.5) * pixelSize + yMin - p.y()) ** 2)
+                    if distance > radius:
+                        continue
+                    pos = (yPositionIO + yp) * width + xPosition + xp
+                    if values[pos] == NO_DATA:
+                        values[pos] = 0.0
+                    values[pos] = toFloat32(values[pos] + f['weight'] * (1 - (distance / radius) ** 2) ** 2)
+        return values
+
+    def testTiledSurface(self):
+        """Test that the surface accumulated in tiles matches adding the kernels point by point"""
+        width, height, values = self.runKde(1)
+        self.assertTrue(width > 256 and height > 256)
+        expected = self.expectedValues(width, height)
+        mismatches = [i for i in range(len(values)) if abs(values[i] - expected[i]) > 1e-4]
+        self.assertEqual(mismatches, [])
+
+    def testThreadCount(self):
+        """Test that the surface does not depend on the number of threads"""
+        single = self.runKde(1)
+        multi = self.runKde(4)
+        self.assertEqual(single, multi)
+
+
+if __name__ == '__main__':
+    unittest.main()
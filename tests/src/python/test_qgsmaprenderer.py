@@ -427,6 +427,48 @@ class TestQgsMapRenderer(unittest.TestCase):
         self.assertFalse(job.isActive())
         self.assertEqual(len(finished_spy), 1)
 
+    def testParallelRendererLayerTiles(self):
+        """test that rendering a layer split into tiles gives the same result as rendering it in one piece"""
+        layer = QgsVectorLayer("Point?field=fldtxt:string",
+                               "layer1", "memory")
+
+        for i in range(2000):
+            x = uniform(5, 25)
+            y = uniform(25, 45)
+            g = QgsGeometry.fromPoint(QgsPointXY(x, y))
+            f = QgsFeature()
+            f.setGeometry(g)
+            f.initAttributes(1)
+            layer.dataProvider().addFeatures([f])
+
+        settings = QgsMapSettings()
+        settings.setExtent(QgsRectangle(5, 25, 25, 45))
+        settings.setOutputSize(QSize(600, 400))
+        settings.setLayers([layer])
+        settings.setFlag(QgsMapSettings.Antialiasing, False)
+
+        # make sure there are idle threads which tiles can use
+        thread_count = QThreadPool.globalInstance().maxThreadCount()
+        QThreadPool.globalInstance().setMaxThreadCount(8)
+
+        job = QgsMapRendererParallelJob(settings)
+        job.start()
+        job.waitForFinished()
+        expected = job.renderedImage()
+
+        settings.setFlag(QgsMapSettings.RenderLayerTiles, True)
+        cache = QgsMapRendererCache()
+        job = QgsMapRendererParallelJob(settings)
+        job.setCache(cache)
+        job.start()
+        job.waitForFinished()
+        self.assertEqual(job.renderedImage(), expected)
+        # the composed layer image is cached, not individual tiles
+        self.assertTrue(cache.hasCacheImage(layer.id()))
+        self.assertEqual(cache.cacheImage(layer.id()).size(), QSize(600, 400))
+
+        QThreadPool.globalInstance().setMaxThreadCount(thread_count)
+
     def runRendererChecks(self, renderer):
         """ runs all checks on the specified renderer """
         self.checkRendererUseCachedLabels(renderer)
@@ -15,12 +15,13 @@ __revision__ = '$Format:%H$'
 import qgis  # NOQA
 
 from qgis.core import (QgsMapRendererCache,
+                       QgsMapSettings,
                        QgsRectangle,
                        QgsVectorLayer,
                        QgsProject)
 from qgis.testing import start_app, unittest
-from qgis.PyQt.QtCore import QCoreApplication
-from qgis.PyQt.QtGui import QImage
+from qgis.PyQt.QtCore import QCoreApplication, QSize, QTemporaryDir
+from qgis.PyQt.QtGui import QImage, qRgb
 from time import sleep
 start_app()
 
@@ -266,6 +267,135 @@ class TestQgsMapRendererCache(unittest.TestCase):
         # cache should be cleared
         self.assertFalse(cache.hasCacheImage('l1'))
 
+    def tileSettings(self, x, y):
+        """ map settings for a 100x100 pixel view at pixel x, y of a 1 map unit per pixel grid """
+        settings = QgsMapSettings()
+        settings.setOutputSize(QSize(100, 100))
+        settings.setExtent(QgsRectangle(x, -y - 100, x + 100, -y))
+        return settings
+
+    def tileImage(self, x, y):
+        """ image of a view, whose pixel colors depend on their position in the grid """
+        im = QImage(100, 100, QImage.Format_ARGB32_Premultiplied)
+        for row in range(100):
+            for col in range(100):
+                im.setPixel(col, row, qRgb((x + col) % 256, (y + row) % 256, 0))
+        return im
+
+    def testTiles(self):
+        cache = QgsMapRendererCache()
+        self.assertFalse(cache.isTileCacheEnabled())
+        self.assertFalse(cache.initTiles(self.tileSettings(0, 0)))
+        cache.setTileCacheEnabled(True)
+        self.assertTrue(cache.isTileCacheEnabled())
+
+        layer = QgsVectorLayer("Point?field=fldtxt:string",
+                               "layer1", "memory")
+
+        # render four overlapping views
+        for x, y in [(0, 0), (60, 0), (0, 60), (60, 60)]:
+            self.assertTrue(cache.initTiles(self.tileSettings(x, y)))
+            self.assertFalse(cache.hasCacheTiles('layer'))
+            self.assertTrue(cache.tiledCacheImage('layer').isNull())
+            cache.setCacheTiles('layer', self.tileImage(x, y), [layer])
+        self.assertGreater(cache.tileMemoryUsage(), 0)
+
+        # a view inside the rendered views, without their edges
+        self.assertTrue(cache.initTiles(self.tileSettings(30, 25)))
+        self.assertTrue(cache.hasCacheTiles('layer'))
+        self.assertFalse(cache.hasCacheTiles('other layer'))
+        im = cache.tiledCacheImage('layer')
+        self.assertEqual(im.size(), QSize(100, 100))
+        self.assertEqual(im, self.tileImage(30, 25))
+
+        # partly outside the rendered views
+        self.assertTrue(cache.initTiles(self.tileSettings(50, 50)))
+        self.assertFalse(cache.hasCacheTiles('layer'))
+        self.assertTrue(cache.tiledCacheImage('layer').isNull())
+
+        # another scale uses another grid
+        settings = self.tileSettings(30, 25)
+        settings.setExtent(QgsRectangle(30, -325, 230, -125))
+        self.assertTrue(cache.initTiles(settings))
+        self.assertFalse(cache.hasCacheTiles('layer'))
+
+        # a map extent between the pixels of the grid
+        self.assertTrue(cache.initTiles(self.tileSettings(30.5, 25)))
+        self.assertFalse(cache.hasCacheTiles('layer'))
+
+        # tiles are kept when the images are cleared
+        self.assertTrue(cache.initTiles(self.tileSettings(30, 25)))
+        cache.init(QgsRectangle(1, 2, 3, 4), 1000)
+        self.assertTrue(cache.hasCacheTiles('layer'))
+
+        # but removed when the layer is repainted
+        layer.triggerRepaint()
+        self.assertFalse(cache.hasCacheTiles('layer'))
+        self.assertEqual(cache.tileMemoryUsage(), 0)
+
+    def testTileMargin(self):
+        cache = QgsMapRendererCache()
+        cache.setTileCacheEnabled(True)
+
+        # the edges of the image are not stored by default
+        self.assertTrue(cache.initTiles(self.tileSettings(0, 0)))
+        cache.setCacheTiles('layer', self.tileImage(0, 0))
+        self.assertFalse(cache.hasCacheTiles('layer'))
+
+        # without a margin, the whole image is stored
+        cache.setCacheTiles('layer', self.tileImage(0, 0), [], 0)
+        self.assertTrue(cache.hasCacheTiles('layer'))
+        self.assertEqual(cache.tiledCacheImage('layer'), self.tileImage(0, 0))
+
+        # a view 15 pixels inside the rendered views is only covered with a margin of at most 15 pixels
+        for margin, covered in [(15, True), (16, False)]:
+            cache.setTileCacheEnabled(False)
+            cache.setTileCacheEnabled(True)
+            self.assertTrue(cache.initTiles(self.tileSettings(0, 0)))
+            cache.setCacheTiles('layer', self.tileImage(0, 0), [], margin)
+            self.assertTrue(cache.initTiles(self.tileSettings(30, 30)))
+            cache.setCacheTiles('layer', self.tileImage(30, 30), [], margin)
+            self.assertTrue(cache.initTiles(self.tileSettings(0, 30)))
+            cache.setCacheTiles('layer', self.tileImage(0, 30), [], margin)
+            self.assertTrue(cache.initTiles(self.tileSettings(30, 0)))
+            cache.setCacheTiles('layer', self.tileImage(30, 0), [], margin)
+            self.assertTrue(cache.initTiles(self.tileSettings(15, 15)))
+            self.assertEqual(cache.hasCacheTiles('layer'), covered)
+
+    def cacheTileRegion(self, cache, x, y):
+        """ caches four overlapping views, whose inner parts cover the 128x128 pixels from x + 16, y + 16 """
+        for dx, dy in [(0, 0), (60, 0), (0, 60), (60, 60)]:
+            self.assertTrue(cache.initTiles(self.tileSettings(x + dx, y + dy)))
+            cache.setCacheTiles('layer', self.tileImage(x + dx, y + dy))
+
+    def testTileBudget(self):
+        cache = QgsMapRendererCache()
+        cache.setTileCacheEnabled(True)
+        cache.setTileMemoryBudget(256 * 256 * 4)
+        self.assertEqual(cache.tileMemoryBudget(), 256 * 256 * 4)
+
+        # without a spill directory, the least recently used tiles are dropped
+        self.cacheTileRegion(cache, 290, 290)
+        self.cacheTileRegion(cache, 0, 0)
+        self.assertLessEqual(cache.tileMemoryUsage(), 256 * 256 * 4)
+        self.assertTrue(cache.initTiles(self.tileSettings(30, 30)))
+        self.assertTrue(cache.hasCacheTiles('layer'))
+        self.assertTrue(cache.initTiles(self.tileSettings(320, 320)))
+        self.assertFalse(cache.hasCacheTiles('layer'))
+
+        # with a spill directory, they are read back from disk
+        spill_dir = QTemporaryDir()
+        cache.setTileSpillDirectory(spill_dir.path())
+        self.assertEqual(cache.tileSpillDirectory(), spill_dir.path())
+        self.cacheTileRegion(cache, 290, 290)
+        self.assertLessEqual(cache.tileMemoryUsage(), 256 * 256 * 4)
+        self.assertTrue(cache.initTiles(self.tileSettings(320, 320)))
+        self.assertTrue(cache.hasCacheTiles('layer'))
+        self.assertEqual(cache.tiledCacheImage('layer'), self.tileImage(320, 320))
+        self.assertTrue(cache.initTiles(self.tileSettings(30, 30)))
+        self.assertTrue(cache.hasCacheTiles('layer'))
+        self.assertEqual(cache.tiledCacheImage('layer'), self.tileImage(30, 30))
+        self.assertLessEqual(cache.tileMemoryUsage(), 256 * 256 * 4)
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,90 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsNetworkCostMatrix.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Development Team'
+__date__ = '17/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+import math
+import random
+
+from qgis.core import QgsPointXY, QgsVectorLayer, QgsFeedback
+from qgis.analysis import QgsGraph, QgsGraphAnalyzer, QgsCompactGraph, QgsNetworkCostMatrix
+
+from qgis.testing import start_app, unittest
+
+start_app()
+
+
+class TestQgsNetworkCostMatrix(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        rng = random.Random(1)
+        cls.graph = QgsGraph()
+        for i in range(300):
+            cls.graph.addVertex(QgsPointXY(i, 0))
+        for i in range(900):
+            cls.graph.addEdge(rng.randrange(300), rng.randrange(300), [rng.random() * 10])
+        cls.compact = QgsCompactGraph(cls.graph)
+        cls.origins = [rng.randrange(300) for i in range(40)] + [-1]
+        cls.destinations = [rng.randrange(300) for i in range(25)] + [1000]
+
+    def expectedMatrix(self):
+        matrix = []
+        for origin in self.origins:
+            if origin < 0:
+                matrix.extend([math.inf] * len(self.destinations))
+                continue
+            tree, costs = QgsGraphAnalyzer.dijkstra(self.graph, origin, 0)
+            matrix.extend([costs[d] if d < len(costs) else math.inf for d in self.destinations])
+        return matrix
+
+    def testCostMatrix(self):
+        expected = self.expectedMatrix()
+        for threads in (1, 4):
+            matrix = QgsNetworkCostMatrix(self.compact)
+            matrix.setThreadCount(threads)
+            self.assertEqual(matrix.threadCount(), threads)
+            self.assertEqual(matrix.costMatrix(self.origins, self.destinations), expected)
+
+        self.assertEqual(QgsNetworkCostMatrix(self.compact).costMatrix([], self.destinations), [])
+
+        # too large for a QVector, the matrix is not computed
+        vertices = [i % 300 for i in range(20000)]
+        self.assertEqual(QgsNetworkCostMatrix(self.compact).costMatrix(vertices, vertices), [])
+
+    def testWriteToSink(self):
+        expected = self.expectedMatrix()
+        for includeUnreachable in (False, True):
+            layer = QgsVectorLayer('None?field=origin:integer&field=destination:integer&field=cost:double', 'matrix', 'memory')
+            matrix = QgsNetworkCostMatrix(self.compact)
+            matrix.setThreadCount(3)
+            self.assertTrue(matrix.writeToSink(self.origins, self.destinations, layer.dataProvider(), None, includeUnreachable))
+
+            rows = [(f['origin'], f['destination'], f['cost']) for f in layer.getFeatures()]
+            pairs = [(i // len(self.destinations), i % len(self.destinations), cost) for i, cost in enumerate(expected)]
+            if not includeUnreachable:
+                pairs = [p for p in pairs if not math.isinf(p[2])]
+            self.assertEqual(rows, pairs)
+
+        self.assertEqual([f.name() for f in QgsNetworkCostMatrix.fields()], ['origin', 'destination', 'cost'])
+
+    def testCanceled(self):
+        feedback = QgsFeedback()
+        feedback.cancel()
+        matrix = QgsNetworkCostMatrix(self.compact)
+        self.assertEqual(matrix.costMatrix(self.origins, self.destinations, feedback), [])
+
+
+if __name__ == '__main__':
+    unittest.main()
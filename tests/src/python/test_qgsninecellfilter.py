@@ -0,0 +1,80 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsNineCellFilter.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Development Team'
+__date__ = '17/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+import math
+import os
+import struct
+
+from osgeo import gdal
+from qgis.PyQt.QtCore import QTemporaryDir
+from qgis.analysis import (QgsSlopeFilter,
+                           QgsAspectFilter,
+                           QgsHillshadeFilter,
+                           QgsRuggednessFilter)
+
+from qgis.testing import start_app, unittest
+
+start_app()
+
+
+class TestQgsNineCellFilter(unittest.TestCase):
+
+    def setUp(self):
+        self.tempDir = QTemporaryDir()
+        self.demFile = os.path.join(self.tempDir.path(), 'dem.tif')
+
+        # a tiled DEM, so that rows are processed in several bands of blocks
+        width = 301
+        height = 223
+        dataset = gdal.GetDriverByName('GTiff').Create(self.demFile, width, height, 1, gdal.GDT_Float32,
+                                                        ['TILED=YES', 'BLOCKXSIZE=16', 'BLOCKYSIZE=16'])
+        dataset.SetGeoTransform([1000, 10, 0, 5000, 0, -10])
+        band = dataset.GetRasterBand(1)
+        band.SetNoDataValue(-9999)
+        values = []
+        for row in range(height):
+            for col in range(width):
+                if (row * 7 + col) % 97 == 0:
+                    values.append(-9999)
+                else:
+                    values.append(100 * math.sin(row / 17.0) * math.cos(col / 23.0) + row * 0.5)
+        band.WriteRaster(0, 0, width, height, struct.pack('%df' % len(values), *values))
+        dataset = None
+
+    def process(self, filterClass, threadCount):
+        outputFile = os.path.join(self.tempDir.path(), '{}_{}.tif'.format(filterClass.__name__, threadCount))
+        if filterClass == QgsHillshadeFilter:
+            nineCellFilter = filterClass(self.demFile, outputFile, 'GTiff', 300, 40)
+        else:
+            nineCellFilter = filterClass(self.demFile, outputFile, 'GTiff')
+        nineCellFilter.setThreadCount(threadCount)
+        self.assertEqual(nineCellFilter.threadCount(), threadCount)
+        self.assertEqual(nineCellFilter.processRaster(None), 0)
+
+        dataset = gdal.Open(outputFile)
+        band = dataset.GetRasterBand(1)
+        return band.ReadRaster(0, 0, dataset.RasterXSize, dataset.RasterYSize)
+
+    def testThreads(self):
+        """ rows computed by several threads must give the same raster as sequential rows """
+        for filterClass in [QgsSlopeFilter, QgsAspectFilter, QgsHillshadeFilter, QgsRuggednessFilter]:
+            expected = self.process(filterClass, 1)
+            self.assertEqual(len(expected), 301 * 223 * 4)
+            self.assertEqual(self.process(filterClass, 4), expected, filterClass.__name__)
+
+
+if __name__ == '__main__':
+    unittest.main()
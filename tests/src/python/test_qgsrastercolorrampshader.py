@@ -33,6 +33,45 @@ class TestQgsRasterColorRampShader(unittest.TestCase):
         self.assertFalse(shader.shade(float('NaN'))[0])
         self.assertFalse(shader.shade(float("inf"))[0])
 
+    def testLookupTable(self):
+        shader = QgsColorRampShader()
+        shader.setColorRampType(QgsColorRampShader.Interpolated)
+        item1 = QgsColorRampShader.ColorRampItem(0, QColor(0, 0, 0))
+        item2 = QgsColorRampShader.ColorRampItem(10, QColor(100, 200, 250))
+        shader.setColorRampItemList([item1, item2])
+
+        # integer values are shaded exactly
+        self.assertEqual(shader.shade(0), (True, 0, 0, 0, 255))
+        self.assertEqual(shader.shade(5), (True, 50, 100, 125, 255))
+        self.assertEqual(shader.shade(10), (True, 100, 200, 250, 255))
+        self.assertEqual(shader.shade(2.5), (True, 25, 50, 62, 255))
+
+        # the compiled colors must follow changes to the color ramp
+        item2 = QgsColorRampShader.ColorRampItem(10, QColor(200, 200, 200))
+        shader.setColorRampItemList([item1, item2])
+        self.assertEqual(shader.shade(5), (True, 100, 100, 100, 255))
+        shader.setColorRampType(QgsColorRampShader.Discrete)
+        self.assertEqual(shader.shade(5), (True, 200, 200, 200, 255))
+        shader.setColorRampType(QgsColorRampShader.Interpolated)
+        self.assertEqual(shader.shade(5), (True, 100, 100, 100, 255))
+
+        # copies share the compiled colors, but not the changes made afterwards
+        copy = QgsColorRampShader(shader)
+        self.assertEqual(copy.shade(5), (True, 100, 100, 100, 255))
+        shader.setColorRampItemList([item1])
+        self.assertEqual(copy.shade(5), (True, 100, 100, 100, 255))
+
+        # non integer values are shaded with the nearest step of the quantized table
+        self.assertEqual(copy.quantizedLookupTableSteps(), 0)
+        copy.setQuantizedLookupTableSteps(100)
+        self.assertEqual(copy.quantizedLookupTableSteps(), 100)
+        self.assertEqual(copy.shade(2.5), (True, 50, 50, 50, 255))
+        result = copy.shade(2.54)
+        self.assertTrue(result[0])
+        for component in result[1:4]:
+            self.assertLessEqual(abs(component - 50.8), 2)
+        self.assertEqual(copy.shade(11.5), (True, 200, 200, 200, 255))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -694,6 +694,38 @@ class TestQgsRasterLayer(unittest.TestCase):
         # compare xml documents
         self.assertEqual(layer_doc.toString(), clone_doc.toString())
 
+    def testPseudoColorBlockDataTypes(self):
+        """ test that pseudocolor blocks are shaded the same for all data types """
+        for file_name in ['band1_byte_noct_epsg4326.tif',
+                          'band1_int16_noct_epsg4326.tif',
+                          'band1_float32_noct_epsg4326.tif']:
+            layer = QgsRasterLayer(os.path.join(unitTestDataPath('raster'), file_name), 'layer')
+            self.assertTrue(layer.isValid())
+            provider = layer.dataProvider()
+            width = layer.width()
+            height = layer.height()
+            data = provider.block(1, layer.extent(), width, height)
+            values = [data.value(row, col) for row in range(height) for col in range(width)
+                      if not data.isNoData(row, col)]
+
+            ramp_shader = QgsColorRampShader(min(values), max(values))
+            ramp_shader.setColorRampType(QgsColorRampShader.Interpolated)
+            ramp_shader.setColorRampItemList([QgsColorRampShader.ColorRampItem(min(values), QColor(255, 0, 0)),
+                                              QgsColorRampShader.ColorRampItem(max(values), QColor(0, 0, 255))])
+            shader = QgsRasterShader()
+            shader.setRasterShaderFunction(ramp_shader)
+            renderer = QgsSingleBandPseudoColorRenderer(provider, 1, shader)
+
+            block = renderer.block(1, layer.extent(), width, height)
+            for row in range(height):
+                for col in range(width):
+                    if data.isNoData(row, col):
+                        self.assertEqual(block.color(row, col), 0)
+                        continue
+                    ok, red, green, blue, alpha = shader.shade(data.value(row, col))
+                    self.assertTrue(ok)
+                    self.assertEqual(block.color(row, col), QColor(red, green, blue, alpha).rgba(), file_name)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,133 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsCompactGraph and QgsShortestPathEngine.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Development Team'
+__date__ = '17/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+import math
+import random
+
+from qgis.core import QgsPointXY
+from qgis.analysis import QgsGraph, QgsGraphAnalyzer, QgsCompactGraph, QgsShortestPathEngine
+
+from qgis.testing import start_app, unittest
+
+start_app()
+
+
+def randomGraph(seed, vertexCount, edgeCount):
+    rng = random.Random(seed)
+    graph = QgsGraph()
+    for i in range(vertexCount):
+        graph.addVertex(QgsPointXY(i, rng.randint(0, 100)))
+    for i in range(edgeCount):
+        # integer costs, so that many paths are of equal cost
+        graph.addEdge(rng.randrange(vertexCount), rng.randrange(vertexCount), [rng.randint(0, 4), rng.random() * 10])
+    return graph
+
+
+class TestQgsShortestPathEngine(unittest.TestCase):
+
+    def testCompactGraph(self):
+        graph = QgsGraph()
+        for i in range(3):
+            graph.addVertex(QgsPointXY(i, 0))
+        graph.addEdge(1, 2, [5])
+        graph.addEdge(0, 1, [1, 2])
+        graph.addEdge(1, 0, [3, 4])
+
+        compact = QgsCompactGraph(graph)
+        self.assertEqual(compact.vertexCount(), 3)
+        self.assertEqual(compact.edgeCount(), 3)
+        self.assertEqual(compact.strategyCount(), 2)
+        self.assertEqual(compact.vertexPoint(2), QgsPointXY(2, 0))
+
+        # edges leaving vertex 1, in the order of the source graph
+        self.assertEqual(compact.outEdgesEnd(1) - compact.outEdgesBegin(1), 2)
+        first = compact.outEdgesBegin(1)
+        self.assertEqual(compact.sourceEdgeId(first), 0)
+        self.assertEqual(compact.edgeSource(first), 1)
+        self.assertEqual(compact.edgeTarget(first), 2)
+        self.assertEqual(compact.edgeCost(first, 0), 5)
+        # missing strategy
+        self.assertTrue(math.isinf(compact.edgeCost(first, 1)))
+        self.assertEqual(compact.sourceEdgeId(first + 1), 2)
+        self.assertEqual(compact.edgeCost(first + 1, 1), 4)
+
+        # edges entering vertex 0
+        self.assertEqual(compact.inEdgesEnd(0) - compact.inEdgesBegin(0), 1)
+        self.assertEqual(compact.sourceEdgeId(compact.inEdge(compact.inEdgesBegin(0))), 2)
+
+        self.assertEqual(QgsCompactGraph().vertexCount(), 0)
+
+    def testShortestPathTree(self):
+        graph = randomGraph(1, 200, 600)
+        compact = QgsCompactGraph(graph)
+        for strategy in range(2):
+            engine = QgsShortestPathEngine(compact, strategy)
+            for start in range(0, 200, 7):
+                # the engine answers exactly like the analyzer, ties included
+                tree, cost = engine.shortestPathTree(start)
+                self.assertEqual((tree, cost), QgsGraphAnalyzer.dijkstra(graph, start, strategy))
+
+    def testShortestPath(self):
+        graph = randomGraph(2, 300, 900)
+        compact = QgsCompactGraph(graph)
+        engine = QgsShortestPathEngine(compact, 1)
+        rng = random.Random(3)
+        for i in range(100):
+            start = rng.randrange(300)
+            end = rng.randrange(300)
+            tree, expected = QgsGraphAnalyzer.dijkstra(graph, start, 1)
+            cost, path = engine.shortestPath(start, end)
+            if math.isinf(expected[end]):
+                self.assertTrue(math.isinf(cost))
+                self.assertEqual(path, [])
+                continue
+
+            self.assertAlmostEqual(cost, expected[end], 9)
+            vertex = start
+            total = 0
+            for edgeId in path:
+                edge = graph.edge(edgeId)
+                self.assertEqual(edge.outVertex(), vertex)
+                total += edge.cost(1)
+                vertex = edge.inVertex()
+            self.assertEqual(vertex, end)
+            self.assertAlmostEqual(total, cost, 9)
+
+        self.assertEqual(engine.shortestPath(5, 5), (0.0, []))
+
+    def testCostsToVertices(self):
+        graph = randomGraph(4, 200, 500)
+        compact = QgsCompactGraph(graph)
+        engine = QgsShortestPathEngine(compact, 0)
+        rng = random.Random(5)
+        for start in range(0, 200, 11):
+            tree, expected = QgsGraphAnalyzer.dijkstra(graph, start, 0)
+            targets = [rng.randrange(200) for i in range(5)] + [start]
+            self.assertEqual(engine.costsToVertices(start, targets), [expected[t] for t in targets])
+        self.assertEqual(engine.costsToVertices(0, []), [])
+
+    def testInvalidStrategy(self):
+        graph = randomGraph(6, 10, 30)
+        engine = QgsShortestPathEngine(QgsCompactGraph(graph), 5)
+        tree, cost = engine.shortestPathTree(0)
+        self.assertEqual(tree, [-1] * 10)
+        self.assertEqual(cost[0], 0)
+        self.assertTrue(all(math.isinf(c) for c in cost[1:]))
+        self.assertTrue(math.isinf(engine.shortestPath(0, 1)[0]))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,93 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsVectorLayerDirector.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Development Team'
+__date__ = '17/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+from qgis.core import QgsFeature, QgsGeometry, QgsPointXY, QgsVectorLayer
+from qgis.analysis import QgsGraphBuilder, QgsVectorLayerDirector
+
+from qgis.testing import start_app, unittest
+
+start_app()
+
+
+class TestQgsVectorLayerDirector(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.layer = QgsVectorLayer('LineString?crs=epsg:3857', 'lines', 'memory')
+        features = []
+        for wkt in ['LineString (0 0, 10 0, 10 10)',
+                    'LineString (10 10, 20 10)',
+                    # starts in the tolerance cell of (20, 10) when the tolerance is 1
+                    'LineString (19.6 9.5, 30 9.5)']:
+            f = QgsFeature()
+            f.setGeometry(QgsGeometry.fromWkt(wkt))
+            features.append(f)
+        assert cls.layer.dataProvider().addFeatures(features)
+
+        cls.additionalPoints = [
+            # on the first segment
+            QgsPointXY(5, 3),
+            # as close to the second segment as to the third one, tied to the vertex they share
+            QgsPointXY(9, 11),
+            # equidistant from the second and third segments, tied to the first one found
+            QgsPointXY(15, 5),
+            # lying on the third segment
+            QgsPointXY(15, 10),
+            # tied to the first segment at (9.6, 0), in the tolerance cell of (10, 0) when the tolerance is 1
+            QgsPointXY(9.6, -1)]
+
+    def makeGraph(self, tolerance):
+        director = QgsVectorLayerDirector(self.layer, -1, 'forward', 'backward', 'both', QgsVectorLayerDirector.DirectionForward)
+        builder = QgsGraphBuilder(self.layer.crs(), False, tolerance)
+        snappedPoints = director.makeGraph(builder, self.additionalPoints)
+        return builder.graph(), snappedPoints
+
+    def assertPoints(self, points, expected):
+        self.assertEqual([(round(p.x(), 6), round(p.y(), 6)) for p in points], expected)
+
+    def assertGraph(self, graph, expectedVertices, expectedEdges):
+        self.assertPoints([graph.vertex(i).point() for i in range(graph.vertexCount())], expectedVertices)
+        self.assertEqual([(graph.edge(i).outVertex(), graph.edge(i).inVertex()) for i in range(graph.edgeCount())], expectedEdges)
+
+    def testNoTolerance(self):
+        graph, snappedPoints = self.makeGraph(0)
+        self.assertPoints(snappedPoints, [(5, 0), (10, 10), (10, 5), (15, 10), (9.6, 0)])
+        self.assertGraph(graph,
+                         [(0, 0), (5, 0), (9.6, 0), (10, 0), (10, 5), (10, 10), (15, 10), (19.6, 9.5), (20, 10), (30, 9.5)],
+                         [(0, 1), (1, 2), (2, 3), (3, 4), (4, 5), (5, 6), (6, 8), (7, 9)])
+
+    def testTolerance(self):
+        # points in the same tolerance cell are merged into the vertex added first,
+        # the tied point (9.6, 0) is snapped to (10, 0) and the third line is connected to the second one
+        graph, snappedPoints = self.makeGraph(1)
+        self.assertPoints(snappedPoints, [(5, 0), (10, 10), (10, 5), (15, 10), (10, 0)])
+        self.assertGraph(graph,
+                         [(0, 0), (5, 0), (10, 0), (10, 5), (10, 10), (15, 10), (20, 10), (30, 9.5)],
+                         [(0, 1), (1, 2), (2, 3), (3, 4), (4, 5), (5, 6), (6, 7)])
+
+    def testNoAdditionalPoints(self):
+        director = QgsVectorLayerDirector(self.layer, -1, 'forward', 'backward', 'both', QgsVectorLayerDirector.DirectionBoth)
+        builder = QgsGraphBuilder(self.layer.crs(), False, 0)
+        self.assertEqual(director.makeGraph(builder, []), [])
+        graph = builder.graph()
+        self.assertEqual(graph.vertexCount(), 6)
+        self.assertEqual(graph.edgeCount(), 8)
+        for i in range(graph.edgeCount()):
+            self.assertNotEqual(graph.edge(i).outVertex(), graph.edge(i).inVertex())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -15,7 +15,7 @@ __revision__ = '$Format:%H$'
 import qgis  # NOQA
 
 from qgis.PyQt.QtCore import QDir, QFile
-from qgis.core import QgsVectorLayer, QgsRasterLayer, QgsFeature, QgsFeatureRequest
+from qgis.core import QgsVectorLayer, QgsRasterLayer, QgsFeature, QgsFeatureRequest, QgsGeometry, QgsRectangle
 from qgis.analysis import QgsZonalStatistics
 
 from qgis.testing import start_app, unittest
@@ -119,6 +119,65 @@ class TestQgsZonalStatistics(unittest.TestCase):
         myMessage = ('Expected: %f\nGot: %f\n' % (2.0, feat[11]))
         assert feat[11] == 2.0, myMessage
 
+    def testThreadCount(self):
+        """Test that concurrent zones give the same statistics"""
+        TEST_DATA_DIR = unitTestDataPath() + "/zonalstatistics/"
+        myTempPath = QDir.tempPath() + "/"
+        testDir = QDir(TEST_DATA_DIR)
+        for f in testDir.entryList(QDir.Files):
+            QFile.remove(myTempPath + f)
+            QFile.copy(TEST_DATA_DIR + f, myTempPath + f)
+
+        myVector = QgsVectorLayer(myTempPath + "polys.shp", "poly", "ogr")
+        myRaster = QgsRasterLayer(myTempPath + "edge_problem.asc", "raster", "gdal")
+        stats = QgsZonalStatistics.Count | QgsZonalStatistics.Sum | QgsZonalStatistics.Median | QgsZonalStatistics.Majority
+
+        # zones covering at most one pixel center use the precise intersection, spread over several batches
+        cellSize = 0.000045
+        left = 100.379357
+        top = -0.960588 + 3 * cellSize
+        smallZones = []
+        for i in range(300):
+            row = i % 3
+            column = (i // 3) % 4
+            x = left + column * cellSize
+            y = top - (row + 1) * cellSize
+            if i % 2:
+                # a quarter of the pixel around its center
+                rect = QgsRectangle(x + cellSize / 4, y + cellSize / 4, x + 3 * cellSize / 4, y + 3 * cellSize / 4)
+            else:
+                # a corner of the pixel, without its center
+                rect = QgsRectangle(x + cellSize / 10, y + cellSize / 10, x + cellSize / 5, y + cellSize / 5)
+            f = QgsFeature(myVector.fields())
+            f.setGeometry(QgsGeometry.fromRect(rect))
+            smallZones.append(f)
+        ok, smallZones = myVector.dataProvider().addFeatures(smallZones)
+        self.assertTrue(ok)
+        smallIndex = {f.id(): i for i, f in enumerate(smallZones)}
+
+        zs = QgsZonalStatistics(myVector, myRaster, "a", 1, stats)
+        self.assertGreaterEqual(zs.threadCount(), 1)
+        zs.setThreadCount(1)
+        self.assertEqual(zs.threadCount(), 1)
+        self.assertEqual(zs.calculateStatistics(None), 0)
+
+        zs = QgsZonalStatistics(myVector, myRaster, "b", 1, stats)
+        zs.setThreadCount(4)
+        self.assertEqual(zs.calculateStatistics(None), 0)
+
+        expected = {0: (12.0, 8.0), 1: (9.0, 5.0), 2: (6.0, 5.0)}
+        values = [[1, 1, 0, 0], [1, 1, 0, 0], [1, 1, 1, 1]]
+        for feat in myVector.getFeatures():
+            if feat.id() in smallIndex:
+                i = smallIndex[feat.id()]
+                fraction = 0.25 if i % 2 else 0.01
+                self.assertAlmostEqual(feat['acount'], fraction, 6)
+                self.assertAlmostEqual(feat['asum'], fraction * values[i % 3][(i // 3) % 4], 6)
+            else:
+                self.assertEqual((feat['acount'], feat['asum']), expected[feat.id()])
+            for name in ['count', 'sum', 'median', 'majority']:
+                self.assertEqual(feat['a' + name], feat['b' + name])
+
 
 if __name__ == '__main__':
     unittest.main()